@@ -236,7 +236,7 @@ int amqpvalue_get_error(AMQP_VALUE value, ERROR_HANDLE* error_handle)
 			{
 				AMQP_VALUE item_value;
 				/* condition */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -254,11 +254,9 @@ int amqpvalue_get_error(AMQP_VALUE value, ERROR_HANDLE* error_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* description */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -275,11 +273,9 @@ int amqpvalue_get_error(AMQP_VALUE value, ERROR_HANDLE* error_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* info */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -296,8 +292,6 @@ int amqpvalue_get_error(AMQP_VALUE value, ERROR_HANDLE* error_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				error_instance->composite_value = amqpvalue_clone(value);
@@ -669,7 +663,7 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 			{
 				AMQP_VALUE item_value;
 				/* container-id */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -687,11 +681,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* hostname */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -708,11 +700,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* max-frame-size */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -729,11 +719,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* channel-max */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -750,11 +738,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* idle-time-out */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -771,11 +757,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* outgoing-locales */
-				item_value = amqpvalue_get_list_item(list_value, 5);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 5);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -794,11 +778,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* incoming-locales */
-				item_value = amqpvalue_get_list_item(list_value, 6);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 6);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -817,11 +799,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* offered-capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 7);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 7);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -840,11 +820,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* desired-capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 8);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 8);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -863,11 +841,9 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* properties */
-				item_value = amqpvalue_get_list_item(list_value, 9);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 9);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -884,8 +860,6 @@ int amqpvalue_get_open(AMQP_VALUE value, OPEN_HANDLE* open_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				open_instance->composite_value = amqpvalue_clone(value);
@@ -1705,7 +1679,7 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 			{
 				AMQP_VALUE item_value;
 				/* remote-channel */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -1722,11 +1696,9 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* next-outgoing-id */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					{
@@ -1744,11 +1716,9 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* incoming-window */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					{
@@ -1766,11 +1736,9 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* outgoing-window */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					{
@@ -1788,11 +1756,9 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* handle-max */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -1809,11 +1775,9 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* offered-capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 5);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 5);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -1832,11 +1796,9 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* desired-capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 6);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 6);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -1855,11 +1817,9 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* properties */
-				item_value = amqpvalue_get_list_item(list_value, 7);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 7);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -1876,8 +1836,6 @@ int amqpvalue_get_begin(AMQP_VALUE value, BEGIN_HANDLE* begin_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				begin_instance->composite_value = amqpvalue_clone(value);
@@ -2565,7 +2523,7 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 			{
 				AMQP_VALUE item_value;
 				/* name */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -2583,11 +2541,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* handle */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					{
@@ -2605,11 +2561,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* role */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					{
@@ -2627,11 +2581,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* snd-settle-mode */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2648,11 +2600,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* rcv-settle-mode */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2669,31 +2619,11 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* source */
-				item_value = amqpvalue_get_list_item(list_value, 5);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* target */
-				item_value = amqpvalue_get_list_item(list_value, 6);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* unsettled */
-				item_value = amqpvalue_get_list_item(list_value, 7);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 7);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2710,11 +2640,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* incomplete-unsettled */
-				item_value = amqpvalue_get_list_item(list_value, 8);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 8);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2731,11 +2659,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* initial-delivery-count */
-				item_value = amqpvalue_get_list_item(list_value, 9);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 9);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2752,11 +2678,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* max-message-size */
-				item_value = amqpvalue_get_list_item(list_value, 10);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 10);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2773,11 +2697,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* offered-capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 11);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 11);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2796,11 +2718,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* desired-capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 12);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 12);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2819,11 +2739,9 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* properties */
-				item_value = amqpvalue_get_list_item(list_value, 13);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 13);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -2840,8 +2758,6 @@ int amqpvalue_get_attach(AMQP_VALUE value, ATTACH_HANDLE* attach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				attach_instance->composite_value = amqpvalue_clone(value);
@@ -3913,7 +3829,7 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 			{
 				AMQP_VALUE item_value;
 				/* next-incoming-id */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -3930,11 +3846,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* incoming-window */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					{
@@ -3952,11 +3866,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* next-outgoing-id */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					{
@@ -3974,11 +3886,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* outgoing-window */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					{
@@ -3996,11 +3906,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* handle */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -4017,11 +3925,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* delivery-count */
-				item_value = amqpvalue_get_list_item(list_value, 5);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 5);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -4038,11 +3944,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* link-credit */
-				item_value = amqpvalue_get_list_item(list_value, 6);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 6);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -4059,11 +3963,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* available */
-				item_value = amqpvalue_get_list_item(list_value, 7);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 7);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -4080,11 +3982,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* drain */
-				item_value = amqpvalue_get_list_item(list_value, 8);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 8);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -4101,11 +4001,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* echo */
-				item_value = amqpvalue_get_list_item(list_value, 9);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 9);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -4122,11 +4020,9 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* properties */
-				item_value = amqpvalue_get_list_item(list_value, 10);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 10);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -4143,8 +4039,6 @@ int amqpvalue_get_flow(AMQP_VALUE value, FLOW_HANDLE* flow_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				flow_instance->composite_value = amqpvalue_clone(value);
@@ -5016,7 +4910,7 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 			{
 				AMQP_VALUE item_value;
 				/* handle */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -5034,11 +4928,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* delivery-id */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5055,11 +4947,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* delivery-tag */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5076,11 +4966,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* message-format */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5097,11 +4985,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* settled */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5118,11 +5004,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* more */
-				item_value = amqpvalue_get_list_item(list_value, 5);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 5);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5139,11 +5023,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* rcv-settle-mode */
-				item_value = amqpvalue_get_list_item(list_value, 6);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 6);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5160,21 +5042,10 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* state */
-				item_value = amqpvalue_get_list_item(list_value, 7);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* resume */
-				item_value = amqpvalue_get_list_item(list_value, 8);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 8);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5191,11 +5062,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* aborted */
-				item_value = amqpvalue_get_list_item(list_value, 9);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 9);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5212,11 +5081,9 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* batchable */
-				item_value = amqpvalue_get_list_item(list_value, 10);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 10);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -5233,8 +5100,6 @@ int amqpvalue_get_transfer(AMQP_VALUE value, TRANSFER_HANDLE* transfer_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				transfer_instance->composite_value = amqpvalue_clone(value);
@@ -6107,7 +5972,7 @@ int amqpvalue_get_disposition(AMQP_VALUE value, DISPOSITION_HANDLE* disposition_
 			{
 				AMQP_VALUE item_value;
 				/* role */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -6125,11 +5990,9 @@ int amqpvalue_get_disposition(AMQP_VALUE value, DISPOSITION_HANDLE* disposition_
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* first */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					{
@@ -6147,11 +6010,9 @@ int amqpvalue_get_disposition(AMQP_VALUE value, DISPOSITION_HANDLE* disposition_
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* last */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -6168,11 +6029,9 @@ int amqpvalue_get_disposition(AMQP_VALUE value, DISPOSITION_HANDLE* disposition_
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* settled */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -6189,21 +6048,10 @@ int amqpvalue_get_disposition(AMQP_VALUE value, DISPOSITION_HANDLE* disposition_
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* state */
-				item_value = amqpvalue_get_list_item(list_value, 4);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* batchable */
-				item_value = amqpvalue_get_list_item(list_value, 5);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 5);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -6220,8 +6068,6 @@ int amqpvalue_get_disposition(AMQP_VALUE value, DISPOSITION_HANDLE* disposition_
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				disposition_instance->composite_value = amqpvalue_clone(value);
@@ -6757,7 +6603,7 @@ int amqpvalue_get_detach(AMQP_VALUE value, DETACH_HANDLE* detach_handle)
 			{
 				AMQP_VALUE item_value;
 				/* handle */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -6775,11 +6621,9 @@ int amqpvalue_get_detach(AMQP_VALUE value, DETACH_HANDLE* detach_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* closed */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -6796,11 +6640,9 @@ int amqpvalue_get_detach(AMQP_VALUE value, DETACH_HANDLE* detach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* error */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -6817,8 +6659,6 @@ int amqpvalue_get_detach(AMQP_VALUE value, DETACH_HANDLE* detach_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				detach_instance->composite_value = amqpvalue_clone(value);
@@ -7149,7 +6989,7 @@ int amqpvalue_get_end(AMQP_VALUE value, END_HANDLE* end_handle)
 			{
 				AMQP_VALUE item_value;
 				/* error */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -7166,8 +7006,6 @@ int amqpvalue_get_end(AMQP_VALUE value, END_HANDLE* end_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				end_instance->composite_value = amqpvalue_clone(value);
@@ -7366,7 +7204,7 @@ int amqpvalue_get_close(AMQP_VALUE value, CLOSE_HANDLE* close_handle)
 			{
 				AMQP_VALUE item_value;
 				/* error */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -7383,8 +7221,6 @@ int amqpvalue_get_close(AMQP_VALUE value, CLOSE_HANDLE* close_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				close_instance->composite_value = amqpvalue_clone(value);
@@ -7603,7 +7439,7 @@ int amqpvalue_get_sasl_mechanisms(AMQP_VALUE value, SASL_MECHANISMS_HANDLE* sasl
 			{
 				AMQP_VALUE item_value;
 				/* sasl-server-mechanisms */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -7623,8 +7459,6 @@ int amqpvalue_get_sasl_mechanisms(AMQP_VALUE value, SASL_MECHANISMS_HANDLE* sasl
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				sasl_mechanisms_instance->composite_value = amqpvalue_clone(value);
@@ -7836,7 +7670,7 @@ int amqpvalue_get_sasl_init(AMQP_VALUE value, SASL_INIT_HANDLE* sasl_init_handle
 			{
 				AMQP_VALUE item_value;
 				/* mechanism */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -7854,11 +7688,9 @@ int amqpvalue_get_sasl_init(AMQP_VALUE value, SASL_INIT_HANDLE* sasl_init_handle
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* initial-response */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -7875,11 +7707,9 @@ int amqpvalue_get_sasl_init(AMQP_VALUE value, SASL_INIT_HANDLE* sasl_init_handle
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* hostname */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -7896,8 +7726,6 @@ int amqpvalue_get_sasl_init(AMQP_VALUE value, SASL_INIT_HANDLE* sasl_init_handle
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				sasl_init_instance->composite_value = amqpvalue_clone(value);
@@ -8241,7 +8069,7 @@ int amqpvalue_get_sasl_challenge(AMQP_VALUE value, SASL_CHALLENGE_HANDLE* sasl_c
 			{
 				AMQP_VALUE item_value;
 				/* challenge */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -8259,8 +8087,6 @@ int amqpvalue_get_sasl_challenge(AMQP_VALUE value, SASL_CHALLENGE_HANDLE* sasl_c
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				sasl_challenge_instance->composite_value = amqpvalue_clone(value);
@@ -8472,7 +8298,7 @@ int amqpvalue_get_sasl_response(AMQP_VALUE value, SASL_RESPONSE_HANDLE* sasl_res
 			{
 				AMQP_VALUE item_value;
 				/* response */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -8490,8 +8316,6 @@ int amqpvalue_get_sasl_response(AMQP_VALUE value, SASL_RESPONSE_HANDLE* sasl_res
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				sasl_response_instance->composite_value = amqpvalue_clone(value);
@@ -8703,7 +8527,7 @@ int amqpvalue_get_sasl_outcome(AMQP_VALUE value, SASL_OUTCOME_HANDLE* sasl_outco
 			{
 				AMQP_VALUE item_value;
 				/* code */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -8721,11 +8545,9 @@ int amqpvalue_get_sasl_outcome(AMQP_VALUE value, SASL_OUTCOME_HANDLE* sasl_outco
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* additional-data */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -8742,8 +8564,6 @@ int amqpvalue_get_sasl_outcome(AMQP_VALUE value, SASL_OUTCOME_HANDLE* sasl_outco
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				sasl_outcome_instance->composite_value = amqpvalue_clone(value);
@@ -9036,17 +8856,8 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 			{
 				AMQP_VALUE item_value;
 				/* address */
-				item_value = amqpvalue_get_list_item(list_value, 0);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* durable */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9063,11 +8874,9 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* expiry-policy */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9084,11 +8893,9 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* timeout */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9105,11 +8912,9 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* dynamic */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9126,11 +8931,9 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* dynamic-node-properties */
-				item_value = amqpvalue_get_list_item(list_value, 5);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 5);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9147,11 +8950,9 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* distribution-mode */
-				item_value = amqpvalue_get_list_item(list_value, 6);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 6);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9168,11 +8969,9 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* filter */
-				item_value = amqpvalue_get_list_item(list_value, 7);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 7);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9189,21 +8988,10 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* default-outcome */
-				item_value = amqpvalue_get_list_item(list_value, 8);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* outcomes */
-				item_value = amqpvalue_get_list_item(list_value, 9);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 9);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9222,11 +9010,9 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 10);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 10);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -9245,8 +9031,6 @@ int amqpvalue_get_source(AMQP_VALUE value, SOURCE_HANDLE* source_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				source_instance->composite_value = amqpvalue_clone(value);
@@ -10093,17 +9877,8 @@ int amqpvalue_get_target(AMQP_VALUE value, TARGET_HANDLE* target_handle)
 			{
 				AMQP_VALUE item_value;
 				/* address */
-				item_value = amqpvalue_get_list_item(list_value, 0);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* durable */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10120,11 +9895,9 @@ int amqpvalue_get_target(AMQP_VALUE value, TARGET_HANDLE* target_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* expiry-policy */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10141,11 +9914,9 @@ int amqpvalue_get_target(AMQP_VALUE value, TARGET_HANDLE* target_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* timeout */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10162,11 +9933,9 @@ int amqpvalue_get_target(AMQP_VALUE value, TARGET_HANDLE* target_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* dynamic */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10183,11 +9952,9 @@ int amqpvalue_get_target(AMQP_VALUE value, TARGET_HANDLE* target_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* dynamic-node-properties */
-				item_value = amqpvalue_get_list_item(list_value, 5);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 5);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10204,11 +9971,9 @@ int amqpvalue_get_target(AMQP_VALUE value, TARGET_HANDLE* target_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* capabilities */
-				item_value = amqpvalue_get_list_item(list_value, 6);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 6);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10227,8 +9992,6 @@ int amqpvalue_get_target(AMQP_VALUE value, TARGET_HANDLE* target_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				target_instance->composite_value = amqpvalue_clone(value);
@@ -10859,7 +10622,7 @@ int amqpvalue_get_header(AMQP_VALUE value, HEADER_HANDLE* header_handle)
 			{
 				AMQP_VALUE item_value;
 				/* durable */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10876,11 +10639,9 @@ int amqpvalue_get_header(AMQP_VALUE value, HEADER_HANDLE* header_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* priority */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10897,11 +10658,9 @@ int amqpvalue_get_header(AMQP_VALUE value, HEADER_HANDLE* header_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* ttl */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10918,11 +10677,9 @@ int amqpvalue_get_header(AMQP_VALUE value, HEADER_HANDLE* header_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* first-acquirer */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10939,11 +10696,9 @@ int amqpvalue_get_header(AMQP_VALUE value, HEADER_HANDLE* header_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* delivery-count */
-				item_value = amqpvalue_get_list_item(list_value, 4);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 4);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -10960,8 +10715,6 @@ int amqpvalue_get_header(AMQP_VALUE value, HEADER_HANDLE* header_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				header_instance->composite_value = amqpvalue_clone(value);
@@ -11760,17 +11513,8 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 			{
 				AMQP_VALUE item_value;
 				/* message-id */
-				item_value = amqpvalue_get_list_item(list_value, 0);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* user-id */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11787,21 +11531,10 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* to */
-				item_value = amqpvalue_get_list_item(list_value, 2);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* subject */
-				item_value = amqpvalue_get_list_item(list_value, 3);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 3);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11818,31 +11551,11 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* reply-to */
-				item_value = amqpvalue_get_list_item(list_value, 4);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* correlation-id */
-				item_value = amqpvalue_get_list_item(list_value, 5);
-				if (item_value == NULL)
-				{
-					/* do nothing */
-				}
-				else
-				{
-					amqpvalue_destroy(item_value);
-				}
 				/* content-type */
-				item_value = amqpvalue_get_list_item(list_value, 6);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 6);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11859,11 +11572,9 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* content-encoding */
-				item_value = amqpvalue_get_list_item(list_value, 7);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 7);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11880,11 +11591,9 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* absolute-expiry-time */
-				item_value = amqpvalue_get_list_item(list_value, 8);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 8);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11901,11 +11610,9 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* creation-time */
-				item_value = amqpvalue_get_list_item(list_value, 9);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 9);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11922,11 +11629,9 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* group-id */
-				item_value = amqpvalue_get_list_item(list_value, 10);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 10);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11943,11 +11648,9 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* group-sequence */
-				item_value = amqpvalue_get_list_item(list_value, 11);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 11);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11964,11 +11667,9 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* reply-to-group-id */
-				item_value = amqpvalue_get_list_item(list_value, 12);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 12);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -11985,8 +11686,6 @@ int amqpvalue_get_properties(AMQP_VALUE value, PROPERTIES_HANDLE* properties_han
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				properties_instance->composite_value = amqpvalue_clone(value);
@@ -12973,7 +12672,7 @@ int amqpvalue_get_received(AMQP_VALUE value, RECEIVED_HANDLE* received_handle)
 			{
 				AMQP_VALUE item_value;
 				/* section-number */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					{
@@ -12991,11 +12690,9 @@ int amqpvalue_get_received(AMQP_VALUE value, RECEIVED_HANDLE* received_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* section-offset */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					{
@@ -13013,8 +12710,6 @@ int amqpvalue_get_received(AMQP_VALUE value, RECEIVED_HANDLE* received_handle)
 						result = __LINE__;
 						break;
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				received_instance->composite_value = amqpvalue_clone(value);
@@ -13408,7 +13103,7 @@ int amqpvalue_get_rejected(AMQP_VALUE value, REJECTED_HANDLE* rejected_handle)
 			{
 				AMQP_VALUE item_value;
 				/* error */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -13425,8 +13120,6 @@ int amqpvalue_get_rejected(AMQP_VALUE value, REJECTED_HANDLE* rejected_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				rejected_instance->composite_value = amqpvalue_clone(value);
@@ -13754,7 +13447,7 @@ int amqpvalue_get_modified(AMQP_VALUE value, MODIFIED_HANDLE* modified_handle)
 			{
 				AMQP_VALUE item_value;
 				/* delivery-failed */
-				item_value = amqpvalue_get_list_item(list_value, 0);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 0);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -13771,11 +13464,9 @@ int amqpvalue_get_modified(AMQP_VALUE value, MODIFIED_HANDLE* modified_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* undeliverable-here */
-				item_value = amqpvalue_get_list_item(list_value, 1);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 1);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -13792,11 +13483,9 @@ int amqpvalue_get_modified(AMQP_VALUE value, MODIFIED_HANDLE* modified_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 				/* message-annotations */
-				item_value = amqpvalue_get_list_item(list_value, 2);
+				item_value = amqpvalue_get_list_item_in_place(list_value, 2);
 				if (item_value == NULL)
 				{
 					/* do nothing */
@@ -13813,8 +13502,6 @@ int amqpvalue_get_modified(AMQP_VALUE value, MODIFIED_HANDLE* modified_handle)
 							break;
 						}
 					}
-
-					amqpvalue_destroy(item_value);
 				}
 
 				modified_instance->composite_value = amqpvalue_clone(value);
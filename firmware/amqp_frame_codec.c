@@ -94,21 +94,19 @@ static void frame_received(void* context, const unsigned char* type_specific, ui
 				/* Codes_SRS_AMQP_FRAME_CODEC_01_002: [The frame body is defined as a performative followed by an opaque payload.] */
 				amqp_frame_codec_instance->decoded_performative = NULL;
 
-				while ((frame_body_size > 0) &&
-					   (amqp_frame_codec_instance->decoded_performative == NULL) &&
-					   (amqp_frame_codec_instance->decode_state != AMQP_FRAME_DECODE_ERROR))
+				/* Codes_SRS_AMQP_FRAME_CODEC_01_052: [Decoding the performative shall be done by feeding the bytes to the decoder create in amqp_frame_codec_create.] */
+				/* The whole frame body is handed to the decoder at once, it stops right after the performative
+				and the strings/binaries in it reference frame_body, which outlives the frame_received_callback call. */
+				size_t used_bytes;
+				if (amqpvalue_decode_single_value(amqp_frame_codec_instance->decoder, frame_body, frame_body_size, &used_bytes) != 0)
 				{
-					/* Codes_SRS_AMQP_FRAME_CODEC_01_052: [Decoding the performative shall be done by feeding the bytes to the decoder create in amqp_frame_codec_create.] */
-					if (amqpvalue_decode_bytes(amqp_frame_codec_instance->decoder, frame_body, 1) != 0)
-					{
-						/* Codes_SRS_AMQP_FRAME_CODEC_01_060: [If any error occurs while decoding a frame, the decoder shall switch to an error state where decoding shall not be possible anymore.] */
-						amqp_frame_codec_instance->decode_state = AMQP_FRAME_DECODE_ERROR;
-					}
-					else
-					{
-						frame_body_size--;
-						frame_body++;
-					}
+					/* Codes_SRS_AMQP_FRAME_CODEC_01_060: [If any error occurs while decoding a frame, the decoder shall switch to an error state where decoding shall not be possible anymore.] */
+					amqp_frame_codec_instance->decode_state = AMQP_FRAME_DECODE_ERROR;
+				}
+				else
+				{
+					frame_body_size -= (uint32_t)used_bytes;
+					frame_body += used_bytes;
 				}
 
 				if (amqp_frame_codec_instance->decode_state == AMQP_FRAME_DECODE_ERROR)
@@ -166,7 +164,7 @@ AMQP_FRAME_CODEC_HANDLE amqp_frame_codec_create(FRAME_CODEC_HANDLE frame_codec,
 			result->decode_state = AMQP_FRAME_DECODE_FRAME;
 
 			/* Codes_SRS_AMQP_FRAME_CODEC_01_018: [amqp_frame_codec_create shall create a decoder to be used for decoding AMQP values.] */
-			result->decoder = amqpvalue_decoder_create(amqp_value_decoded, result);
+			result->decoder = amqpvalue_decoder_create_in_place(amqp_value_decoded, result);
 			if (result->decoder == NULL)
 			{
 				/* Codes_SRS_AMQP_FRAME_CODEC_01_019: [If creating the decoder fails, amqp_frame_codec_create shall fail and return NULL.] */
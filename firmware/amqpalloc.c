@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "gballoc.h"
 #include "amqpalloc.h"
 
 #ifndef SIZE_MAX
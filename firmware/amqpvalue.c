@@ -27,6 +27,10 @@ typedef struct AMQP_ARRAY_VALUE_TAG
 {
 	AMQP_VALUE* items;
 	uint32_t count;
+	/* fixed width numeric arrays are kept as count native items of packed_type, items is NULL in that case.
+	   packed_type is AMQP_TYPE_UNKNOWN for arrays that hold individual AMQP_VALUE items */
+	void* packed_items;
+	AMQP_TYPE packed_type;
 } AMQP_ARRAY_VALUE;
 
 typedef struct AMQP_MAP_KEY_VALUE_PAIR_TAG
@@ -41,20 +45,26 @@ typedef struct AMQP_MAP_VALUE_TAG
 	uint32_t pair_count;
 } AMQP_MAP_VALUE;
 
+/* is_view is set when the value was decoded in place and references the decoder input buffer instead of owning its bytes */
 typedef struct AMQP_STRING_VALUE_TAG
 {
 	char* chars;
+	uint32_t length;
+	bool is_view;
 } AMQP_STRING_VALUE;
 
 typedef struct AMQP_SYMBOL_VALUE_TAG
 {
 	char* chars;
+	uint32_t length;
+	bool is_view;
 } AMQP_SYMBOL_VALUE;
 
 typedef struct AMQP_BINARY_VALUE_TAG
 {
 	unsigned char* bytes;
 	uint32_t length;
+	bool is_view;
 } AMQP_BINARY_VALUE;
 
 typedef struct DESCRIBED_VALUE_TAG
@@ -81,7 +91,7 @@ typedef union AMQP_VALUE_UNION_TAG
 	int64_t timestamp_value;
 	uuid uuid_value;
 	AMQP_STRING_VALUE string_value;
-	amqp_binary binary_value;
+	AMQP_BINARY_VALUE binary_value;
 	AMQP_LIST_VALUE list_value;
 	AMQP_MAP_VALUE map_value;
 	AMQP_ARRAY_VALUE array_value;
@@ -99,7 +109,8 @@ typedef enum DECODE_ARRAY_STEP_TAG
 {
 	DECODE_ARRAY_STEP_SIZE,
 	DECODE_ARRAY_STEP_COUNT,
-	DECODE_ARRAY_STEP_ITEMS
+	DECODE_ARRAY_STEP_ITEMS,
+	DECODE_ARRAY_STEP_PACKED_ITEMS
 } DECODE_ARRAY_STEP;
 
 typedef enum DECODE_DESCRIBED_VALUE_STEP_TAG
@@ -183,14 +194,209 @@ typedef struct INTERNAL_DECODER_DATA_TAG
 	AMQP_VALUE_DATA* decode_to_value;
 	void* inner_decoder;
 	DECODE_VALUE_STATE_UNION decode_value_state;
+	bool decode_in_place;
 } INTERNAL_DECODER_DATA;
 
 typedef struct DECODER_DATA_TAG
 {
 	INTERNAL_DECODER_DATA* internal_decoder;
 	AMQP_VALUE_DATA* decode_to_value;
+	ON_VALUE_DECODED on_value_decoded;
+	void* on_value_decoded_context;
+	bool stop_after_value;
 } DECODER_DATA;
 
+/* Turns the characters of a string or symbol view into an owned, NUL terminated copy.
+This is done lazily, only when a caller needs the value as a C string. */
+static int own_view_chars(char** chars, uint32_t length, bool* is_view)
+{
+	int result;
+	char* owned_chars = (char*)amqpalloc_malloc(length + 1);
+
+	if (owned_chars == NULL)
+	{
+		result = __LINE__;
+	}
+	else
+	{
+		if (length > 0)
+		{
+			(void)memcpy(owned_chars, *chars, length);
+		}
+
+		owned_chars[length] = '\0';
+		*chars = owned_chars;
+		*is_view = false;
+		result = 0;
+	}
+
+	return result;
+}
+
+/* Well known strings and symbols are interned: creating or cloning one of them hands out the shared immutable
+value below instead of allocating, destroying it is a no-op and two interned values are equal only if they are the same value.
+The str8/sym8 constructor and length are kept next to each value so encoding does not have to build them. The table is
+const so that it stays in flash, AMQP_VALUE is not const, so the pointers handed out are cast where they leave the table
+and nothing writes through them because every function that changes or frees a value checks is_interned_value first. */
+typedef struct INTERNED_VALUE_TAG
+{
+	AMQP_VALUE_DATA value;
+	unsigned char encoded_header[2];
+} INTERNED_VALUE;
+
+#define INTERNED_STRING(text) { { AMQP_TYPE_STRING, { .string_value = { (char*)text, sizeof(text) - 1, false } } }, { 0xA1, sizeof(text) - 1 } }
+#define INTERNED_SYMBOL(text) { { AMQP_TYPE_SYMBOL, { .symbol_value = { (char*)text, sizeof(text) - 1, false } } }, { 0xA3, sizeof(text) - 1 } }
+
+static const INTERNED_VALUE interned_values[] =
+{
+	/* error conditions */
+	INTERNED_SYMBOL("amqp:internal-error"),
+	INTERNED_SYMBOL("amqp:not-found"),
+	INTERNED_SYMBOL("amqp:unauthorized-access"),
+	INTERNED_SYMBOL("amqp:decode-error"),
+	INTERNED_SYMBOL("amqp:resource-limit-exceeded"),
+	INTERNED_SYMBOL("amqp:not-allowed"),
+	INTERNED_SYMBOL("amqp:invalid-field"),
+	INTERNED_SYMBOL("amqp:not-implemented"),
+	INTERNED_SYMBOL("amqp:resource-locked"),
+	INTERNED_SYMBOL("amqp:precondition-failed"),
+	INTERNED_SYMBOL("amqp:resource-deleted"),
+	INTERNED_SYMBOL("amqp:illegal-state"),
+	INTERNED_SYMBOL("amqp:frame-size-too-small"),
+	INTERNED_SYMBOL("amqp:connection:forced"),
+	INTERNED_SYMBOL("amqp:connection:framing-error"),
+	INTERNED_SYMBOL("amqp:connection:redirect"),
+	INTERNED_SYMBOL("amqp:session:window-violation"),
+	INTERNED_SYMBOL("amqp:session:errant-link"),
+	INTERNED_SYMBOL("amqp:session:handle-in-use"),
+	INTERNED_SYMBOL("amqp:session:unattached-handle"),
+	INTERNED_SYMBOL("amqp:link:detach-forced"),
+	INTERNED_SYMBOL("amqp:link:transfer-limit-exceeded"),
+	INTERNED_SYMBOL("amqp:link:message-size-exceeded"),
+	INTERNED_SYMBOL("amqp:link:redirect"),
+	INTERNED_SYMBOL("amqp:link:stolen"),
+
+	/* SASL mechanisms, distribution modes and link properties */
+	INTERNED_SYMBOL("MSSBCBS"),
+	INTERNED_SYMBOL("PLAIN"),
+	INTERNED_SYMBOL("ANONYMOUS"),
+	INTERNED_SYMBOL("move"),
+	INTERNED_SYMBOL("copy"),
+	INTERNED_SYMBOL("com.microsoft:client-version"),
+
+	/* AMQP management and CBS application properties */
+	INTERNED_STRING("operation"),
+	INTERNED_STRING("type"),
+	INTERNED_STRING("name"),
+	INTERNED_STRING("locales"),
+	INTERNED_STRING("status-code"),
+	INTERNED_STRING("status-description"),
+	INTERNED_STRING("put-token"),
+	INTERNED_STRING("delete-token")
+};
+
+static bool is_interned_value(const AMQP_VALUE_DATA* value_data)
+{
+	const INTERNED_VALUE* interned_value = (const INTERNED_VALUE*)value_data;
+	return (interned_value >= &interned_values[0]) &&
+		(interned_value < &interned_values[sizeof(interned_values) / sizeof(interned_values[0])]);
+}
+
+/* kept in step with interned_values, so that most other strings are turned away without scanning the table */
+#define INTERNED_MIN_LENGTH 4	/* "move", "copy", "type", "name" */
+#define INTERNED_MAX_LENGTH 33	/* "amqp:link:transfer-limit-exceeded" */
+static const char interned_first_chars[] = "aMPAmcotnlspd";
+
+static AMQP_VALUE_DATA* find_interned_value(AMQP_TYPE type, const char* chars, uint32_t length)
+{
+	AMQP_VALUE_DATA* result = NULL;
+
+	if ((length >= INTERNED_MIN_LENGTH) &&
+		(length <= INTERNED_MAX_LENGTH) &&
+		(memchr(interned_first_chars, chars[0], sizeof(interned_first_chars) - 1) != NULL))
+	{
+		size_t i;
+
+		for (i = 0; i < sizeof(interned_values) / sizeof(interned_values[0]); i++)
+		{
+			/* string and symbol values share the same layout */
+			const AMQP_STRING_VALUE* interned_chars = &interned_values[i].value.value.string_value;
+			if ((interned_chars->length == length) &&
+				(interned_chars->chars[0] == chars[0]) &&
+				(interned_values[i].value.type == type) &&
+				(memcmp(interned_chars->chars, chars, length) == 0))
+			{
+				result = (AMQP_VALUE_DATA*)&interned_values[i].value;
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+static int encode_interned_value(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const AMQP_VALUE_DATA* value_data)
+{
+	int result;
+	const INTERNED_VALUE* interned_value = (const INTERNED_VALUE*)value_data;
+
+	if ((encoder_output(context, interned_value->encoded_header, sizeof(interned_value->encoded_header)) != 0) ||
+		(encoder_output(context, (const unsigned char*)value_data->value.string_value.chars, value_data->value.string_value.length) != 0))
+	{
+		/* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
+		result = __LINE__;
+	}
+	else
+	{
+		/* Codes_SRS_AMQPVALUE_01_266: [On success amqpvalue_encode shall return 0.] */
+		result = 0;
+	}
+
+	return result;
+}
+
+static AMQP_VALUE create_chars_value_copy(AMQP_TYPE type, const char* chars, uint32_t length)
+{
+	AMQP_VALUE_DATA* result = find_interned_value(type, chars, length);
+	if (result != NULL)
+	{
+		/* well known value, nothing to copy */
+	}
+	else if ((result = (AMQP_VALUE_DATA*)amqpalloc_malloc(sizeof(AMQP_VALUE_DATA))) != NULL)
+	{
+		char* owned_chars = (char*)amqpalloc_malloc(length + 1);
+		if (owned_chars == NULL)
+		{
+			amqpalloc_free(result);
+			result = NULL;
+		}
+		else
+		{
+			if (length > 0)
+			{
+				(void)memcpy(owned_chars, chars, length);
+			}
+
+			owned_chars[length] = '\0';
+			result->type = type;
+			if (type == AMQP_TYPE_STRING)
+			{
+				result->value.string_value.chars = owned_chars;
+				result->value.string_value.length = length;
+				result->value.string_value.is_view = false;
+			}
+			else
+			{
+				result->value.symbol_value.chars = owned_chars;
+				result->value.symbol_value.length = length;
+				result->value.symbol_value.is_view = false;
+			}
+		}
+	}
+
+	return result;
+}
+
 /* Codes_SRS_AMQPVALUE_01_003: [1.6.1 null Indicates an empty value.] */
 AMQP_VALUE amqpvalue_create_null(void)
 {
@@ -874,6 +1080,7 @@ AMQP_VALUE amqpvalue_create_binary(amqp_binary value)
 			}
 
 			result->value.binary_value.length = value.length;
+			result->value.binary_value.is_view = false;
 
 			if ((result->value.binary_value.bytes == NULL) && (value.length > 0))
 			{
@@ -937,9 +1144,13 @@ AMQP_VALUE amqpvalue_create_string(const char* value)
 	{
 		size_t length = strlen(value);
 		
-		/* Codes_SRS_AMQPVALUE_01_136: [If allocating the AMQP_VALUE fails then amqpvalue_create_string shall return NULL.] */
-		result = (AMQP_VALUE_DATA*)amqpalloc_malloc(sizeof(AMQP_VALUE_DATA));
+		result = find_interned_value(AMQP_TYPE_STRING, value, (uint32_t)length);
 		if (result != NULL)
+		{
+			/* well known string, hand out the shared value */
+		}
+		/* Codes_SRS_AMQPVALUE_01_136: [If allocating the AMQP_VALUE fails then amqpvalue_create_string shall return NULL.] */
+		else if ((result = (AMQP_VALUE_DATA*)amqpalloc_malloc(sizeof(AMQP_VALUE_DATA))) != NULL)
 		{
 			result->type = AMQP_TYPE_STRING;
 			result->value.string_value.chars = amqpalloc_malloc(length + 1);
@@ -955,6 +1166,8 @@ AMQP_VALUE amqpvalue_create_string(const char* value)
 #pragma warning(suppress: 6324) /* we use strcpy intentionally */
 #endif
 				(void)strcpy(result->value.string_value.chars, value);
+				result->value.string_value.length = (uint32_t)length;
+				result->value.string_value.is_view = false;
 			}
 		}
 	}
@@ -981,6 +1194,11 @@ int amqpvalue_get_string(AMQP_VALUE value, const char** string_value)
 		{
 			result = __LINE__;
 		}
+		else if ((value_data->value.string_value.is_view) &&
+			(own_view_chars(&value_data->value.string_value.chars, value_data->value.string_value.length, &value_data->value.string_value.is_view) != 0))
+		{
+			result = __LINE__;
+		}
 		else
 		{
 			/* Codes_SRS_AMQPVALUE_01_138: [amqpvalue_get_string shall yield a pointer to the sequence of bytes held by the AMQP_VALUE in string_value.] */
@@ -1005,12 +1223,16 @@ AMQP_VALUE amqpvalue_create_symbol(const char* value)
 	}
 	else
 	{
-		/* Codes_SRS_AMQPVALUE_01_143: [If allocating the AMQP_VALUE fails then amqpvalue_create_symbol shall return NULL.] */
-		result = (AMQP_VALUE_DATA*)amqpalloc_malloc(sizeof(AMQP_VALUE_DATA));
+		uint32_t length = strlen(value);
+
+		result = find_interned_value(AMQP_TYPE_SYMBOL, value, length);
 		if (result != NULL)
 		{
-			uint32_t length = strlen(value);
-
+			/* well known symbol, hand out the shared value */
+		}
+		/* Codes_SRS_AMQPVALUE_01_143: [If allocating the AMQP_VALUE fails then amqpvalue_create_symbol shall return NULL.] */
+		else if ((result = (AMQP_VALUE_DATA*)amqpalloc_malloc(sizeof(AMQP_VALUE_DATA))) != NULL)
+		{
 			/* Codes_SRS_AMQPVALUE_01_142: [amqpvalue_create_symbol shall return a handle to an AMQP_VALUE that stores a symbol (ASCII string) value.] */
 			result->type = AMQP_TYPE_SYMBOL;
 			result->value.symbol_value.chars = (char*)amqpalloc_malloc(length + 1);
@@ -1022,6 +1244,8 @@ AMQP_VALUE amqpvalue_create_symbol(const char* value)
 			else
 			{
 				(void)strcpy(result->value.symbol_value.chars, value);
+				result->value.symbol_value.length = length;
+				result->value.symbol_value.is_view = false;
 			}
 		}
 	}
@@ -1048,6 +1272,11 @@ int amqpvalue_get_symbol(AMQP_VALUE value, const char** symbol_value)
 		{
 			result = __LINE__;
 		}
+		else if ((value_data->value.symbol_value.is_view) &&
+			(own_view_chars(&value_data->value.symbol_value.chars, value_data->value.symbol_value.length, &value_data->value.symbol_value.is_view) != 0))
+		{
+			result = __LINE__;
+		}
 		else
 		{
 			/* Codes_SRS_AMQPVALUE_01_145: [amqpvalue_get_symbol shall fill in the symbol_value the symbol value string held by the AMQP_VALUE.] */
@@ -1614,13 +1843,375 @@ int amqpvalue_get_map(AMQP_VALUE value, AMQP_VALUE* map_value)
 	return result;
 }
 
+static size_t get_packed_item_size(AMQP_TYPE type)
+{
+	size_t result;
+
+	switch (type)
+	{
+	default:
+		result = 0;
+		break;
+
+	case AMQP_TYPE_UINT:
+	case AMQP_TYPE_INT:
+	case AMQP_TYPE_FLOAT:
+		result = 4;
+		break;
+
+	case AMQP_TYPE_ULONG:
+	case AMQP_TYPE_LONG:
+	case AMQP_TYPE_DOUBLE:
+		result = 8;
+		break;
+	}
+
+	return result;
+}
+
+static unsigned char get_packed_item_constructor(AMQP_TYPE type)
+{
+	unsigned char result;
+
+	switch (type)
+	{
+	default:
+		result = 0x40;
+		break;
+
+	case AMQP_TYPE_UINT:
+		result = 0x70;
+		break;
+	case AMQP_TYPE_INT:
+		result = 0x71;
+		break;
+	case AMQP_TYPE_FLOAT:
+		result = 0x72;
+		break;
+	case AMQP_TYPE_ULONG:
+		result = 0x80;
+		break;
+	case AMQP_TYPE_LONG:
+		result = 0x81;
+		break;
+	case AMQP_TYPE_DOUBLE:
+		result = 0x82;
+		break;
+	}
+
+	return result;
+}
+
+static AMQP_TYPE get_packed_item_type(unsigned char constructor_byte)
+{
+	AMQP_TYPE result;
+
+	switch (constructor_byte)
+	{
+	default:
+		result = AMQP_TYPE_UNKNOWN;
+		break;
+
+	case 0x70:
+		result = AMQP_TYPE_UINT;
+		break;
+	case 0x71:
+		result = AMQP_TYPE_INT;
+		break;
+	case 0x72:
+		result = AMQP_TYPE_FLOAT;
+		break;
+	case 0x80:
+		result = AMQP_TYPE_ULONG;
+		break;
+	case 0x81:
+		result = AMQP_TYPE_LONG;
+		break;
+	case 0x82:
+		result = AMQP_TYPE_DOUBLE;
+		break;
+	}
+
+	return result;
+}
+
+/* The swaps below load a whole native item and store it byte by byte with shifts (or the other way around),
+   which works regardless of host endianness and lets the compiler emit a single byte reverse per item */
+static void packed_items_to_network_order(unsigned char* destination, const unsigned char* source, size_t item_size, size_t item_count)
+{
+	size_t i;
+
+	if (item_size == 4)
+	{
+		for (i = 0; i < item_count; i++)
+		{
+			uint32_t item;
+			(void)memcpy(&item, source, 4);
+			destination[0] = (unsigned char)(item >> 24);
+			destination[1] = (unsigned char)(item >> 16);
+			destination[2] = (unsigned char)(item >> 8);
+			destination[3] = (unsigned char)item;
+			source += 4;
+			destination += 4;
+		}
+	}
+	else
+	{
+		for (i = 0; i < item_count; i++)
+		{
+			uint64_t item;
+			(void)memcpy(&item, source, 8);
+			destination[0] = (unsigned char)(item >> 56);
+			destination[1] = (unsigned char)(item >> 48);
+			destination[2] = (unsigned char)(item >> 40);
+			destination[3] = (unsigned char)(item >> 32);
+			destination[4] = (unsigned char)(item >> 24);
+			destination[5] = (unsigned char)(item >> 16);
+			destination[6] = (unsigned char)(item >> 8);
+			destination[7] = (unsigned char)item;
+			source += 8;
+			destination += 8;
+		}
+	}
+}
+
+/* converts in place, destination and source may be the same buffer */
+static void packed_items_from_network_order(unsigned char* destination, const unsigned char* source, size_t item_size, size_t item_count)
+{
+	size_t i;
+
+	if (item_size == 4)
+	{
+		for (i = 0; i < item_count; i++)
+		{
+			uint32_t item = ((uint32_t)source[0] << 24) |
+				((uint32_t)source[1] << 16) |
+				((uint32_t)source[2] << 8) |
+				(uint32_t)source[3];
+			(void)memcpy(destination, &item, 4);
+			source += 4;
+			destination += 4;
+		}
+	}
+	else
+	{
+		for (i = 0; i < item_count; i++)
+		{
+			uint64_t item = ((uint64_t)source[0] << 56) |
+				((uint64_t)source[1] << 48) |
+				((uint64_t)source[2] << 40) |
+				((uint64_t)source[3] << 32) |
+				((uint64_t)source[4] << 24) |
+				((uint64_t)source[5] << 16) |
+				((uint64_t)source[6] << 8) |
+				(uint64_t)source[7];
+			(void)memcpy(destination, &item, 8);
+			source += 8;
+			destination += 8;
+		}
+	}
+}
+
+static AMQP_VALUE create_packed_array_item(AMQP_TYPE item_type, const unsigned char* packed_item)
+{
+	AMQP_VALUE result;
+
+	switch (item_type)
+	{
+	default:
+		result = NULL;
+		break;
+
+	case AMQP_TYPE_UINT:
+	{
+		uint32_t item;
+		(void)memcpy(&item, packed_item, sizeof(item));
+		result = amqpvalue_create_uint(item);
+		break;
+	}
+	case AMQP_TYPE_INT:
+	{
+		int32_t item;
+		(void)memcpy(&item, packed_item, sizeof(item));
+		result = amqpvalue_create_int(item);
+		break;
+	}
+	case AMQP_TYPE_FLOAT:
+	{
+		float item;
+		(void)memcpy(&item, packed_item, sizeof(item));
+		result = amqpvalue_create_float(item);
+		break;
+	}
+	case AMQP_TYPE_ULONG:
+	{
+		uint64_t item;
+		(void)memcpy(&item, packed_item, sizeof(item));
+		result = amqpvalue_create_ulong(item);
+		break;
+	}
+	case AMQP_TYPE_LONG:
+	{
+		int64_t item;
+		(void)memcpy(&item, packed_item, sizeof(item));
+		result = amqpvalue_create_long(item);
+		break;
+	}
+	case AMQP_TYPE_DOUBLE:
+	{
+		double item;
+		(void)memcpy(&item, packed_item, sizeof(item));
+		result = amqpvalue_create_double(item);
+		break;
+	}
+	}
+
+	return result;
+}
+
+/* the value union stores all the fixed width numeric types at offset 0, so the native bytes can be copied straight out of it */
+static int pack_array_items(AMQP_VALUE_DATA* value_data, AMQP_TYPE item_type)
+{
+	int result;
+	size_t item_size = get_packed_item_size(item_type);
+	uint32_t count = value_data->value.array_value.count;
+	unsigned char* packed_items = (unsigned char*)amqpalloc_malloc(count * item_size);
+
+	if (packed_items == NULL)
+	{
+		result = __LINE__;
+	}
+	else
+	{
+		uint32_t i;
+
+		for (i = 0; i < count; i++)
+		{
+			AMQP_VALUE_DATA* item_data = (AMQP_VALUE_DATA*)value_data->value.array_value.items[i];
+			if (item_data->type != item_type)
+			{
+				break;
+			}
+
+			(void)memcpy(packed_items + (i * item_size), &item_data->value, item_size);
+		}
+
+		if (i < count)
+		{
+			amqpalloc_free(packed_items);
+			result = __LINE__;
+		}
+		else
+		{
+			for (i = 0; i < count; i++)
+			{
+				amqpvalue_destroy(value_data->value.array_value.items[i]);
+			}
+
+			amqpalloc_free(value_data->value.array_value.items);
+			value_data->value.array_value.items = NULL;
+			value_data->value.array_value.packed_items = packed_items;
+			value_data->value.array_value.packed_type = item_type;
+			result = 0;
+		}
+	}
+
+	return result;
+}
+
 AMQP_VALUE amqpvalue_create_array(void)
 {
 	AMQP_VALUE_DATA* result = (AMQP_VALUE_DATA*)amqpalloc_malloc(sizeof(AMQP_VALUE_DATA));
 	if (result != NULL)
 	{
 		result->type = AMQP_TYPE_ARRAY;
+		result->value.array_value.items = NULL;
+		result->value.array_value.count = 0;
+		result->value.array_value.packed_items = NULL;
+		result->value.array_value.packed_type = AMQP_TYPE_UNKNOWN;
+	}
+	return result;
+}
+
+AMQP_VALUE amqpvalue_create_array_from_typed(AMQP_TYPE item_type, const void* items, uint32_t count)
+{
+	AMQP_VALUE_DATA* result;
+	size_t item_size = get_packed_item_size(item_type);
+
+	if ((item_size == 0) ||
+		((items == NULL) && (count > 0)))
+	{
+		result = NULL;
+	}
+	else
+	{
+		result = (AMQP_VALUE_DATA*)amqpvalue_create_array();
+		if (result != NULL)
+		{
+			result->value.array_value.packed_type = item_type;
+
+			if (count > 0)
+			{
+				result->value.array_value.packed_items = amqpalloc_malloc(count * item_size);
+				if (result->value.array_value.packed_items == NULL)
+				{
+					amqpalloc_free(result);
+					result = NULL;
+				}
+				else
+				{
+					(void)memcpy(result->value.array_value.packed_items, items, count * item_size);
+					result->value.array_value.count = count;
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+int amqpvalue_get_array_as_typed(AMQP_VALUE value, AMQP_TYPE item_type, const void** items, uint32_t* count)
+{
+	int result;
+
+	if ((value == NULL) ||
+		(items == NULL) ||
+		(count == NULL) ||
+		(get_packed_item_size(item_type) == 0))
+	{
+		result = __LINE__;
+	}
+	else
+	{
+		AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
+		if (value_data->type != AMQP_TYPE_ARRAY)
+		{
+			result = __LINE__;
+		}
+		else if ((value_data->value.array_value.count == 0) &&
+			(value_data->value.array_value.packed_type == AMQP_TYPE_UNKNOWN))
+		{
+			*items = NULL;
+			*count = 0;
+			result = 0;
+		}
+		else if ((value_data->value.array_value.packed_type == AMQP_TYPE_UNKNOWN) &&
+			(pack_array_items(value_data, item_type) != 0))
+		{
+			result = __LINE__;
+		}
+		else if (value_data->value.array_value.packed_type != item_type)
+		{
+			result = __LINE__;
+		}
+		else
+		{
+			*items = value_data->value.array_value.packed_items;
+			*count = value_data->value.array_value.count;
+			result = 0;
+		}
 	}
+
 	return result;
 }
 
@@ -1670,11 +2261,34 @@ int amqpvalue_add_array_item(AMQP_VALUE value, AMQP_VALUE array_item_value)
 		{
 			AMQP_VALUE_DATA* array_item_value_data = (AMQP_VALUE_DATA*)array_item_value;
 
-			if ((value_data->value.array_value.count > 0) &&
+			if ((value_data->value.array_value.packed_type != AMQP_TYPE_UNKNOWN) &&
+				(array_item_value_data->type != value_data->value.array_value.packed_type))
+			{
+				result = __LINE__;
+			}
+			else if ((value_data->value.array_value.count > 0) &&
+				(value_data->value.array_value.packed_type == AMQP_TYPE_UNKNOWN) &&
 				(array_item_value_data->type != value_data->value.array_value.items[0]->type))
 			{
 				result = __LINE__;
 			}
+			else if (value_data->value.array_value.packed_type != AMQP_TYPE_UNKNOWN)
+			{
+				size_t item_size = get_packed_item_size(value_data->value.array_value.packed_type);
+				unsigned char* new_packed_items = (unsigned char*)amqpalloc_realloc(value_data->value.array_value.packed_items, (value_data->value.array_value.count + 1) * item_size);
+				if (new_packed_items == NULL)
+				{
+					result = __LINE__;
+				}
+				else
+				{
+					value_data->value.array_value.packed_items = new_packed_items;
+					(void)memcpy(new_packed_items + (value_data->value.array_value.count * item_size), &array_item_value_data->value, item_size);
+					value_data->value.array_value.count++;
+
+					result = 0;
+				}
+			}
 			else
 			{
 				AMQP_VALUE cloned_item = amqpvalue_clone(array_item_value);
@@ -1725,6 +2339,10 @@ AMQP_VALUE amqpvalue_get_array_item(AMQP_VALUE value, uint32_t index)
 		{
 			result = NULL;
 		}
+		else if (value_data->value.array_value.packed_type != AMQP_TYPE_UNKNOWN)
+		{
+			result = create_packed_array_item(value_data->value.array_value.packed_type, (const unsigned char*)value_data->value.array_value.packed_items + (index * get_packed_item_size(value_data->value.array_value.packed_type)));
+		}
 		else
 		{
 			result = amqpvalue_clone(value_data->value.array_value.items[index]);
@@ -1796,6 +2414,11 @@ bool amqpvalue_are_equal(AMQP_VALUE value1, AMQP_VALUE value2)
 		{
 			result = false;
 		}
+		else if (is_interned_value(value1_data) &&
+			is_interned_value(value2_data))
+		{
+			result = (value1_data == value2_data);
+		}
 		else
 		{
 			switch (value1_data->type)
@@ -1887,12 +2510,14 @@ bool amqpvalue_are_equal(AMQP_VALUE value1, AMQP_VALUE value2)
 
 			case AMQP_TYPE_STRING:
 				/* Codes_SRS_AMQPVALUE_01_230: [- string: compare all string characters.] */
-				result = (strcmp(value1_data->value.string_value.chars, value2_data->value.string_value.chars) == 0);
+				result = (value1_data->value.string_value.length == value2_data->value.string_value.length) &&
+					(memcmp(value1_data->value.string_value.chars, value2_data->value.string_value.chars, value1_data->value.string_value.length) == 0);
 				break;
 
 			case AMQP_TYPE_SYMBOL:
 				/* Codes_SRS_AMQPVALUE_01_263: [- symbol: compare all symbol characters.] */
-				result = (strcmp(value1_data->value.symbol_value.chars, value2_data->value.symbol_value.chars) == 0);
+				result = (value1_data->value.symbol_value.length == value2_data->value.symbol_value.length) &&
+					(memcmp(value1_data->value.symbol_value.chars, value2_data->value.symbol_value.chars, value1_data->value.symbol_value.length) == 0);
 				break;
 
 			case AMQP_TYPE_LIST:
@@ -1962,6 +2587,10 @@ AMQP_VALUE amqpvalue_clone(AMQP_VALUE value)
 	{
 		result = NULL;
 	}
+	else if (is_interned_value((AMQP_VALUE_DATA*)value))
+	{
+		result = value;
+	}
 	else
 	{
 		AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
@@ -2048,17 +2677,22 @@ AMQP_VALUE amqpvalue_clone(AMQP_VALUE value)
 
 		case AMQP_TYPE_BINARY:
 			/* Codes_SRS_AMQPVALUE_01_255: [binary] */
-			result = amqpvalue_create_binary(value_data->value.binary_value);
+		{
+			amqp_binary binary_value;
+			binary_value.bytes = value_data->value.binary_value.bytes;
+			binary_value.length = value_data->value.binary_value.length;
+			result = amqpvalue_create_binary(binary_value);
 			break;
+		}
 
 		case AMQP_TYPE_STRING:
 			/* Codes_SRS_AMQPVALUE_01_256: [string] */
-			result = amqpvalue_create_string(value_data->value.string_value.chars);
+			result = create_chars_value_copy(AMQP_TYPE_STRING, value_data->value.string_value.chars, value_data->value.string_value.length);
 			break;
 
 		case AMQP_TYPE_SYMBOL:
 			/* Codes_SRS_AMQPVALUE_01_257: [symbol] */
-			result = amqpvalue_create_symbol(value_data->value.symbol_value.chars);
+			result = create_chars_value_copy(AMQP_TYPE_SYMBOL, value_data->value.symbol_value.chars, value_data->value.symbol_value.length);
 			break;
 
 		case AMQP_TYPE_LIST:
@@ -2210,8 +2844,30 @@ AMQP_VALUE amqpvalue_clone(AMQP_VALUE value)
 			{
 				result_data->type = AMQP_TYPE_ARRAY;
 				result_data->value.array_value.count = value_data->value.array_value.count;
+				result_data->value.array_value.packed_items = NULL;
+				result_data->value.array_value.packed_type = value_data->value.array_value.packed_type;
+
+				if (value_data->value.array_value.packed_type != AMQP_TYPE_UNKNOWN)
+				{
+					size_t packed_size = value_data->value.array_value.count * get_packed_item_size(value_data->value.array_value.packed_type);
 
-				if (value_data->value.array_value.count > 0)
+					result_data->value.array_value.items = NULL;
+					if (packed_size == 0)
+					{
+						result = result_data;
+					}
+					else if ((result_data->value.array_value.packed_items = amqpalloc_malloc(packed_size)) == NULL)
+					{
+						amqpalloc_free(result_data);
+						result = NULL;
+					}
+					else
+					{
+						(void)memcpy(result_data->value.array_value.packed_items, value_data->value.array_value.packed_items, packed_size);
+						result = result_data;
+					}
+				}
+				else if (value_data->value.array_value.count > 0)
 				{
 					result_data->value.array_value.items = (AMQP_VALUE*)amqpalloc_malloc(value_data->value.array_value.count * sizeof(AMQP_VALUE));
 					if (result_data->value.array_value.items == NULL)
@@ -2749,10 +3405,9 @@ static int encode_binary(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context,
 	return result;
 }
 
-static int encode_string(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value)
+static int encode_string(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value, uint32_t length)
 {
 	int result;
-	uint32_t length = strlen(value);
 
 	if (length <= 255)
 	{
@@ -2793,10 +3448,9 @@ static int encode_string(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context,
 	return result;
 }
 
-static int encode_symbol(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value)
+static int encode_symbol(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, const char* value, uint32_t length)
 {
 	int result;
-	uint32_t length = strlen(value);
 
 	if (length <= 255)
 	{
@@ -3036,26 +3690,103 @@ static int encode_map(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, ui
 			}
 		}
 
-		if (result == 0)
+		if (result == 0)
+		{
+            /* Codes_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
+            for (i = 0; i < count; i++)
+			{
+				if ((amqpvalue_encode(pairs[i].key, encoder_output, context) != 0) ||
+					(amqpvalue_encode(pairs[i].value, encoder_output, context) != 0))
+				{
+					break;
+				}
+			}
+
+			if (i < count)
+			{
+				result = __LINE__;
+			}
+			else
+			{
+				result = 0;
+			}
+		}
+	}
+
+	return result;
+}
+
+static int encode_packed_array(AMQPVALUE_ENCODER_OUTPUT encoder_output, void* context, uint32_t count, AMQP_TYPE item_type, const unsigned char* packed_items)
+{
+	int result;
+	size_t item_size = get_packed_item_size(item_type);
+	size_t items_size = count * item_size;
+	unsigned char item_constructor = get_packed_item_constructor(item_type);
+
+	/* the element constructor is written once, followed by the raw fixed width elements */
+	if ((count <= 255) &&
+		(items_size <= 253))
+	{
+		/* array8: size and count are one byte each */
+		if ((output_byte(encoder_output, context, 0xE0) != 0) ||
+			(output_byte(encoder_output, context, (unsigned char)(items_size + 2)) != 0) ||
+			(output_byte(encoder_output, context, (unsigned char)count) != 0) ||
+			(output_byte(encoder_output, context, item_constructor) != 0))
+		{
+			result = __LINE__;
+		}
+		else
+		{
+			result = 0;
+		}
+	}
+	else
+	{
+		/* array32: size and count are four bytes each */
+		uint32_t size = (uint32_t)(items_size + 5);
+		unsigned char header[10];
+
+		header[0] = 0xF0;
+		header[1] = (size >> 24) & 0xFF;
+		header[2] = (size >> 16) & 0xFF;
+		header[3] = (size >> 8) & 0xFF;
+		header[4] = size & 0xFF;
+		header[5] = (count >> 24) & 0xFF;
+		header[6] = (count >> 16) & 0xFF;
+		header[7] = (count >> 8) & 0xFF;
+		header[8] = count & 0xFF;
+		header[9] = item_constructor;
+
+		if (output_bytes(encoder_output, context, header, sizeof(header)) != 0)
+		{
+			result = __LINE__;
+		}
+		else
+		{
+			result = 0;
+		}
+	}
+
+	if (result == 0)
+	{
+		/* byte swap into a small stack chunk and hand out whole chunks rather than single bytes */
+		unsigned char chunk[128];
+		size_t items_per_chunk = sizeof(chunk) / item_size;
+
+		while (count > 0)
 		{
-            /* Codes_SRS_AMQPVALUE_01_123: [A map is encoded as a compound value where the constituent elements form alternating key value pairs.] */
-            for (i = 0; i < count; i++)
-			{
-				if ((amqpvalue_encode(pairs[i].key, encoder_output, context) != 0) ||
-					(amqpvalue_encode(pairs[i].value, encoder_output, context) != 0))
-				{
-					break;
-				}
-			}
+			size_t chunk_items = (count < items_per_chunk) ? count : items_per_chunk;
 
-			if (i < count)
+			packed_items_to_network_order(chunk, packed_items, item_size, chunk_items);
+			if (output_bytes(encoder_output, context, chunk, chunk_items * item_size) != 0)
 			{
+				/* Codes_SRS_AMQPVALUE_01_274: [When the encoder output function fails, amqpvalue_encode shall fail and return a non-zero value.] */
 				result = __LINE__;
+				break;
 			}
-			else
-			{
-				result = 0;
-			}
+
+			packed_items += chunk_items * item_size;
+			count -= (uint32_t)chunk_items;
 		}
 	}
 
@@ -3149,11 +3880,25 @@ int amqpvalue_encode(AMQP_VALUE value, AMQPVALUE_ENCODER_OUTPUT encoder_output,
 			break;
 
 		case AMQP_TYPE_STRING:
-			result = encode_string(encoder_output, context, value_data->value.string_value.chars);
+			if (is_interned_value(value_data))
+			{
+				result = encode_interned_value(encoder_output, context, value_data);
+			}
+			else
+			{
+				result = encode_string(encoder_output, context, value_data->value.string_value.chars, value_data->value.string_value.length);
+			}
 			break;
 
 		case AMQP_TYPE_SYMBOL:
-			result = encode_symbol(encoder_output, context, value_data->value.symbol_value.chars);
+			if (is_interned_value(value_data))
+			{
+				result = encode_interned_value(encoder_output, context, value_data);
+			}
+			else
+			{
+				result = encode_symbol(encoder_output, context, value_data->value.symbol_value.chars, value_data->value.symbol_value.length);
+			}
 			break;
 
 		case AMQP_TYPE_LIST:
@@ -3164,6 +3909,18 @@ int amqpvalue_encode(AMQP_VALUE value, AMQPVALUE_ENCODER_OUTPUT encoder_output,
 			result = encode_map(encoder_output, context, value_data->value.map_value.pair_count, value_data->value.map_value.pairs);
 			break;
 
+		case AMQP_TYPE_ARRAY:
+			if (value_data->value.array_value.packed_type != AMQP_TYPE_UNKNOWN)
+			{
+				result = encode_packed_array(encoder_output, context, value_data->value.array_value.count, value_data->value.array_value.packed_type, (const unsigned char*)value_data->value.array_value.packed_items);
+			}
+			else
+			{
+				/* only packed arrays can be encoded for now */
+				result = __LINE__;
+			}
+			break;
+
 		case AMQP_TYPE_COMPOSITE:
 		case AMQP_TYPE_DESCRIBED:
 		{
@@ -3221,19 +3978,22 @@ static void amqpvalue_clear(AMQP_VALUE_DATA* value_data)
 	default:
 		break;
 	case AMQP_TYPE_BINARY:
-		if (value_data->value.binary_value.bytes != NULL)
+		if ((!value_data->value.binary_value.is_view) &&
+			(value_data->value.binary_value.bytes != NULL))
 		{
 			amqpalloc_free((void*)value_data->value.binary_value.bytes);
 		}
 		break;
 	case AMQP_TYPE_STRING:
-		if (value_data->value.string_value.chars != NULL)
+		if ((!value_data->value.string_value.is_view) &&
+			(value_data->value.string_value.chars != NULL))
 		{
 			amqpalloc_free(value_data->value.string_value.chars);
 		}
 		break;
 	case AMQP_TYPE_SYMBOL:
-		if (value_data->value.symbol_value.chars != NULL)
+		if ((!value_data->value.symbol_value.is_view) &&
+			(value_data->value.symbol_value.chars != NULL))
 		{
 			amqpalloc_free(value_data->value.symbol_value.chars);
 		}
@@ -3265,14 +4025,25 @@ static void amqpvalue_clear(AMQP_VALUE_DATA* value_data)
 	}
 	case AMQP_TYPE_ARRAY:
 	{
-		size_t i;
-		for (i = 0; i < value_data->value.array_value.count; i++)
+		if (value_data->value.array_value.packed_type != AMQP_TYPE_UNKNOWN)
 		{
-			amqpvalue_destroy(value_data->value.array_value.items[i]);
+			if (value_data->value.array_value.packed_items != NULL)
+			{
+				amqpalloc_free(value_data->value.array_value.packed_items);
+				value_data->value.array_value.packed_items = NULL;
+			}
 		}
+		else
+		{
+			size_t i;
+			for (i = 0; i < value_data->value.array_value.count; i++)
+			{
+				amqpvalue_destroy(value_data->value.array_value.items[i]);
+			}
 
-		amqpalloc_free(value_data->value.array_value.items);
-		value_data->value.array_value.items = NULL;
+			amqpalloc_free(value_data->value.array_value.items);
+			value_data->value.array_value.items = NULL;
+		}
 		break;
 	}
 	case AMQP_TYPE_COMPOSITE:
@@ -3288,7 +4059,8 @@ static void amqpvalue_clear(AMQP_VALUE_DATA* value_data)
 void amqpvalue_destroy(AMQP_VALUE value)
 {
 	/* Codes_SRS_AMQPVALUE_01_315: [If the value argument is NULL, amqpvalue_destroy shall do nothing.] */
-	if (value != NULL)
+	if ((value != NULL) &&
+		(!is_interned_value((AMQP_VALUE_DATA*)value)))
 	{
 		/* Codes_SRS_AMQPVALUE_01_314: [amqpvalue_destroy shall free all resources allocated by any of the amqpvalue_create_xxx functions or amqpvalue_clone.] */
 		AMQP_VALUE_DATA* value_data = (AMQP_VALUE_DATA*)value;
@@ -3297,7 +4069,7 @@ void amqpvalue_destroy(AMQP_VALUE value)
 	}
 }
 
-static INTERNAL_DECODER_DATA* internal_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context, AMQP_VALUE_DATA* value_data)
+static INTERNAL_DECODER_DATA* internal_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context, AMQP_VALUE_DATA* value_data, bool decode_in_place)
 {
 	INTERNAL_DECODER_DATA* internal_decoder_data = (INTERNAL_DECODER_DATA*)amqpalloc_malloc(sizeof(INTERNAL_DECODER_DATA));
 	if (internal_decoder_data != NULL)
@@ -3307,6 +4079,7 @@ static INTERNAL_DECODER_DATA* internal_decoder_create(ON_VALUE_DECODED on_value_
 		internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
 		internal_decoder_data->inner_decoder = NULL;
 		internal_decoder_data->decode_to_value = value_data;
+		internal_decoder_data->decode_in_place = decode_in_place;
 	}
 
 	return internal_decoder_data;
@@ -3373,7 +4146,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 					{
 						descriptor->type = AMQP_TYPE_UNKNOWN;
 						internal_decoder_data->decode_to_value->value.described_value.descriptor = descriptor;
-						internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, descriptor);
+						internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, descriptor, internal_decoder_data->decode_in_place);
 						if (internal_decoder_data->inner_decoder == NULL)
 						{
 							internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -3653,6 +4426,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 					internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
 					internal_decoder_data->decode_to_value->value.binary_value.length = 0;
 					internal_decoder_data->decode_to_value->value.binary_value.bytes = NULL;
+					internal_decoder_data->decode_to_value->value.binary_value.is_view = false;
 					internal_decoder_data->bytes_decoded = 0;
 
 					/* Codes_SRS_AMQPVALUE_01_327: [If not enough bytes have accumulated to decode a value, the on_value_decoded shall not be called.] */
@@ -3668,6 +4442,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 					internal_decoder_data->decode_to_value->type = AMQP_TYPE_STRING;
 					internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
 					internal_decoder_data->decode_to_value->value.string_value.chars = NULL;
+					internal_decoder_data->decode_to_value->value.string_value.is_view = false;
 					internal_decoder_data->decode_value_state.string_value_state.length = 0;
 					internal_decoder_data->bytes_decoded = 0;
 
@@ -3684,6 +4459,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 					internal_decoder_data->decode_to_value->type = AMQP_TYPE_SYMBOL;
 					internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
 					internal_decoder_data->decode_to_value->value.symbol_value.chars = NULL;
+					internal_decoder_data->decode_to_value->value.symbol_value.is_view = false;
 					internal_decoder_data->decode_value_state.symbol_value_state.length = 0;
 					internal_decoder_data->bytes_decoded = 0;
 
@@ -3736,8 +4512,10 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 				case 0xF0:
 					internal_decoder_data->decode_to_value->type = AMQP_TYPE_ARRAY;
 					internal_decoder_data->decoder_state = DECODER_STATE_TYPE_DATA;
-					internal_decoder_data->decode_to_value->value.list_value.count = 0;
-					internal_decoder_data->decode_to_value->value.list_value.items = NULL;
+					internal_decoder_data->decode_to_value->value.array_value.count = 0;
+					internal_decoder_data->decode_to_value->value.array_value.items = NULL;
+					internal_decoder_data->decode_to_value->value.array_value.packed_items = NULL;
+					internal_decoder_data->decode_to_value->value.array_value.packed_type = AMQP_TYPE_UNKNOWN;
 					internal_decoder_data->bytes_decoded = 0;
 					internal_decoder_data->decode_value_state.list_value_state.list_value_state = DECODE_ARRAY_STEP_SIZE;
 
@@ -3791,7 +4569,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 								{
 									described_value->type = AMQP_TYPE_UNKNOWN;
 									internal_decoder_data->decode_to_value->value.described_value.value = (AMQP_VALUE)described_value;
-									internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, described_value);
+									internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, described_value, internal_decoder_data->decode_in_place);
 									if (internal_decoder_data->inner_decoder == NULL)
 									{
 										internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -4154,6 +4932,19 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 							internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
 							result = 0;
 						}
+						else if ((internal_decoder_data->decode_in_place) &&
+							(size >= internal_decoder_data->decode_to_value->value.binary_value.length))
+						{
+							/* all the bytes are in this buffer, reference them instead of copying them */
+							internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)buffer;
+							internal_decoder_data->decode_to_value->value.binary_value.is_view = true;
+							buffer += internal_decoder_data->decode_to_value->value.binary_value.length;
+							size -= internal_decoder_data->decode_to_value->value.binary_value.length;
+							internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+							internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+							result = 0;
+						}
 						else
 						{
 							internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)amqpalloc_malloc(internal_decoder_data->decode_to_value->value.binary_value.length);
@@ -4220,6 +5011,19 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 								internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
 								result = 0;
 							}
+							else if ((internal_decoder_data->decode_in_place) &&
+								(size >= internal_decoder_data->decode_to_value->value.binary_value.length))
+							{
+								/* all the bytes are in this buffer, reference them instead of copying them */
+								internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)buffer;
+								internal_decoder_data->decode_to_value->value.binary_value.is_view = true;
+								buffer += internal_decoder_data->decode_to_value->value.binary_value.length;
+								size -= internal_decoder_data->decode_to_value->value.binary_value.length;
+								internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+								internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+								result = 0;
+							}
 							else
 							{
 								internal_decoder_data->decode_to_value->value.binary_value.bytes = (unsigned char*)amqpalloc_malloc(internal_decoder_data->decode_to_value->value.binary_value.length + 1);
@@ -4281,26 +5085,43 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 						buffer++;
 						size--;
 
-						internal_decoder_data->decode_to_value->value.string_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.string_value_state.length + 1);
-						if (internal_decoder_data->decode_to_value->value.string_value.chars == NULL)
+						internal_decoder_data->decode_to_value->value.string_value.length = internal_decoder_data->decode_value_state.string_value_state.length;
+						if ((internal_decoder_data->decode_in_place) &&
+							(size >= internal_decoder_data->decode_value_state.string_value_state.length))
 						{
-							/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-							internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
-							result = __LINE__;
+							/* all the characters are in this buffer, reference them instead of copying them */
+							internal_decoder_data->decode_to_value->value.string_value.chars = (char*)buffer;
+							internal_decoder_data->decode_to_value->value.string_value.is_view = true;
+							buffer += internal_decoder_data->decode_value_state.string_value_state.length;
+							size -= internal_decoder_data->decode_value_state.string_value_state.length;
+							internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+							internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+							result = 0;
 						}
 						else
 						{
-							if (internal_decoder_data->decode_value_state.string_value_state.length == 0)
+							internal_decoder_data->decode_to_value->value.string_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.string_value_state.length + 1);
+							if (internal_decoder_data->decode_to_value->value.string_value.chars == NULL)
 							{
-								internal_decoder_data->decode_to_value->value.string_value.chars[0] = '\0';
-
-								/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-								/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-								/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-								internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+								/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+								internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+								result = __LINE__;
 							}
+							else
+							{
+								if (internal_decoder_data->decode_value_state.string_value_state.length == 0)
+								{
+									internal_decoder_data->decode_to_value->value.string_value.chars[0] = '\0';
 
-							result = 0;
+									/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+									/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+									/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+									internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+								}
+
+								result = 0;
+							}
 						}
 					}
 					else
@@ -4350,26 +5171,43 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 
 						if (internal_decoder_data->bytes_decoded == 4)
 						{
-							internal_decoder_data->decode_to_value->value.string_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.string_value_state.length + 1);
-							if (internal_decoder_data->decode_to_value->value.string_value.chars == NULL)
+							internal_decoder_data->decode_to_value->value.string_value.length = internal_decoder_data->decode_value_state.string_value_state.length;
+							if ((internal_decoder_data->decode_in_place) &&
+								(size >= internal_decoder_data->decode_value_state.string_value_state.length))
 							{
-								/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-								internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
-								result = __LINE__;
+								/* all the characters are in this buffer, reference them instead of copying them */
+								internal_decoder_data->decode_to_value->value.string_value.chars = (char*)buffer;
+								internal_decoder_data->decode_to_value->value.string_value.is_view = true;
+								buffer += internal_decoder_data->decode_value_state.string_value_state.length;
+								size -= internal_decoder_data->decode_value_state.string_value_state.length;
+								internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+								internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+								result = 0;
 							}
 							else
 							{
-								if (internal_decoder_data->decode_value_state.string_value_state.length == 0)
+								internal_decoder_data->decode_to_value->value.string_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.string_value_state.length + 1);
+								if (internal_decoder_data->decode_to_value->value.string_value.chars == NULL)
 								{
-									internal_decoder_data->decode_to_value->value.string_value.chars[0] = '\0';
-
-									/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-									/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-									/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-									internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+									/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+									internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+									result = __LINE__;
 								}
+								else
+								{
+									if (internal_decoder_data->decode_value_state.string_value_state.length == 0)
+									{
+										internal_decoder_data->decode_to_value->value.string_value.chars[0] = '\0';
 
-								result = 0;
+										/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+										/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+										/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+										internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+									}
+
+									result = 0;
+								}
 							}
 						}
 						else
@@ -4422,26 +5260,43 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 						buffer++;
 						size--;
 
-						internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.symbol_value_state.length + 1);
-						if (internal_decoder_data->decode_to_value->value.symbol_value.chars == NULL)
+						internal_decoder_data->decode_to_value->value.symbol_value.length = internal_decoder_data->decode_value_state.symbol_value_state.length;
+						if ((internal_decoder_data->decode_in_place) &&
+							(size >= internal_decoder_data->decode_value_state.symbol_value_state.length))
 						{
-							/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-							internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
-							result = __LINE__;
+							/* all the characters are in this buffer, reference them instead of copying them */
+							internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)buffer;
+							internal_decoder_data->decode_to_value->value.symbol_value.is_view = true;
+							buffer += internal_decoder_data->decode_value_state.symbol_value_state.length;
+							size -= internal_decoder_data->decode_value_state.symbol_value_state.length;
+							internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+							internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+							result = 0;
 						}
 						else
 						{
-							if (internal_decoder_data->decode_value_state.symbol_value_state.length == 0)
+							internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.symbol_value_state.length + 1);
+							if (internal_decoder_data->decode_to_value->value.symbol_value.chars == NULL)
 							{
-								internal_decoder_data->decode_to_value->value.symbol_value.chars[0] = '\0';
-
-								/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-								/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-								/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-								internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+								/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+								internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+								result = __LINE__;
 							}
+							else
+							{
+								if (internal_decoder_data->decode_value_state.symbol_value_state.length == 0)
+								{
+									internal_decoder_data->decode_to_value->value.symbol_value.chars[0] = '\0';
 
-							result = 0;
+									/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+									/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+									/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+									internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+								}
+
+								result = 0;
+							}
 						}
 					}
 					else
@@ -4491,26 +5346,43 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 
 						if (internal_decoder_data->bytes_decoded == 4)
 						{
-							internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.symbol_value_state.length + 1);
-							if (internal_decoder_data->decode_to_value->value.symbol_value.chars == NULL)
+							internal_decoder_data->decode_to_value->value.symbol_value.length = internal_decoder_data->decode_value_state.symbol_value_state.length;
+							if ((internal_decoder_data->decode_in_place) &&
+								(size >= internal_decoder_data->decode_value_state.symbol_value_state.length))
 							{
-								/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
-								internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
-								result = __LINE__;
+								/* all the characters are in this buffer, reference them instead of copying them */
+								internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)buffer;
+								internal_decoder_data->decode_to_value->value.symbol_value.is_view = true;
+								buffer += internal_decoder_data->decode_value_state.symbol_value_state.length;
+								size -= internal_decoder_data->decode_value_state.symbol_value_state.length;
+								internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+
+								internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+								result = 0;
 							}
 							else
 							{
-								if (internal_decoder_data->decode_value_state.symbol_value_state.length == 0)
+								internal_decoder_data->decode_to_value->value.symbol_value.chars = (char*)amqpalloc_malloc(internal_decoder_data->decode_value_state.symbol_value_state.length + 1);
+								if (internal_decoder_data->decode_to_value->value.symbol_value.chars == NULL)
 								{
-									internal_decoder_data->decode_to_value->value.symbol_value.chars[0] = '\0';
-
-									/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
-									/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
-									/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
-									internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+									/* Codes_SRS_AMQPVALUE_01_326: [If any allocation failure occurs during decoding, amqpvalue_decode_bytes shall fail and return a non-zero value.] */
+									internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+									result = __LINE__;
 								}
+								else
+								{
+									if (internal_decoder_data->decode_value_state.symbol_value_state.length == 0)
+									{
+										internal_decoder_data->decode_to_value->value.symbol_value.chars[0] = '\0';
 
-								result = 0;
+										/* Codes_SRS_AMQPVALUE_01_323: [When enough bytes have been processed for a valid amqp value, the on_value_decoded passed in amqpvalue_decoder_create shall be called.] */
+										/* Codes_SRS_AMQPVALUE_01_324: [The decoded amqp value shall be passed to on_value_decoded.] */
+										/* Codes_SRS_AMQPVALUE_01_325: [Also the context stored in amqpvalue_decoder_create shall be passed to the on_value_decoded callback.] */
+										internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+									}
+
+									result = 0;
+								}
 							}
 						}
 						else
@@ -4698,7 +5570,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 							{
 								list_item->type = AMQP_TYPE_UNKNOWN;
 								internal_decoder_data->decode_to_value->value.list_value.items[internal_decoder_data->decode_value_state.list_value_state.item] = list_item;
-								internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, list_item);
+								internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, list_item, internal_decoder_data->decode_in_place);
 								if (internal_decoder_data->inner_decoder == NULL)
 								{
 									internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -4906,7 +5778,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 								{
 									internal_decoder_data->decode_to_value->value.map_value.pairs[internal_decoder_data->decode_value_state.map_value_state.item].value = map_item;
 								}
-								internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, map_item);
+								internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, map_item, internal_decoder_data->decode_in_place);
 								if (internal_decoder_data->inner_decoder == NULL)
 								{
 									internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -5085,6 +5957,34 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 					{
 						size_t used_bytes;
 
+						if ((internal_decoder_data->bytes_decoded == 0) &&
+							(internal_decoder_data->decode_value_state.array_value_state.item == 0) &&
+							(get_packed_item_type(buffer[0]) != AMQP_TYPE_UNKNOWN))
+						{
+							/* fixed width numeric elements are copied into one packed buffer instead of one AMQP_VALUE per element */
+							AMQP_TYPE packed_type = get_packed_item_type(buffer[0]);
+							void* packed_items = amqpalloc_malloc(internal_decoder_data->decode_to_value->value.array_value.count * get_packed_item_size(packed_type));
+							if (packed_items == NULL)
+							{
+								internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
+								result = __LINE__;
+							}
+							else
+							{
+								amqpalloc_free(internal_decoder_data->decode_to_value->value.array_value.items);
+								internal_decoder_data->decode_to_value->value.array_value.items = NULL;
+								internal_decoder_data->decode_to_value->value.array_value.packed_items = packed_items;
+								internal_decoder_data->decode_to_value->value.array_value.packed_type = packed_type;
+								internal_decoder_data->decode_value_state.array_value_state.array_value_state = DECODE_ARRAY_STEP_PACKED_ITEMS;
+								internal_decoder_data->bytes_decoded = 0;
+								buffer++;
+								size--;
+								result = 0;
+							}
+
+							break;
+						}
+
 						if (internal_decoder_data->bytes_decoded == 0)
 						{
 							internal_decoder_data->decode_value_state.array_value_state.constructor_byte = buffer[0];
@@ -5099,7 +5999,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 							{
 								array_item->type = AMQP_TYPE_UNKNOWN;
 								internal_decoder_data->decode_to_value->value.array_value.items[internal_decoder_data->decode_value_state.array_value_state.item] = array_item;
-								internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, array_item);
+								internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, array_item, internal_decoder_data->decode_in_place);
 								if (internal_decoder_data->inner_decoder == NULL)
 								{
 									internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -5152,7 +6052,7 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 									{
 										array_item->type = AMQP_TYPE_UNKNOWN;
 										internal_decoder_data->decode_to_value->value.array_value.items[internal_decoder_data->decode_value_state.array_value_state.item] = array_item;
-										internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, array_item);
+										internal_decoder_data->inner_decoder = internal_decoder_create(inner_decoder_callback, internal_decoder_data, array_item, internal_decoder_data->decode_in_place);
 										if (internal_decoder_data->inner_decoder == NULL)
 										{
 											internal_decoder_data->decoder_state = DECODER_STATE_ERROR;
@@ -5180,6 +6080,36 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 
 						break;
 					}
+
+					case DECODE_ARRAY_STEP_PACKED_ITEMS:
+					{
+						AMQP_ARRAY_VALUE* array_value = &internal_decoder_data->decode_to_value->value.array_value;
+						size_t item_size = get_packed_item_size(array_value->packed_type);
+						size_t total_bytes = array_value->count * item_size;
+						size_t to_copy = total_bytes - internal_decoder_data->bytes_decoded;
+
+						if (to_copy > size)
+						{
+							to_copy = size;
+						}
+
+						(void)memcpy((unsigned char*)array_value->packed_items + internal_decoder_data->bytes_decoded, buffer, to_copy);
+						internal_decoder_data->bytes_decoded += to_copy;
+						buffer += to_copy;
+						size -= to_copy;
+
+						if (internal_decoder_data->bytes_decoded == total_bytes)
+						{
+							/* all elements are in, swap them to native order in one pass */
+							packed_items_from_network_order((unsigned char*)array_value->packed_items, (const unsigned char*)array_value->packed_items, item_size, array_value->count);
+
+							internal_decoder_data->decoder_state = DECODER_STATE_CONSTRUCTOR;
+							internal_decoder_data->on_value_decoded(internal_decoder_data->on_value_decoded_context, internal_decoder_data->decode_to_value);
+						}
+
+						result = 0;
+						break;
+					}
 					}
 
 					break;
@@ -5204,7 +6134,19 @@ int internal_decoder_decode_bytes(INTERNAL_DECODER_DATA* internal_decoder_data,
 	return result;
 }
 
-AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context)
+static void decoder_value_decoded(void* context, AMQP_VALUE decoded_value)
+{
+	DECODER_DATA* decoder_instance = (DECODER_DATA*)context;
+	decoder_instance->on_value_decoded(decoder_instance->on_value_decoded_context, decoded_value);
+
+	if (decoder_instance->stop_after_value)
+	{
+		/* stop the decoder loop right after this value, the rest of the buffer belongs to the caller */
+		decoder_instance->internal_decoder->decoder_state = DECODER_STATE_DONE;
+	}
+}
+
+static AMQPVALUE_DECODER_HANDLE decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context, bool decode_in_place)
 {
 	DECODER_DATA* decoder_instance;
 
@@ -5229,7 +6171,10 @@ AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create(ON_VALUE_DECODED on_value_deco
 			else
 			{
 				decoder_instance->decode_to_value->type = AMQP_TYPE_UNKNOWN;
-				decoder_instance->internal_decoder = internal_decoder_create(on_value_decoded, callback_context, decoder_instance->decode_to_value);
+				decoder_instance->on_value_decoded = on_value_decoded;
+				decoder_instance->on_value_decoded_context = callback_context;
+				decoder_instance->stop_after_value = false;
+				decoder_instance->internal_decoder = internal_decoder_create(decoder_value_decoded, decoder_instance, decoder_instance->decode_to_value, decode_in_place);
 				if (decoder_instance->internal_decoder == NULL)
 				{
 					/* Codes_SRS_AMQPVALUE_01_313: [If creating the decoder fails, amqpvalue_decoder_create shall return NULL.] */
@@ -5245,6 +6190,20 @@ AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create(ON_VALUE_DECODED on_value_deco
 	return decoder_instance;
 }
 
+AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context)
+{
+	return decoder_create(on_value_decoded, callback_context, false);
+}
+
+/* Strings, symbols and binary values whose bytes are entirely contained in the buffer given to a decode call
+reference that buffer instead of being copied. The caller has to keep the buffer alive for as long as the
+decoded values are used, which for the decoder callback means at least until the decode call returns.
+amqpvalue_clone produces an owned deep copy for values that need to outlive the buffer. */
+AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create_in_place(ON_VALUE_DECODED on_value_decoded, void* callback_context)
+{
+	return decoder_create(on_value_decoded, callback_context, true);
+}
+
 void amqpvalue_decoder_destroy(AMQPVALUE_DECODER_HANDLE handle)
 {
 	DECODER_DATA* decoder_instance = (DECODER_DATA*)handle;
@@ -5292,6 +6251,42 @@ int amqpvalue_decode_bytes(AMQPVALUE_DECODER_HANDLE handle, const unsigned char*
 	return result;
 }
 
+int amqpvalue_decode_single_value(AMQPVALUE_DECODER_HANDLE handle, const unsigned char* buffer, size_t size, size_t* used_bytes)
+{
+	int result;
+
+	DECODER_DATA* decoder_instance = (DECODER_DATA*)handle;
+	if ((decoder_instance == NULL) ||
+		(buffer == NULL) ||
+		(size == 0) ||
+		(used_bytes == NULL))
+	{
+		result = __LINE__;
+	}
+	else
+	{
+		decoder_instance->stop_after_value = true;
+
+		if (internal_decoder_decode_bytes(decoder_instance->internal_decoder, buffer, size, used_bytes) != 0)
+		{
+			result = __LINE__;
+		}
+		else
+		{
+			if (decoder_instance->internal_decoder->decoder_state == DECODER_STATE_DONE)
+			{
+				decoder_instance->internal_decoder->decoder_state = DECODER_STATE_CONSTRUCTOR;
+			}
+
+			result = 0;
+		}
+
+		decoder_instance->stop_after_value = false;
+	}
+
+	return result;
+}
+
 AMQP_VALUE amqpvalue_get_inplace_descriptor(AMQP_VALUE value)
 {
 	AMQP_VALUE result;
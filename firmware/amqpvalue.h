@@ -94,6 +94,8 @@ extern "C" {
 	extern AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create(ON_VALUE_DECODED on_value_decoded, void* callback_context);
 	extern void amqpvalue_decoder_destroy(AMQPVALUE_DECODER_HANDLE handle);
 	extern int amqpvalue_decode_bytes(AMQPVALUE_DECODER_HANDLE handle, const unsigned char* buffer, size_t size);
+	extern AMQPVALUE_DECODER_HANDLE amqpvalue_decoder_create_in_place(ON_VALUE_DECODED on_value_decoded, void* callback_context);
+	extern int amqpvalue_decode_single_value(AMQPVALUE_DECODER_HANDLE handle, const unsigned char* buffer, size_t size, size_t* used_bytes);
 
 	/* misc for now */
 	extern AMQP_VALUE amqpvalue_create_array(void);
@@ -101,6 +103,8 @@ extern "C" {
 	extern int amqpvalue_add_array_item(AMQP_VALUE value, AMQP_VALUE array_item_value);
 	extern AMQP_VALUE amqpvalue_get_array_item(AMQP_VALUE value, uint32_t index);
 	extern int amqpvalue_get_array(AMQP_VALUE value, AMQP_VALUE* array_value);
+	extern AMQP_VALUE amqpvalue_create_array_from_typed(AMQP_TYPE item_type, const void* items, uint32_t count);
+	extern int amqpvalue_get_array_as_typed(AMQP_VALUE value, AMQP_TYPE item_type, const void** items, uint32_t* count);
 
 	extern AMQP_VALUE amqpvalue_get_inplace_descriptor(AMQP_VALUE value);
 	extern AMQP_VALUE amqpvalue_get_inplace_described_value(AMQP_VALUE value);
@@ -0,0 +1,403 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* a host tool, it replays the captures xio_capture_load reads from files */
+#if defined(__unix__) || defined(__APPLE__) || defined(_WIN32)
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "gballoc.h"
+#include "iot_logging.h"
+#include "mqtt_codec.h"
+#include "frame_codec.h"
+#include "sasl_frame_codec.h"
+#include "amqp_frame_codec.h"
+#include "codec_replay.h"
+
+#define AMQP_PROTOCOL_HEADER_SIZE   8
+#define AMQP_FRAME_HEADER_SIZE      8
+
+/* one direction of the capture: all bytes back to back, split into chunks, chunks grouped into connections */
+typedef struct REPLAY_STREAMS_TAG
+{
+    unsigned char* bytes;
+    size_t* chunk_sizes;
+    size_t chunk_count;
+    /* first chunk of every connection, connection_starts[connection_count] is chunk_count */
+    size_t* connection_starts;
+    size_t connection_count;
+} REPLAY_STREAMS;
+
+typedef struct REPLAY_DECODER_TAG
+{
+    MQTTCODEC_HANDLE mqtt_codec;
+    FRAME_CODEC_HANDLE frame_codec;
+    SASL_FRAME_CODEC_HANDLE sasl_frame_codec;
+    AMQP_FRAME_CODEC_HANDLE amqp_frame_codec;
+    size_t packets;
+    size_t errors;
+} REPLAY_DECODER;
+
+static int collect_streams(const XIO_CAPTURE_RECORD* records, size_t record_count, XIO_CAPTURE_RECORD_TYPE direction, REPLAY_STREAMS* streams)
+{
+    int result;
+    size_t total_size = 0;
+    size_t i;
+
+    for (i = 0; i < record_count; i++)
+    {
+        if (records[i].type == direction)
+        {
+            total_size += records[i].size;
+        }
+    }
+
+    streams->bytes = (unsigned char*)malloc((total_size == 0) ? 1 : total_size);
+    streams->chunk_sizes = (size_t*)malloc((record_count + 1) * sizeof(size_t));
+    streams->connection_starts = (size_t*)malloc((record_count + 2) * sizeof(size_t));
+    streams->chunk_count = 0;
+    streams->connection_count = 0;
+
+    if ((streams->bytes == NULL) || (streams->chunk_sizes == NULL) || (streams->connection_starts == NULL))
+    {
+        LogError("Failure allocating the replay streams.\r\n");
+        free(streams->bytes);
+        free(streams->chunk_sizes);
+        free(streams->connection_starts);
+        result = __LINE__;
+    }
+    else
+    {
+        size_t position = 0;
+
+        /* the current connection starts at chunk_count as long as it has no chunks */
+        streams->connection_starts[0] = 0;
+        for (i = 0; i < record_count; i++)
+        {
+            if (records[i].type == XIO_CAPTURE_OPEN)
+            {
+                /* connections without bytes in this direction are left out */
+                if (streams->chunk_count > streams->connection_starts[streams->connection_count])
+                {
+                    streams->connection_starts[++streams->connection_count] = streams->chunk_count;
+                }
+            }
+            else if ((records[i].type == direction) && (records[i].size > 0))
+            {
+                (void)memcpy(streams->bytes + position, records[i].bytes, records[i].size);
+                position += records[i].size;
+                streams->chunk_sizes[streams->chunk_count++] = records[i].size;
+            }
+        }
+
+        if (streams->chunk_count > streams->connection_starts[streams->connection_count])
+        {
+            streams->connection_starts[++streams->connection_count] = streams->chunk_count;
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+static void destroy_streams(REPLAY_STREAMS* streams)
+{
+    free(streams->bytes);
+    free(streams->chunk_sizes);
+    free(streams->connection_starts);
+}
+
+static uint32_t get_frame_size(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+/* frame_codec only understands frames, so the protocol headers ("AMQP" and 4 more bytes, before SASL and before AMQP)
+   are cut out of every connection in place, shrinking the chunks they were read in */
+static void strip_amqp_headers(REPLAY_STREAMS* streams)
+{
+    unsigned char* source = streams->bytes;
+    unsigned char* destination = streams->bytes;
+    size_t connection;
+
+    for (connection = 0; connection < streams->connection_count; connection++)
+    {
+        size_t first_chunk = streams->connection_starts[connection];
+        size_t last_chunk = streams->connection_starts[connection + 1];
+        unsigned char* connection_end = source;
+        unsigned char* boundary = source;
+        unsigned char* skip_end = source;
+        size_t chunk;
+
+        for (chunk = first_chunk; chunk < last_chunk; chunk++)
+        {
+            connection_end += streams->chunk_sizes[chunk];
+        }
+
+        for (chunk = first_chunk; chunk < last_chunk; chunk++)
+        {
+            unsigned char* chunk_end = source + streams->chunk_sizes[chunk];
+            size_t kept = 0;
+
+            while (source < chunk_end)
+            {
+                if (source < skip_end)
+                {
+                    source = (skip_end < chunk_end) ? skip_end : chunk_end;
+                }
+                else
+                {
+                    unsigned char* copy_end;
+
+                    if (source == boundary)
+                    {
+                        size_t available = connection_end - source;
+                        if ((available >= AMQP_PROTOCOL_HEADER_SIZE) && (memcmp(source, "AMQP", 4) == 0))
+                        {
+                            skip_end = source + AMQP_PROTOCOL_HEADER_SIZE;
+                            boundary = skip_end;
+                            continue;
+                        }
+                        else if ((available >= 4) && (get_frame_size(source) >= AMQP_FRAME_HEADER_SIZE) && (get_frame_size(source) <= available))
+                        {
+                            boundary = source + get_frame_size(source);
+                        }
+                        else
+                        {
+                            /* a truncated or corrupt frame, handed to frame_codec as it is */
+                            boundary = connection_end;
+                        }
+                    }
+
+                    copy_end = (boundary < chunk_end) ? boundary : chunk_end;
+                    (void)memmove(destination, source, copy_end - source);
+                    destination += copy_end - source;
+                    kept += copy_end - source;
+                    source = copy_end;
+                }
+            }
+
+            streams->chunk_sizes[chunk] = kept;
+        }
+    }
+}
+
+static void on_mqtt_packet(void* context, CONTROL_PACKET_TYPE packet, int flags, BUFFER_HANDLE headerData)
+{
+    (void)packet;
+    (void)flags;
+    (void)headerData;
+    ((REPLAY_DECODER*)context)->packets++;
+}
+
+static void on_amqp_frame(void* context, uint16_t channel, AMQP_VALUE performative, const unsigned char* payload_bytes, uint32_t frame_payload_size)
+{
+    (void)channel;
+    (void)performative;
+    (void)payload_bytes;
+    (void)frame_payload_size;
+    ((REPLAY_DECODER*)context)->packets++;
+}
+
+static void on_amqp_empty_frame(void* context, uint16_t channel)
+{
+    (void)channel;
+    ((REPLAY_DECODER*)context)->packets++;
+}
+
+static void on_sasl_frame(void* context, AMQP_VALUE sasl_frame_value)
+{
+    (void)sasl_frame_value;
+    ((REPLAY_DECODER*)context)->packets++;
+}
+
+static void on_decoder_error(void* context)
+{
+    ((REPLAY_DECODER*)context)->errors++;
+}
+
+static int create_decoder(CODEC_REPLAY_PROTOCOL protocol, REPLAY_DECODER* decoder)
+{
+    int result;
+
+    decoder->mqtt_codec = NULL;
+    decoder->frame_codec = NULL;
+    decoder->sasl_frame_codec = NULL;
+    decoder->amqp_frame_codec = NULL;
+
+    if (protocol == CODEC_REPLAY_MQTT)
+    {
+        result = ((decoder->mqtt_codec = mqtt_codec_create(on_mqtt_packet, decoder)) == NULL) ? __LINE__ : 0;
+    }
+    else if (((decoder->frame_codec = frame_codec_create(on_decoder_error, decoder, NULL)) == NULL) ||
+        /* the captured peer already enforced its negotiated maximum */
+        (frame_codec_set_max_frame_size(decoder->frame_codec, UINT32_MAX) != 0) ||
+        ((decoder->sasl_frame_codec = sasl_frame_codec_create(decoder->frame_codec, on_sasl_frame, on_decoder_error, decoder)) == NULL) ||
+        ((decoder->amqp_frame_codec = amqp_frame_codec_create(decoder->frame_codec, on_amqp_frame, on_amqp_empty_frame, on_decoder_error, decoder)) == NULL))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void destroy_decoder(REPLAY_DECODER* decoder)
+{
+    if (decoder->amqp_frame_codec != NULL)
+    {
+        amqp_frame_codec_destroy(decoder->amqp_frame_codec);
+    }
+    if (decoder->sasl_frame_codec != NULL)
+    {
+        sasl_frame_codec_destroy(decoder->sasl_frame_codec);
+    }
+    if (decoder->frame_codec != NULL)
+    {
+        frame_codec_destroy(decoder->frame_codec);
+    }
+    if (decoder->mqtt_codec != NULL)
+    {
+        mqtt_codec_destroy(decoder->mqtt_codec);
+    }
+}
+
+static int feed_decoder(REPLAY_DECODER* decoder, const unsigned char* bytes, size_t size)
+{
+    return (decoder->mqtt_codec != NULL) ? mqtt_codec_bytesReceived(decoder->mqtt_codec, bytes, size) : frame_codec_receive_bytes(decoder->frame_codec, bytes, size);
+}
+
+/* feeds one connection, stopping at the first error since the decoders do not recover from one */
+static int replay_connection(const CODEC_REPLAY_CONFIG* config, const unsigned char* bytes, const size_t* chunk_sizes, size_t chunk_count, CODEC_REPLAY_REPORT* report)
+{
+    int result;
+    REPLAY_DECODER decoder;
+
+    decoder.packets = 0;
+    decoder.errors = 0;
+
+    if (create_decoder(config->protocol, &decoder) != 0)
+    {
+        LogError("Failure creating the replay decoders.\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        size_t size = 0;
+        size_t position = 0;
+        size_t i;
+
+        for (i = 0; i < chunk_count; i++)
+        {
+            size += chunk_sizes[i];
+        }
+
+        for (i = 0; (position < size) && (decoder.errors == 0); i++)
+        {
+            size_t chunk = (config->chunk_size != 0) ? config->chunk_size : chunk_sizes[i];
+            if (chunk > size - position)
+            {
+                chunk = size - position;
+            }
+
+            if ((chunk > 0) && (feed_decoder(&decoder, bytes + position, chunk) != 0) && (decoder.errors == 0))
+            {
+                decoder.errors++;
+            }
+            position += chunk;
+            report->chunks += (chunk > 0) ? 1 : 0;
+        }
+
+        report->bytes += position;
+        report->packets += decoder.packets;
+        report->errors += decoder.errors;
+        destroy_decoder(&decoder);
+        result = 0;
+    }
+
+    return result;
+}
+
+int codec_replay_run(const XIO_CAPTURE_RECORD* records, size_t record_count, const CODEC_REPLAY_CONFIG* config, CODEC_REPLAY_REPORT* report)
+{
+    int result;
+    REPLAY_STREAMS streams;
+
+    if ((records == NULL) || (config == NULL) || (report == NULL) || (config->iterations == 0) ||
+        ((config->direction != XIO_CAPTURE_RECEIVED) &&
+        ((config->direction != XIO_CAPTURE_SENT) || (config->protocol == CODEC_REPLAY_MQTT))))
+    {
+        LogError("Invalid argument to codec_replay_run.\r\n");
+        result = __LINE__;
+    }
+    else if (collect_streams(records, record_count, config->direction, &streams) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        clock_t cpu_start;
+        size_t iteration;
+
+        if (config->protocol == CODEC_REPLAY_AMQP)
+        {
+            strip_amqp_headers(&streams);
+        }
+
+        (void)memset(report, 0, sizeof(CODEC_REPLAY_REPORT));
+        report->connections = streams.connection_count;
+
+        result = 0;
+        cpu_start = clock();
+        for (iteration = 0; (iteration < config->iterations) && (result == 0); iteration++)
+        {
+            const unsigned char* bytes = streams.bytes;
+            size_t connection;
+
+            for (connection = 0; connection < streams.connection_count; connection++)
+            {
+                size_t first_chunk = streams.connection_starts[connection];
+                size_t chunk_count = streams.connection_starts[connection + 1] - first_chunk;
+                size_t i;
+
+                if (replay_connection(config, bytes, streams.chunk_sizes + first_chunk, chunk_count, report) != 0)
+                {
+                    result = __LINE__;
+                    break;
+                }
+
+                for (i = 0; i < chunk_count; i++)
+                {
+                    bytes += streams.chunk_sizes[first_chunk + i];
+                }
+            }
+        }
+        report->cpu_seconds = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        if (result == 0)
+        {
+            report->bytes_per_cpu_second = (report->cpu_seconds <= 0) ? 0 : report->bytes / report->cpu_seconds;
+            report->packets_per_cpu_second = (report->cpu_seconds <= 0) ? 0 : report->packets / report->cpu_seconds;
+            report->bytes /= config->iterations;
+            report->chunks /= config->iterations;
+            report->packets /= config->iterations;
+            report->errors /= config->iterations;
+        }
+
+        destroy_streams(&streams);
+    }
+
+    return result;
+}
+
+#endif /* defined(__unix__) || defined(__APPLE__) || defined(_WIN32) */
@@ -0,0 +1,60 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CODEC_REPLAY_H
+#define CODEC_REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "xio_capture.h"
+
+/* Decoder benchmark over captured traffic (xio_capture.h): one direction of every captured connection is fed
+   through fresh decoders, mqtt_codec for MQTT, frame_codec with sasl_frame_codec and amqp_frame_codec (and so the
+   amqpvalue decoder) for AMQP, whose 8 byte protocol headers are skipped. The stream is fed in the captured read
+   sizes or re-chunked to chunk_size, so the same corpus shows the cost of small TLS records as well as of large
+   reads. A capture has to decode to the same packet count with no errors at any chunk size, which makes a set of
+   captures a regression corpus for the decoders. */
+
+typedef enum CODEC_REPLAY_PROTOCOL_TAG
+{
+    CODEC_REPLAY_MQTT,
+    CODEC_REPLAY_AMQP
+} CODEC_REPLAY_PROTOCOL;
+
+typedef struct CODEC_REPLAY_CONFIG_TAG
+{
+    CODEC_REPLAY_PROTOCOL protocol;
+    /* XIO_CAPTURE_RECEIVED replays what the device decoded, XIO_CAPTURE_SENT what the service decoded (AMQP only,
+       mqtt_codec is the device's decoder and does not complete the empty PINGREQ and DISCONNECT packets) */
+    XIO_CAPTURE_RECORD_TYPE direction;
+    /* 0 keeps the captured chunks */
+    size_t chunk_size;
+    size_t iterations;
+} CODEC_REPLAY_CONFIG;
+
+typedef struct CODEC_REPLAY_REPORT_TAG
+{
+    size_t connections;
+    /* per iteration */
+    size_t bytes;
+    size_t chunks;
+    size_t packets;
+    size_t errors;
+    /* all iterations */
+    double cpu_seconds;
+    double bytes_per_cpu_second;
+    double packets_per_cpu_second;
+} CODEC_REPLAY_REPORT;
+
+extern int codec_replay_run(const XIO_CAPTURE_RECORD* records, size_t record_count, const CODEC_REPLAY_CONFIG* config, CODEC_REPLAY_REPORT* report);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CODEC_REPLAY_H */
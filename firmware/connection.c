@@ -135,46 +135,47 @@ static int send_header(CONNECTION_INSTANCE* connection_instance)
 static const char* get_frame_type_as_string(AMQP_VALUE descriptor)
 {
 	const char* result;
+	uint64_t descriptor_ulong;
 
-	if (is_open_type_by_descriptor(descriptor))
+	if (amqpvalue_get_ulong(descriptor, &descriptor_ulong) != 0)
 	{
-		result = "[OPEN]";
-	}
-	else if (is_begin_type_by_descriptor(descriptor))
-	{
-		result = "[BEGIN]";
-	}
-	else if (is_attach_type_by_descriptor(descriptor))
-	{
-		result = "[ATTACH]";
-	}
-	else if (is_flow_type_by_descriptor(descriptor))
-	{
-		result = "[FLOW]";
-	}
-	else if (is_disposition_type_by_descriptor(descriptor))
-	{
-		result = "[DISPOSITION]";
-	}
-	else if (is_transfer_type_by_descriptor(descriptor))
-	{
-		result = "[TRANSFER]";
-	}
-	else if (is_detach_type_by_descriptor(descriptor))
-	{
-		result = "[DETACH]";
-	}
-	else if (is_end_type_by_descriptor(descriptor))
-	{
-		result = "[END]";
-	}
-	else if (is_close_type_by_descriptor(descriptor))
-	{
-		result = "[CLOSE]";
+		result = "[Unknown]";
 	}
 	else
 	{
-		result = "[Unknown]";
+		switch (descriptor_ulong)
+		{
+		default:
+			result = "[Unknown]";
+			break;
+		case AMQP_OPEN:
+			result = "[OPEN]";
+			break;
+		case AMQP_BEGIN:
+			result = "[BEGIN]";
+			break;
+		case AMQP_ATTACH:
+			result = "[ATTACH]";
+			break;
+		case AMQP_FLOW:
+			result = "[FLOW]";
+			break;
+		case AMQP_DISPOSITION:
+			result = "[DISPOSITION]";
+			break;
+		case AMQP_TRANSFER:
+			result = "[TRANSFER]";
+			break;
+		case AMQP_DETACH:
+			result = "[DETACH]";
+			break;
+		case AMQP_END:
+			result = "[END]";
+			break;
+		case AMQP_CLOSE:
+			result = "[CLOSE]";
+			break;
+		}
 	}
 
 	return result;
@@ -646,38 +647,39 @@ static void on_amqp_frame_received(void* context, uint16_t channel, AMQP_VALUE p
 					AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
 					uint64_t performative_ulong;
 
-					log_incoming_frame(connection_instance->logger, performative);
-
-					if (is_open_type_by_descriptor(descriptor))
+					if (amqpvalue_get_ulong(descriptor, &performative_ulong) != 0)
 					{
-						if (channel != 0)
-						{
-							/* Codes_SRS_CONNECTION_01_006: [The open frame can only be sent on channel 0.] */
-							/* Codes_SRS_CONNECTION_01_222: [If an Open frame is received in a manner violating the ISO specification, the connection shall be closed with condition amqp:not-allowed and description being an implementation defined string.] */
-							close_connection_with_error(connection_instance, "amqp:not-allowed", "OPEN frame received on a channel that is not 0");
-						}
+						close_connection_with_error(connection_instance, "amqp:decode-error", "connection_endpoint_frame_received::cannot get performative descriptor");
+					}
+					else
+					{
+						log_incoming_frame(connection_instance->logger, performative);
 
-						if (connection_instance->connection_state == CONNECTION_STATE_OPENED)
+						switch (performative_ulong)
 						{
-							/* Codes_SRS_CONNECTION_01_239: [If an Open frame is received in the Opened state the connection shall be closed with condition amqp:illegal-state and description being an implementation defined string.] */
-							close_connection_with_error(connection_instance, "amqp:illegal-state", "OPEN frame received in the OPENED state");
-						}
-						else if ((connection_instance->connection_state == CONNECTION_STATE_OPEN_SENT) ||
-							(connection_instance->connection_state == CONNECTION_STATE_HDR_EXCH))
+						default:
+							LOG(connection_instance->logger, LOG_LINE, "Bad performative: %02x", performative);
+							break;
+
+						case AMQP_OPEN:
 						{
-							OPEN_HANDLE open_handle;
-							if (amqpvalue_get_open(performative, &open_handle) != 0)
+							if (channel != 0)
 							{
-								/* Codes_SRS_CONNECTION_01_143: [If any of the values in the received open frame are invalid then the connection shall be closed.] */
-								/* Codes_SRS_CONNECTION_01_220: [The error amqp:invalid-field shall be set in the error.condition field of the CLOSE frame.] */
-								close_connection_with_error(connection_instance, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing OPEN frame");
+								/* Codes_SRS_CONNECTION_01_006: [The open frame can only be sent on channel 0.] */
+								/* Codes_SRS_CONNECTION_01_222: [If an Open frame is received in a manner violating the ISO specification, the connection shall be closed with condition amqp:not-allowed and description being an implementation defined string.] */
+								close_connection_with_error(connection_instance, "amqp:not-allowed", "OPEN frame received on a channel that is not 0");
 							}
-							else
+
+							if (connection_instance->connection_state == CONNECTION_STATE_OPENED)
+							{
+								/* Codes_SRS_CONNECTION_01_239: [If an Open frame is received in the Opened state the connection shall be closed with condition amqp:illegal-state and description being an implementation defined string.] */
+								close_connection_with_error(connection_instance, "amqp:illegal-state", "OPEN frame received in the OPENED state");
+							}
+							else if ((connection_instance->connection_state == CONNECTION_STATE_OPEN_SENT) ||
+								(connection_instance->connection_state == CONNECTION_STATE_HDR_EXCH))
 							{
-								(void)open_get_idle_time_out(open_handle, &connection_instance->remote_idle_timeout);
-								if ((open_get_max_frame_size(open_handle, &connection_instance->remote_max_frame_size) != 0) ||
-									/* Codes_SRS_CONNECTION_01_167: [Both peers MUST accept frames of up to 512 (MIN-MAX-FRAME-SIZE) octets.] */
-									(connection_instance->remote_max_frame_size < 512))
+								OPEN_HANDLE open_handle;
+								if (amqpvalue_get_open(performative, &open_handle) != 0)
 								{
 									/* Codes_SRS_CONNECTION_01_143: [If any of the values in the received open frame are invalid then the connection shall be closed.] */
 									/* Codes_SRS_CONNECTION_01_220: [The error amqp:invalid-field shall be set in the error.condition field of the CLOSE frame.] */
@@ -685,88 +687,95 @@ static void on_amqp_frame_received(void* context, uint16_t channel, AMQP_VALUE p
 								}
 								else
 								{
-									if (connection_instance->connection_state == CONNECTION_STATE_OPEN_SENT)
+									(void)open_get_idle_time_out(open_handle, &connection_instance->remote_idle_timeout);
+									if ((open_get_max_frame_size(open_handle, &connection_instance->remote_max_frame_size) != 0) ||
+										/* Codes_SRS_CONNECTION_01_167: [Both peers MUST accept frames of up to 512 (MIN-MAX-FRAME-SIZE) octets.] */
+										(connection_instance->remote_max_frame_size < 512))
 									{
-										connection_set_state(connection_instance, CONNECTION_STATE_OPENED);
+										/* Codes_SRS_CONNECTION_01_143: [If any of the values in the received open frame are invalid then the connection shall be closed.] */
+										/* Codes_SRS_CONNECTION_01_220: [The error amqp:invalid-field shall be set in the error.condition field of the CLOSE frame.] */
+										close_connection_with_error(connection_instance, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing OPEN frame");
 									}
 									else
 									{
-										if (send_open_frame(connection_instance) != 0)
+										if (connection_instance->connection_state == CONNECTION_STATE_OPEN_SENT)
 										{
-											connection_set_state(connection_instance, CONNECTION_STATE_END);
+											connection_set_state(connection_instance, CONNECTION_STATE_OPENED);
 										}
 										else
 										{
-											connection_set_state(connection_instance, CONNECTION_STATE_OPENED);
+											if (send_open_frame(connection_instance) != 0)
+											{
+												connection_set_state(connection_instance, CONNECTION_STATE_END);
+											}
+											else
+											{
+												connection_set_state(connection_instance, CONNECTION_STATE_OPENED);
+											}
 										}
 									}
-								}
 
-								open_destroy(open_handle);
+									open_destroy(open_handle);
+								}
 							}
+							else
+							{
+								/* do nothing for now ... */
+							}
+
+							break;
 						}
-						else
-						{
-							/* do nothing for now ... */
-						}
-					}
-					else if (is_close_type_by_descriptor(descriptor))
-					{
-						/* Codes_SRS_CONNECTION_01_012: [A close frame MAY be received on any channel up to the maximum channel number negotiated in open.] */
-						/* Codes_SRS_CONNECTION_01_242: [The connection module shall accept CLOSE frames even if they have extra payload bytes besides the Close performative.] */
-
-						/* Codes_SRS_CONNECTION_01_225: [HDR_RCVD HDR OPEN] */
-						if ((connection_instance->connection_state == CONNECTION_STATE_HDR_RCVD) ||
-							/* Codes_SRS_CONNECTION_01_227: [HDR_EXCH OPEN OPEN] */
-							(connection_instance->connection_state == CONNECTION_STATE_HDR_EXCH) ||
-							/* Codes_SRS_CONNECTION_01_228: [OPEN_RCVD OPEN *] */
-							(connection_instance->connection_state == CONNECTION_STATE_OPEN_RCVD) ||
-							/* Codes_SRS_CONNECTION_01_235: [CLOSE_SENT - * TCP Close for Write] */
-							(connection_instance->connection_state == CONNECTION_STATE_CLOSE_SENT) ||
-							/* Codes_SRS_CONNECTION_01_236: [DISCARDING - * TCP Close for Write] */
-							(connection_instance->connection_state == CONNECTION_STATE_DISCARDING))
-						{
-							xio_close(connection_instance->io, NULL, NULL);
-						}
-						else
-						{
-							CLOSE_HANDLE close_handle;
 
+						case AMQP_CLOSE:
+						{
 							/* Codes_SRS_CONNECTION_01_012: [A close frame MAY be received on any channel up to the maximum channel number negotiated in open.] */
-							if (channel > connection_instance->channel_max)
+							/* Codes_SRS_CONNECTION_01_242: [The connection module shall accept CLOSE frames even if they have extra payload bytes besides the Close performative.] */
+
+							/* Codes_SRS_CONNECTION_01_225: [HDR_RCVD HDR OPEN] */
+							if ((connection_instance->connection_state == CONNECTION_STATE_HDR_RCVD) ||
+								/* Codes_SRS_CONNECTION_01_227: [HDR_EXCH OPEN OPEN] */
+								(connection_instance->connection_state == CONNECTION_STATE_HDR_EXCH) ||
+								/* Codes_SRS_CONNECTION_01_228: [OPEN_RCVD OPEN *] */
+								(connection_instance->connection_state == CONNECTION_STATE_OPEN_RCVD) ||
+								/* Codes_SRS_CONNECTION_01_235: [CLOSE_SENT - * TCP Close for Write] */
+								(connection_instance->connection_state == CONNECTION_STATE_CLOSE_SENT) ||
+								/* Codes_SRS_CONNECTION_01_236: [DISCARDING - * TCP Close for Write] */
+								(connection_instance->connection_state == CONNECTION_STATE_DISCARDING))
 							{
-								close_connection_with_error(connection_instance, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing CLOSE frame");
+								xio_close(connection_instance->io, NULL, NULL);
 							}
 							else
 							{
-								if (amqpvalue_get_close(performative, &close_handle) != 0)
+								CLOSE_HANDLE close_handle;
+
+								/* Codes_SRS_CONNECTION_01_012: [A close frame MAY be received on any channel up to the maximum channel number negotiated in open.] */
+								if (channel > connection_instance->channel_max)
 								{
 									close_connection_with_error(connection_instance, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing CLOSE frame");
 								}
 								else
 								{
-									close_destroy(close_handle);
+									if (amqpvalue_get_close(performative, &close_handle) != 0)
+									{
+										close_connection_with_error(connection_instance, "amqp:invalid-field", "connection_endpoint_frame_received::failed parsing CLOSE frame");
+									}
+									else
+									{
+										close_destroy(close_handle);
 
-									connection_set_state(connection_instance, CONNECTION_STATE_CLOSE_RCVD);
+										connection_set_state(connection_instance, CONNECTION_STATE_CLOSE_RCVD);
 
-									(void)send_close_frame(connection_instance, NULL);
-									/* Codes_SRS_CONNECTION_01_214: [If the close frame cannot be constructed or sent, the connection shall be closed and set to the END state.] */
-									(void)xio_close(connection_instance->io, NULL, NULL);
+										(void)send_close_frame(connection_instance, NULL);
+										/* Codes_SRS_CONNECTION_01_214: [If the close frame cannot be constructed or sent, the connection shall be closed and set to the END state.] */
+										(void)xio_close(connection_instance->io, NULL, NULL);
 
-									connection_set_state(connection_instance, CONNECTION_STATE_END);
+										connection_set_state(connection_instance, CONNECTION_STATE_END);
+									}
 								}
 							}
-						}
-					}
-					else
-					{
-						amqpvalue_get_ulong(descriptor, &performative_ulong);
 
-						switch (performative_ulong)
-						{
-						default:
-							LOG(connection_instance->logger, LOG_LINE, "Bad performative: %02x", performative);
 							break;
+						}
 
 						case AMQP_BEGIN:
 						{
@@ -0,0 +1,530 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* getaddrinfo is POSIX, the device resolves through its own network stack */
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include "dns_resolver.h"
+#include "lock.h"
+#include "condition.h"
+#include "threadapi.h"
+#include "agenttime.h"
+#include "crt_abstractions.h"
+#include "iot_logging.h"
+
+#define DEFAULT_TTL_SECONDS 300
+#define DEFAULT_NEGATIVE_TTL_SECONDS 5
+
+/* one lookup outcome, shared by the cache and every handle that picked it up */
+typedef struct DNS_RESULT_TAG
+{
+    size_t ref_count;
+    struct addrinfo* address_info;
+} DNS_RESULT;
+
+typedef struct DNS_CACHE_ENTRY_TAG
+{
+    char* hostname;
+    int port;
+    bool is_resolving;
+    /* NULL until the first lookup finished */
+    DNS_RESULT* result;
+    time_t resolved_time;
+    /* handles that point at the entry, it can only be evicted once there are none */
+    size_t handle_count;
+    struct DNS_CACHE_ENTRY_TAG* next;
+    struct DNS_CACHE_ENTRY_TAG* next_queued;
+} DNS_CACHE_ENTRY;
+
+typedef struct DNS_RESOLVER_INSTANCE_TAG
+{
+    DNS_CACHE_ENTRY* entry;
+    DNS_RESULT* result;
+} DNS_RESOLVER_INSTANCE;
+
+typedef struct DNS_RESOLVER_STATE_TAG
+{
+    LOCK_HANDLE lock;
+    COND_HANDLE work_available;
+    THREAD_HANDLE thread;
+    bool stop;
+    DNS_CACHE_ENTRY* entries;
+    DNS_CACHE_ENTRY* queue_head;
+    DNS_CACHE_ENTRY* queue_tail;
+    unsigned int ttl_seconds;
+    unsigned int negative_ttl_seconds;
+} DNS_RESOLVER_STATE;
+
+static DNS_RESOLVER_STATE* resolver = NULL;
+/* every IO layer that resolves names inits the resolver, the last deinit stops it */
+static size_t init_count = 0;
+/* completes a lookup whose result could not be allocated, it holds a reference of its own and is never freed */
+static DNS_RESULT allocation_failed_result = { 1, NULL };
+
+static void release_result(DNS_RESULT* result)
+{
+    if (result != NULL)
+    {
+        result->ref_count--;
+        if (result->ref_count == 0)
+        {
+            if (result->address_info != NULL)
+            {
+                freeaddrinfo(result->address_info);
+            }
+
+            free(result);
+        }
+    }
+}
+
+static bool is_fresh(DNS_CACHE_ENTRY* entry)
+{
+    bool result;
+
+    if (entry->result == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        time_t now = get_time(NULL);
+        unsigned int ttl_seconds = (entry->result->address_info == NULL) ? resolver->negative_ttl_seconds : resolver->ttl_seconds;
+
+        result = (now != (time_t)-1) && (get_difftime(now, entry->resolved_time) < (double)ttl_seconds);
+    }
+
+    return result;
+}
+
+static void queue_lookup(DNS_CACHE_ENTRY* entry)
+{
+    entry->is_resolving = true;
+    entry->next_queued = NULL;
+    if (resolver->queue_tail == NULL)
+    {
+        resolver->queue_head = entry;
+    }
+    else
+    {
+        resolver->queue_tail->next_queued = entry;
+    }
+    resolver->queue_tail = entry;
+
+    (void)Condition_Post(resolver->work_available);
+}
+
+static int dns_resolver_thread(void* arg)
+{
+    (void)arg;
+
+    if (Lock(resolver->lock) != LOCK_OK)
+    {
+        LogError("Failed to get the Lock.\r\n");
+    }
+    else
+    {
+        while (!resolver->stop)
+        {
+            DNS_CACHE_ENTRY* entry = resolver->queue_head;
+            if (entry == NULL)
+            {
+                (void)Condition_Wait(resolver->work_available, resolver->lock, 0);
+            }
+            else
+            {
+                struct addrinfo address_hint;
+                struct addrinfo* address_info = NULL;
+                char port_string[16];
+                DNS_RESULT* result;
+                int error;
+
+                resolver->queue_head = entry->next_queued;
+                if (resolver->queue_head == NULL)
+                {
+                    resolver->queue_tail = NULL;
+                }
+
+                /* the entry is never freed while it is resolving, so it can be used outside of the lock */
+                (void)Unlock(resolver->lock);
+
+                (void)memset(&address_hint, 0, sizeof(address_hint));
+                address_hint.ai_family = AF_UNSPEC;
+                address_hint.ai_socktype = SOCK_STREAM;
+                (void)sprintf_s(port_string, sizeof(port_string), "%d", entry->port);
+                error = getaddrinfo(entry->hostname, port_string, &address_hint, &address_info);
+                if (error != 0)
+                {
+                    LogError("Failure resolving %s, error %d.\r\n", entry->hostname, error);
+                    address_info = NULL;
+                }
+
+                result = (DNS_RESULT*)malloc(sizeof(DNS_RESULT));
+                if (result == NULL)
+                {
+                    LogError("Failed allocating the DNS result.\r\n");
+                    if (address_info != NULL)
+                    {
+                        freeaddrinfo(address_info);
+                    }
+                }
+                else
+                {
+                    result->ref_count = 1;
+                    result->address_info = address_info;
+                }
+
+                (void)Lock(resolver->lock);
+
+                if (result == NULL)
+                {
+                    /* the waiters see a failed lookup, which is only retried once the negative TTL is over */
+                    result = &allocation_failed_result;
+                    result->ref_count++;
+                }
+
+                release_result(entry->result);
+                entry->result = result;
+                entry->resolved_time = get_time(NULL);
+                entry->is_resolving = false;
+            }
+        }
+
+        (void)Unlock(resolver->lock);
+    }
+
+    return 0;
+}
+
+static void free_entry(DNS_CACHE_ENTRY* entry)
+{
+    release_result(entry->result);
+    free(entry->hostname);
+    free(entry);
+}
+
+static void free_resolver(void)
+{
+    while (resolver->entries != NULL)
+    {
+        DNS_CACHE_ENTRY* entry = resolver->entries;
+        resolver->entries = entry->next;
+        free_entry(entry);
+    }
+
+    if (resolver->work_available != NULL)
+    {
+        Condition_Deinit(resolver->work_available);
+    }
+    if (resolver->lock != NULL)
+    {
+        (void)Lock_Deinit(resolver->lock);
+    }
+
+    free(resolver);
+    resolver = NULL;
+}
+
+int dns_resolver_init(void)
+{
+    int result;
+
+    if (resolver != NULL)
+    {
+        init_count++;
+        result = 0;
+    }
+    else if ((resolver = (DNS_RESOLVER_STATE*)malloc(sizeof(DNS_RESOLVER_STATE))) == NULL)
+    {
+        result = __LINE__;
+        LogError("Failed allocating the resolver.\r\n");
+    }
+    else
+    {
+        (void)memset(resolver, 0, sizeof(DNS_RESOLVER_STATE));
+        resolver->ttl_seconds = DEFAULT_TTL_SECONDS;
+        resolver->negative_ttl_seconds = DEFAULT_NEGATIVE_TTL_SECONDS;
+
+        if ((resolver->lock = Lock_Init()) == NULL)
+        {
+            result = __LINE__;
+            LogError("Failed creating the lock.\r\n");
+            free_resolver();
+        }
+        else if ((resolver->work_available = Condition_Init()) == NULL)
+        {
+            result = __LINE__;
+            LogError("Failed creating the condition.\r\n");
+            free_resolver();
+        }
+        else if (ThreadAPI_Create(&resolver->thread, dns_resolver_thread, NULL) != THREADAPI_OK)
+        {
+            result = __LINE__;
+            LogError("Failed starting the resolver thread.\r\n");
+            free_resolver();
+        }
+        else
+        {
+            init_count = 1;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+void dns_resolver_deinit(void)
+{
+    if ((resolver != NULL) &&
+        (--init_count == 0))
+    {
+        int thread_result;
+
+        if (Lock(resolver->lock) != LOCK_OK)
+        {
+            LogError("Failed to get the Lock.\r\n");
+        }
+        else
+        {
+            resolver->stop = true;
+            (void)Condition_Post(resolver->work_available);
+            (void)Unlock(resolver->lock);
+        }
+
+        /* a lookup in progress has to finish first, getaddrinfo cannot be interrupted */
+        (void)ThreadAPI_Join(resolver->thread, &thread_result);
+        free_resolver();
+    }
+}
+
+void dns_resolver_set_ttl(unsigned int ttl_seconds, unsigned int negative_ttl_seconds)
+{
+    if (resolver == NULL)
+    {
+        LogError("dns_resolver is not initialized.\r\n");
+    }
+    else if (Lock(resolver->lock) != LOCK_OK)
+    {
+        LogError("Failed to get the Lock.\r\n");
+    }
+    else
+    {
+        resolver->ttl_seconds = ttl_seconds;
+        resolver->negative_ttl_seconds = negative_ttl_seconds;
+        (void)Unlock(resolver->lock);
+    }
+}
+
+void dns_resolver_flush(void)
+{
+    if (resolver == NULL)
+    {
+        LogError("dns_resolver is not initialized.\r\n");
+    }
+    else if (Lock(resolver->lock) != LOCK_OK)
+    {
+        LogError("Failed to get the Lock.\r\n");
+    }
+    else
+    {
+        DNS_CACHE_ENTRY* entry;
+
+        /* entries stay, handles point at them; the next lookup for each one goes to DNS again */
+        for (entry = resolver->entries; entry != NULL; entry = entry->next)
+        {
+            entry->resolved_time = 0;
+        }
+
+        (void)Unlock(resolver->lock);
+    }
+}
+
+DNS_RESOLVER_HANDLE dns_resolver_create(const char* hostname, int port)
+{
+    DNS_RESOLVER_INSTANCE* result;
+
+    if (hostname == NULL)
+    {
+        result = NULL;
+        LogError("NULL hostname.\r\n");
+    }
+    else if (resolver == NULL)
+    {
+        result = NULL;
+        LogError("dns_resolver is not initialized.\r\n");
+    }
+    else if ((result = (DNS_RESOLVER_INSTANCE*)malloc(sizeof(DNS_RESOLVER_INSTANCE))) == NULL)
+    {
+        LogError("Failed allocating the resolver handle.\r\n");
+    }
+    else if (Lock(resolver->lock) != LOCK_OK)
+    {
+        LogError("Failed to get the Lock.\r\n");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        DNS_CACHE_ENTRY** current = &resolver->entries;
+        DNS_CACHE_ENTRY* entry = NULL;
+
+        /* expired entries nobody points at are dropped on the way, so the cache does not grow with every name ever used */
+        while ((entry == NULL) && (*current != NULL))
+        {
+            if (((*current)->port == port) && (strcmp((*current)->hostname, hostname) == 0))
+            {
+                entry = *current;
+            }
+            else if (((*current)->handle_count == 0) && (!(*current)->is_resolving) && (!is_fresh(*current)))
+            {
+                DNS_CACHE_ENTRY* expired = *current;
+                *current = expired->next;
+                free_entry(expired);
+            }
+            else
+            {
+                current = &(*current)->next;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            entry = (DNS_CACHE_ENTRY*)malloc(sizeof(DNS_CACHE_ENTRY));
+            if (entry == NULL)
+            {
+                LogError("Failed allocating the cache entry.\r\n");
+            }
+            else if (mallocAndStrcpy_s(&entry->hostname, hostname) != 0)
+            {
+                LogError("Failed copying the hostname.\r\n");
+                free(entry);
+                entry = NULL;
+            }
+            else
+            {
+                entry->port = port;
+                entry->is_resolving = false;
+                entry->result = NULL;
+                entry->resolved_time = 0;
+                entry->handle_count = 0;
+                entry->next = resolver->entries;
+                entry->next_queued = NULL;
+                resolver->entries = entry;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->entry = entry;
+            result->result = NULL;
+            entry->handle_count++;
+
+            if (is_fresh(entry))
+            {
+                /* cache hit, complete without waiting for the thread */
+                result->result = entry->result;
+                result->result->ref_count++;
+            }
+            else if (!entry->is_resolving)
+            {
+                queue_lookup(entry);
+            }
+        }
+
+        (void)Unlock(resolver->lock);
+    }
+
+    return result;
+}
+
+void dns_resolver_destroy(DNS_RESOLVER_HANDLE dns_resolver)
+{
+    if (dns_resolver != NULL)
+    {
+        if (Lock(resolver->lock) != LOCK_OK)
+        {
+            LogError("Failed to get the Lock.\r\n");
+        }
+        else
+        {
+            release_result(dns_resolver->result);
+            dns_resolver->entry->handle_count--;
+            (void)Unlock(resolver->lock);
+        }
+
+        free(dns_resolver);
+    }
+}
+
+bool dns_resolver_is_lookup_complete(DNS_RESOLVER_HANDLE dns_resolver)
+{
+    bool result;
+
+    if (dns_resolver == NULL)
+    {
+        result = false;
+        LogError("NULL dns_resolver.\r\n");
+    }
+    else if (dns_resolver->result != NULL)
+    {
+        result = true;
+    }
+    else if (Lock(resolver->lock) != LOCK_OK)
+    {
+        result = false;
+        LogError("Failed to get the Lock.\r\n");
+    }
+    else
+    {
+        if ((!dns_resolver->entry->is_resolving) &&
+            (dns_resolver->entry->result != NULL))
+        {
+            dns_resolver->result = dns_resolver->entry->result;
+            dns_resolver->result->ref_count++;
+            result = true;
+        }
+        else
+        {
+            result = false;
+        }
+
+        (void)Unlock(resolver->lock);
+    }
+
+    return result;
+}
+
+const struct addrinfo* dns_resolver_get_addrinfo(DNS_RESOLVER_HANDLE dns_resolver)
+{
+    const struct addrinfo* result;
+
+    if ((dns_resolver == NULL) ||
+        (dns_resolver->result == NULL))
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = dns_resolver->result->address_info;
+    }
+
+    return result;
+}
+
+#endif /* defined(__unix__) || defined(__APPLE__) */
@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef DNS_RESOLVER_H
+#define DNS_RESOLVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+struct addrinfo;
+
+typedef struct DNS_RESOLVER_INSTANCE_TAG* DNS_RESOLVER_HANDLE;
+
+/* Process wide resolver shared by all transports: lookups run on one background thread and results are cached
+   per host and port for the TTL (failures for a shorter time), so a reconnect does not block DoWork on DNS.
+   Init and deinit are counted, every user inits once and the last deinit stops the thread. */
+extern int dns_resolver_init(void);
+extern void dns_resolver_deinit(void);
+extern void dns_resolver_set_ttl(unsigned int ttl_seconds, unsigned int negative_ttl_seconds);
+extern void dns_resolver_flush(void);
+
+/* starts a lookup, or completes it right away from the cache */
+extern DNS_RESOLVER_HANDLE dns_resolver_create(const char* hostname, int port);
+extern void dns_resolver_destroy(DNS_RESOLVER_HANDLE dns_resolver);
+/* never blocks, true once the lookup has either succeeded or failed */
+extern bool dns_resolver_is_lookup_complete(DNS_RESOLVER_HANDLE dns_resolver);
+/* NULL while the lookup is running or when it failed, owned by the handle */
+extern const struct addrinfo* dns_resolver_get_addrinfo(DNS_RESOLVER_HANDLE dns_resolver);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* DNS_RESOLVER_H */
@@ -13,6 +13,7 @@
 #include "list.h"
 #include "frame_codec.h"
 #include "amqpvalue.h"
+#include "trace_probes.h"
 #include "amqpalloc.h"
 
 #define FRAME_HEADER_SIZE 8
@@ -352,6 +353,7 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
 							/* Codes_SRS_FRAME_CODEC_01_005: [This is an extension point defined for future expansion.] */
 							/* Codes_SRS_FRAME_CODEC_01_006: [The treatment of this area depends on the frame type.] */
 							/* Codes_SRS_FRAME_CODEC_01_100: [If the frame body size is 0, the frame_body pointer passed to on_frame_received shall be NULL.] */
+							TRACE_PROBE2(frame_decode, frame_codec_data->receive_frame_type, 0);
 							frame_codec_data->receive_frame_subscription->on_frame_received(frame_codec_data->receive_frame_subscription->callback_context, frame_codec_data->receive_frame_bytes, frame_codec_data->type_specific_size, NULL, 0);
 							amqpalloc_free(frame_codec_data->receive_frame_bytes);
 							frame_codec_data->receive_frame_bytes = NULL;
@@ -397,6 +399,7 @@ int frame_codec_receive_bytes(FRAME_CODEC_HANDLE frame_codec, const unsigned cha
 						/* Codes_SRS_FRAME_CODEC_01_005: [This is an extension point defined for future expansion.] */
 						/* Codes_SRS_FRAME_CODEC_01_006: [The treatment of this area depends on the frame type.] */
 						/* Codes_SRS_FRAME_CODEC_01_099: [A pointer to the frame_body bytes shall also be passed to the on_frame_received.] */
+						TRACE_PROBE2(frame_decode, frame_codec_data->receive_frame_type, frame_body_size);
 						frame_codec_data->receive_frame_subscription->on_frame_received(frame_codec_data->receive_frame_subscription->callback_context, frame_codec_data->receive_frame_bytes, frame_codec_data->type_specific_size, frame_codec_data->receive_frame_bytes + frame_codec_data->type_specific_size, frame_body_size);
 						amqpalloc_free(frame_codec_data->receive_frame_bytes);
 						frame_codec_data->receive_frame_bytes = NULL;
@@ -622,6 +625,8 @@ int frame_codec_encode_frame(FRAME_CODEC_HANDLE frame_codec, uint8_t type, const
 			on_bytes_encoded(callback_context, payloads[i].bytes, payloads[i].length, (i == payload_count - 1) ? true : false);
 		}
 
+		TRACE_PROBE2(frame_encode, type, frame_size);
+
 		/* Codes_SRS_FRAME_CODEC_01_043: [On success it shall return 0.] */
 		result = 0;
 	}
@@ -9,6 +9,20 @@
 #include "lock.h"
 #include "iot_logging.h"
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* gballoc.c always provides the tracking functions, so it needs their declarations rather than the no-op macros */
+#ifndef GB_DEBUG_ALLOC
+#define GB_DEBUG_ALLOC
+#endif
+#include "gballoc.h"
+
+/* a translation unit built with GB_MEASURE_MEMORY_FOR_THIS gets the redirects too, and the tracking functions need the real allocator */
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
 
 #ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)~(size_t)0)
@@ -19,6 +33,7 @@ typedef struct ALLOCATION_TAG
     size_t size;
     void* ptr;
     void* next;
+    void* site;
 } ALLOCATION;
 
 typedef enum GBALLOC_STATE_TAG
@@ -30,10 +45,111 @@ typedef enum GBALLOC_STATE_TAG
 static ALLOCATION* head = NULL;
 static size_t totalSize = 0;
 static size_t maxSize = 0;
+static size_t allocationCount = 0;
+static size_t allocatedBytes = 0;
 static GBALLOC_STATE gballocState = GBALLOC_STATE_NOT_INIT;
 
 static LOCK_HANDLE gballocThreadSafeLock = NULL;
 
+/* call site profiling: allocations are attributed to the file/line passed by the GB_PROFILE_CALL_SITES macros, or
+   to the caller's return address otherwise. One in sampleInterval allocations is recorded, 0 turns profiling off */
+#define GBALLOC_CALL_SITE_COUNT 256
+
+typedef struct CALL_SITE_TAG
+{
+    const char* file;
+    int line;
+    void* caller;
+    size_t allocationCount;
+    size_t allocatedBytes;
+    size_t liveCount;
+    size_t liveBytes;
+} CALL_SITE;
+
+static CALL_SITE callSites[GBALLOC_CALL_SITE_COUNT];
+static size_t callSiteCount = 0;
+static size_t droppedCallSiteSamples = 0;
+static size_t sampleInterval = 0;
+static size_t sampleCountdown = 0;
+
+#if defined(__GNUC__)
+#define GBALLOC_CALLER() __builtin_return_address(0)
+#else
+#define GBALLOC_CALLER() NULL
+#endif
+
+static CALL_SITE* find_call_site(const char* file, int line, void* caller)
+{
+    CALL_SITE* result = NULL;
+    size_t hash = (file != NULL) ? (((size_t)file >> 2) * 31 + (size_t)line) : ((size_t)caller >> 2);
+    size_t i;
+
+    /* open addressing, the table never shrinks until gballoc_resetCallSites */
+    for (i = 0; i < GBALLOC_CALL_SITE_COUNT; i++)
+    {
+        CALL_SITE* site = &callSites[(hash + i) % GBALLOC_CALL_SITE_COUNT];
+        if ((site->allocationCount == 0) && (site->file == NULL) && (site->caller == NULL))
+        {
+            if (callSiteCount < GBALLOC_CALL_SITE_COUNT)
+            {
+                site->file = file;
+                site->line = line;
+                site->caller = caller;
+                callSiteCount++;
+                result = site;
+            }
+            break;
+        }
+        else if ((file != NULL) ? ((site->file == file) && (site->line == line)) : ((site->file == NULL) && (site->caller == caller)))
+        {
+            result = site;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void record_call_site(ALLOCATION* allocation, const char* file, int line, void* caller)
+{
+    allocation->site = NULL;
+    if (sampleInterval != 0)
+    {
+        if (sampleCountdown > 1)
+        {
+            sampleCountdown--;
+        }
+        else
+        {
+            CALL_SITE* site = find_call_site(file, line, caller);
+            sampleCountdown = sampleInterval;
+            if (site == NULL)
+            {
+                droppedCallSiteSamples++;
+            }
+            else
+            {
+                site->allocationCount++;
+                site->allocatedBytes += allocation->size;
+                site->liveCount++;
+                site->liveBytes += allocation->size;
+                allocation->site = site;
+            }
+        }
+    }
+}
+
+static void release_call_site(ALLOCATION* allocation)
+{
+    CALL_SITE* site = (CALL_SITE*)allocation->site;
+    if (site != NULL)
+    {
+        site->liveCount--;
+        site->liveBytes -= allocation->size;
+        allocation->site = NULL;
+    }
+}
+
 int gballoc_init(void)
 {
     int result;
@@ -56,6 +172,14 @@ int gballoc_init(void)
         /* Codes_ SRS_GBALLOC_01_002: [Upon initialization the total memory used and maximum total memory used tracked by the module shall be set to 0.] */
         totalSize = 0;
         maxSize = 0;
+        allocationCount = 0;
+        allocatedBytes = 0;
+
+        (void)memset(callSites, 0, sizeof(callSites));
+        callSiteCount = 0;
+        droppedCallSiteSamples = 0;
+        sampleInterval = 0;
+        sampleCountdown = 0;
 
         /* Codes_SRS_GBALLOC_01_024: [gballoc_init shall initialize the gballoc module and return 0 upon success.] */
         result = 0;
@@ -75,7 +199,7 @@ void gballoc_deinit(void)
     gballocState = GBALLOC_STATE_NOT_INIT;
 }
 
-void* gballoc_malloc(size_t size)
+static void* malloc_at(size_t size, const char* file, int line, void* caller)
 {
     void* result;
 
@@ -114,8 +238,11 @@ void* gballoc_malloc(size_t size)
             allocation->size = size;
             allocation->next = head;
             head = allocation;
+            record_call_site(allocation, file, line, caller);
 
             totalSize += size;
+            allocationCount++;
+            allocatedBytes += size;
             /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
             if (maxSize < totalSize)
             {
@@ -130,7 +257,7 @@ void* gballoc_malloc(size_t size)
     return result;
 }
 
-void* gballoc_calloc(size_t nmemb, size_t size)
+static void* calloc_at(size_t nmemb, size_t size, const char* file, int line, void* caller)
 {
     void* result;
 
@@ -169,8 +296,11 @@ void* gballoc_calloc(size_t nmemb, size_t size)
             allocation->size = nmemb * size;
             allocation->next = head;
             head = allocation;
+            record_call_site(allocation, file, line, caller);
 
             totalSize += allocation->size;
+            allocationCount++;
+            allocatedBytes += allocation->size;
             /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
             if (maxSize < totalSize)
             {
@@ -185,7 +315,7 @@ void* gballoc_calloc(size_t nmemb, size_t size)
     return result;
 }
 
-void* gballoc_realloc(void* ptr, size_t size)
+static void* realloc_at(void* ptr, size_t size, const char* file, int line, void* caller)
 {
     ALLOCATION* curr;
     void* result;
@@ -251,6 +381,7 @@ void* gballoc_realloc(void* ptr, size_t size)
                 /* Codes_SRS_GBALLOC_01_006: [If the underlying realloc call is successful, gballoc_realloc shall look up the size associated with the pointer ptr and decrease the total memory used with that size.] */
                 allocation->ptr = result;
                 totalSize -= allocation->size;
+                release_call_site(allocation);
                 allocation->size = size;
             }
             else
@@ -262,8 +393,13 @@ void* gballoc_realloc(void* ptr, size_t size)
                 head = allocation;
             }
 
+            /* a reallocated block is attributed to the site that last resized it */
+            record_call_site(allocation, file, line, caller);
+
             /* Codes_SRS_GBALLOC_01_007: [If realloc is successful, gballoc_realloc shall also increment the total memory used value tracked by this module.] */
             totalSize += size;
+            allocationCount++;
+            allocatedBytes += size;
 
             /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
             if (maxSize < totalSize)
@@ -279,6 +415,36 @@ void* gballoc_realloc(void* ptr, size_t size)
     return result;
 }
 
+void* gballoc_malloc(size_t size)
+{
+    return malloc_at(size, NULL, 0, GBALLOC_CALLER());
+}
+
+void* gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc_at(nmemb, size, NULL, 0, GBALLOC_CALLER());
+}
+
+void* gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc_at(ptr, size, NULL, 0, GBALLOC_CALLER());
+}
+
+void* gballoc_malloc_at(size_t size, const char* file, int line)
+{
+    return malloc_at(size, file, line, GBALLOC_CALLER());
+}
+
+void* gballoc_calloc_at(size_t nmemb, size_t size, const char* file, int line)
+{
+    return calloc_at(nmemb, size, file, line, GBALLOC_CALLER());
+}
+
+void* gballoc_realloc_at(void* ptr, size_t size, const char* file, int line)
+{
+    return realloc_at(ptr, size, file, line, GBALLOC_CALLER());
+}
+
 void gballoc_free(void* ptr)
 {
     ALLOCATION* curr = head;
@@ -305,6 +471,7 @@ void gballoc_free(void* ptr)
             /* Codes_SRS_GBALLOC_01_008: [gballoc_free shall call the C99 free function.] */
             free(ptr);
             totalSize -= curr->size;
+            release_call_site(curr);
             if (prev != NULL)
             {
                 prev->next = curr->next;
@@ -386,3 +553,236 @@ size_t gballoc_getCurrentMemoryUsed(void)
 
     return result;
 }
+
+size_t gballoc_getAllocationCount(void)
+{
+    size_t result;
+
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.\r\n");
+        result = SIZE_MAX;
+    }
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        LogError("Failed to get the Lock.\r\n");
+        result = SIZE_MAX;
+    }
+    else
+    {
+        result = allocationCount;
+        (void)Unlock(gballocThreadSafeLock);
+    }
+
+    return result;
+}
+
+size_t gballoc_getAllocatedBytes(void)
+{
+    size_t result;
+
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.\r\n");
+        result = SIZE_MAX;
+    }
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        LogError("Failed to get the Lock.\r\n");
+        result = SIZE_MAX;
+    }
+    else
+    {
+        result = allocatedBytes;
+        (void)Unlock(gballocThreadSafeLock);
+    }
+
+    return result;
+}
+
+void gballoc_setSampleInterval(size_t interval)
+{
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.\r\n");
+    }
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        LogError("Failed to get the Lock.\r\n");
+    }
+    else
+    {
+        sampleInterval = interval;
+        sampleCountdown = interval;
+        (void)Unlock(gballocThreadSafeLock);
+    }
+}
+
+void gballoc_resetCallSites(void)
+{
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.\r\n");
+    }
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        LogError("Failed to get the Lock.\r\n");
+    }
+    else
+    {
+        ALLOCATION* curr;
+
+        /* live allocations must not keep pointing into the cleared table */
+        for (curr = head; curr != NULL; curr = (ALLOCATION*)curr->next)
+        {
+            curr->site = NULL;
+        }
+
+        (void)memset(callSites, 0, sizeof(callSites));
+        callSiteCount = 0;
+        droppedCallSiteSamples = 0;
+        sampleCountdown = sampleInterval;
+        (void)Unlock(gballocThreadSafeLock);
+    }
+}
+
+static int compare_call_sites(const void* left, const void* right)
+{
+    const CALL_SITE* leftSite = *(const CALL_SITE* const*)left;
+    const CALL_SITE* rightSite = *(const CALL_SITE* const*)right;
+    int result;
+
+    if (leftSite->allocatedBytes > rightSite->allocatedBytes)
+    {
+        result = -1;
+    }
+    else if (leftSite->allocatedBytes < rightSite->allocatedBytes)
+    {
+        result = 1;
+    }
+    else
+    {
+        result = (leftSite->allocationCount > rightSite->allocationCount) ? -1 : (leftSite->allocationCount < rightSite->allocationCount) ? 1 : 0;
+    }
+
+    return result;
+}
+
+static void dump_table(CALL_SITE** sites, size_t count, GBALLOC_DUMP_WRITE write, void* context)
+{
+    char line[256];
+    size_t i;
+
+    (void)snprintf(line, sizeof(line), "sample interval %u, %u call sites, %u dropped samples\n", (unsigned int)sampleInterval, (unsigned int)count, (unsigned int)droppedCallSiteSamples);
+    write(context, line);
+    (void)snprintf(line, sizeof(line), "%12s %10s %12s %10s  %s\n", "bytes", "count", "live bytes", "live", "site");
+    write(context, line);
+
+    for (i = 0; i < count; i++)
+    {
+        if (sites[i]->file != NULL)
+        {
+            (void)snprintf(line, sizeof(line), "%12lu %10lu %12lu %10lu  %s:%d\n",
+                (unsigned long)(sites[i]->allocatedBytes * sampleInterval), (unsigned long)(sites[i]->allocationCount * sampleInterval),
+                (unsigned long)(sites[i]->liveBytes * sampleInterval), (unsigned long)(sites[i]->liveCount * sampleInterval),
+                sites[i]->file, sites[i]->line);
+        }
+        else
+        {
+            (void)snprintf(line, sizeof(line), "%12lu %10lu %12lu %10lu  %p\n",
+                (unsigned long)(sites[i]->allocatedBytes * sampleInterval), (unsigned long)(sites[i]->allocationCount * sampleInterval),
+                (unsigned long)(sites[i]->liveBytes * sampleInterval), (unsigned long)(sites[i]->liveCount * sampleInterval),
+                sites[i]->caller);
+        }
+        write(context, line);
+    }
+}
+
+/* legacy text heap profile as understood by pprof: in use objects/bytes, then allocated objects/bytes since the last reset */
+static void dump_pprof(CALL_SITE** sites, size_t count, GBALLOC_DUMP_WRITE write, void* context)
+{
+    char line[128];
+    size_t liveCount = 0;
+    size_t liveBytes = 0;
+    size_t allocationCount = 0;
+    size_t allocatedBytes = 0;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        liveCount += sites[i]->liveCount;
+        liveBytes += sites[i]->liveBytes;
+        allocationCount += sites[i]->allocationCount;
+        allocatedBytes += sites[i]->allocatedBytes;
+    }
+
+    (void)snprintf(line, sizeof(line), "heap profile: %lu: %lu [%lu: %lu] @ heapprofile\n",
+        (unsigned long)(liveCount * sampleInterval), (unsigned long)(liveBytes * sampleInterval),
+        (unsigned long)(allocationCount * sampleInterval), (unsigned long)(allocatedBytes * sampleInterval));
+    write(context, line);
+
+    for (i = 0; i < count; i++)
+    {
+        /* sites without a return address cannot be symbolized by pprof */
+        if (sites[i]->caller != NULL)
+        {
+            (void)snprintf(line, sizeof(line), "%lu: %lu [%lu: %lu] @ 0x%lx\n",
+                (unsigned long)(sites[i]->liveCount * sampleInterval), (unsigned long)(sites[i]->liveBytes * sampleInterval),
+                (unsigned long)(sites[i]->allocationCount * sampleInterval), (unsigned long)(sites[i]->allocatedBytes * sampleInterval),
+                (unsigned long)(uintptr_t)sites[i]->caller);
+            write(context, line);
+        }
+    }
+}
+
+int gballoc_dumpCallSites(GBALLOC_DUMP_FORMAT format, GBALLOC_DUMP_WRITE write, void* context)
+{
+    int result;
+
+    if (write == NULL)
+    {
+        LogError("Invalid argument (write = NULL).\r\n");
+        result = __LINE__;
+    }
+    else if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.\r\n");
+        result = __LINE__;
+    }
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        LogError("Failed to get the Lock.\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        /* write is called with the lock held, so it must not allocate through gballoc */
+        CALL_SITE* sites[GBALLOC_CALL_SITE_COUNT];
+        size_t count = 0;
+        size_t i;
+
+        for (i = 0; i < GBALLOC_CALL_SITE_COUNT; i++)
+        {
+            if (callSites[i].allocationCount > 0)
+            {
+                sites[count++] = &callSites[i];
+            }
+        }
+
+        qsort(sites, count, sizeof(CALL_SITE*), compare_call_sites);
+
+        if (format == GBALLOC_DUMP_PPROF)
+        {
+            dump_pprof(sites, count, write, context);
+        }
+        else
+        {
+            dump_table(sites, count, write, context);
+        }
+
+        (void)Unlock(gballocThreadSafeLock);
+        result = 0;
+    }
+
+    return result;
+}
@@ -16,6 +16,14 @@ extern "C"
 #include <crtdbg.h>
 #endif
 
+typedef enum GBALLOC_DUMP_FORMAT_TAG
+{
+    GBALLOC_DUMP_TABLE,
+    GBALLOC_DUMP_PPROF
+} GBALLOC_DUMP_FORMAT;
+
+typedef void(*GBALLOC_DUMP_WRITE)(void* context, const char* text);
+
 /* all translation units that need memory measurement need to have GB_MEASURE_MEMORY_FOR_THIS defined */
 /* GB_DEBUG_ALLOC is the switch that turns the measurement on/off, so that it is not on always */
 #if defined(GB_DEBUG_ALLOC)
@@ -30,6 +38,18 @@ extern void gballoc_free(void* ptr);
 extern size_t gballoc_getMaximumMemoryUsed(void);
 extern size_t gballoc_getCurrentMemoryUsed(void);
 
+/* allocations (malloc, calloc and realloc calls) and bytes requested since gballoc_init, freed or not */
+extern size_t gballoc_getAllocationCount(void);
+extern size_t gballoc_getAllocatedBytes(void);
+
+/* call site profiling: one in every interval allocations is attributed to its call site, 0 (the default) turns it off */
+extern void* gballoc_malloc_at(size_t size, const char* file, int line);
+extern void* gballoc_calloc_at(size_t nmemb, size_t size, const char* file, int line);
+extern void* gballoc_realloc_at(void* ptr, size_t size, const char* file, int line);
+extern void gballoc_setSampleInterval(size_t interval);
+extern void gballoc_resetCallSites(void);
+extern int gballoc_dumpCallSites(GBALLOC_DUMP_FORMAT format, GBALLOC_DUMP_WRITE write, void* context);
+
 /* if GB_MEASURE_MEMORY_FOR_THIS is defined then we want to redirect memory allocation functions to gballoc_xxx functions */
 #ifdef GB_MEASURE_MEMORY_FOR_THIS
 #if defined(_CRTDBG_MAP_ALLOC) && defined(_DEBUG)
@@ -41,6 +61,12 @@ extern size_t gballoc_getCurrentMemoryUsed(void);
 #define _calloc_dbg(nmemb, size, ...) gballoc_calloc(nmemb, size)
 #define _realloc_dbg(ptr, size, ...) gballoc_realloc(ptr, size)
 #define _free_dbg(ptr, ...) gballoc_free(ptr)
+#elif defined(GB_PROFILE_CALL_SITES)
+/* GB_PROFILE_CALL_SITES keys the call site profile by file and line instead of return address */
+#define malloc(size) gballoc_malloc_at(size, __FILE__, __LINE__)
+#define calloc(nmemb, size) gballoc_calloc_at(nmemb, size, __FILE__, __LINE__)
+#define realloc(ptr, size) gballoc_realloc_at(ptr, size, __FILE__, __LINE__)
+#define free gballoc_free
 #else
 #define malloc gballoc_malloc
 #define calloc gballoc_calloc
@@ -56,6 +82,12 @@ extern size_t gballoc_getCurrentMemoryUsed(void);
 
 #define gballoc_getMaximumMemoryUsed() SIZE_MAX
 #define gballoc_getCurrentMemoryUsed() SIZE_MAX
+#define gballoc_getAllocationCount() SIZE_MAX
+#define gballoc_getAllocatedBytes() SIZE_MAX
+
+#define gballoc_setSampleInterval(interval) ((void)0)
+#define gballoc_resetCallSites() ((void)0)
+#define gballoc_dumpCallSites(format, write, context) __LINE__
 
 #endif /* GB_DEBUG_ALLOC */
 
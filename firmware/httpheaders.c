@@ -10,6 +10,7 @@
 #include "map.h"
 #include "httpheaders.h"
 #include <string.h>
+#include <stdint.h>
 #include "crt_abstractions.h"
 #include "iot_logging.h"
 
@@ -24,8 +25,86 @@ DEFINE_ENUM_STRINGS(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 typedef struct HTTP_HEADERS_HANDLE_DATA_TAG
 {
     MAP_HANDLE headers;
+    /*for overlays: the headers seen through headers, never modified through this handle*/
+    struct HTTP_HEADERS_HANDLE_DATA_TAG* base;
 } HTTP_HEADERS_HANDLE_DATA;
 
+/*the value of name in handleData, looking through an overlay to its base*/
+static const char* headers_FindValue(HTTP_HEADERS_HANDLE_DATA* handleData, const char* name)
+{
+    const char* result = Map_GetValueFromKey(handleData->headers, name);
+    if ((result == NULL) && (handleData->base != NULL))
+    {
+        result = Map_GetValueFromKey(handleData->base->headers, name);
+    }
+    return result;
+}
+
+/*an overlay lists the headers of its base first (with the overlay's value when it replaced them), then its own new headers*/
+static int headers_GetInternal(HTTP_HEADERS_HANDLE_DATA* handleData, size_t index, const char** name, const char** value, size_t* headerCount)
+{
+    int result;
+    const char*const* keys;
+    const char*const* values;
+    size_t count;
+
+    if (Map_GetInternals(handleData->headers, &keys, &values, &count) != MAP_OK)
+    {
+        result = __LINE__;
+    }
+    else if (handleData->base == NULL)
+    {
+        if (index < count)
+        {
+            *name = keys[index];
+            *value = values[index];
+        }
+        *headerCount = count;
+        result = 0;
+    }
+    else
+    {
+        const char*const* baseKeys;
+        const char*const* baseValues;
+        size_t baseCount;
+
+        if (Map_GetInternals(handleData->base->headers, &baseKeys, &baseValues, &baseCount) != MAP_OK)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            size_t i;
+            size_t total = baseCount;
+
+            if (index < baseCount)
+            {
+                const char* ownValue = Map_GetValueFromKey(handleData->headers, baseKeys[index]);
+                *name = baseKeys[index];
+                *value = (ownValue != NULL) ? ownValue : baseValues[index];
+            }
+
+            for (i = 0; i < count; i++)
+            {
+                if (Map_GetValueFromKey(handleData->base->headers, keys[i]) == NULL)
+                {
+                    if (total == index)
+                    {
+                        *name = keys[i];
+                        *value = values[i];
+                    }
+                    total++;
+                }
+            }
+
+            *headerCount = total;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 HTTP_HEADERS_HANDLE HTTPHeaders_Alloc(void)
 {
     /*Codes_SRS_HTTP_HEADERS_99_002:[ This API shall produce a HTTP_HANDLE that can later be used in subsequent calls to the module.]*/
@@ -48,7 +127,7 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Alloc(void)
         }
         else
         {
-            /*all is fine*/
+            result->base = NULL;
         }
     }
 
@@ -56,6 +135,51 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Alloc(void)
     return (HTTP_HEADERS_HANDLE)result;
 }
 
+HTTP_HEADERS_HANDLE HTTPHeaders_AllocOverlay(HTTP_HEADERS_HANDLE base)
+{
+    HTTP_HEADERS_HANDLE_DATA* result;
+
+    if (base == NULL)
+    {
+        LogError("invalid arg (NULL) base\r\n");
+        result = NULL;
+    }
+    else
+    {
+        result = (HTTP_HEADERS_HANDLE_DATA*)HTTPHeaders_Alloc();
+        if (result == NULL)
+        {
+            LogError("HTTPHeaders_Alloc failed\r\n");
+        }
+        else
+        {
+            /*an overlay of an overlay looks straight through to the bottom headers, the overlay's own headers are copied*/
+            HTTP_HEADERS_HANDLE_DATA* baseData = (HTTP_HEADERS_HANDLE_DATA*)base;
+            if (baseData->base == NULL)
+            {
+                result->base = baseData;
+            }
+            else
+            {
+                Map_Destroy(result->headers);
+                result->headers = Map_Clone(baseData->headers);
+                if (result->headers == NULL)
+                {
+                    LogError("Map_Clone failed\r\n");
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->base = baseData->base;
+                }
+            }
+        }
+    }
+
+    return (HTTP_HEADERS_HANDLE)result;
+}
+
 /*Codes_SRS_HTTP_HEADERS_99_005:[ Calling this API shall de-allocate the data structures allocated by previous API calls to the same handle.]*/
 void HTTPHeaders_Free(HTTP_HEADERS_HANDLE handle)
 {
@@ -110,7 +234,7 @@ static HTTP_HEADERS_RESULT headers_ReplaceHeaderNameValuePair(HTTP_HEADERS_HANDL
         else
         {
             HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
-            const char* existingValue = Map_GetValueFromKey(handleData->headers, name);
+            const char* existingValue = headers_FindValue(handleData, name);
             /*eat up the whitespaces from value, as per RFC 2616, chapter 4.2 "The field value MAY be preceded by any amount of LWS, though a single SP is preferred."*/
             /*Codes_SRS_HTTP_HEADERS_02_002: [The LWS from the beginning of the value shall not be stored.] */
             while ((value[0] == ' ') || (value[0] == '\t') || (value[0] == '\r') || (value[0] == '\n'))
@@ -198,7 +322,7 @@ const char* HTTPHeaders_FindHeaderValue(HTTP_HEADERS_HANDLE httpHeadersHandle, c
         /*Codes_SRS_HTTP_HEADERS_99_020:[ The return value shall be different than NULL when the name matches the name of a previously stored name:value pair.] */
         /*Codes_SRS_HTTP_HEADERS_99_021:[ In this case the return value shall point to a string that shall strcmp equal to the original stored string.]*/
         HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)httpHeadersHandle;
-        result = Map_GetValueFromKey(handleData->headers, name);
+        result = headers_FindValue(handleData, name);
     }
     return result;
 
@@ -218,10 +342,10 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeaderCount(HTTP_HEADERS_HANDLE handle, size_
     else
     {
         HTTP_HEADERS_HANDLE_DATA *handleData = (HTTP_HEADERS_HANDLE_DATA *)handle;
-        const char*const* keys;
-        const char*const* values;
+        const char* name;
+        const char* value;
         /*Codes_SRS_HTTP_HEADERS_99_023:[ Calling this API shall provide the number of stored headers.]*/
-        if (Map_GetInternals(handleData->headers, &keys, &values, headerCount) != MAP_OK)
+        if (headers_GetInternal(handleData, SIZE_MAX, &name, &value, headerCount) != 0)
         {
             /*Codes_SRS_HTTP_HEADERS_99_037:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs.]*/
             result = HTTP_HEADERS_ERROR;
@@ -256,10 +380,10 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, size_t ind
     else
     {
         HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
-        const char*const* keys;
-        const char*const* values;
+        const char* name;
+        const char* value;
         size_t headerCount;
-        if (Map_GetInternals(handleData->headers, &keys, &values, &headerCount) != MAP_OK)
+        if (headers_GetInternal(handleData, index, &name, &value, &headerCount) != 0)
         {
             /*Codes_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
             result = HTTP_HEADERS_ERROR;
@@ -275,7 +399,7 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, size_t ind
             }
             else
             {
-                *destination = (char*)malloc(strlen(keys[index]) + COLON_AND_SPACE_LENGTH + strlen(values[index]) + 1);
+                *destination = (char*)malloc(strlen(name) + COLON_AND_SPACE_LENGTH + strlen(value) + 1);
                 if (*destination == NULL)
                 {
                     /*Codes_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
@@ -286,9 +410,9 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, size_t ind
                 {
                     /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
                     /*Codes_SRS_HTTP_HEADERS_99_027:[ Calling this API shall produce the string value+": "+pair) for the index header in the *destination parameter.]*/
-                    strcpy(*destination, keys[index]);
+                    strcpy(*destination, name);
                     strcat(*destination, COLON_AND_SPACE);
-                    strcat(*destination, values[index]);
+                    strcat(*destination, value);
                     /*Codes_SRS_HTTP_HEADERS_99_035:[ The function shall return HTTP_HEADERS_OK when the function executed without error.]*/
                     result = HTTP_HEADERS_OK;
                 }
@@ -327,7 +451,7 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Clone(HTTP_HEADERS_HANDLE handle)
             }
             else
             {
-                /*all is fine*/
+                result->base = handleData->base;
             }
         }
     }
@@ -150,6 +150,21 @@ extern HTTP_HEADERS_RESULT HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, siz
  */
 extern HTTP_HEADERS_HANDLE HTTPHeaders_Clone(HTTP_HEADERS_HANDLE handle);
 
+/**
+ * @brief	Produces a collection of HTTP headers that starts out with the
+ * 			headers of @p base without copying them.
+ *
+ * @param   base	A valid @c HTTP_HEADERS_HANDLE value.
+ *
+ *			Headers added or replaced through the overlay are stored only in
+ *			the overlay, @p base is never modified through it. The overlay
+ *			reads @p base on every call, so @p base has to outlive it and
+ *			should not change while it is in use. Free it with ::HTTPHeaders_Free.
+ *
+ * @return	A @c HTTP_HEADERS_HANDLE or @c NULL when an error occurs.
+ */
+extern HTTP_HEADERS_HANDLE HTTPHeaders_AllocOverlay(HTTP_HEADERS_HANDLE base);
+
 #ifdef __cplusplus
 }
 #endif 
@@ -256,6 +256,13 @@ IOTHUB_CLIENT_HANDLE IoTHubClient_CreateWithTransport(TRANSPORT_HANDLE transport
 							free(result);
 							result = NULL;
 						}
+						else if (IoTHubTransport_RegisterStripes(transportHandle, config, result->IoTHubClientLLHandle) != IOTHUB_CLIENT_OK)
+						{
+							LogError("unable to spread the device over the striped transport");
+							IoTHubClient_LL_Destroy(result->IoTHubClientLLHandle);
+							free(result);
+							result = NULL;
+						}
 
 						if (Unlock(transportLock) != LOCK_OK)
 						{
@@ -301,6 +308,7 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
 		{
 			/*Codes_SRS_IOTHUBCLIENT_01_007: [ The thread created as part of executing IoTHubClient_SendEventAsync or IoTHubClient_SetNotificationMessageCallback shall be joined. ]*/
 			okToJoin = IoTHubTransport_SignalEndWorkerThread(iotHubClientInstance->TransportHandle, iotHubClientHandle);
+			IoTHubTransport_UnregisterStripes(iotHubClientInstance->TransportHandle, iotHubClientInstance->IoTHubClientLLHandle);
 		}
 
         /* Codes_SRS_IOTHUBCLIENT_01_006: [That includes destroying the IoTHubClient_LL instance by calling IoTHubClient_LL_Destroy.] */
@@ -385,6 +393,43 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_SendEventBatchAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const IOTHUB_EVENT_BATCH_ITEM* events, size_t eventCount)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle\r\n");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock\r\n");
+        }
+        else
+        {
+            if ((result = StartWorkerThreadIfNeeded(iotHubClientInstance)) != IOTHUB_CLIENT_OK)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+                LogError("Could not start worker thread\r\n");
+            }
+            else
+            {
+                result = IoTHubClient_LL_SendEventBatchAsync(iotHubClientInstance->IoTHubClientLLHandle, events, eventCount);
+            }
+
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -499,6 +544,34 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetLastMessageReceiveTime(IOTHUB_CLIENT_HANDLE
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_GetMemoryUsage(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MEMORY_USAGE* memoryUsage)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle\r\n");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock\r\n");
+        }
+        else
+        {
+            result = IoTHubClient_LL_GetMemoryUsage(iotHubClientInstance->IoTHubClientLLHandle, memoryUsage);
+            Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -522,6 +595,20 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHan
         {
             LogError("IoTHubClient_LL_SetOption failed\r\n");
         }
+        else if (iotHubClientInstance->TransportHandle != NULL)
+        {
+            /* the client only knows the first connection of a striped transport */
+            if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+                LogError("Could not acquire lock\r\n");
+            }
+            else
+            {
+                result = IoTHubTransport_SetStripeOption(iotHubClientInstance->TransportHandle, optionName, value);
+                (void)Unlock(iotHubClientInstance->LockHandle);
+            }
+        }
     }
     return result;
 }
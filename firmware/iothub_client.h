@@ -102,6 +102,19 @@ extern "C"
     */
     extern IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback);
 
+    /**
+    * @brief	Asynchronous call to send several messages at once, see
+    *			::IoTHubClient_LL_SendEventBatchAsync. The client lock is taken once for
+    *			the whole batch.
+    *
+    * @param	iotHubClientHandle		   	The handle created by a call to the create function.
+    * @param	events					   	The messages to send, with their confirmation callbacks.
+    * @param	eventCount				   	The number of items in @p events.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    extern IOTHUB_CLIENT_RESULT IoTHubClient_SendEventBatchAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const IOTHUB_EVENT_BATCH_ITEM* events, size_t eventCount);
+
     /**
     * @brief	This function returns the current sending status for IoTHubClient.
     *
@@ -146,6 +159,16 @@ extern "C"
     */
     extern IOTHUB_CLIENT_RESULT IoTHubClient_GetLastMessageReceiveTime(IOTHUB_CLIENT_HANDLE iotHubClientHandle, time_t* lastMessageReceiveTime);
 
+    /**
+    * @brief	This function reports how much memory the events queued in the client use.
+    *
+    * @param	iotHubClientHandle		The handle created by a call to the create function.
+    * @param	memoryUsage				Out parameter receiving the current usage.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    extern IOTHUB_CLIENT_RESULT IoTHubClient_GetMemoryUsage(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MEMORY_USAGE* memoryUsage);
+
     /**
     * @brief	This API sets a runtime option identified by parameter @p optionName
     * 			to a value pointed to by @p value. @p optionName and the data type
@@ -183,6 +206,8 @@ extern "C"
     *				- @b messageTimeout - the maximum time in milliseconds until a message 
     *                 is timeouted. The time starts at IoTHubClient_SendEventAsync. By default,
     *                 messages do not expire. 
+    *				- @b memoryHighWatermark, @b memoryLowWatermark, @b memoryPolicy - the
+    *				  memory budget of the queued events, see ::IoTHubClient_LL_SetOption.
     * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
     */
     extern IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const char* optionName, const void* value);
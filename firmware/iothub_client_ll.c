@@ -11,6 +11,7 @@
 #include "doublylinkedlist.h"
 #include "iot_logging.h"
 #include "tickcounter.h"
+#include "trace_probes.h"
 
 #include "iothub_client_ll.h"
 #include "iothub_client_private.h"
@@ -20,7 +21,19 @@
 #define LOG_ERROR LogError("result = %s\r\n", ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, result));
 #define INDEFINITE_TIME ((time_t)(-1))
 
+/*send pacing: rates are in events per minute and the token bucket counts 1/60000 of an event per millisecond per unit of rate*/
+#define PACING_TOKENS_PER_EVENT ((uint64_t)60000)
+#define PACING_MINIMUM_RATE ((size_t)6)
+/*where pacing starts when a throttle signal comes before anything was confirmed*/
+#define PACING_INITIAL_RATE ((size_t)60)
+#define PACING_DEFAULT_BURST ((size_t)10)
+/*the rate grows by one event per minute for every that many milliseconds events keep getting through while pacing holds others back*/
+#define PACING_INCREASE_INTERVAL ((uint64_t)2000)
+#define PACING_INITIAL_BACKOFF ((uint64_t)250)
+#define PACING_MAXIMUM_BACKOFF ((uint64_t)8000)
+
 DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
+DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_MEMORY_POLICY, IOTHUB_CLIENT_MEMORY_POLICY_VALUES);
 
 typedef struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG
 {
@@ -34,8 +47,41 @@ typedef struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG
     time_t lastMessageReceiveTime;
     TICK_COUNTER_HANDLE tickCounter; /*shared tickcounter used to track message timeouts in waitingToSend list*/
     uint64_t currentMessageTimeout;
+    size_t queuedEventBytes; /*charged by every event from the moment it is queued until it completes, wherever it is held*/
+    size_t queuedEventCount;
+    size_t droppedEventCount;
+    size_t waitingToSendRemovals; /*bumped whenever the client itself takes events out of waitingToSend*/
+    size_t memoryHighWatermark; /*0 means no memory budget*/
+    size_t memoryLowWatermark; /*follows memoryHighWatermark until it is set on its own*/
+    bool isMemoryLowWatermarkSet;
+    IOTHUB_CLIENT_MEMORY_POLICY memoryPolicy;
+    bool isOverBudget;
+    /*send pacing: while sendRate is not 0 new events wait in pacedEvents and DoWork moves them to waitingToSend as tokens allow*/
+    DLIST_ENTRY pacedEvents;
+    bool isThrottlePacingEnabled;
+    bool reclaimWaitingToSend; /*set by a throttle signal, waitingToSend goes back to the front of pacedEvents at the next DoWork*/
+    size_t sendRateLimit; /*0 means no configured limit*/
+    size_t sendRate;
+    size_t sendBurst;
+    uint64_t sendTokens;
+    uint64_t lastRefillTime;
+    uint64_t pausedUntil;
+    uint64_t throttleBackoff;
+    uint64_t lastIncreaseTime;
+    size_t confirmedSinceThrottle;
+    uint64_t rateWindowStart; /*events confirmed in the current and the previous minute, to start pacing near the rate that got throttled*/
+    size_t confirmedThisWindow;
+    size_t confirmedLastWindow;
+    size_t throttleCount;
 }IOTHUB_CLIENT_LL_HANDLE_DATA;
 
+/*one allocation holding all the entries queued by a IoTHubClient_LL_SendEventBatchAsync call. It is freed when the last of them completes*/
+typedef struct IOTHUB_MESSAGE_LIST_BLOCK_TAG
+{
+    size_t pendingCount;
+    IOTHUB_MESSAGE_LIST entries[];
+}IOTHUB_MESSAGE_LIST_BLOCK;
+
 static const char HOSTNAME_TOKEN[] = "HostName";
 static const char DEVICEID_TOKEN[] = "DeviceId";
 static const char DEVICEKEY_TOKEN[] = "SharedAccessKey";
@@ -246,6 +292,26 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateFromConnectionString(const char* c
     return result;
 }
 
+static void init_pacing(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    DList_InitializeListHead(&(handleData->pacedEvents));
+    handleData->isThrottlePacingEnabled = true;
+    handleData->reclaimWaitingToSend = false;
+    handleData->sendRateLimit = 0;
+    handleData->sendRate = 0;
+    handleData->sendBurst = PACING_DEFAULT_BURST;
+    handleData->sendTokens = 0;
+    handleData->lastRefillTime = 0;
+    handleData->pausedUntil = 0;
+    handleData->throttleBackoff = PACING_INITIAL_BACKOFF;
+    handleData->lastIncreaseTime = 0;
+    handleData->confirmedSinceThrottle = 0;
+    handleData->rateWindowStart = 0;
+    handleData->confirmedThisWindow = 0;
+    handleData->confirmedLastWindow = 0;
+    handleData->throttleCount = 0;
+}
+
 static void setTransportProtocol(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, TRANSPORT_PROVIDER* protocol)
 {
 	handleData->IoTHubTransport_SetOption = protocol->IoTHubTransport_SetOption;
@@ -326,6 +392,16 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_Create(const IOTHUB_CLIENT_CONFIG* confi
 					handleData->isSharedTransport = false;
                         /*Codes_SRS_IOTHUBCLIENT_LL_02_042: [ By default, messages shall not timeout. ]*/
                         handleData->currentMessageTimeout = 0; 
+                        handleData->queuedEventBytes = 0;
+                        handleData->queuedEventCount = 0;
+                        handleData->droppedEventCount = 0;
+                        handleData->waitingToSendRemovals = 0;
+                        handleData->memoryHighWatermark = 0;
+                        handleData->memoryLowWatermark = 0;
+                        handleData->isMemoryLowWatermarkSet = false;
+                        handleData->memoryPolicy = IOTHUB_CLIENT_MEMORY_REJECT;
+                        handleData->isOverBudget = false;
+                        init_pacing(handleData);
 					result = handleData;
 				}
             }
@@ -391,6 +467,16 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateWithTransport(const IOTHUB_CLIENT_
 				handleData->isSharedTransport = true;
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_042: [ By default, messages shall not timeout. ]*/
                     handleData->currentMessageTimeout = 0;
+                    handleData->queuedEventBytes = 0;
+                    handleData->queuedEventCount = 0;
+                    handleData->droppedEventCount = 0;
+                    handleData->waitingToSendRemovals = 0;
+                    handleData->memoryHighWatermark = 0;
+                    handleData->memoryLowWatermark = 0;
+                    handleData->isMemoryLowWatermarkSet = false;
+                    handleData->memoryPolicy = IOTHUB_CLIENT_MEMORY_REJECT;
+                    handleData->isOverBudget = false;
+                    init_pacing(handleData);
 				result = handleData;
 			}
 		}
@@ -414,7 +500,11 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 			/*Codes_SRS_IOTHUBCLIENT_LL_02_010: [If iotHubClientHandle was not created by IoTHubClient_LL_CreateWithTransport, IoTHubClient_LL_Destroy  shall call the underlaying layer's _Destroy function.] */
 			handleData->IoTHubTransport_Destroy(handleData->transportHandle);
 		}
-        /*if any, remove the items currently not send*/
+        /*if any, remove the items currently not send, the ones held back by pacing are the most recent*/
+        while ((unsend = DList_RemoveHeadList(&(handleData->pacedEvents))) != &(handleData->pacedEvents))
+        {
+            DList_InsertTailList(&(handleData->waitingToSend), unsend);
+        }
         while ((unsend = DList_RemoveHeadList(&(handleData->waitingToSend))) != &(handleData->waitingToSend))
         {
             IOTHUB_MESSAGE_LIST* temp = containingRecord(unsend, IOTHUB_MESSAGE_LIST, entry);
@@ -424,7 +514,7 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
                 temp->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, temp->context);
             }
             IoTHubMessage_Destroy(temp->messageHandle);
-            free(temp);
+            IoTHubClient_LL_FreeMessageListEntry(temp);
         }
 		/*Codes_SRS_IOTHUBCLIENT_LL_17_011: [IoTHubClient_LL_Destroy  shall free the resources allocated by IoTHubClient (if any).] */
         tickcounter_destroy(handleData->tickCounter);
@@ -432,6 +522,21 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
     }
 }
 
+PDLIST_ENTRY IoTHubClient_LL_GetWaitingToSend(IOTHUB_CLIENT_LL_HANDLE handle)
+{
+    PDLIST_ENTRY result;
+    if (handle == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
+        result = &(handleData->waitingToSend);
+    }
+    return result;
+}
+
 /*Codes_SRS_IOTHUBCLIENT_LL_02_044: [ Messages already delivered to IoTHubClient_LL shall not have their timeouts modified by a new call to IoTHubClient_LL_SetOption. ]*/
 /*returns 0 on success, any other value is error*/
 static int attach_ms_timesOutAfter(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST *newEntry)
@@ -460,7 +565,173 @@ static int attach_ms_timesOutAfter(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOT
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+/*the number of bytes an event is charged against the memory budget: its body and its queue entry. Mapped segments are
+not charged, they are file pages the kernel can drop, see IoTHubMessage_CreateFromFile for the copies the transports make*/
+static size_t get_event_charge(IOTHUB_MESSAGE_HANDLE eventMessageHandle)
+{
+    size_t result = sizeof(IOTHUB_MESSAGE_LIST);
+    if (IoTHubMessage_GetContentType(eventMessageHandle) == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        /*the segments are added up, copying them together would charge the body twice*/
+        const IOTHUB_MESSAGE_SEGMENT* segments;
+        size_t segmentCount;
+        if (IoTHubMessage_GetSegments(eventMessageHandle, &segments, &segmentCount) == IOTHUB_MESSAGE_OK)
+        {
+            size_t i;
+            for (i = 0; i < segmentCount; i++)
+            {
+                if (!segments[i].mapped)
+                {
+                    result += segments[i].size;
+                }
+            }
+        }
+    }
+    else
+    {
+        const char* text = IoTHubMessage_GetString(eventMessageHandle);
+        if (text != NULL)
+        {
+            result += strlen(text);
+        }
+    }
+    return result;
+}
+
+static void drop_oldest_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    /*events held back by pacing are newer than the ones already released to the transport*/
+    PDLIST_ENTRY oldest;
+    IOTHUB_MESSAGE_LIST* messageList;
+    if (DList_IsListEmpty(&(handleData->waitingToSend)))
+    {
+        oldest = DList_RemoveHeadList(&(handleData->pacedEvents));
+    }
+    else
+    {
+        oldest = DList_RemoveHeadList(&(handleData->waitingToSend));
+        handleData->waitingToSendRemovals++;
+    }
+    messageList = containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry);
+    handleData->droppedEventCount++;
+    if (messageList->callback != NULL)
+    {
+        messageList->callback(IOTHUB_CLIENT_CONFIRMATION_ERROR, messageList->context);
+    }
+    IoTHubMessage_Destroy(messageList->messageHandle);
+    IoTHubClient_LL_FreeMessageListEntry(messageList);
+}
+
+/*the bytes of the events nobody started sending yet, the rest is owned by the transport until it completes them*/
+static size_t get_droppable_bytes(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    size_t result = 0;
+    PDLIST_ENTRY lists[2];
+    size_t i;
+    lists[0] = &(handleData->waitingToSend);
+    lists[1] = &(handleData->pacedEvents);
+    for (i = 0; i < 2; i++)
+    {
+        PDLIST_ENTRY current;
+        for (current = lists[i]->Flink; current != lists[i]; current = current->Flink)
+        {
+            result += containingRecord(current, IOTHUB_MESSAGE_LIST, entry)->chargedBytes;
+        }
+    }
+    return result;
+}
+
+/*returns 0 when events worth "bytes" can be queued within the memory budget. Once the high watermark is crossed
+the client stays over budget until the queued events drain below the low watermark. The caller has everything the
+events need allocated already, so that older events are only dropped for events that are certain to be queued*/
+static int reserve_event_bytes(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, size_t bytes)
+{
+    int result;
+    if (handleData->memoryHighWatermark == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        if (handleData->queuedEventBytes + bytes > handleData->memoryHighWatermark)
+        {
+            handleData->isOverBudget = true;
+        }
+
+        /*nothing is dropped when dropping everything that can be dropped would still not make room*/
+        if (handleData->isOverBudget &&
+            (handleData->memoryPolicy == IOTHUB_CLIENT_MEMORY_DROP_OLDEST) &&
+            (handleData->queuedEventBytes - get_droppable_bytes(handleData) + bytes <= handleData->memoryHighWatermark))
+        {
+            while ((handleData->queuedEventBytes + bytes > handleData->memoryLowWatermark) &&
+                ((!DList_IsListEmpty(&(handleData->waitingToSend))) || (!DList_IsListEmpty(&(handleData->pacedEvents)))))
+            {
+                drop_oldest_event(handleData);
+            }
+            if (handleData->queuedEventBytes + bytes <= handleData->memoryHighWatermark)
+            {
+                handleData->isOverBudget = false;
+            }
+        }
+
+        if (handleData->isOverBudget)
+        {
+            LogError("queued events use %u bytes, over the memory budget of %u bytes\r\n", (unsigned int)handleData->queuedEventBytes, (unsigned int)handleData->memoryHighWatermark);
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static size_t get_batch_charge(const IOTHUB_EVENT_BATCH_ITEM* events, size_t eventCount)
+{
+    size_t result = 0;
+    size_t i;
+    for (i = 0; i < eventCount; i++)
+    {
+        result += get_event_charge(events[i].eventMessageHandle);
+    }
+    return result;
+}
+
+static void charge_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* messageList, size_t bytes)
+{
+    messageList->owner = handleData;
+    messageList->chargedBytes = bytes;
+    handleData->queuedEventBytes += bytes;
+    handleData->queuedEventCount++;
+}
+
+static void release_event(IOTHUB_MESSAGE_LIST* messageList)
+{
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = messageList->owner;
+    handleData->queuedEventBytes -= messageList->chargedBytes;
+    handleData->queuedEventCount--;
+    if (handleData->isOverBudget && (handleData->queuedEventBytes <= handleData->memoryLowWatermark))
+    {
+        handleData->isOverBudget = false;
+    }
+}
+
+/*while pacing, or while earlier events are still held back, new events wait for DoWork to release them*/
+static void enqueue_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* messageList)
+{
+    if ((handleData->sendRate != 0) || (!DList_IsListEmpty(&(handleData->pacedEvents))))
+    {
+        DList_InsertTailList(&(handleData->pacedEvents), &(messageList->entry));
+    }
+    else
+    {
+        DList_InsertTailList(&(handleData->waitingToSend), &(messageList->entry));
+    }
+}
+
+/*queues eventMessageHandle itself when takeOwnership is true, a clone of it otherwise*/
+static IOTHUB_CLIENT_RESULT queue_event(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool takeOwnership)
 {
     IOTHUB_CLIENT_RESULT result;
     /*Codes_SRS_IOTHUBCLIENT_LL_02_011: [IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle or eventMessageHandle is NULL.]*/
@@ -485,17 +756,15 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
         else
         {
             IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
-           
+
             if (attach_ms_timesOutAfter(handleData, newEntry) != 0)
             {
                 result = IOTHUB_CLIENT_ERROR;
                 LOG_ERROR;
                 free(newEntry);
             }
-            else
-            {
             /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
-            if ((newEntry->messageHandle = IoTHubMessage_Clone(eventMessageHandle)) == NULL)
+            else if ((newEntry->messageHandle = takeOwnership ? eventMessageHandle : IoTHubMessage_Clone(eventMessageHandle)) == NULL)
             {
                 /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
                 result = IOTHUB_CLIENT_ERROR;
@@ -504,20 +773,152 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotH
             }
             else
             {
-                IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
-                /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
-                newEntry->callback = eventConfirmationCallback;
-                newEntry->context = userContextCallback;
-                DList_InsertTailList(&(handleData->waitingToSend), &(newEntry->entry));
-                /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
-                result = IOTHUB_CLIENT_OK;
+                size_t charge = get_event_charge(eventMessageHandle);
+                if (reserve_event_bytes(handleData, charge) != 0)
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                    LOG_ERROR;
+                    /*the message stays with the caller when the client does not queue it*/
+                    if (!takeOwnership)
+                    {
+                        IoTHubMessage_Destroy(newEntry->messageHandle);
+                    }
+                    free(newEntry);
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
+                    newEntry->callback = eventConfirmationCallback;
+                    newEntry->context = userContextCallback;
+                    newEntry->block = NULL;
+                    charge_event(handleData, newEntry, charge);
+                    enqueue_event(handleData, newEntry);
+                    TRACE_PROBE2(event_enqueue, iotHubClientHandle, newEntry);
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
+                    result = IOTHUB_CLIENT_OK;
+                }
             }
         }
     }
-    }
     return result; 
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return queue_event(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, false);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsyncTakeOwnership(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return queue_event(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, true);
+}
+
+void IoTHubClient_LL_FreeMessageListEntry(IOTHUB_MESSAGE_LIST* messageList)
+{
+    if (messageList != NULL)
+    {
+        release_event(messageList);
+        if (messageList->block == NULL)
+        {
+            free(messageList);
+        }
+        else if (--messageList->block->pendingCount == 0)
+        {
+            free(messageList->block);
+        }
+    }
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventBatchAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const IOTHUB_EVENT_BATCH_ITEM* events, size_t eventCount)
+{
+    IOTHUB_CLIENT_RESULT result;
+    size_t i;
+
+    if ((iotHubClientHandle == NULL) || (events == NULL) || (eventCount == 0))
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR;
+    }
+    else
+    {
+        /*same argument rules as IoTHubClient_LL_SendEventAsync, checked for every event before anything is queued*/
+        for (i = 0; i < eventCount; i++)
+        {
+            if ((events[i].eventMessageHandle == NULL) ||
+                ((events[i].eventConfirmationCallback == NULL) && (events[i].userContextCallback != NULL)))
+            {
+                break;
+            }
+        }
+
+        if (i < eventCount)
+        {
+            result = IOTHUB_CLIENT_INVALID_ARG;
+            LogError("invalid event at index %u\r\n", (unsigned int)i);
+        }
+        else
+        {
+            IOTHUB_MESSAGE_LIST_BLOCK* block = (IOTHUB_MESSAGE_LIST_BLOCK*)malloc(sizeof(IOTHUB_MESSAGE_LIST_BLOCK) + eventCount * sizeof(IOTHUB_MESSAGE_LIST));
+            if (block == NULL)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+                LOG_ERROR;
+            }
+            else
+            {
+                IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+
+                /*the whole batch was submitted at the same time, so the clock is read only once*/
+                if (attach_ms_timesOutAfter(handleData, &block->entries[0]) != 0)
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                    LOG_ERROR;
+                    free(block);
+                }
+                else
+                {
+                    for (i = 0; i < eventCount; i++)
+                    {
+                        if ((block->entries[i].messageHandle = IoTHubMessage_Clone(events[i].eventMessageHandle)) == NULL)
+                        {
+                            break;
+                        }
+                    }
+
+                    /*nothing is queued unless every message could be cloned and the whole batch fits the memory budget*/
+                    if ((i < eventCount) ||
+                        (reserve_event_bytes(handleData, get_batch_charge(events, eventCount)) != 0))
+                    {
+                        result = IOTHUB_CLIENT_ERROR;
+                        LOG_ERROR;
+                        while (i > 0)
+                        {
+                            IoTHubMessage_Destroy(block->entries[--i].messageHandle);
+                        }
+                        free(block);
+                    }
+                    else
+                    {
+                        block->pendingCount = eventCount;
+                        for (i = 0; i < eventCount; i++)
+                        {
+                            IOTHUB_MESSAGE_LIST* newEntry = &block->entries[i];
+                            newEntry->callback = events[i].eventConfirmationCallback;
+                            newEntry->context = events[i].userContextCallback;
+                            newEntry->ms_timesOutAfter = block->entries[0].ms_timesOutAfter;
+                            newEntry->block = block;
+                            charge_event(handleData, newEntry, get_event_charge(events[i].eventMessageHandle));
+                            enqueue_event(handleData, newEntry);
+                        }
+                        result = IOTHUB_CLIENT_OK;
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -560,6 +961,36 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE
     return result;
 }
 
+/*returns the number of events that timed out*/
+static size_t DoTimeoutsInList(PDLIST_ENTRY list, uint64_t nowTick)
+{
+    size_t result = 0;
+    DLIST_ENTRY* currentItemInWaitingToSend = list->Flink;
+    while (currentItemInWaitingToSend != list) /*while we are not at the end of the list*/
+    {
+        IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentItemInWaitingToSend, IOTHUB_MESSAGE_LIST, entry);
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_041: [ If more than value miliseconds have passed since the call to IoTHubClient_LL_SendEventAsync then the message callback shall be called with a status code of IOTHUB_CLIENT_CONFIRMATION_TIMEOUT. ]*/
+        if ((fullEntry->ms_timesOutAfter!=0) && (fullEntry->ms_timesOutAfter < nowTick))
+        {
+            PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
+            DList_RemoveEntryList(currentItemInWaitingToSend);
+            if (fullEntry->callback != NULL)
+            {
+                fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
+            }
+            IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
+            IoTHubClient_LL_FreeMessageListEntry(fullEntry);
+            currentItemInWaitingToSend = theNext;
+            result++;
+        }
+        else
+        {
+            currentItemInWaitingToSend = currentItemInWaitingToSend->Flink;
+        }
+    }
+    return result;
+}
+
 static void DoTimeouts(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
 {
     uint64_t nowTick;
@@ -569,37 +1000,237 @@ static void DoTimeouts(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
     }
     else
     {
-        DLIST_ENTRY* currentItemInWaitingToSend = handleData->waitingToSend.Flink;
-        while (currentItemInWaitingToSend != &(handleData->waitingToSend)) /*while we are not at the end of the list*/
+        if (DoTimeoutsInList(&(handleData->waitingToSend), nowTick) != 0)
         {
-            IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentItemInWaitingToSend, IOTHUB_MESSAGE_LIST, entry);
-            /*Codes_SRS_IOTHUBCLIENT_LL_02_041: [ If more than value miliseconds have passed since the call to IoTHubClient_LL_SendEventAsync then the message callback shall be called with a status code of IOTHUB_CLIENT_CONFIRMATION_TIMEOUT. ]*/
-            if ((fullEntry->ms_timesOutAfter!=0) && (fullEntry->ms_timesOutAfter < nowTick))
+            handleData->waitingToSendRemovals++;
+        }
+        (void)DoTimeoutsInList(&(handleData->pacedEvents), nowTick);
+    }
+}
+
+/*moves every event of "from" in front of the events of "to", keeping their order*/
+static void move_to_front(PDLIST_ENTRY to, PDLIST_ENTRY from)
+{
+    while (!DList_IsListEmpty(from))
+    {
+        PDLIST_ENTRY newest = from->Blink;
+        DList_RemoveEntryList(newest);
+        DList_InsertHeadList(to, newest);
+    }
+}
+
+/*token bucket: sendRate events per minute with bursts of up to sendBurst events, nothing is released during the pause
+that follows a throttle signal*/
+static void DoPacing(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    if (handleData->reclaimWaitingToSend)
+    {
+        /*what the transport did not pick up yet would only run into the same throttling*/
+        handleData->reclaimWaitingToSend = false;
+        if (!DList_IsListEmpty(&(handleData->waitingToSend)))
+        {
+            handleData->waitingToSendRemovals++;
+            move_to_front(&(handleData->pacedEvents), &(handleData->waitingToSend));
+        }
+    }
+
+    if (!DList_IsListEmpty(&(handleData->pacedEvents)))
+    {
+        if (handleData->sendRate == 0)
+        {
+            while (!DList_IsListEmpty(&(handleData->pacedEvents)))
             {
-                PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
-                DList_RemoveEntryList(currentItemInWaitingToSend);
-                if (fullEntry->callback != NULL)
+                DList_InsertTailList(&(handleData->waitingToSend), DList_RemoveHeadList(&(handleData->pacedEvents)));
+            }
+        }
+        else
+        {
+            uint64_t nowTick;
+            if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
+            {
+                LogError("unable to get the current ms, paced events will not be released\r\n");
+            }
+            else
+            {
+                uint64_t maxTokens = handleData->sendBurst * PACING_TOKENS_PER_EVENT;
+                if (nowTick > handleData->lastRefillTime)
+                {
+                    handleData->sendTokens += (nowTick - handleData->lastRefillTime) * handleData->sendRate;
+                    if (handleData->sendTokens > maxTokens)
+                    {
+                        handleData->sendTokens = maxTokens;
+                    }
+                }
+                handleData->lastRefillTime = nowTick;
+
+                if (nowTick >= handleData->pausedUntil)
                 {
-                    fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
+                    while ((handleData->sendTokens >= PACING_TOKENS_PER_EVENT) &&
+                        (!DList_IsListEmpty(&(handleData->pacedEvents))))
+                    {
+                        DList_InsertTailList(&(handleData->waitingToSend), DList_RemoveHeadList(&(handleData->pacedEvents)));
+                        handleData->sendTokens -= PACING_TOKENS_PER_EVENT;
+                    }
                 }
-                IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
-                free(fullEntry);
-                currentItemInWaitingToSend = theNext;
+            }
+        }
+    }
+}
+
+/*additive increase of the pacing rate, and the per minute count of confirmed events a throttle signal starts from*/
+static void count_confirmed_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    uint64_t nowTick;
+    if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) == 0)
+    {
+        if (nowTick - handleData->rateWindowStart >= 60000)
+        {
+            handleData->confirmedLastWindow = (nowTick - handleData->rateWindowStart < 120000) ? handleData->confirmedThisWindow : 0;
+            handleData->confirmedThisWindow = 0;
+            handleData->rateWindowStart = nowTick;
+        }
+
+        /*the rate only grows while it is what holds events back, an idle client has nothing to learn about the quota*/
+        if ((handleData->sendRate == 0) || DList_IsListEmpty(&(handleData->pacedEvents)) || (nowTick < handleData->lastIncreaseTime))
+        {
+            handleData->lastIncreaseTime = nowTick;
+        }
+        else if (nowTick - handleData->lastIncreaseTime >= PACING_INCREASE_INTERVAL)
+        {
+            handleData->sendRate += (size_t)((nowTick - handleData->lastIncreaseTime) / PACING_INCREASE_INTERVAL);
+            if ((handleData->sendRateLimit != 0) && (handleData->sendRate > handleData->sendRateLimit))
+            {
+                handleData->sendRate = handleData->sendRateLimit;
+            }
+            handleData->lastIncreaseTime = nowTick;
+        }
+    }
+    handleData->confirmedThisWindow++;
+    handleData->confirmedSinceThrottle++;
+    handleData->throttleBackoff = PACING_INITIAL_BACKOFF;
+}
+
+void IoTHubClient_LL_ReportThrottle(IOTHUB_CLIENT_LL_HANDLE handle, uint64_t retryAfterMs)
+{
+    if (handle == NULL)
+    {
+        LogError("invalid arg\r\n");
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
+        handleData->throttleCount++;
+        if (handleData->isThrottlePacingEnabled)
+        {
+            uint64_t nowTick;
+            bool hasNowTick = (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) == 0);
+
+            /*multiplicative decrease, once per throttling episode: more signals before an event got through again
+            only make the pause longer. Without pacing yet it starts from what got through lately*/
+            if ((handleData->sendRate == 0) || (handleData->confirmedSinceThrottle != 0))
+            {
+                size_t observedRate = handleData->confirmedLastWindow;
+                size_t newRate;
+
+                if (hasNowTick && (nowTick - handleData->rateWindowStart >= 1000))
+                {
+                    /*the current minute is extrapolated once it is a second old*/
+                    size_t currentRate = (size_t)(handleData->confirmedThisWindow * 60000 / (nowTick - handleData->rateWindowStart));
+                    if (currentRate > observedRate)
+                    {
+                        observedRate = currentRate;
+                    }
+                }
+                newRate = ((handleData->sendRate != 0) ? handleData->sendRate : (observedRate != 0) ? observedRate : PACING_INITIAL_RATE) / 4 * 3;
+
+                if (newRate < PACING_MINIMUM_RATE)
+                {
+                    newRate = PACING_MINIMUM_RATE;
+                }
+                if ((handleData->sendRateLimit != 0) && (newRate > handleData->sendRateLimit))
+                {
+                    newRate = handleData->sendRateLimit;
+                }
+                handleData->sendRate = newRate;
+                handleData->confirmedSinceThrottle = 0;
+            }
+            handleData->sendTokens = 0;
+
+            if (!hasNowTick)
+            {
+                LogError("unable to get the current ms, the send pause is skipped\r\n");
             }
             else
             {
-                currentItemInWaitingToSend = currentItemInWaitingToSend->Flink;
+                handleData->pausedUntil = nowTick + ((retryAfterMs != 0) ? retryAfterMs : handleData->throttleBackoff);
+                handleData->lastRefillTime = handleData->pausedUntil;
+                handleData->lastIncreaseTime = handleData->pausedUntil;
+            }
+            if (handleData->throttleBackoff < PACING_MAXIMUM_BACKOFF)
+            {
+                handleData->throttleBackoff *= 2;
             }
+
+            /*transports report throttling while walking their lists, so waitingToSend is only reclaimed at the next DoWork*/
+            handleData->reclaimWaitingToSend = true;
         }
     }
 }
 
+void IoTHubClient_LL_RetryEvent(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_MESSAGE_LIST* messageList)
+{
+    if ((handle == NULL) || (messageList == NULL))
+    {
+        LogError("invalid arg\r\n");
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
+        DList_InsertHeadList(&(handleData->pacedEvents), &(messageList->entry));
+    }
+}
+
+size_t IoTHubClient_LL_GetWaitingToSendRemovals(IOTHUB_CLIENT_LL_HANDLE handle)
+{
+    size_t result;
+
+    if (handle == NULL)
+    {
+        LogError("invalid arg\r\n");
+        result = 0;
+    }
+    else
+    {
+        result = ((IOTHUB_CLIENT_LL_HANDLE_DATA*)handle)->waitingToSendRemovals;
+    }
+
+    return result;
+}
+
+IOTHUB_DEVICE_HANDLE IoTHubClient_LL_GetDeviceHandle(IOTHUB_CLIENT_LL_HANDLE handle)
+{
+    IOTHUB_DEVICE_HANDLE result;
+
+    if (handle == NULL)
+    {
+        LogError("invalid arg\r\n");
+        result = NULL;
+    }
+    else
+    {
+        result = ((IOTHUB_CLIENT_LL_HANDLE_DATA*)handle)->deviceHandle;
+    }
+
+    return result;
+}
+
 void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 {
     /*Codes_SRS_IOTHUBCLIENT_LL_02_020: [If parameter iotHubClientHandle is NULL then IoTHubClient_LL_DoWork shall not perform any action.] */
     if (iotHubClientHandle != NULL)
     {
         IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        DoPacing(handleData);
         DoTimeouts(handleData);
         handleData->IoTHubTransport_DoWork(handleData->transportHandle, iotHubClientHandle);
     }
@@ -621,7 +1252,16 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE iotHu
 
         /* Codes_SRS_IOTHUBCLIENT_09_008: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_IDLE if there is currently no items to be sent] */
         /* Codes_SRS_IOTHUBCLIENT_09_009: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY if there are currently items to be sent] */
-        result = handleData->IoTHubTransport_GetSendStatus(handleData->deviceHandle, iotHubClientStatus);
+        if (!DList_IsListEmpty(&(handleData->pacedEvents)))
+        {
+            /*events held back by pacing are still to be sent even when the transport is idle*/
+            *iotHubClientStatus = IOTHUB_CLIENT_SEND_STATUS_BUSY;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else
+        {
+            result = handleData->IoTHubTransport_GetSendStatus(handleData->deviceHandle, iotHubClientStatus);
+        }
     }
 
     return result;
@@ -647,12 +1287,17 @@ void IoTHubClient_LL_SendComplete(IOTHUB_CLIENT_LL_HANDLE handle, PDLIST_ENTRY c
         while((oldest= DList_RemoveHeadList(completed))!=completed)
         {
             IOTHUB_MESSAGE_LIST* messageList = (IOTHUB_MESSAGE_LIST*)containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry);
+            if (result == IOTHUB_BATCHSTATE_SUCCESS)
+            {
+                count_confirmed_event((IOTHUB_CLIENT_LL_HANDLE_DATA*)handle);
+            }
+            TRACE_PROBE3(event_complete, handle, messageList, (int)(result == IOTHUB_BATCHSTATE_SUCCESS));
             if (messageList->callback != NULL)
             {
                 messageList->callback(resultToBeCalled, messageList->context);
             }
             IoTHubMessage_Destroy(messageList->messageHandle);
-            free(messageList);
+            IoTHubClient_LL_FreeMessageListEntry(messageList);
         }
     }
 }
@@ -720,6 +1365,27 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetLastMessageReceiveTime(IOTHUB_CLIENT_LL_
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetMemoryUsage(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MEMORY_USAGE* memoryUsage)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubClientHandle == NULL || memoryUsage == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        memoryUsage->queuedEventCount = handleData->queuedEventCount;
+        memoryUsage->queuedEventBytes = handleData->queuedEventBytes;
+        memoryUsage->droppedEventCount = handleData->droppedEventCount;
+        memoryUsage->isOverBudget = handleData->isOverBudget;
+        memoryUsage->allocatedBytes = gballoc_getCurrentMemoryUsed();
+        result = IOTHUB_CLIENT_OK;
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
     
@@ -748,6 +1414,98 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubCli
             handleData->currentMessageTimeout = *(const uint64_t*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp(optionName, "memoryHighWatermark") == 0)
+        {
+            /*bytes of queued events (bodies and queue entries) over which the memoryPolicy applies, "0" turns the budget off*/
+            size_t memoryHighWatermark = *(const size_t*)value;
+            if ((memoryHighWatermark != 0) &&
+                handleData->isMemoryLowWatermarkSet &&
+                (handleData->memoryLowWatermark > memoryHighWatermark))
+            {
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("memoryHighWatermark (%u) cannot be under memoryLowWatermark (%u)\r\n", (unsigned int)memoryHighWatermark, (unsigned int)handleData->memoryLowWatermark);
+            }
+            else
+            {
+                handleData->memoryHighWatermark = memoryHighWatermark;
+                if ((!handleData->isMemoryLowWatermarkSet) || (memoryHighWatermark == 0))
+                {
+                    handleData->memoryLowWatermark = memoryHighWatermark;
+                    handleData->isMemoryLowWatermarkSet = false;
+                }
+                handleData->isOverBudget = false;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, "memoryLowWatermark") == 0)
+        {
+            /*once over budget, queued events have to drain below this many bytes before new ones are accepted again*/
+            size_t memoryLowWatermark = *(const size_t*)value;
+            if (memoryLowWatermark > handleData->memoryHighWatermark)
+            {
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("memoryLowWatermark (%u) cannot be over memoryHighWatermark (%u)\r\n", (unsigned int)memoryLowWatermark, (unsigned int)handleData->memoryHighWatermark);
+            }
+            else
+            {
+                handleData->memoryLowWatermark = memoryLowWatermark;
+                handleData->isMemoryLowWatermarkSet = true;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, "memoryPolicy") == 0)
+        {
+            if (strcmp((const char*)value, "reject") == 0)
+            {
+                handleData->memoryPolicy = IOTHUB_CLIENT_MEMORY_REJECT;
+                result = IOTHUB_CLIENT_OK;
+            }
+            else if (strcmp((const char*)value, "drop_oldest") == 0)
+            {
+                handleData->memoryPolicy = IOTHUB_CLIENT_MEMORY_DROP_OLDEST;
+                result = IOTHUB_CLIENT_OK;
+            }
+            else
+            {
+                LogError("unknown memoryPolicy %s, it must be reject or drop_oldest\r\n", (const char*)value);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+        }
+        else if (strcmp(optionName, "throttlePacing") == 0)
+        {
+            /*when false throttle signals from the transport are only counted and events are sent as soon as possible*/
+            handleData->isThrottlePacingEnabled = *(const bool*)value;
+            if (!handleData->isThrottlePacingEnabled)
+            {
+                handleData->sendRate = handleData->sendRateLimit;
+                handleData->pausedUntil = 0;
+            }
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (strcmp(optionName, "sendRateLimit") == 0)
+        {
+            /*events per minute the client never exceeds, "0" leaves pacing to throttle signals only*/
+            handleData->sendRateLimit = *(const size_t*)value;
+            if ((handleData->sendRateLimit != 0) &&
+                ((handleData->sendRate == 0) || (handleData->sendRate > handleData->sendRateLimit)))
+            {
+                handleData->sendRate = handleData->sendRateLimit;
+            }
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (strcmp(optionName, "sendBurst") == 0)
+        {
+            if (*(const size_t*)value == 0)
+            {
+                LogError("sendBurst cannot be 0\r\n");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->sendBurst = *(const size_t*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         else
         {
         /*Codes_SRS_IOTHUBCLIENT_LL_02_038: [Otherwise, IoTHubClient_LL shall call the function _SetOption of the underlying transport and return what that function is returning.] */
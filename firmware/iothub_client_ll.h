@@ -66,6 +66,18 @@ DEFINE_ENUM(IOTHUB_CLIENT_CONFIRMATION_RESULT, IOTHUB_CLIENT_CONFIRMATION_RESULT
 */
 DEFINE_ENUM(IOTHUB_CLIENT_STATUS, IOTHUB_CLIENT_STATUS_VALUES);
 
+#define IOTHUB_CLIENT_MEMORY_POLICY_VALUES \
+    IOTHUB_CLIENT_MEMORY_REJECT,           \
+    IOTHUB_CLIENT_MEMORY_DROP_OLDEST       \
+
+/** @brief Enumeration of what the IoT Hub client does with a new event once the
+*		   queued events are over the memory budget set by the @b memoryHighWatermark
+*		   option. @c IOTHUB_CLIENT_MEMORY_REJECT fails the send call,
+*		   @c IOTHUB_CLIENT_MEMORY_DROP_OLDEST completes the oldest events not yet
+*		   handed to the transport with @c IOTHUB_CLIENT_CONFIRMATION_ERROR.
+*/
+DEFINE_ENUM(IOTHUB_CLIENT_MEMORY_POLICY, IOTHUB_CLIENT_MEMORY_POLICY_VALUES);
+
 #define TRANSPORT_TYPE_VALUES \
     TRANSPORT_LL, /*LL comes from "LowLevel" */ \
     TRANSPORT_THREADED
@@ -87,6 +99,35 @@ typedef void(*IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK)(IOTHUB_CLIENT_CONFIRMAT
 typedef IOTHUBMESSAGE_DISPOSITION_RESULT (*IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC)(IOTHUB_MESSAGE_HANDLE message, void* userContextCallback);
 typedef const void*(*IOTHUB_CLIENT_TRANSPORT_PROVIDER)(void);
 
+/** @brief	One event submitted through ::IoTHubClient_LL_SendEventBatchAsync. The fields
+*			have the same meaning as the parameters of ::IoTHubClient_LL_SendEventAsync. */
+typedef struct IOTHUB_EVENT_BATCH_ITEM_TAG
+{
+    IOTHUB_MESSAGE_HANDLE eventMessageHandle;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback;
+    void* userContextCallback;
+} IOTHUB_EVENT_BATCH_ITEM;
+
+/** @brief	Memory used by the events queued in an IoT Hub client, as returned by
+*			::IoTHubClient_LL_GetMemoryUsage. */
+typedef struct IOTHUB_CLIENT_MEMORY_USAGE_TAG
+{
+    /** @brief	Events sent and not completed yet, whether waiting or being sent. */
+    size_t queuedEventCount;
+
+    /** @brief	Bytes charged to the memory budget by these events. */
+    size_t queuedEventBytes;
+
+    /** @brief	Events completed with an error to stay within the memory budget. */
+    size_t droppedEventCount;
+
+    /** @brief	True between crossing the high watermark and draining below the low one. */
+    bool isOverBudget;
+
+    /** @brief	Bytes allocated through gballoc, or @c SIZE_MAX if it is not measuring. */
+    size_t allocatedBytes;
+} IOTHUB_CLIENT_MEMORY_USAGE;
+
 /** @brief	This struct captures IoTHub client configuration. */
 typedef struct IOTHUB_CLIENT_CONFIG_TAG
 {
@@ -214,6 +255,32 @@ extern void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle);
  */
 extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback);
 
+/**
+ * @brief	Same as ::IoTHubClient_LL_SendEventAsync, but the message is queued as it is
+ *			instead of being cloned. On success the client owns @p eventMessageHandle and
+ *			destroys it once the event completes, the caller must not use it anymore. On
+ *			failure the caller still owns it.
+ * 
+ * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+ */
+extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsyncTakeOwnership(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback);
+
+/**
+ * @brief	Asynchronous call to send several messages at once. It behaves like calling
+ *			::IoTHubClient_LL_SendEventAsync for each of @p events in order, but the
+ *			queue entries share a single allocation and the message timeout is computed
+ *			once for the whole batch.
+ *
+ * @param	iotHubClientHandle		   	The handle created by a call to the create function.
+ * @param	events					   	The messages to send, with their confirmation callbacks.
+ * @param	eventCount				   	The number of items in @p events.
+ *
+ *			Either all the messages are queued or none of them is.
+ * 
+ * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+ */
+extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventBatchAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const IOTHUB_EVENT_BATCH_ITEM* events, size_t eventCount);
+
 /**
  * @brief	This function returns the current sending status for IoTHubClient.
  *
@@ -258,6 +325,16 @@ extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_
  */
 extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetLastMessageReceiveTime(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, time_t* lastMessageReceiveTime);
 
+/**
+ * @brief	This function reports how much memory the events queued in the client use.
+ *
+ * @param	iotHubClientHandle	The handle created by a call to the create function.
+ * @param	memoryUsage			Out parameter receiving the current usage.
+ *
+ * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+ */
+extern IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetMemoryUsage(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MEMORY_USAGE* memoryUsage);
+
 /**
  * @brief	This function is meant to be called by the user when work
  * 			(sending/receiving) can be done by the IoTHubClient.
@@ -308,6 +385,15 @@ extern void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle);
  *                interval in seconds when pings are sent to the server.
  *              - @b logtrace - available for MQTT protocol.  Boolean value that turns on and
  *                off the diagnostic logging.
+ *				- @b memoryHighWatermark - bytes of queued events (bodies and queue entries)
+ *				  over which @b memoryPolicy applies. @p value is a pointer to a size_t.
+ *				  By default, or with a value of 0, there is no memory budget.
+ *				- @b memoryLowWatermark - once over budget, the queued events have to drain
+ *				  below this many bytes before new events are accepted again. @p value is
+ *				  a pointer to a size_t. It cannot be over @b memoryHighWatermark, so set
+ *				  that first. Until it is set it is the same as @b memoryHighWatermark.
+ *				- @b memoryPolicy - "reject" (the default) or "drop_oldest", see
+ *				  ::IOTHUB_CLIENT_MEMORY_POLICY. @p value is a null terminated string.
  *
  * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
  */
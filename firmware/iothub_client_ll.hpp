@@ -0,0 +1,354 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_client_ll.hpp
+*	@brief  Header only C++17 layer over @c IoTHubClient_LL.
+*
+*	@details ::iothub::Message owns an @c IOTHUB_MESSAGE_HANDLE and can only be
+*	         moved. ::iothub::Client::send hands it to the send queue through
+*	         ::IoTHubClient_LL_SendEventAsyncTakeOwnership, so it is neither
+*	         cloned nor destroyed on this path. Payloads and properties are read
+*	         through non-owning views into the message. Failures are reported
+*	         through the C result codes and empty objects, not exceptions.
+*/
+
+#ifndef IOTHUB_CLIENT_LL_HPP
+#define IOTHUB_CLIENT_LL_HPP
+
+#if __cplusplus < 201703L
+#error iothub_client_ll.hpp needs C++17
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#if (__cplusplus > 201703L) && __has_include(<span>)
+#include <span>
+#endif
+
+#include "iothub_client_ll.h"
+#include "iothub_message.h"
+
+namespace iothub
+{
+
+#if (__cplusplus > 201703L) && __has_include(<span>)
+    using Bytes = std::span<const unsigned char>;
+#else
+    /** @brief  Read only view of a byte range, std::span<const unsigned char> from C++20 on. */
+    class Bytes
+    {
+    public:
+        constexpr Bytes() noexcept : data_(nullptr), size_(0) {}
+        constexpr Bytes(const unsigned char* data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+        constexpr const unsigned char* data() const noexcept { return data_; }
+        constexpr std::size_t size() const noexcept { return size_; }
+        constexpr bool empty() const noexcept { return size_ == 0; }
+        constexpr const unsigned char* begin() const noexcept { return data_; }
+        constexpr const unsigned char* end() const noexcept { return data_ + size_; }
+        constexpr const unsigned char& operator[](std::size_t index) const noexcept { return data_[index]; }
+
+    private:
+        const unsigned char* data_;
+        std::size_t size_;
+    };
+#endif
+
+    /** @brief  Non-owning access to a message, e.g. one passed to a message callback. The
+    *           views it returns are valid as long as the message is not changed or destroyed. */
+    class MessageView
+    {
+    public:
+        constexpr MessageView() noexcept : handle_(nullptr) {}
+        constexpr explicit MessageView(IOTHUB_MESSAGE_HANDLE handle) noexcept : handle_(handle) {}
+
+        explicit operator bool() const noexcept { return handle_ != nullptr; }
+        IOTHUB_MESSAGE_HANDLE get() const noexcept { return handle_; }
+
+        /** @brief  The body, for string messages without the terminating NUL. */
+        Bytes payload() const noexcept
+        {
+            const unsigned char* buffer;
+            std::size_t size;
+            Bytes result;
+            if (IoTHubMessage_GetContentType(handle_) == IOTHUBMESSAGE_BYTEARRAY)
+            {
+                if (IoTHubMessage_GetByteArray(handle_, &buffer, &size) == IOTHUB_MESSAGE_OK)
+                {
+                    result = Bytes(buffer, size);
+                }
+            }
+            else
+            {
+                const char* text = IoTHubMessage_GetString(handle_);
+                if (text != nullptr)
+                {
+                    result = Bytes(reinterpret_cast<const unsigned char*>(text), std::strlen(text));
+                }
+            }
+            return result;
+        }
+
+        /** @brief  The value of property @p key, empty when the message does not have it. */
+        std::string_view property(std::string_view key) const noexcept
+        {
+            std::string_view result;
+            forEachProperty([&](std::string_view propertyKey, std::string_view value)
+            {
+                if (propertyKey == key)
+                {
+                    result = value;
+                }
+            });
+            return result;
+        }
+
+        /** @brief  Calls @p visit(key, value) for every property, without copying them. */
+        template <typename Visit>
+        void forEachProperty(Visit&& visit) const
+        {
+            const char* const* keys;
+            const char* const* values;
+            std::size_t count;
+            MAP_HANDLE properties = IoTHubMessage_Properties(handle_);
+            if ((properties != nullptr) && (Map_GetInternals(properties, &keys, &values, &count) == MAP_OK))
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    visit(std::string_view(keys[i]), std::string_view(values[i]));
+                }
+            }
+        }
+
+        std::string_view messageId() const noexcept { return toView(IoTHubMessage_GetMessageId(handle_)); }
+        std::string_view correlationId() const noexcept { return toView(IoTHubMessage_GetCorrelationId(handle_)); }
+
+    protected:
+        static std::string_view toView(const char* text) noexcept
+        {
+            return (text == nullptr) ? std::string_view() : std::string_view(text);
+        }
+
+        IOTHUB_MESSAGE_HANDLE handle_;
+    };
+
+    /** @brief  Owns an @c IOTHUB_MESSAGE_HANDLE. Move-only, a failed create leaves it empty. */
+    class Message : public MessageView
+    {
+    public:
+        Message() noexcept = default;
+        explicit Message(IOTHUB_MESSAGE_HANDLE handle) noexcept : MessageView(handle) {}
+        Message(const Message&) = delete;
+        Message& operator=(const Message&) = delete;
+        Message(Message&& other) noexcept : MessageView(other.release()) {}
+        Message& operator=(Message&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset(other.release());
+            }
+            return *this;
+        }
+        ~Message() { reset(nullptr); }
+
+        static Message fromBytes(Bytes payload) noexcept
+        {
+            return Message(IoTHubMessage_CreateFromByteArray(payload.data(), payload.size()));
+        }
+
+        static Message fromString(const char* text) noexcept
+        {
+            return Message(IoTHubMessage_CreateFromString(text));
+        }
+
+        /** @brief  ::IoTHubMessage_Build: body, properties and ids in one allocation, read only afterwards. */
+        static Message build(Bytes payload, const IOTHUB_MESSAGE_PROPERTY* properties, std::size_t propertyCount, const char* messageId = nullptr, const char* correlationId = nullptr) noexcept
+        {
+            return Message(IoTHubMessage_Build(payload.data(), payload.size(), properties, propertyCount, messageId, correlationId));
+        }
+
+        /** @brief  ::IoTHubMessage_CreateFromSegments: the body is not copied, the segments are released with the last clone. */
+        static Message fromSegments(const IOTHUB_MESSAGE_SEGMENT* segments, std::size_t segmentCount) noexcept
+        {
+            return Message(IoTHubMessage_CreateFromSegments(segments, segmentCount));
+        }
+
+        /** @brief  Adds or replaces a property. The C map keeps NUL terminated copies, so the
+        *           views are copied once here. */
+        IOTHUB_MESSAGE_RESULT setProperty(std::string_view key, std::string_view value)
+        {
+            IOTHUB_MESSAGE_RESULT result;
+            MAP_HANDLE properties = IoTHubMessage_Properties(handle_);
+            if (properties == nullptr)
+            {
+                result = IOTHUB_MESSAGE_INVALID_ARG;
+            }
+            else
+            {
+                std::string ownedKey(key);
+                std::string ownedValue(value);
+                result = (Map_AddOrUpdate(properties, ownedKey.c_str(), ownedValue.c_str()) == MAP_OK) ? IOTHUB_MESSAGE_OK : IOTHUB_MESSAGE_ERROR;
+            }
+            return result;
+        }
+
+        IOTHUB_MESSAGE_RESULT setMessageId(const char* messageId) noexcept { return IoTHubMessage_SetMessageId(handle_, messageId); }
+        IOTHUB_MESSAGE_RESULT setCorrelationId(const char* correlationId) noexcept { return IoTHubMessage_SetCorrelationId(handle_, correlationId); }
+
+        /** @brief  Gives up ownership, the caller has to destroy the returned handle. */
+        IOTHUB_MESSAGE_HANDLE release() noexcept
+        {
+            IOTHUB_MESSAGE_HANDLE handle = handle_;
+            handle_ = nullptr;
+            return handle;
+        }
+
+        void reset(IOTHUB_MESSAGE_HANDLE handle) noexcept
+        {
+            if (handle_ != nullptr)
+            {
+                IoTHubMessage_Destroy(handle_);
+            }
+            handle_ = handle;
+        }
+    };
+
+    /** @brief  Owns an @c IOTHUB_CLIENT_LL_HANDLE. Move-only, callbacks stay valid across moves. */
+    class Client
+    {
+    public:
+        using MessageCallback = std::function<IOTHUBMESSAGE_DISPOSITION_RESULT(MessageView)>;
+
+        Client() noexcept : handle_(nullptr) {}
+        explicit Client(const IOTHUB_CLIENT_CONFIG& config) noexcept : handle_(IoTHubClient_LL_Create(&config)) {}
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+        Client(Client&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)), messageCallback_(std::move(other.messageCallback_)) {}
+        Client& operator=(Client&& other) noexcept
+        {
+            if (this != &other)
+            {
+                destroy();
+                handle_ = std::exchange(other.handle_, nullptr);
+                messageCallback_ = std::move(other.messageCallback_);
+            }
+            return *this;
+        }
+        ~Client() { destroy(); }
+
+        static Client fromConnectionString(const char* connectionString, IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol) noexcept
+        {
+            Client result;
+            result.handle_ = IoTHubClient_LL_CreateFromConnectionString(connectionString, protocol);
+            return result;
+        }
+
+        explicit operator bool() const noexcept { return handle_ != nullptr; }
+        IOTHUB_CLIENT_LL_HANDLE get() const noexcept { return handle_; }
+
+        /** @brief  Queues @p message without cloning it. On success @p message is left empty,
+        *           on failure it is untouched and can be sent again. */
+        IOTHUB_CLIENT_RESULT send(Message&& message, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback = nullptr, void* userContextCallback = nullptr) noexcept
+        {
+            IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsyncTakeOwnership(handle_, message.get(), eventConfirmationCallback, userContextCallback);
+            if (result == IOTHUB_CLIENT_OK)
+            {
+                (void)message.release();
+            }
+            return result;
+        }
+
+        /** @brief  Same, with @p onConfirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT) called once the
+        *           event completes. It is kept in one allocation until then. */
+        template <typename OnConfirmation>
+        IOTHUB_CLIENT_RESULT send(Message&& message, OnConfirmation&& onConfirmation)
+        {
+            using Holder = std::decay_t<OnConfirmation>;
+            IOTHUB_CLIENT_RESULT result;
+            Holder* holder = new (std::nothrow) Holder(std::forward<OnConfirmation>(onConfirmation));
+            if (holder == nullptr)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if ((result = send(std::move(message), &confirmationTrampoline<Holder>, holder)) != IOTHUB_CLIENT_OK)
+            {
+                delete holder;
+            }
+            return result;
+        }
+
+        /** @brief  @p onMessage(MessageView) returns the disposition, the view is only valid during
+        *           the call. An empty function unsubscribes. */
+        IOTHUB_CLIENT_RESULT setMessageCallback(MessageCallback onMessage)
+        {
+            IOTHUB_CLIENT_RESULT result;
+            if (!onMessage)
+            {
+                result = IoTHubClient_LL_SetMessageCallback(handle_, nullptr, nullptr);
+                messageCallback_.reset();
+            }
+            else
+            {
+                std::unique_ptr<MessageCallback> callback(new (std::nothrow) MessageCallback(std::move(onMessage)));
+                if (callback == nullptr)
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+                else if ((result = IoTHubClient_LL_SetMessageCallback(handle_, &messageTrampoline, callback.get())) == IOTHUB_CLIENT_OK)
+                {
+                    messageCallback_ = std::move(callback);
+                }
+            }
+            return result;
+        }
+
+        void doWork() noexcept { IoTHubClient_LL_DoWork(handle_); }
+
+        IOTHUB_CLIENT_RESULT setOption(const char* optionName, const void* value) noexcept
+        {
+            return IoTHubClient_LL_SetOption(handle_, optionName, value);
+        }
+
+        IOTHUB_CLIENT_RESULT getSendStatus(IOTHUB_CLIENT_STATUS* status) noexcept
+        {
+            return IoTHubClient_LL_GetSendStatus(handle_, status);
+        }
+
+    private:
+        template <typename Holder>
+        static void confirmationTrampoline(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+        {
+            std::unique_ptr<Holder> holder(static_cast<Holder*>(userContextCallback));
+            (*holder)(result);
+        }
+
+        static IOTHUBMESSAGE_DISPOSITION_RESULT messageTrampoline(IOTHUB_MESSAGE_HANDLE message, void* userContextCallback)
+        {
+            return (*static_cast<MessageCallback*>(userContextCallback))(MessageView(message));
+        }
+
+        void destroy() noexcept
+        {
+            /* pending confirmations run here and free their holders, the message callback has to outlive the handle */
+            if (handle_ != nullptr)
+            {
+                IoTHubClient_LL_Destroy(handle_);
+                handle_ = nullptr;
+            }
+            messageCallback_.reset();
+        }
+
+        IOTHUB_CLIENT_LL_HANDLE handle_;
+        std::unique_ptr<MessageCallback> messageCallback_;
+    };
+
+}
+
+#endif /* IOTHUB_CLIENT_LL_HPP */
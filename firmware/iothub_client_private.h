@@ -12,6 +12,7 @@
 
 #include "iothub_message.h"
 #include "iothub_client_ll.h"
+#include "iothub_transport_ll.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -36,6 +37,7 @@ DEFINE_ENUM(IOTHUB_BATCHSTATE_RESULT, IOTHUB_BATCHSTATE_RESULT_VALUES);
 
 extern void IoTHubClient_LL_SendComplete(IOTHUB_CLIENT_LL_HANDLE handle, PDLIST_ENTRY completed, IOTHUB_BATCHSTATE_RESULT result);
 extern IOTHUBMESSAGE_DISPOSITION_RESULT IoTHubClient_LL_MessageCallback(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_MESSAGE_HANDLE message);
+extern PDLIST_ENTRY IoTHubClient_LL_GetWaitingToSend(IOTHUB_CLIENT_LL_HANDLE handle);
 
 typedef struct IOTHUB_MESSAGE_LIST_TAG
 {
@@ -44,8 +46,26 @@ typedef struct IOTHUB_MESSAGE_LIST_TAG
     void* context; 
     DLIST_ENTRY entry;
     uint64_t ms_timesOutAfter; /* a value of "0" means "no timeout", if the IOTHUBCLIENT_LL's handle tickcounter > msTimesOutAfer then the message shall timeout*/
+    struct IOTHUB_MESSAGE_LIST_BLOCK_TAG* block; /* NULL when the entry was allocated on its own, otherwise the IoTHubClient_LL_SendEventBatchAsync allocation it lives in */
+    IOTHUB_CLIENT_LL_HANDLE owner; /* the client whose memory budget this entry is charged to */
+    size_t chargedBytes;
 }IOTHUB_MESSAGE_LIST;
 
+extern void IoTHubClient_LL_FreeMessageListEntry(IOTHUB_MESSAGE_LIST* messageList);
+
+/* Throttle signals from the transports (HTTP 429, AMQP amqp:resource-limit-exceeded, MQTT disconnects with events in flight):
+   the client paces its events with a token bucket, pauses for retryAfterMs (0 when the service gave no hint) and takes back
+   the events the transport did not pick up yet at the next DoWork. Safe to call while walking waitingToSend. */
+extern void IoTHubClient_LL_ReportThrottle(IOTHUB_CLIENT_LL_HANDLE handle, uint64_t retryAfterMs);
+/* hands an event the transport already removed from waitingToSend back to the client, to be sent again before any other */
+extern void IoTHubClient_LL_RetryEvent(IOTHUB_CLIENT_LL_HANDLE handle, IOTHUB_MESSAGE_LIST* messageList);
+/* changes whenever the client itself takes events out of waitingToSend (timeouts, drops for the memory budget, events paced
+   again after throttling). New events are only ever appended, so while it stays the same a transport can keep what it
+   learnt about the list between DoWork calls. */
+extern size_t IoTHubClient_LL_GetWaitingToSendRemovals(IOTHUB_CLIENT_LL_HANDLE handle);
+/* the handle the transport returned when the client registered, for transport callbacks that only get an event */
+extern IOTHUB_DEVICE_HANDLE IoTHubClient_LL_GetDeviceHandle(IOTHUB_CLIENT_LL_HANDLE handle);
+
 
 #ifdef __cplusplus
 }
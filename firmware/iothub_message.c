@@ -5,9 +5,11 @@
 #ifdef _CRTDBG_MAP_ALLOC
 #include <crtdbg.h>
 #endif
+#include <string.h>
 #include "gballoc.h"
 #include "iot_logging.h"
 #include "buffer_.h"
+#include "refcount.h"
 
 #include "iothub_message.h"
 
@@ -17,6 +19,20 @@ DEFINE_ENUM_STRINGS(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_CONTENT_TYPE_VALUE
 #define LOG_IOTHUB_MESSAGE_ERROR() \
     LogError("(result = %s)\r\n", ENUM_TO_STRING(IOTHUB_MESSAGE_RESULT, result));
 
+/*the body of a message made by IoTHubMessage_CreateFromSegments, shared by its clones*/
+typedef struct MESSAGE_SEGMENTS_TAG
+{
+    IOTHUB_MESSAGE_SEGMENT* segments; /*the array follows the ref count in the same allocation*/
+    size_t segmentCount;
+    size_t size;
+}MESSAGE_SEGMENTS;
+
+REFCOUNT_TYPE(MESSAGE_SEGMENTS)
+{
+    MESSAGE_SEGMENTS counted;
+    uint32_t count;
+};
+
 typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
 {
     IOTHUBMESSAGE_CONTENT_TYPE contentType;
@@ -28,8 +44,21 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
     MAP_HANDLE properties;
     char* messageId;
     char* correlationId;
+    bool isBuilt; /*made by IoTHubMessage_Build: one immutable allocation, shared by clones*/
+    const unsigned char* builtBody;
+    size_t builtBodySize;
+    MESSAGE_SEGMENTS* segments; /*made by IoTHubMessage_CreateFromSegments, value.byteArray is NULL then*/
+    unsigned char* flattened; /*the segments copied together by the first IoTHubMessage_GetByteArray*/
+    IOTHUB_MESSAGE_SEGMENT bodySegment; /*what IoTHubMessage_GetSegments returns for the other byte array messages, set at creation*/
 }IOTHUB_MESSAGE_HANDLE_DATA;
 
+/*the layout DEFINE_REFCOUNT_TYPE would give, except that built messages are allocated together with their content*/
+REFCOUNT_TYPE(IOTHUB_MESSAGE_HANDLE_DATA)
+{
+    IOTHUB_MESSAGE_HANDLE_DATA counted;
+    uint32_t count;
+};
+
 static bool ContainsOnlyUsAscii(const char* asciiValue)
 {
     bool result = true;
@@ -62,6 +91,16 @@ static int ValidateAsciiCharactersFilter(const char* mapKey, const char* mapValu
     return result;
 }
 
+/*the body of the other byte array messages never changes, so its segment is filled in once and only read afterwards*/
+static void SetBodySegment(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const unsigned char* data, size_t size)
+{
+    handleData->bodySegment.data = data;
+    handleData->bodySegment.size = size;
+    handleData->bodySegment.release = NULL;
+    handleData->bodySegment.context = NULL;
+    handleData->bodySegment.mapped = false;
+}
+
 IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byteArray, size_t size)
 {
     IOTHUB_MESSAGE_HANDLE_DATA* result;
@@ -122,6 +161,10 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byt
                 result->contentType = IOTHUBMESSAGE_BYTEARRAY;
                 result->messageId = NULL;
                 result->correlationId = NULL;
+                result->isBuilt = false;
+                result->segments = NULL;
+                result->flattened = NULL;
+                SetBodySegment(result, BUFFER_u_char(result->value.byteArray), BUFFER_length(result->value.byteArray));
                 /*all is fine, return result*/
             }
         }
@@ -164,6 +207,206 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source)
             result->contentType = IOTHUBMESSAGE_STRING;
             result->messageId = NULL;
             result->correlationId = NULL;
+            result->isBuilt = false;
+            result->segments = NULL;
+            result->flattened = NULL;
+        }
+    }
+    return result;
+}
+
+/*everything a built message needs is laid out in its single allocation, each part aligned for pointers*/
+#define BUILT_MESSAGE_ALIGN(size) (((size) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+static bool ValidateBuildProperties(const IOTHUB_MESSAGE_PROPERTY* properties, size_t propertyCount)
+{
+    bool result = true;
+    size_t i;
+    for (i = 0; (result == true) && (i < propertyCount); i++)
+    {
+        size_t j;
+        if ((properties[i].key == NULL) ||
+            (properties[i].value == NULL) ||
+            /*same filter as the properties map of the other messages*/
+            (ValidateAsciiCharactersFilter(properties[i].key, properties[i].value) != 0))
+        {
+            result = false;
+        }
+        for (j = 0; (result == true) && (j < i); j++)
+        {
+            if (strcmp(properties[i].key, properties[j].key) == 0)
+            {
+                result = false;
+            }
+        }
+    }
+    return result;
+}
+
+static char* CopyBuiltString(char** destination, const char* source)
+{
+    char* result;
+    if (source == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        size_t length = strlen(source) + 1;
+        (void)memcpy(*destination, source, length);
+        result = *destination;
+        *destination += length;
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_Build(const unsigned char* byteArray, size_t size, const IOTHUB_MESSAGE_PROPERTY* properties, size_t propertyCount, const char* messageId, const char* correlationId)
+{
+    IOTHUB_MESSAGE_HANDLE_DATA* result;
+    if (((size != 0) && (byteArray == NULL)) ||
+        ((propertyCount != 0) && (properties == NULL)))
+    {
+        LogError("invalid arg to IoTHubMessage_Build\r\n");
+        result = NULL;
+    }
+    else if (!ValidateBuildProperties(properties, propertyCount))
+    {
+        LogError("IoTHubMessage_Build properties shall be distinct, non NULL and US-ASCII\r\n");
+        result = NULL;
+    }
+    else
+    {
+        size_t mapOffset = BUILT_MESSAGE_ALIGN(sizeof(REFCOUNT_TYPE(IOTHUB_MESSAGE_HANDLE_DATA)));
+        size_t keysOffset = mapOffset + BUILT_MESSAGE_ALIGN(Map_GetReadOnlyStorageSize());
+        size_t valuesOffset = keysOffset + propertyCount * sizeof(const char*);
+        size_t bodyOffset = valuesOffset + propertyCount * sizeof(const char*);
+        size_t totalSize = bodyOffset + size;
+        size_t i;
+        unsigned char* block;
+
+        for (i = 0; i < propertyCount; i++)
+        {
+            totalSize += strlen(properties[i].key) + 1 + strlen(properties[i].value) + 1;
+        }
+        totalSize += (messageId == NULL) ? 0 : (strlen(messageId) + 1);
+        totalSize += (correlationId == NULL) ? 0 : (strlen(correlationId) + 1);
+
+        if ((block = (unsigned char*)malloc(totalSize)) == NULL)
+        {
+            LogError("unable to malloc\r\n");
+            result = NULL;
+        }
+        else
+        {
+            const char** keys = (const char**)(block + keysOffset);
+            const char** values = (const char**)(block + valuesOffset);
+            unsigned char* body = block + bodyOffset;
+            char* strings = (char*)(body + size);
+
+            if (size != 0)
+            {
+                (void)memcpy(body, byteArray, size);
+            }
+            for (i = 0; i < propertyCount; i++)
+            {
+                keys[i] = CopyBuiltString(&strings, properties[i].key);
+                values[i] = CopyBuiltString(&strings, properties[i].value);
+            }
+
+            result = (IOTHUB_MESSAGE_HANDLE_DATA*)block;
+            ((REFCOUNT_TYPE(IOTHUB_MESSAGE_HANDLE_DATA)*)block)->count = 1;
+            result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+            result->value.byteArray = NULL;
+            result->properties = Map_CreateReadOnly(block + mapOffset, keys, values, propertyCount);
+            result->messageId = CopyBuiltString(&strings, messageId);
+            result->correlationId = CopyBuiltString(&strings, correlationId);
+            result->isBuilt = true;
+            result->builtBody = body;
+            result->builtBodySize = size;
+            result->segments = NULL;
+            result->flattened = NULL;
+            SetBodySegment(result, body, size);
+        }
+    }
+    return result;
+}
+
+static void ReleaseSegments(MESSAGE_SEGMENTS* segments)
+{
+    if (DEC_REF(MESSAGE_SEGMENTS, segments) == DEC_RETURN_ZERO)
+    {
+        size_t i;
+        for (i = 0; i < segments->segmentCount; i++)
+        {
+            if (segments->segments[i].release != NULL)
+            {
+                segments->segments[i].release(segments->segments[i].context, segments->segments[i].data, segments->segments[i].size);
+            }
+        }
+        free(segments);
+    }
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromSegments(const IOTHUB_MESSAGE_SEGMENT* segments, size_t segmentCount)
+{
+    IOTHUB_MESSAGE_HANDLE_DATA* result;
+    size_t i;
+
+    /*stops early at a NULL segments or at a segment without bytes*/
+    for (i = 0; (segments != NULL) && (i < segmentCount); i++)
+    {
+        if ((segments[i].data == NULL) && (segments[i].size != 0))
+        {
+            break;
+        }
+    }
+
+    if (i < segmentCount)
+    {
+        LogError("invalid arg to IoTHubMessage_CreateFromSegments\r\n");
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA))) == NULL)
+    {
+        LogError("unable to malloc\r\n");
+    }
+    else if ((result->properties = Map_Create(ValidateAsciiCharactersFilter)) == NULL)
+    {
+        LogError("Map_Create failed\r\n");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        size_t segmentsOffset = BUILT_MESSAGE_ALIGN(sizeof(REFCOUNT_TYPE(MESSAGE_SEGMENTS)));
+        unsigned char* block = (unsigned char*)malloc(segmentsOffset + segmentCount * sizeof(IOTHUB_MESSAGE_SEGMENT));
+        if (block == NULL)
+        {
+            LogError("unable to malloc\r\n");
+            Map_Destroy(result->properties);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            MESSAGE_SEGMENTS* messageSegments = (MESSAGE_SEGMENTS*)block;
+            ((REFCOUNT_TYPE(MESSAGE_SEGMENTS)*)block)->count = 1;
+            messageSegments->segments = (IOTHUB_MESSAGE_SEGMENT*)(block + segmentsOffset);
+            messageSegments->segmentCount = segmentCount;
+            messageSegments->size = 0;
+            for (i = 0; i < segmentCount; i++)
+            {
+                messageSegments->segments[i] = segments[i];
+                messageSegments->size += segments[i].size;
+            }
+
+            result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+            result->value.byteArray = NULL;
+            result->messageId = NULL;
+            result->correlationId = NULL;
+            result->isBuilt = false;
+            result->segments = messageSegments;
+            result->flattened = NULL;
         }
     }
     return result;
@@ -180,6 +423,12 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
         result = NULL;
         LogError("iotHubMessageHandle parameter cannot be NULL for IoTHubMessage_Clone\r\n");
     }
+    else if (source->isBuilt)
+    {
+        /*built messages never change, so the clone is the same message*/
+        (void)INC_REF(IOTHUB_MESSAGE_HANDLE_DATA, source);
+        result = (IOTHUB_MESSAGE_HANDLE_DATA*)source;
+    }
     else
     {
         result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA));
@@ -194,6 +443,9 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
         {
             result->messageId = NULL;
             result->correlationId = NULL;
+            result->isBuilt = false;
+            result->segments = NULL;
+            result->flattened = NULL;
             if (source->messageId != NULL && mallocAndStrcpy_s(&result->messageId, source->messageId) != 0)
             {
                 LogError("unable to Copy messageId\r\n");
@@ -211,6 +463,25 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
                 free(result);
                 result = NULL;
             }
+            else if (source->segments != NULL)
+            {
+                /*the segments never change, so the clone shares them*/
+                if ((result->properties = Map_Clone(source->properties)) == NULL)
+                {
+                    LogError("unable to Map_Clone\r\n");
+                    free(result->messageId);
+                    free(result->correlationId);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    (void)INC_REF(MESSAGE_SEGMENTS, source->segments);
+                    result->segments = source->segments;
+                    result->value.byteArray = NULL;
+                    result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+                }
+            }
             else if (source->contentType == IOTHUBMESSAGE_BYTEARRAY)
             {
                 /*Codes_SRS_IOTHUBMESSAGE_02_006: [IoTHubMessage_Clone shall clone to content by a call to BUFFER_clone] */
@@ -253,6 +524,7 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
                 else
                 {
                     result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+                    SetBodySegment(result, BUFFER_u_char(result->value.byteArray), BUFFER_length(result->value.byteArray));
                     /*Codes_SRS_IOTHUBMESSAGE_03_002: [IoTHubMessage_Clone shall return upon success a non-NULL handle to the newly created IoT hub message.]*/
                     /*return as is, this is a good result*/
                 }
@@ -307,6 +579,31 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
     return result;
 }
 
+static int FlattenSegments(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
+{
+    int result;
+    const MESSAGE_SEGMENTS* segments = handleData->segments;
+    if ((handleData->flattened = (unsigned char*)malloc((segments->size == 0) ? 1 : segments->size)) == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        size_t offset = 0;
+        size_t i;
+        for (i = 0; i < segments->segmentCount; i++)
+        {
+            if (segments->segments[i].size != 0)
+            {
+                (void)memcpy(handleData->flattened + offset, segments->segments[i].data, segments->segments[i].size);
+                offset += segments->segments[i].size;
+            }
+        }
+        result = 0;
+    }
+    return result;
+}
+
 IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
 {
     IOTHUB_MESSAGE_RESULT result;
@@ -329,6 +626,28 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMes
             result = IOTHUB_MESSAGE_INVALID_ARG;
             LogError("invalid type of message %s\r\n", ENUM_TO_STRING(IOTHUBMESSAGE_CONTENT_TYPE, handleData->contentType));
         }
+        else if (handleData->isBuilt)
+        {
+            *buffer = handleData->builtBody;
+            *size = handleData->builtBodySize;
+            result = IOTHUB_MESSAGE_OK;
+        }
+        else if (handleData->segments != NULL)
+        {
+            if ((handleData->segments->segmentCount > 1) &&
+                (handleData->flattened == NULL) &&
+                (FlattenSegments(handleData) != 0))
+            {
+                result = IOTHUB_MESSAGE_ERROR;
+                LogError("unable to malloc the contiguous body of a message of %lu segments\r\n", (unsigned long)handleData->segments->segmentCount);
+            }
+            else
+            {
+                *buffer = (handleData->segments->segmentCount == 1) ? handleData->segments->segments[0].data : handleData->flattened;
+                *size = handleData->segments->size;
+                result = IOTHUB_MESSAGE_OK;
+            }
+        }
         else
         {
             /*Codes_SRS_IOTHUBMESSAGE_01_011: [The pointer shall be obtained by using BUFFER_u_char and it shall be copied in the buffer argument.]*/
@@ -341,6 +660,43 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMes
     return result;
 }
 
+IOTHUB_MESSAGE_RESULT IoTHubMessage_GetSegments(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const IOTHUB_MESSAGE_SEGMENT** segments, size_t* segmentCount)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    if (
+        (iotHubMessageHandle == NULL) ||
+        (segments == NULL) ||
+        (segmentCount == NULL)
+        )
+    {
+        LogError("invalid parameter (NULL) to IoTHubMessage_GetSegments IOTHUB_MESSAGE_HANDLE iotHubMessageHandle=%p, const IOTHUB_MESSAGE_SEGMENT** segments=%p, size_t* segmentCount=%p\r\n", iotHubMessageHandle, segments, segmentCount);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
+        if (handleData->contentType != IOTHUBMESSAGE_BYTEARRAY)
+        {
+            result = IOTHUB_MESSAGE_INVALID_ARG;
+            LogError("invalid type of message %s\r\n", ENUM_TO_STRING(IOTHUBMESSAGE_CONTENT_TYPE, handleData->contentType));
+        }
+        else if (handleData->segments != NULL)
+        {
+            *segments = handleData->segments->segments;
+            *segmentCount = handleData->segments->segmentCount;
+            result = IOTHUB_MESSAGE_OK;
+        }
+        else
+        {
+            /*only read here: built messages share their handle with their clones, possibly across threads*/
+            *segments = &handleData->bodySegment;
+            *segmentCount = 1;
+            result = IOTHUB_MESSAGE_OK;
+        }
+    }
+    return result;
+}
+
 const char* IoTHubMessage_GetString(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
 {
     const char* result;
@@ -428,6 +784,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetCorrelationId(IOTHUB_MESSAGE_HANDLE iotHu
         LogError("invalid arg (NULL) passed to IoTHubMessage_SetCorrelationId\r\n");
         result = IOTHUB_MESSAGE_INVALID_ARG;
     }
+    else if (((IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle)->isBuilt)
+    {
+        LogError("IoTHubMessage_SetCorrelationId cannot change a message made by IoTHubMessage_Build\r\n");
+        result = IOTHUB_MESSAGE_ERROR;
+    }
     else
     {
         IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
@@ -460,6 +821,11 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetMessageId(IOTHUB_MESSAGE_HANDLE iotHubMes
         LogError("invalid arg (NULL) passed to IoTHubMessage_SetMessageId\r\n");
         result = IOTHUB_MESSAGE_INVALID_ARG;
     }
+    else if (((IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle)->isBuilt)
+    {
+        LogError("IoTHubMessage_SetMessageId cannot change a message made by IoTHubMessage_Build\r\n");
+        result = IOTHUB_MESSAGE_ERROR;
+    }
     else
     {
         IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
@@ -507,20 +873,36 @@ void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
     {
         /*Codes_SRS_IOTHUBMESSAGE_01_003: [IoTHubMessage_Destroy shall free all resources associated with iotHubMessageHandle.]  */
         IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
-        if (handleData->contentType == IOTHUBMESSAGE_BYTEARRAY)
+        if (handleData->isBuilt)
         {
-            BUFFER_delete(handleData->value.byteArray);
+            /*the properties map, ids and body all live in the same allocation*/
+            if (DEC_REF(IOTHUB_MESSAGE_HANDLE_DATA, handleData) == DEC_RETURN_ZERO)
+            {
+                free(handleData);
+            }
         }
         else
         {
-            /*can only be STRING*/
-            STRING_delete(handleData->value.string);
+            if (handleData->segments != NULL)
+            {
+                ReleaseSegments(handleData->segments);
+                free(handleData->flattened);
+            }
+            else if (handleData->contentType == IOTHUBMESSAGE_BYTEARRAY)
+            {
+                BUFFER_delete(handleData->value.byteArray);
+            }
+            else
+            {
+                /*can only be STRING*/
+                STRING_delete(handleData->value.string);
+            }
+            Map_Destroy(handleData->properties);
+            free(handleData->messageId);
+            handleData->messageId = NULL;
+            free(handleData->correlationId);
+            handleData->correlationId = NULL;
+            free(handleData);
         }
-        Map_Destroy(handleData->properties);
-        free(handleData->messageId);
-        handleData->messageId = NULL;
-        free(handleData->correlationId);
-        handleData->correlationId = NULL;
-        free(handleData);
     }
 }
\ No newline at end of file
@@ -22,6 +22,7 @@ extern "C"
 #include <stddef.h>
 #include <time.h>
 #include <stdint.h>
+#include <stdbool.h>
 #endif
 
 #define IOTHUB_MESSAGE_RESULT_VALUES         \
@@ -47,6 +48,28 @@ DEFINE_ENUM(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_CONTENT_TYPE_VALUES);
 
 typedef void* IOTHUB_MESSAGE_HANDLE;
 
+/** @brief  A message property, as passed to ::IoTHubMessage_Build. */
+typedef struct IOTHUB_MESSAGE_PROPERTY_TAG
+{
+    const char* key;
+    const char* value;
+} IOTHUB_MESSAGE_PROPERTY;
+
+/** @brief  Releases the bytes of a message segment once no message uses them. */
+typedef void(*IOTHUB_MESSAGE_SEGMENT_RELEASE)(void* context, const unsigned char* data, size_t size);
+
+/** @brief  A part of a message body, as passed to ::IoTHubMessage_CreateFromSegments. */
+typedef struct IOTHUB_MESSAGE_SEGMENT_TAG
+{
+    const unsigned char* data;
+    size_t size;
+    /** @brief  Called with @c context, @c data and @c size when the last message using the segment is destroyed, may be @c NULL. */
+    IOTHUB_MESSAGE_SEGMENT_RELEASE release;
+    void* context;
+    /** @brief  @c true when @c data is mapped from a file rather than allocated, such segments are not charged against the client's memory budget. */
+    bool mapped;
+} IOTHUB_MESSAGE_SEGMENT;
+
 /**
  * @brief   Creates a new IoT hub message from a byte array. The type of the
  *          message will be set to @c IOTHUBMESSAGE_BYTEARRAY.
@@ -71,6 +94,47 @@ extern IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned ch
  */
 extern IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source);
 
+/**
+ * @brief   Creates a new IoT hub message of type @c IOTHUBMESSAGE_BYTEARRAY
+ *          with its properties and ids in a single allocation. The message
+ *          cannot be changed afterwards: the properties map is read only and
+ *          ::IoTHubMessage_SetMessageId / ::IoTHubMessage_SetCorrelationId
+ *          fail. ::IoTHubMessage_Clone shares it instead of copying it.
+ *
+ * @param   byteArray       The message body, may be @c NULL if @p size is 0.
+ * @param   size            The size of the body.
+ * @param   properties      The message properties. Keys shall be distinct
+ *                          and keys and values US-ASCII printable.
+ * @param   propertyCount   The number of items in @p properties.
+ * @param   messageId       The message id or @c NULL.
+ * @param   correlationId   The correlation id or @c NULL.
+ *
+ * @return  A valid @c IOTHUB_MESSAGE_HANDLE if the message was successfully
+ *          created or @c NULL in case an error occurs.
+ */
+extern IOTHUB_MESSAGE_HANDLE IoTHubMessage_Build(const unsigned char* byteArray, size_t size, const IOTHUB_MESSAGE_PROPERTY* properties, size_t propertyCount, const char* messageId, const char* correlationId);
+
+/**
+ * @brief   Creates a new IoT hub message of type @c IOTHUBMESSAGE_BYTEARRAY
+ *          whose body is the concatenation of @p segments, without copying
+ *          them. The message takes over the segments: their bytes shall
+ *          stay unchanged until their release callback is called, which
+ *          happens when the last of the message and its clones is
+ *          destroyed. ::IoTHubMessage_Clone shares the segments. The
+ *          transports gather the segments straight into the frames they
+ *          send; ::IoTHubMessage_GetByteArray still works but has to copy
+ *          a body of several segments into one buffer.
+ *
+ * @param   segments        The body segments, may be @c NULL if
+ *                          @p segmentCount is 0.
+ * @param   segmentCount    The number of items in @p segments.
+ *
+ * @return  A valid @c IOTHUB_MESSAGE_HANDLE if the message was successfully
+ *          created or @c NULL in case an error occurs, then the segments
+ *          are not released.
+ */
+extern IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromSegments(const IOTHUB_MESSAGE_SEGMENT* segments, size_t segmentCount);
+
 /**
  * @brief   Creates a new IoT hub message with the content identical to that
  *          of the @p iotHubMessageHandle parameter.
@@ -99,6 +163,23 @@ extern IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMes
  */
 extern IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size);
 
+/**
+ * @brief   Fetches the segments of the body of an @c IOTHUBMESSAGE_BYTEARRAY
+ *          message: those given to ::IoTHubMessage_CreateFromSegments, or a
+ *          single segment for the other messages. If the content type of
+ *          the message is not @c IOTHUBMESSAGE_BYTEARRAY then the function
+ *          returns @c IOTHUB_MESSAGE_INVALID_ARG.
+ *
+ * @param   iotHubMessageHandle Handle to the message.
+ * @param   segments            Receives a pointer to the segments, valid
+ *                              as long as the message.
+ * @param   segmentCount        Receives the number of segments.
+ *
+ * @return  Returns IOTHUB_MESSAGE_OK if the segments were fetched
+ *          successfully or an error code otherwise.
+ */
+extern IOTHUB_MESSAGE_RESULT IoTHubMessage_GetSegments(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const IOTHUB_MESSAGE_SEGMENT** segments, size_t* segmentCount);
+
 /**
  * @brief   Returns the null terminated string stored in the message.
  *          If the content type of the message is not @c IOTHUBMESSAGE_STRING
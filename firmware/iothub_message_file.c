@@ -0,0 +1,101 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* mmap is POSIX, the device has neither a file system nor virtual memory */
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "iot_logging.h"
+
+#include "iothub_message_file.h"
+
+/*the release of the one segment of a file message*/
+static void UnmapFile(void* context, const unsigned char* data, size_t size)
+{
+    (void)context;
+    if (munmap((void*)data, size) != 0)
+    {
+        LogError("unable to munmap a message body of %lu bytes\r\n", (unsigned long)size);
+    }
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromFile(const char* fileName)
+{
+    IOTHUB_MESSAGE_HANDLE result;
+    int fileDescriptor;
+
+    if (fileName == NULL)
+    {
+        LogError("invalid arg (NULL) passed to IoTHubMessage_CreateFromFile\r\n");
+        result = NULL;
+    }
+    else if ((fileDescriptor = open(fileName, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+        LogError("unable to open %s\r\n", fileName);
+        result = NULL;
+    }
+    else
+    {
+        struct stat fileStatus;
+
+        if ((fstat(fileDescriptor, &fileStatus) != 0) ||
+            !S_ISREG(fileStatus.st_mode))
+        {
+            LogError("%s is not a regular file\r\n", fileName);
+            result = NULL;
+        }
+        else if ((uint64_t)fileStatus.st_size > SIZE_MAX)
+        {
+            LogError("%s is too large to be mapped\r\n", fileName);
+            result = NULL;
+        }
+        else if (fileStatus.st_size == 0)
+        {
+            /*an empty file cannot be mapped and does not need to be*/
+            result = IoTHubMessage_CreateFromSegments(NULL, 0);
+        }
+        else
+        {
+            size_t size = (size_t)fileStatus.st_size;
+            void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            if (mapping == MAP_FAILED)
+            {
+                LogError("unable to mmap %s\r\n", fileName);
+                result = NULL;
+            }
+            else
+            {
+                IOTHUB_MESSAGE_SEGMENT segment;
+                segment.data = (const unsigned char*)mapping;
+                segment.size = size;
+                segment.release = UnmapFile;
+                segment.context = NULL;
+                segment.mapped = true;
+
+                /*the transports read the body once, front to back*/
+                (void)madvise(mapping, size, MADV_SEQUENTIAL);
+
+                if ((result = IoTHubMessage_CreateFromSegments(&segment, 1)) == NULL)
+                {
+                    LogError("unable to IoTHubMessage_CreateFromSegments\r\n");
+                    (void)munmap(mapping, size);
+                }
+            }
+        }
+
+        /*the mapping does not need the descriptor*/
+        (void)close(fileDescriptor);
+    }
+
+    return result;
+}
+
+#endif /* defined(__unix__) || defined(__APPLE__) */
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_message_file.h
+*	@brief  Messages whose body is a file mapped into memory (POSIX mmap).
+*			Only built on POSIX systems, not for the device.
+*/
+
+#ifndef IOTHUB_MESSAGE_FILE_H
+#define IOTHUB_MESSAGE_FILE_H
+
+#include "iothub_message.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief   Creates a new IoT hub message of type @c IOTHUBMESSAGE_BYTEARRAY
+ *          whose body is the file @p fileName, mapped read only instead of
+ *          being read into memory. ::IoTHubMessage_GetByteArray returns the
+ *          mapping, ::IoTHubMessage_Clone shares it and it is unmapped when
+ *          the last of the message and its clones is destroyed. A queued
+ *          message does not hold the body on the heap and is not charged
+ *          for it against the client's memory budget, but the transports
+ *          still copy the body while sending it:
+ *          - AMQP copies it into the uAMQP message, which the message
+ *            sender clones and keeps until the disposition arrives, and
+ *            encodes it once more for the transfer, so up to three copies
+ *            exist while the event is handed over and one until it is
+ *            settled.
+ *          - MQTT copies it into the MQTT message and encodes that into
+ *            the PUBLISH packet, two copies that are freed before
+ *            ::IoTHubClient_LL_DoWork returns.
+ *          - HTTP copies it into the request body, base64 encoded in batch
+ *            mode, for the time of the request.
+ *          The file shall not be truncated or written while the message
+ *          exists.
+ *
+ * @param   fileName    The path of the file.
+ *
+ * @return  A valid @c IOTHUB_MESSAGE_HANDLE if the message was successfully
+ *          created or @c NULL in case an error occurs.
+ */
+extern IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromFile(const char* fileName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_MESSAGE_FILE_H */
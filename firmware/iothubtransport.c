@@ -15,10 +15,22 @@
 #include "iothubtransport.h"
 #include "iothub_client.h"
 #include "iothub_client_private.h"
+#include "iothubtransportmqtt.h"
 #include "threadapi.h"
 #include "lock.h"
 #include "iot_logging.h"
 #include "vector.h"
+#include "doublylinkedlist.h"
+
+/* An extra connection opened for the same device when striping. It gets its own share of the device's events. */
+typedef struct TRANSPORT_STRIPE_TAG
+{
+	TRANSPORT_LL_HANDLE transportLLHandle;
+	IOTHUB_DEVICE_HANDLE deviceHandle;
+	DLIST_ENTRY waitingToSend;
+	/* false when the last DoWork left events behind, e.g. while the connection is down or being re-established */
+	bool isDraining;
+} TRANSPORT_STRIPE;
 
 typedef struct TRANSPORT_HANDLE_DATA_TAG
 {
@@ -28,12 +40,79 @@ typedef struct TRANSPORT_HANDLE_DATA_TAG
     sig_atomic_t stopThread;
 	TRANSPORT_PROVIDER_FIELDS;
 	VECTOR_HANDLE clients;
+	/* connections 1..stripeCount-1 when striping, connection 0 is transportLLHandle */
+	TRANSPORT_STRIPE* stripes;
+	size_t stripeCount;
+	IOTHUB_CLIENT_LL_HANDLE stripedClient;
+	PDLIST_ENTRY stripedWaitingToSend;
+	size_t nextStripe;
 } TRANSPORT_HANDLE_DATA;
 
 /* Used for Unit test */
 const size_t IoTHubTransport_ThreadTerminationOffset = offsetof(TRANSPORT_HANDLE_DATA, stopThread);
 
+static void destroy_stripes(TRANSPORT_HANDLE_DATA* transportData)
+{
+	size_t i;
+	for (i = 1; i < transportData->stripeCount; i++)
+	{
+		(transportData->IoTHubTransport_Destroy)(transportData->stripes[i - 1].transportLLHandle);
+	}
+	free(transportData->stripes);
+	transportData->stripes = NULL;
+	transportData->stripeCount = 1;
+}
+
+/*returns 0 when the extra connections (if any) have been created*/
+static int create_stripes(TRANSPORT_HANDLE_DATA* transportData, const IOTHUBTRANSPORT_CONFIG* transportLLConfig, size_t stripeCount)
+{
+	int result;
+
+	transportData->stripes = NULL;
+	transportData->stripeCount = 1;
+	transportData->stripedClient = NULL;
+	transportData->stripedWaitingToSend = NULL;
+	transportData->nextStripe = 0;
+
+	if (stripeCount == 1)
+	{
+		result = 0;
+	}
+	else if ((transportData->stripes = (TRANSPORT_STRIPE*)malloc((stripeCount - 1) * sizeof(TRANSPORT_STRIPE))) == NULL)
+	{
+		LogError("unable to allocate stripes.");
+		result = __LINE__;
+	}
+	else
+	{
+		result = 0;
+		while (transportData->stripeCount < stripeCount)
+		{
+			TRANSPORT_STRIPE* stripe = &transportData->stripes[transportData->stripeCount - 1];
+			stripe->transportLLHandle = transportData->IoTHubTransport_Create(transportLLConfig);
+			if (stripe->transportLLHandle == NULL)
+			{
+				LogError("Lower Layer transport for stripe %u not created.", (unsigned int)transportData->stripeCount);
+				destroy_stripes(transportData);
+				result = __LINE__;
+				break;
+			}
+			stripe->deviceHandle = NULL;
+			DList_InitializeListHead(&stripe->waitingToSend);
+			stripe->isDraining = true;
+			transportData->stripeCount++;
+		}
+	}
+
+	return result;
+}
+
 TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char* iotHubName, const char* iotHubSuffix)
+{
+	return IoTHubTransport_CreateStriped(protocol, iotHubName, iotHubSuffix, 1);
+}
+
+TRANSPORT_HANDLE  IoTHubTransport_CreateStriped(IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char* iotHubName, const char* iotHubSuffix, size_t stripeCount)
 {
 	TRANSPORT_HANDLE_DATA * result;
 
@@ -45,6 +124,17 @@ TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoc
 		LogError("Invalid NULL argument, protocol [%p], name [%p], suffix [%p].", protocol, iotHubName, iotHubSuffix);
 		result = NULL;
 	}
+	else if (stripeCount == 0)
+	{
+		LogError("At least one connection is needed.");
+		result = NULL;
+	}
+	else if ((stripeCount > 1) && (protocol == MQTT_Protocol))
+	{
+		/* the hub keeps a single MQTT session per device id, every new connection would close the previous one */
+		LogError("MQTT connections cannot be striped.");
+		result = NULL;
+	}
 	else
 	{
 		/*Codes_SRS_IOTHUBTRANSPORT_17_032: [ IoTHubTransport_Create shall allocate memory for the transport data. ]*/
@@ -118,6 +208,16 @@ TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoc
 						result->IoTHubTransport_Unsubscribe = transportProtocol->IoTHubTransport_Unsubscribe;
 						result->IoTHubTransport_DoWork = transportProtocol->IoTHubTransport_DoWork;
 						result->IoTHubTransport_GetSendStatus = transportProtocol->IoTHubTransport_GetSendStatus;
+
+						if (create_stripes(result, &transportLLConfig, stripeCount) != 0)
+						{
+							LogError("striped connections not created.");
+							VECTOR_destroy(result->clients);
+							Lock_Deinit(result->lockHandle);
+							transportProtocol->IoTHubTransport_Destroy(result->transportLLHandle);
+							free(result);
+							result = NULL;
+						}
 					}
 				}
 			}
@@ -127,6 +227,62 @@ TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoc
 	return result;
 }
 
+/* deals the events queued by the striped client round robin over the connections. Connection 0 consumes
+   its share straight from the client's list. A connection that did not drain its last share is only handed
+   one event until it catches up again, the rest is left for the others. */
+static void deal_stripe_events(TRANSPORT_HANDLE_DATA* transportData)
+{
+	PDLIST_ENTRY shared = transportData->stripedWaitingToSend;
+	PDLIST_ENTRY current = shared->Flink;
+	size_t stripeIndex = transportData->nextStripe;
+
+	while (current != shared)
+	{
+		PDLIST_ENTRY next = current->Flink;
+		if (stripeIndex != 0)
+		{
+			TRANSPORT_STRIPE* stripe = &transportData->stripes[stripeIndex - 1];
+			if (stripe->isDraining || DList_IsListEmpty(&stripe->waitingToSend))
+			{
+				(void)DList_RemoveEntryList(current);
+				DList_InsertTailList(&stripe->waitingToSend, current);
+			}
+		}
+		stripeIndex = (stripeIndex + 1) % transportData->stripeCount;
+		current = next;
+	}
+
+	transportData->nextStripe = stripeIndex;
+}
+
+/* puts back at the head of the client's list whatever a connection could not take, keeping the original order */
+static void return_stripe_events(TRANSPORT_HANDLE_DATA* transportData, TRANSPORT_STRIPE* stripe)
+{
+	PDLIST_ENTRY leftover;
+	while ((leftover = stripe->waitingToSend.Blink) != &stripe->waitingToSend)
+	{
+		(void)DList_RemoveEntryList(leftover);
+		DList_InsertHeadList(transportData->stripedWaitingToSend, leftover);
+	}
+}
+
+static void do_work_striped(TRANSPORT_HANDLE_DATA* transportData)
+{
+	size_t i;
+
+	deal_stripe_events(transportData);
+
+	(transportData->IoTHubTransport_DoWork)(transportData->transportLLHandle, NULL);
+
+	for (i = 1; i < transportData->stripeCount; i++)
+	{
+		TRANSPORT_STRIPE* stripe = &transportData->stripes[i - 1];
+		(transportData->IoTHubTransport_DoWork)(stripe->transportLLHandle, transportData->stripedClient);
+		stripe->isDraining = (DList_IsListEmpty(&stripe->waitingToSend) != 0);
+		return_stripe_events(transportData, stripe);
+	}
+}
+
 static int transport_worker_thread(void* threadArgument)
 {
 	TRANSPORT_HANDLE_DATA* transportData = (TRANSPORT_HANDLE_DATA*)threadArgument;
@@ -143,6 +299,11 @@ static int transport_worker_thread(void* threadArgument)
 				(void)Unlock(transportData->lockHandle);
 				break;
 			}
+			else if (transportData->stripedClient != NULL)
+			{
+				do_work_striped(transportData);
+				(void)Unlock(transportData->lockHandle);
+			}
 			else
 			{
 				(transportData->IoTHubTransport_DoWork)(transportData->transportLLHandle, NULL);
@@ -277,6 +438,7 @@ void IoTHubTransport_Destroy(TRANSPORT_HANDLE transportHandle)
 		wait_worker_thread(transportData);
 		/*Codes_SRS_IOTHUBTRANSPORT_17_010: [ IoTHubTransport_Destroy shall free all resources. ]*/
 		Lock_Deinit(transportData->lockHandle);
+		destroy_stripes(transportData);
 		(transportData->IoTHubTransport_Destroy)(transportData->transportLLHandle);
 		VECTOR_destroy(transportData->clients);
 		free(transportHandle);
@@ -372,3 +534,106 @@ void IoTHubTransport_JoinWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_C
 		wait_worker_thread(transportData);
 	}
 }
+
+IOTHUB_CLIENT_RESULT IoTHubTransport_RegisterStripes(TRANSPORT_HANDLE transportHandle, const IOTHUB_CLIENT_CONFIG* config, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+	IOTHUB_CLIENT_RESULT result;
+	if (transportHandle == NULL || config == NULL || iotHubClientHandle == NULL)
+	{
+		LogError("Invalid NULL argument, transport [%p], config [%p], client [%p].", transportHandle, config, iotHubClientHandle);
+		result = IOTHUB_CLIENT_INVALID_ARG;
+	}
+	else
+	{
+		TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+		if (transportData->stripeCount == 1)
+		{
+			/* not striped, the device only uses the connection it registered with */
+			result = IOTHUB_CLIENT_OK;
+		}
+		else if (transportData->stripedClient != NULL)
+		{
+			LogError("a striped transport carries a single device.");
+			result = IOTHUB_CLIENT_ERROR;
+		}
+		else
+		{
+			size_t i;
+			result = IOTHUB_CLIENT_OK;
+			for (i = 1; i < transportData->stripeCount; i++)
+			{
+				TRANSPORT_STRIPE* stripe = &transportData->stripes[i - 1];
+				stripe->deviceHandle = (transportData->IoTHubTransport_Register)(stripe->transportLLHandle, config->deviceId, config->deviceKey, iotHubClientHandle, &stripe->waitingToSend);
+				if (stripe->deviceHandle == NULL)
+				{
+					LogError("unable to register the device on stripe %u.", (unsigned int)i);
+					while (--i > 0)
+					{
+						(transportData->IoTHubTransport_Unregister)(transportData->stripes[i - 1].deviceHandle);
+						transportData->stripes[i - 1].deviceHandle = NULL;
+					}
+					result = IOTHUB_CLIENT_ERROR;
+					break;
+				}
+			}
+
+			if (result == IOTHUB_CLIENT_OK)
+			{
+				transportData->stripedClient = iotHubClientHandle;
+				transportData->stripedWaitingToSend = IoTHubClient_LL_GetWaitingToSend(iotHubClientHandle);
+				transportData->nextStripe = 0;
+			}
+		}
+	}
+	return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubTransport_SetStripeOption(TRANSPORT_HANDLE transportHandle, const char* optionName, const void* value)
+{
+	IOTHUB_CLIENT_RESULT result;
+	if (transportHandle == NULL || optionName == NULL || value == NULL)
+	{
+		LogError("Invalid NULL argument, transport [%p], option [%p], value [%p].", transportHandle, optionName, value);
+		result = IOTHUB_CLIENT_INVALID_ARG;
+	}
+	else
+	{
+		TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+		size_t i;
+		result = IOTHUB_CLIENT_OK;
+		for (i = 1; i < transportData->stripeCount; i++)
+		{
+			IOTHUB_CLIENT_RESULT stripeResult = (transportData->IoTHubTransport_SetOption)(transportData->stripes[i - 1].transportLLHandle, optionName, value);
+			/* the connections do not know the client's own options, IoTHubClient_LL_SetOption already applied those */
+			if ((stripeResult != IOTHUB_CLIENT_OK) && (stripeResult != IOTHUB_CLIENT_INVALID_ARG))
+			{
+				LogError("unable to set option %s on stripe %u.", optionName, (unsigned int)i);
+				result = stripeResult;
+			}
+		}
+	}
+	return result;
+}
+
+void IoTHubTransport_UnregisterStripes(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+	if (!(transportHandle == NULL || iotHubClientHandle == NULL))
+	{
+		TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+		if (transportData->stripedClient == iotHubClientHandle)
+		{
+			size_t i;
+			for (i = 1; i < transportData->stripeCount; i++)
+			{
+				TRANSPORT_STRIPE* stripe = &transportData->stripes[i - 1];
+				(transportData->IoTHubTransport_Unregister)(stripe->deviceHandle);
+				stripe->deviceHandle = NULL;
+				stripe->isDraining = true;
+				/* the client completes these with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY */
+				return_stripe_events(transportData, stripe);
+			}
+			transportData->stripedClient = NULL;
+			transportData->stripedWaitingToSend = NULL;
+		}
+	}
+}
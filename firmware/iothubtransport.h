@@ -18,12 +18,16 @@ extern "C"
 #endif
 
 extern TRANSPORT_HANDLE		IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char* iotHubName, const char* iotHubSuffix);
+extern TRANSPORT_HANDLE		IoTHubTransport_CreateStriped(IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char* iotHubName, const char* iotHubSuffix, size_t stripeCount);
 extern void					IoTHubTransport_Destroy(TRANSPORT_HANDLE transportHandle);
 extern LOCK_HANDLE			IoTHubTransport_GetLock(TRANSPORT_HANDLE transportHandle);
 extern TRANSPORT_LL_HANDLE	IoTHubTransport_GetLLTransport(TRANSPORT_HANDLE transportHandle);
 extern IOTHUB_CLIENT_RESULT IoTHubTransport_StartWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_HANDLE clientHandle);
 extern bool					IoTHubTransport_SignalEndWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_HANDLE clientHandle);
 extern void					IoTHubTransport_JoinWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_HANDLE clientHandle);
+extern IOTHUB_CLIENT_RESULT IoTHubTransport_RegisterStripes(TRANSPORT_HANDLE transportHandle, const IOTHUB_CLIENT_CONFIG* config, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle);
+extern IOTHUB_CLIENT_RESULT IoTHubTransport_SetStripeOption(TRANSPORT_HANDLE transportHandle, const char* optionName, const void* value);
+extern void					IoTHubTransport_UnregisterStripes(TRANSPORT_HANDLE transportHandle, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle);
 
 #ifdef __cplusplus
 }
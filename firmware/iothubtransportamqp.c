@@ -17,6 +17,7 @@
 #include "strings.h"
 #include "urlencode.h"
 #include "tlsio.h"
+#include "trace_probes.h"
 
 #include "cbs.h"
 #include "link.h"
@@ -51,6 +52,8 @@
 #define MESSAGE_SENDER_LINK_NAME "sender-link"
 #define MESSAGE_SENDER_SOURCE_ADDRESS "ingress"
 #define MESSAGE_SENDER_MAX_LINK_SIZE UINT64_MAX
+#define DEFAULT_EVENT_SENDER_COUNT 1
+#define MAX_EVENT_SENDER_COUNT 4
 
 typedef XIO_HANDLE(*TLS_IO_TRANSPORT_PROVIDER)(const char* fqdn, int port);
 
@@ -61,6 +64,20 @@ typedef enum CBS_STATE_TAG
     CBS_STATE_AUTHENTICATED
 } CBS_STATE;
 
+typedef enum EVENT_SENDER_DISTRIBUTION_TAG
+{
+    EVENT_SENDER_DISTRIBUTION_ROUND_ROBIN,
+    EVENT_SENDER_DISTRIBUTION_LEAST_OUTSTANDING
+} EVENT_SENDER_DISTRIBUTION;
+
+typedef struct EVENT_SENDER_TAG
+{
+    // AMQP link used by the event sender.
+    LINK_HANDLE sender_link;
+    // uAMQP event sender.
+    MESSAGE_SENDER_HANDLE message_sender;
+} EVENT_SENDER;
+
 typedef struct AMQP_TRANSPORT_STATE_TAG
 {
     // FQDN of the IoT Hub.
@@ -104,10 +121,16 @@ typedef struct AMQP_TRANSPORT_STATE_TAG
     size_t connection_establish_time;
     // AMQP session.
     SESSION_HANDLE session;
-    // AMQP link used by the event sender.
-    LINK_HANDLE sender_link;
-    // uAMQP event sender.
-    MESSAGE_SENDER_HANDLE message_sender;
+    // Event senders, each with its own link, credit and settlement. Only the first event_sender_count are used.
+    EVENT_SENDER event_senders[MAX_EVENT_SENDER_COUNT];
+    // Number of sender links to open on the session for events the next time the senders are created.
+    size_t event_sender_count;
+    // Number of sender links currently open; event_sender_count can change while they are.
+    size_t active_event_sender_count;
+    // How events are spread across the sender links.
+    EVENT_SENDER_DISTRIBUTION event_sender_distribution;
+    // Index of the sender link that gets the next event when distributing round-robin.
+    size_t next_event_sender;
     // Internal flag that controls if messages should be received or not.
     bool receive_messages;
     // AMQP link used by the message receiver.
@@ -161,6 +184,7 @@ static size_t getSecondsSinceEpoch(void)
 
 static void trackEventInProgress(IOTHUB_MESSAGE_LIST* message, AMQP_TRANSPORT_INSTANCE* transport_state)
 {
+    TRACE_PROBE2(event_dequeue, transport_state, message);
     DList_RemoveEntryList(&message->entry);
     DList_InsertTailList(&transport_state->inProgress, &message->entry);
 }
@@ -217,34 +241,51 @@ static void on_message_send_complete(void* context, MESSAGE_SEND_RESULT send_res
 
     IOTHUB_CLIENT_RESULT iot_hub_send_result;
 
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_142: [The callback 'on_message_send_complete' shall pass to the upper layer callback an IOTHUB_CLIENT_CONFIRMATION_OK if the result received is MESSAGE_SEND_OK] 
-    if (send_result == MESSAGE_SEND_OK)
+    // The AMQP transport registers its own state as the device handle, the same value event_dequeue reports
+    TRACE_PROBE2(send_ack, IoTHubClient_LL_GetDeviceHandle(message->owner), message);
+
+    if (send_result == MESSAGE_SEND_THROTTLED)
     {
-        iot_hub_send_result = IOTHUB_CLIENT_CONFIRMATION_OK;
+        // The hub did not take the message because of its quota, so it goes back to the client to be paced and sent again
+        LogError("The service is throttling events.\r\n");
+        if (isEventInInProgressList(message))
+        {
+            removeEventFromInProgressList(message);
+        }
+        IoTHubClient_LL_ReportThrottle(message->owner, 0);
+        IoTHubClient_LL_RetryEvent(message->owner, message);
     }
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_143: [The callback 'on_message_send_complete' shall pass to the upper layer callback an IOTHUB_CLIENT_CONFIRMATION_ERROR if the result received is MESSAGE_SEND_ERROR]
     else
     {
-        iot_hub_send_result = IOTHUB_CLIENT_CONFIRMATION_ERROR;
-    }
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_142: [The callback 'on_message_send_complete' shall pass to the upper layer callback an IOTHUB_CLIENT_CONFIRMATION_OK if the result received is MESSAGE_SEND_OK] 
+        if (send_result == MESSAGE_SEND_OK)
+        {
+            iot_hub_send_result = IOTHUB_CLIENT_CONFIRMATION_OK;
+        }
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_143: [The callback 'on_message_send_complete' shall pass to the upper layer callback an IOTHUB_CLIENT_CONFIRMATION_ERROR if the result received is MESSAGE_SEND_ERROR]
+        else
+        {
+            iot_hub_send_result = IOTHUB_CLIENT_CONFIRMATION_ERROR;
+        }
 
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_102: [The callback 'on_message_send_complete' shall invoke the upper layer callback for message received if provided] 
-    if (message->callback != NULL)
-    {
-        message->callback(iot_hub_send_result, message->context);
-    }
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_102: [The callback 'on_message_send_complete' shall invoke the upper layer callback for message received if provided] 
+        if (message->callback != NULL)
+        {
+            message->callback(iot_hub_send_result, message->context);
+        }
 
-	// Codes_SRS_IOTHUBTRANSPORTAMQP_09_100: [The callback 'on_message_send_complete' shall remove the target message from the in-progress list after the upper layer callback] 
-	if (isEventInInProgressList(message))
-	{
-		removeEventFromInProgressList(message);
-	}
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_100: [The callback 'on_message_send_complete' shall remove the target message from the in-progress list after the upper layer callback] 
+        if (isEventInInProgressList(message))
+        {
+            removeEventFromInProgressList(message);
+        }
 
-    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_151: [The callback 'on_message_send_complete' shall destroy the message handle (IOTHUB_MESSAGE_HANDLE) using IoTHubMessage_Destroy()]
-    IoTHubMessage_Destroy(message->messageHandle);
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_151: [The callback 'on_message_send_complete' shall destroy the message handle (IOTHUB_MESSAGE_HANDLE) using IoTHubMessage_Destroy()]
+        IoTHubMessage_Destroy(message->messageHandle);
 
-	// Codes_SRS_IOTHUBTRANSPORTAMQP_09_152: [The callback 'on_message_send_complete' shall destroy the IOTHUB_MESSAGE_LIST instance]
-    free(message);
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_152: [The callback 'on_message_send_complete' shall destroy the IOTHUB_MESSAGE_LIST instance]
+        IoTHubClient_LL_FreeMessageListEntry(message);
+    }
 }
 
 static void on_put_token_complete(void* context, CBS_OPERATION_RESULT operation_result, unsigned int status_code, const char* status_description)
@@ -370,6 +411,7 @@ static void on_amqp_management_state_changed(void* context, AMQP_MANAGEMENT_STAT
 
     if (transport_state != NULL)
     {
+        TRACE_PROBE3(connection_state, transport_state, new_amqp_management_state, previous_amqp_management_state);
         transport_state->connection_state = new_amqp_management_state;
     }
 }
@@ -560,21 +602,88 @@ static void attachDeviceClientTypeToLink(LINK_HANDLE link)
 
 static void destroyEventSender(AMQP_TRANSPORT_INSTANCE* transport_state)
 {
-    if (transport_state->message_sender != NULL)
+    size_t i;
+
+    for (i = 0; i < MAX_EVENT_SENDER_COUNT; i++)
     {
-        messagesender_destroy(transport_state->message_sender);
-        transport_state->message_sender = NULL;
+        EVENT_SENDER* event_sender = &transport_state->event_senders[i];
 
-        link_destroy(transport_state->sender_link);
-        transport_state->sender_link = NULL;
+        if (event_sender->message_sender != NULL)
+        {
+            messagesender_destroy(event_sender->message_sender);
+            event_sender->message_sender = NULL;
+        }
+
+        if (event_sender->sender_link != NULL)
+        {
+            link_destroy(event_sender->sender_link);
+            event_sender->sender_link = NULL;
+        }
     }
+
+    transport_state->active_event_sender_count = 0;
+    transport_state->next_event_sender = 0;
+}
+
+static int createEventSenderLink(AMQP_TRANSPORT_INSTANCE* transport_state, EVENT_SENDER* event_sender, size_t index, AMQP_VALUE source, AMQP_VALUE target)
+{
+    int result = RESULT_FAILURE;
+    // Link names must be unique within the session; the first link keeps the historical name.
+    char link_name[sizeof(MESSAGE_SENDER_LINK_NAME) + 4];
+
+    if (index == 0)
+    {
+        (void)strcpy(link_name, MESSAGE_SENDER_LINK_NAME);
+    }
+    else
+    {
+        (void)sprintf_s(link_name, sizeof(link_name), "%s-%u", MESSAGE_SENDER_LINK_NAME, (unsigned int)index);
+    }
+
+    if ((event_sender->sender_link = link_create(transport_state->session, link_name, role_sender, source, target)) == NULL)
+    {
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_069: [If IoTHubTransportAMQP_DoWork fails to create the AMQP link for sending messages, the function shall fail and return immediately, flagging the connection to be re-stablished] 
+        LogError("Failed creating AMQP link for message sender.\r\n");
+    }
+    else
+    {
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_119: [IoTHubTransportAMQP_DoWork shall apply a default value of 65536 for the parameter 'Link MAX message size']
+        if (link_set_max_message_size(event_sender->sender_link, MESSAGE_SENDER_MAX_LINK_SIZE) != RESULT_OK)
+        {
+            LogError("Failed setting AMQP link max message size.\r\n");
+        }
+
+        attachDeviceClientTypeToLink(event_sender->sender_link);
+
+        // Codes_SRS_IOTHUBTRANSPORTAMQP_09_070: [IoTHubTransportAMQP_DoWork shall create the AMQP message sender using messagesender_create() AMQP API] 
+        if ((event_sender->message_sender = messagesender_create(event_sender->sender_link, NULL, NULL, NULL)) == NULL)
+        {
+            // Codes_SRS_IOTHUBTRANSPORTAMQP_09_071: [IoTHubTransportAMQP_DoWork shall fail and return immediately if the AMQP message sender instance fails to be created, flagging the connection to be re-established] 
+            LogError("Could not allocate AMQP message sender\r\n");
+        }
+        else
+        {
+            // Codes_SRS_IOTHUBTRANSPORTAMQP_09_072: [IoTHubTransportAMQP_DoWork shall open the AMQP message sender using messagesender_open() AMQP API] 
+            if (messagesender_open(event_sender->message_sender) != RESULT_OK)
+            {
+                // Codes_SRS_IOTHUBTRANSPORTAMQP_09_073: [IoTHubTransportAMQP_DoWork shall fail and return immediately if the AMQP message sender instance fails to be opened, flagging the connection to be re-established] 
+                LogError("Failed opening the AMQP message sender.\r\n");
+            }
+            else
+            {
+                result = RESULT_OK;
+            }
+        }
+    }
+
+    return result;
 }
 
 static int createEventSender(AMQP_TRANSPORT_INSTANCE* transport_state)
 {
     int result = RESULT_FAILURE;
 
-    if (transport_state->message_sender == NULL)
+    if (transport_state->event_senders[0].message_sender == NULL)
     {
         AMQP_VALUE source = NULL;
         AMQP_VALUE target = NULL;
@@ -588,39 +697,27 @@ static int createEventSender(AMQP_TRANSPORT_INSTANCE* transport_state)
         {
             LogError("Failed creating AMQP messaging target attribute.\r\n");
         }
-        else if ((transport_state->sender_link = link_create(transport_state->session, MESSAGE_SENDER_LINK_NAME, role_sender, source, target)) == NULL)
-        {
-            // Codes_SRS_IOTHUBTRANSPORTAMQP_09_069: [If IoTHubTransportAMQP_DoWork fails to create the AMQP link for sending messages, the function shall fail and return immediately, flagging the connection to be re-stablished] 
-            LogError("Failed creating AMQP link for message sender.\r\n");
-        }
         else
         {
-            // Codes_SRS_IOTHUBTRANSPORTAMQP_09_119: [IoTHubTransportAMQP_DoWork shall apply a default value of 65536 for the parameter 'Link MAX message size']
-            if (link_set_max_message_size(transport_state->sender_link, MESSAGE_SENDER_MAX_LINK_SIZE) != RESULT_OK)
+            size_t i;
+
+            for (i = 0; i < transport_state->event_sender_count; i++)
             {
-                LogError("Failed setting AMQP link max message size.\r\n");
+                if (createEventSenderLink(transport_state, &transport_state->event_senders[i], i, source, target) != RESULT_OK)
+                {
+                    break;
+                }
             }
 
-            attachDeviceClientTypeToLink(transport_state->sender_link);
-
-            // Codes_SRS_IOTHUBTRANSPORTAMQP_09_070: [IoTHubTransportAMQP_DoWork shall create the AMQP message sender using messagesender_create() AMQP API] 
-            if ((transport_state->message_sender = messagesender_create(transport_state->sender_link, NULL, NULL, NULL)) == NULL)
+            if (i < transport_state->event_sender_count)
             {
-                // Codes_SRS_IOTHUBTRANSPORTAMQP_09_071: [IoTHubTransportAMQP_DoWork shall fail and return immediately if the AMQP message sender instance fails to be created, flagging the connection to be re-established] 
-                LogError("Could not allocate AMQP message sender\r\n");
+                destroyEventSender(transport_state);
             }
             else
             {
-                // Codes_SRS_IOTHUBTRANSPORTAMQP_09_072: [IoTHubTransportAMQP_DoWork shall open the AMQP message sender using messagesender_open() AMQP API] 
-                if (messagesender_open(transport_state->message_sender) != RESULT_OK)
-                {
-                    // Codes_SRS_IOTHUBTRANSPORTAMQP_09_073: [IoTHubTransportAMQP_DoWork shall fail and return immediately if the AMQP message sender instance fails to be opened, flagging the connection to be re-established] 
-                    LogError("Failed opening the AMQP message sender.\r\n");
-                }
-                else
-                {
-                    result = RESULT_OK;
-                }
+                transport_state->active_event_sender_count = transport_state->event_sender_count;
+                transport_state->next_event_sender = 0;
+                result = RESULT_OK;
             }
         }
 
@@ -633,6 +730,36 @@ static int createEventSender(AMQP_TRANSPORT_INSTANCE* transport_state)
     return result;
 }
 
+static MESSAGE_SENDER_HANDLE getNextEventSender(AMQP_TRANSPORT_INSTANCE* transport_state)
+{
+    size_t selected = 0;
+
+    if (transport_state->event_sender_distribution == EVENT_SENDER_DISTRIBUTION_LEAST_OUTSTANDING)
+    {
+        size_t least_pending = SIZE_MAX;
+        size_t i;
+
+        for (i = 0; i < transport_state->active_event_sender_count; i++)
+        {
+            size_t pending;
+
+            if ((messagesender_get_pending_message_count(transport_state->event_senders[i].message_sender, &pending) == 0) &&
+                (pending < least_pending))
+            {
+                least_pending = pending;
+                selected = i;
+            }
+        }
+    }
+    else
+    {
+        selected = transport_state->next_event_sender;
+        transport_state->next_event_sender = (transport_state->next_event_sender + 1) % transport_state->active_event_sender_count;
+    }
+
+    return transport_state->event_senders[selected].message_sender;
+}
+
 static int destroyMessageReceiver(AMQP_TRANSPORT_INSTANCE* transport_state)
 {
     int result = RESULT_FAILURE;
@@ -662,7 +789,7 @@ static int createMessageReceiver(AMQP_TRANSPORT_INSTANCE* transport_state, IOTHU
 {
     int result = RESULT_FAILURE;
 
-    if (transport_state->message_sender == NULL)
+    if (transport_state->event_senders[0].message_sender == NULL)
     {
         AMQP_VALUE source = NULL;
         AMQP_VALUE target = NULL;
@@ -845,7 +972,8 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
 
         IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message->messageHandle);
         const unsigned char* messageContent;
-        size_t messageContentSize;
+        const IOTHUB_MESSAGE_SEGMENT* segments;
+        size_t segmentCount;
         MESSAGE_HANDLE amqp_message = NULL;
         bool is_message_error = false;
 
@@ -853,8 +981,9 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
 		trackEventInProgress(message, transport_state);
 
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_087: [If the event contains a message of type IOTHUBMESSAGE_BYTEARRAY, IoTHubTransportAMQP_DoWork shall obtain its char* representation and size using IoTHubMessage_GetByteArray()] 
+        // The segments of the body are gathered into the data section, so messages made of several segments are not copied together first
         if (contentType == IOTHUBMESSAGE_BYTEARRAY &&
-            IoTHubMessage_GetByteArray(message->messageHandle, &messageContent, &messageContentSize) != IOTHUB_MESSAGE_OK)
+            IoTHubMessage_GetSegments(message->messageHandle, &segments, &segmentCount) != IOTHUB_MESSAGE_OK)
         {
             LogError("Failed getting the BYTE array representation of the event content to be sent.\r\n");
             is_message_error = true;
@@ -881,17 +1010,36 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
         else
         {
             BINARY_DATA binary_data;
+            BINARY_DATA* body_parts = &binary_data;
+            size_t body_part_count = 1;
 
             if (contentType == IOTHUBMESSAGE_STRING)
             {
-                messageContentSize = strlen(messageContent);
+                binary_data.bytes = messageContent;
+                binary_data.length = strlen(messageContent);
+            }
+            else if ((segmentCount > 1) &&
+                ((body_parts = (BINARY_DATA*)malloc(segmentCount * sizeof(BINARY_DATA))) == NULL))
+            {
+                LogError("Failed allocating the parts of the AMQP message body.\r\n");
+            }
+            else
+            {
+                size_t i;
+                for (i = 0; i < segmentCount; i++)
+                {
+                    body_parts[i].bytes = segments[i].data;
+                    body_parts[i].length = segments[i].size;
+                }
+                body_part_count = segmentCount;
             }
 
-            binary_data.bytes = messageContent;
-            binary_data.length = messageContentSize;
-
+            if (body_parts == NULL)
+            {
+                // The event goes back to the wait list like for any other allocation failure
+            }
             // Codes_SRS_IOTHUBTRANSPORTAMQP_09_095: [IoTHubTransportAMQP_DoWork shall set the AMQP message body using message_add_body_amqp_data() uAMQP API] 
-            if (message_add_body_amqp_data(amqp_message, binary_data) != RESULT_OK)
+            else if (message_add_body_amqp_data_parts(amqp_message, body_parts, body_part_count) != RESULT_OK)
             {
                 LogError("Failed setting the body of the AMQP message.\r\n");
             }
@@ -905,7 +1053,7 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
                 else
                 {
                     // Codes_SRS_IOTHUBTRANSPORTAMQP_09_097: [IoTHubTransportAMQP_DoWork shall pass the encoded AMQP message to AMQP for sending (along with on_message_send_complete callback) using messagesender_send()] 
-                    if (messagesender_send(transport_state->message_sender, amqp_message, on_message_send_complete, message) != RESULT_OK)
+                    if (messagesender_send(getNextEventSender(transport_state), amqp_message, on_message_send_complete, message) != RESULT_OK)
                     {
                         LogError("Failed sending the AMQP message.\r\n");
                     }
@@ -915,6 +1063,11 @@ static int sendPendingEvents(AMQP_TRANSPORT_INSTANCE* transport_state)
                     }
                 }
             }
+
+            if (body_parts != &binary_data)
+            {
+                free(body_parts);
+            }
         }
 
         if (amqp_message != NULL)
@@ -1042,11 +1195,14 @@ static TRANSPORT_LL_HANDLE IoTHubTransportAMQP_Create(const IOTHUBTRANSPORT_CONF
             transport_state->iothub_client_handle = NULL;
             transport_state->receive_messages = false;
             transport_state->message_receiver = NULL;
-            transport_state->message_sender = NULL;
+            transport_state->event_sender_count = DEFAULT_EVENT_SENDER_COUNT;
+            transport_state->active_event_sender_count = 0;
+            transport_state->event_sender_distribution = EVENT_SENDER_DISTRIBUTION_ROUND_ROBIN;
+            transport_state->next_event_sender = 0;
+            (void)memset(transport_state->event_senders, 0, sizeof(transport_state->event_senders));
             transport_state->receiver_link = NULL;
             transport_state->sasl_io = NULL;
             transport_state->sasl_mechanism = NULL;
-            transport_state->sender_link = NULL;
             transport_state->session = NULL;
             transport_state->tls_io = NULL;
             transport_state->tls_io_transport_provider = getTLSIOTransport;
@@ -1232,7 +1388,7 @@ static void IoTHubTransportAMQP_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
                 LogError("Failed destroying AMQP transport message receiver.\r\n");
             }
 
-            if (transport_state->message_sender == NULL &&
+            if (transport_state->event_senders[0].message_sender == NULL &&
                 createEventSender(transport_state) != RESULT_OK)
             {
                 LogError("Failed creating AMQP transport event sender.\r\n");
@@ -1366,6 +1522,41 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportAMQP_SetOption(TRANSPORT_LL_HANDLE ha
             transport_state->cbs_request_timeout = *((size_t*)value);
             result = IOTHUB_CLIENT_OK;
         }
+        // The number of sender links only applies to links created after this call, i.e. on the next connection (re)establishment.
+        else if (strcmp("event_sender_count", option) == 0)
+        {
+            size_t event_sender_count = *((size_t*)value);
+
+            if ((event_sender_count == 0) ||
+                (event_sender_count > MAX_EVENT_SENDER_COUNT))
+            {
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("Invalid event_sender_count (%u) passed to AMQP transport SetOption(), it must be between 1 and %d\r\n", (unsigned int)event_sender_count, MAX_EVENT_SENDER_COUNT);
+            }
+            else
+            {
+                transport_state->event_sender_count = event_sender_count;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp("event_sender_distribution", option) == 0)
+        {
+            if (strcmp("round_robin", (const char*)value) == 0)
+            {
+                transport_state->event_sender_distribution = EVENT_SENDER_DISTRIBUTION_ROUND_ROBIN;
+                result = IOTHUB_CLIENT_OK;
+            }
+            else if (strcmp("least_outstanding", (const char*)value) == 0)
+            {
+                transport_state->event_sender_distribution = EVENT_SENDER_DISTRIBUTION_LEAST_OUTSTANDING;
+                result = IOTHUB_CLIENT_OK;
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("Invalid event_sender_distribution (%s) passed to AMQP transport SetOption()\r\n", (const char*)value);
+            }
+        }
         // Codes_SRS_IOTHUBTRANSPORTAMQP_09_047: [If the option name does not match one of the options handled by this module, then IoTHubTransportAMQP_SetOption shall get  the handle to the XIO and invoke the xio_setoption passing down the option name and value parameters.] 
         else
         {
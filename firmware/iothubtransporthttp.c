@@ -24,6 +24,8 @@
 #include "vector.h"
 #include "httpheaders.h"
 #include "agenttime.h"
+#include "tickcounter.h"
+#include "trace_probes.h"
 
 #define IOTHUB_APP_PREFIX "iothub-app-"
 const char* IOTHUB_MESSAGE_ID = "iothub-messageid";
@@ -37,10 +39,18 @@ const char* IOTHUB_CORRELATION_ID = "iothub-correlationid";
 /*the default is 25 minutes*/
 #define DEFAULT_GETMINIMUMPOLLINGTIME ((unsigned int)25*60) 
 
+/*DEFAULT_MAXEVENTSPERDOWORK is how many events a device sends per _DoWork when batching is off*/
+#define DEFAULT_MAXEVENTSPERDOWORK ((unsigned int)16)
+
 #define MAXIMUM_MESSAGE_SIZE (255*1024-1)
 #define MAXIMUM_PAYLOAD_OVERHEAD 384
 #define MAXIMUM_PROPERTY_OVERHEAD 16
 
+/*batched transfers: a batch is posted once it reaches the target size or its oldest event has lingered long enough*/
+/*the default linger of 0 posts whatever is waiting at every _DoWork*/
+#define DEFAULT_BATCHLINGERTIME ((unsigned int)0)
+#define MINIMUM_BATCHTARGETSIZE ((size_t)4*1024)
+
 /*forward declaration*/
 static int appendMapToJSON(STRING_HANDLE existing, const char* const* keys, const char* const* values, size_t count);
 
@@ -70,7 +80,15 @@ typedef struct HTTPTRANSPORT_HANDLE_DATA_TAG
     HTTPAPIEX_HANDLE httpApiExHandle;
     bool doBatchedTransfers;
     unsigned int getMinimumPollingTime;
+    unsigned int maxEventsPerDoWork;
 	VECTOR_HANDLE perDeviceList;
+    TICK_COUNTER_HANDLE tickCounter;
+    /*batching policy: the configured bounds, and the linger and target size adapted within them from the requests seen so far*/
+    unsigned int maxBatchLingerTime;
+    size_t maxBatchTargetSize;
+    size_t batchTargetSize;
+    uint64_t batchLatency; /*smoothed milliseconds per batch request, 0 before the first one*/
+    unsigned int batchSuccessRate; /*smoothed percentage of batch requests that succeeded*/
 }HTTPTRANSPORT_HANDLE_DATA;
 
 typedef struct HTTPTRANSPORT_PERDEVICE_DATA_TAG
@@ -92,6 +110,13 @@ typedef struct HTTPTRANSPORT_PERDEVICE_DATA_TAG
 	IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle;
     PDLIST_ENTRY waitingToSend;
     DLIST_ENTRY eventConfirmations; /*holds items for event confirmations*/
+    bool isLingering; /*lingerStartTime is when the batched events now waiting were first seen*/
+    uint64_t lingerStartTime;
+    /*the estimated size of the waitingToSend events up to pendingLast, so that a lingering batch only sizes the events added
+    since. It holds while the client reports the same waitingToSendRemovals and is dropped whenever the transport takes events*/
+    size_t pendingSize;
+    PDLIST_ENTRY pendingLast;
+    size_t pendingRemovals;
 } HTTPTRANSPORT_PERDEVICE_DATA;
 
 static void destroy_eventHTTPrelativePath(HTTPTRANSPORT_PERDEVICE_DATA* handleData)
@@ -519,6 +544,10 @@ IOTHUB_DEVICE_HANDLE IoTHubTransportHttp_Register(TRANSPORT_LL_HANDLE handle, co
 				result->iotHubClientHandle = iotHubClientHandle;
 				result->waitingToSend = waitingToSend;
 				DList_InitializeListHead(&(result->eventConfirmations));
+				result->isLingering = false;
+				result->pendingSize = 0;
+				result->pendingLast = NULL;
+				result->pendingRemovals = 0;
 				result->transportHandle = handle;
 			}
 			else
@@ -668,6 +697,28 @@ static bool create_httpApiExHandle(HTTPTRANSPORT_HANDLE_DATA* handleData, const
 	return result;
 }
 
+static void destroy_tickCounter(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+	tickcounter_destroy(handleData->tickCounter);
+	handleData->tickCounter = NULL;
+}
+
+static bool create_tickCounter(HTTPTRANSPORT_HANDLE_DATA* handleData)
+{
+	bool result;
+	handleData->tickCounter = tickcounter_create();
+	if (handleData->tickCounter == NULL)
+	{
+		LogError("unable to tickcounter_create\r\n");
+		result = false;
+	}
+	else
+	{
+		result = true;
+	}
+	return result;
+}
+
 static void destroy_perDeviceList(HTTPTRANSPORT_HANDLE_DATA* handleData)
 {
 	VECTOR_destroy(handleData->perDeviceList);
@@ -739,16 +790,24 @@ TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONFIG* con
 			bool was_hostName_ok = create_hostName(result, config);
             bool was_httpApiExHandle_ok = was_hostName_ok && create_httpApiExHandle(result, config);
 			bool was_perDeviceList_ok = was_httpApiExHandle_ok && create_perDeviceList(result);
+			bool was_tickCounter_ok = was_perDeviceList_ok && create_tickCounter(result);
 
 
-            if (was_perDeviceList_ok)
+            if (was_tickCounter_ok)
             {
 				/*Codes_SRS_TRANSPORTMULTITHTTP_17_011: [ Otherwise, IoTHubTransportHttp_Create shall succeed and return a non-NULL value. ]*/
                 result->doBatchedTransfers = false;
                 result->getMinimumPollingTime = DEFAULT_GETMINIMUMPOLLINGTIME;
+                result->maxEventsPerDoWork = DEFAULT_MAXEVENTSPERDOWORK;
+                result->maxBatchLingerTime = DEFAULT_BATCHLINGERTIME;
+                result->maxBatchTargetSize = MAXIMUM_MESSAGE_SIZE;
+                result->batchTargetSize = MAXIMUM_MESSAGE_SIZE;
+                result->batchLatency = 0;
+                result->batchSuccessRate = 100;
             }
             else
             {
+                if (was_perDeviceList_ok) destroy_perDeviceList(result);
                 if (was_httpApiExHandle_ok) destroy_httpApiExHandle(result);
 				if (was_hostName_ok) destroy_hostName(result);
 
@@ -782,6 +841,7 @@ void IoTHubTransportHttp_Destroy(TRANSPORT_LL_HANDLE handle)
         destroy_hostName(handle);
         destroy_httpApiExHandle(handle);
 		destroy_perDeviceList(handle);
+		destroy_tickCounter(handle);
         free(handle);
     }
 }
@@ -945,6 +1005,57 @@ static int appendMapToJSON(STRING_HANDLE existing, const char* const* keys, cons
     return result;
 }
 
+/*the size of the body of a byte array message, added up from its segments so that a message made by IoTHubMessage_CreateFromSegments
+is not copied together just to be measured*/
+static int getEventBodySize(IOTHUB_MESSAGE_HANDLE messageHandle, const IOTHUB_MESSAGE_SEGMENT** segments, size_t* segmentCount, size_t* size)
+{
+    int result;
+    if (IoTHubMessage_GetSegments(messageHandle, segments, segmentCount) != IOTHUB_MESSAGE_OK)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        size_t i;
+        *size = 0;
+        for (i = 0; i < *segmentCount; i++)
+        {
+            *size += (*segments)[i].size;
+        }
+        result = 0;
+    }
+    return result;
+}
+
+/*gathers the segments of a byte array message straight into the request body*/
+static int buildEventBody(BUFFER_HANDLE toBeSend, const IOTHUB_MESSAGE_SEGMENT* segments, size_t segmentCount, size_t size)
+{
+    int result;
+    if (segmentCount <= 1)
+    {
+        result = BUFFER_build(toBeSend, (segmentCount == 0) ? NULL : segments[0].data, size);
+    }
+    else if (BUFFER_pre_build(toBeSend, size) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        unsigned char* destination = BUFFER_u_char(toBeSend);
+        size_t i;
+        for (i = 0; i < segmentCount; i++)
+        {
+            if (segments[i].size != 0)
+            {
+                (void)memcpy(destination, segments[i].data, segments[i].size);
+                destination += segments[i].size;
+            }
+        }
+        result = 0;
+    }
+    return result;
+}
+
 /*makes the following string:{"body":"base64 encoding of the message content"[,"properties":{"a":"valueOfA"}]}*/
 /*return NULL if there was a failure, or a non-NULL STRING_HANDLE that contains the intended data*/
 static STRING_HANDLE make1EventJSONitem(PDLIST_ENTRY item, size_t *messageSizeContribution)
@@ -967,6 +1078,7 @@ static STRING_HANDLE make1EventJSONitem(PDLIST_ENTRY item, size_t *messageSizeCo
             const unsigned char* source;
             size_t size;
 
+            /*base64 needs the body in one piece, a message made of several segments is copied together here*/
             if (IoTHubMessage_GetByteArray(message->messageHandle, &source, &size) != IOTHUB_MESSAGE_OK)
             {
                 LogError("unable to get the data for the message.\r\n");
@@ -1080,7 +1192,8 @@ DEFINE_ENUM(MAKE_PAYLOAD_RESULT, MAKE_PAYLOAD_RESULT_VALUES);
 
 /*this function assembles several {"body":"base64 encoding of the message content"," base64Encoded": true} into 1 payload*/
 /*Codes_SRS_TRANSPORTMULTITHTTP_17_056: [IoTHubTransportHttp_DoWork shall build the following string:[{"body":"base64 encoding of the message1 content"},{"body":"base64 encoding of the message2 content"}...]]*/
-static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData, STRING_HANDLE* payload)
+/*an item that alone exceeds MAXIMUM_MESSAGE_SIZE fails, otherwise items are added while the payload stays within targetSize (the first one always is)*/
+static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData, size_t targetSize, STRING_HANDLE* payload)
 {
     MAKE_PAYLOAD_RESULT result;
     size_t allMessagesSize = 0;
@@ -1140,6 +1253,7 @@ static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData,
                             /*first item was put nicely in the payload*/
                             PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
                             DList_InsertTailList(&(deviceData->eventConfirmations), head);
+                            TRACE_PROBE2(event_dequeue, deviceData, head);
                             allMessagesSize += messageSize;
                         }
                     }
@@ -1158,7 +1272,7 @@ static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData,
                 }
                 else
                 {
-                    if (allMessagesSize + messageSize > MAXIMUM_MESSAGE_SIZE)
+                    if (allMessagesSize + messageSize > targetSize)
                     {
                         /*this item doesn't make it to the payload, but the payload is valid so far*/
                         /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
@@ -1177,6 +1291,7 @@ static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData,
                         /*cool, the payload made it there, let's continue... */
                         PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
                         DList_InsertTailList(&(deviceData->eventConfirmations), head);
+                        TRACE_PROBE2(event_dequeue, deviceData, head);
                         allMessagesSize += messageSize;
                     }
                     STRING_delete(temp);
@@ -1205,12 +1320,394 @@ static void reversePutListBackIn(PDLIST_ENTRY source, PDLIST_ENTRY destination)
     DList_InitializeListHead(source);
 }
 
+/*the same size make1EventJSONitem reports for the item, without encoding it*/
+static size_t estimateEventSize(PDLIST_ENTRY item)
+{
+    IOTHUB_MESSAGE_LIST* message = containingRecord(item, IOTHUB_MESSAGE_LIST, entry);
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message->messageHandle);
+    const unsigned char* source;
+    const IOTHUB_MESSAGE_SEGMENT* segments;
+    size_t result = MAXIMUM_PAYLOAD_OVERHEAD;
+    size_t size;
+    const char*const* keys;
+    const char*const* values;
+    size_t count;
+
+    if ((contentType == IOTHUBMESSAGE_BYTEARRAY) &&
+        (getEventBodySize(message->messageHandle, &segments, &count, &size) == 0))
+    {
+        result += size;
+    }
+    else if ((contentType == IOTHUBMESSAGE_STRING) &&
+        ((source = (const unsigned char*)IoTHubMessage_GetString(message->messageHandle)) != NULL))
+    {
+        result += strlen((const char*)source);
+    }
+
+    if (Map_GetInternals(IoTHubMessage_Properties(message->messageHandle), &keys, &values, &count) == MAP_OK)
+    {
+        size_t i;
+        for (i = 0; i < count; i++)
+        {
+            result += (strlen(keys[i]) + strlen(values[i]) + MAXIMUM_PROPERTY_OVERHEAD);
+        }
+    }
+
+    return result;
+}
+
+/*forgets the counted events, for when the transport takes events out of waitingToSend*/
+static void resetPendingSize(HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    deviceData->pendingSize = 0;
+    deviceData->pendingLast = NULL;
+}
+
+/*a batch is due when the waiting events fill the target size or the oldest has lingered for the current linger time. The linger
+is the smoothed request latency (waiting about one request's time at most doubles an event's latency) capped by maxBatchLingerTime,
+or the whole maxBatchLingerTime while most requests fail, so that failing batches are not retried at every _DoWork*/
+static bool isBatchDue(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    bool result;
+    uint64_t now;
+
+    if (handleData->maxBatchLingerTime == 0)
+    {
+        result = true;
+    }
+    else
+    {
+        size_t removals = IoTHubClient_LL_GetWaitingToSendRemovals(deviceData->iotHubClientHandle);
+        PDLIST_ENTRY item;
+
+        if (removals != deviceData->pendingRemovals)
+        {
+            /*the client took events out of the list, what was counted may be gone*/
+            deviceData->pendingSize = 0;
+            deviceData->pendingLast = NULL;
+            deviceData->pendingRemovals = removals;
+        }
+
+        for (item = (deviceData->pendingLast == NULL) ? deviceData->waitingToSend->Flink : deviceData->pendingLast->Flink;
+            (item != deviceData->waitingToSend) && (deviceData->pendingSize < handleData->batchTargetSize);
+            item = item->Flink)
+        {
+            deviceData->pendingSize += estimateEventSize(item);
+            deviceData->pendingLast = item;
+        }
+
+        if (deviceData->pendingSize >= handleData->batchTargetSize)
+        {
+            result = true;
+        }
+        else if (tickcounter_get_current_ms(handleData->tickCounter, &now) != 0)
+        {
+            LogError("unable to tickcounter_get_current_ms\r\n");
+            result = true;
+        }
+        else if (!deviceData->isLingering)
+        {
+            deviceData->isLingering = true;
+            deviceData->lingerStartTime = now;
+            result = false;
+        }
+        else
+        {
+            uint64_t lingerTime = ((handleData->batchSuccessRate < 50) || (handleData->batchLatency > handleData->maxBatchLingerTime)) ?
+                handleData->maxBatchLingerTime :
+                handleData->batchLatency;
+            result = (now - deviceData->lingerStartTime >= lingerTime);
+        }
+    }
+
+    if (result)
+    {
+        deviceData->isLingering = false;
+        resetPendingSize(deviceData);
+    }
+
+    return result;
+}
+
+/*the target size shrinks by half after a failed request and by a quarter after a request that took more than twice the smoothed
+latency, and grows by a quarter after a request that left events behind, so a backlog is drained in the largest requests that
+still come back in time*/
+static void updateBatchPolicy(HTTPTRANSPORT_HANDLE_DATA* handleData, uint64_t latency, bool succeeded, bool leftEventsBehind)
+{
+    size_t targetSize = handleData->batchTargetSize;
+
+    if (!succeeded)
+    {
+        targetSize /= 2;
+        handleData->batchSuccessRate = (handleData->batchSuccessRate * 7) / 8;
+    }
+    else
+    {
+        if ((handleData->batchLatency != 0) && (latency > 2 * handleData->batchLatency))
+        {
+            targetSize -= targetSize / 4;
+        }
+        else if (leftEventsBehind)
+        {
+            targetSize += targetSize / 4;
+        }
+        handleData->batchLatency = (handleData->batchLatency == 0) ? (latency + 1) : ((handleData->batchLatency * 7 + latency) / 8);
+        handleData->batchSuccessRate = (handleData->batchSuccessRate * 7 + 100) / 8;
+    }
+
+    if (targetSize < MINIMUM_BATCHTARGETSIZE)
+    {
+        targetSize = MINIMUM_BATCHTARGETSIZE;
+    }
+    if (targetSize > handleData->maxBatchTargetSize)
+    {
+        targetSize = handleData->maxBatchTargetSize;
+    }
+    handleData->batchTargetSize = targetSize;
+}
+
+/*429 is the service throttling the device, Retry-After (in seconds) tells for how long*/
+static void reportThrottling(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, unsigned int statusCode, HTTP_HEADERS_HANDLE responseHeaders)
+{
+    if (statusCode == 429)
+    {
+        const char* retryAfter = (responseHeaders == NULL) ? NULL : HTTPHeaders_FindHeaderValue(responseHeaders, "Retry-After");
+        uint64_t retryAfterMs = (retryAfter == NULL) ? 0 : (uint64_t)strtoul(retryAfter, NULL, 10) * 1000;
+        LogError("the service is throttling events, Retry-After: %s\r\n", (retryAfter == NULL) ? "none" : retryAfter);
+        IoTHubClient_LL_ReportThrottle(iotHubClientHandle, retryAfterMs);
+    }
+}
+
+/*sends the oldest event of waitingToSend on its own, returns true when the event has been completed (sent or failed for good)*/
+static bool DoSingleEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    bool result = false;
+    const unsigned char* messageContent=NULL;
+    const IOTHUB_MESSAGE_SEGMENT* segments=NULL;
+    size_t segmentCount=0;
+    size_t messageSize=0;
+    size_t originalMessageSize=0;
+    IOTHUB_MESSAGE_LIST* message = containingRecord(deviceData->waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry);
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message->messageHandle);
+
+    /*Codes_SRS_TRANSPORTMULTITHTTP_17_073: [The message size is computed from the length of the payload + 384.]*/
+    if (!(
+        (((contentType == IOTHUBMESSAGE_BYTEARRAY) && 
+            (getEventBodySize(message->messageHandle, &segments, &segmentCount, &originalMessageSize)==0)) ? (messageSize= originalMessageSize + MAXIMUM_PAYLOAD_OVERHEAD, 1): 0)
+        
+        ||
+
+        ((contentType == IOTHUBMESSAGE_STRING) && (
+            messageContent = (const unsigned char*)IoTHubMessage_GetString(message->messageHandle), 
+            (messageSize = MAXIMUM_PAYLOAD_OVERHEAD + (originalMessageSize = ((messageContent == NULL)?0:strlen((const char*)messageContent)))), 
+            messageContent!=NULL)
+            )
+        ))
+    {
+        LogError("unable to get the message content\r\n");
+        /*go on...*/
+    }
+    else
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_075: [If the oldest message in waitingToSend causes the message to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_BATCHSTATE_FAILED.]*/
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_072: [The message size shall be limited to 255KB -1 bytes.] */
+        if (messageSize > MAXIMUM_MESSAGE_SIZE)
+        {
+            PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
+            DList_InsertTailList(&(deviceData->eventConfirmations), head);
+            IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_BATCHSTATE_FAILED); /*takes care of emptying the list too*/
+            result = true;
+        }
+        else
+        {
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_071: [If option SetBatching is false then _Dowork shall send individual event message as specced below.] */
+            /*the per message headers are an overlay over the event HTTP request headers, which stay untouched*/
+            HTTP_HEADERS_HANDLE overlayHTTPrequestHeaders = HTTPHeaders_AllocOverlay(deviceData->eventHTTPrequestHeaders);
+            if (overlayHTTPrequestHeaders == NULL)
+            {
+                /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
+                LogError("HTTPHeaders_AllocOverlay failed\r\n");
+            }
+            else
+            {
+                /*Codes_SRS_TRANSPORTMULTITHTTP_17_077: [The overlay HTTP headers shall have the HTTP header "Content-Type" set to "application/octet-stream".] */
+                if (HTTPHeaders_ReplaceHeaderNameValuePair(overlayHTTPrequestHeaders, CONTENT_TYPE, APPLICATION_OCTET_STREAM) != HTTP_HEADERS_OK)
+                {
+                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
+                    LogError("HTTPHeaders_ReplaceHeaderNameValuePair failed\r\n");
+                }
+                else
+                {
+                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_078: [Every message property "property":"value" shall be added to the HTTP headers as an individual header "iothub-app-property":"value".] */
+                    MAP_HANDLE map = IoTHubMessage_Properties(message->messageHandle);
+                    const char*const* keys;
+                    const char*const* values;
+                    size_t count;
+                    if (Map_GetInternals(map, &keys, &values, &count) != MAP_OK)
+                    {
+                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_078: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
+                        LogError("unable to Map_GetInternals\r\n");
+                    }
+                    else
+                    {
+                        size_t i;
+                        bool goOn = true;
+                        const char* msgId;
+                        const char* corrId;
+                        size_t longestKey = 0;
+                        char* headerName;
+
+                        for (i = 0; i < count; i++)
+                        {
+                            size_t keyLength = strlen(keys[i]);
+                            if (keyLength > longestKey)
+                            {
+                                longestKey = keyLength;
+                            }
+                        }
+
+                        /*one buffer for all the "iothub-app-property" names of the message*/
+                        headerName = (char*)malloc(sizeof(IOTHUB_APP_PREFIX) + longestKey);
+                        if (headerName == NULL)
+                        {
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
+                            LogError("unable to malloc\r\n");
+                            goOn = false;
+                        }
+                        else
+                        {
+                            (void)memcpy(headerName, IOTHUB_APP_PREFIX, sizeof(IOTHUB_APP_PREFIX) - 1);
+                        }
+
+                        for (i = 0; (i < count) && goOn; i++)
+                        {
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_074: [Every property name shall add  to the message size the length of the property name + the length of the property value + 16 bytes.] */
+                            messageSize += (strlen(values[i]) + strlen(keys[i]) + MAXIMUM_PROPERTY_OVERHEAD);
+                            if (messageSize > MAXIMUM_MESSAGE_SIZE)
+                            {
+                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_072: [The message size shall be limited to 255KB -1 bytes.] */
+                                PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
+                                DList_InsertTailList(&(deviceData->eventConfirmations), head);
+                                IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_BATCHSTATE_FAILED); /*takes care of emptying the list too*/
+                                goOn = false;
+                                result = true;
+                            }
+                            else
+                            {
+                                (void)strcpy(headerName + sizeof(IOTHUB_APP_PREFIX) - 1, keys[i]);
+                                if (HTTPHeaders_ReplaceHeaderNameValuePair(overlayHTTPrequestHeaders, headerName, values[i]) != HTTP_HEADERS_OK)
+                                {
+                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
+                                    LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair\r\n");
+                                    goOn = false;
+                                }
+                            }
+                        }
+                        free(headerName);
+
+                        // Add the Message Id and the Correlation Id
+                        msgId = IoTHubMessage_GetMessageId(message->messageHandle);
+                        if (goOn && msgId != NULL)
+                        {
+                            if (HTTPHeaders_ReplaceHeaderNameValuePair(overlayHTTPrequestHeaders, IOTHUB_MESSAGE_ID, msgId) != HTTP_HEADERS_OK)
+                            {
+                                LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair\r\n");
+                                goOn = false;
+                            }
+                        }
+
+                        corrId = IoTHubMessage_GetCorrelationId(message->messageHandle);
+                        if (goOn && corrId != NULL)
+                        {
+                            if (HTTPHeaders_ReplaceHeaderNameValuePair(overlayHTTPrequestHeaders, IOTHUB_CORRELATION_ID, corrId) != HTTP_HEADERS_OK)
+                            {
+                                LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair\r\n");
+                                goOn = false;
+                            }
+                        }
+
+                        if (!goOn)
+                        {
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
+                        }
+                        else
+                        {
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_080: [IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters] */
+                            BUFFER_HANDLE toBeSend = BUFFER_new();
+                            if (toBeSend == NULL)
+                            {
+                                LogError("unable to BUFFER_new\r\n");
+                            }
+                            else
+                            {
+                                if (((contentType == IOTHUBMESSAGE_BYTEARRAY) ?
+                                    buildEventBody(toBeSend, segments, segmentCount, originalMessageSize) :
+                                    BUFFER_build(toBeSend, messageContent, originalMessageSize)) != 0)
+                                {
+                                    LogError("unable to BUFFER_build\r\n");
+                                }
+                                else
+                                {
+                                    unsigned int statusCode;
+                                    HTTPAPIEX_RESULT r;
+                                    HTTP_HEADERS_HANDLE responseHeaders = HTTPHeaders_Alloc(); /*only read for throttling, so the request goes ahead without it*/
+                                    if ((r = HTTPAPIEX_SAS_ExecuteRequest(
+												deviceData->sasObject,
+                                        handleData->httpApiExHandle,
+                                        HTTPAPI_REQUEST_POST,
+                                        STRING_c_str(deviceData->eventHTTPrelativePath),
+                                        overlayHTTPrequestHeaders,
+                                        toBeSend,
+                                        &statusCode,
+                                        responseHeaders,
+                                        NULL
+                                        )) != HTTPAPIEX_OK)
+                                    {
+                                        LogError("unable to HTTPAPIEX_ExecuteRequest\r\n");
+                                    }
+                                    else
+                                    {
+                                        if (statusCode < 300)
+                                        {
+                                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_082: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list the item send, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_BATCHSTATE_SUCCESS. The item shall be removed from waitingToSend.] */
+                                            PDLIST_ENTRY justSent = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
+                                            DList_InsertTailList(&(deviceData->eventConfirmations), justSent);
+                                            IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_BATCHSTATE_SUCCESS); /*takes care of emptying the list too*/
+                                            result = true;
+                                        }
+                                        else
+                                        {
+                                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_081: [If HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
+                                            LogError("unexpected HTTP status code (%u)\r\n", statusCode);
+                                            reportThrottling(iotHubClientHandle, statusCode, responseHeaders);
+                                        }
+                                    }
+                                    if (responseHeaders != NULL)
+                                    {
+                                        HTTPHeaders_Free(responseHeaders);
+                                    }
+                                }
+                                BUFFER_delete(toBeSend);
+                            }
+                        }
+                    }
+                }
+                HTTPHeaders_Free(overlayHTTPrequestHeaders);
+            }
+        }
+    }
+
+    return result;
+}
+
 static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 {
 
     if (DList_IsListEmpty(deviceData->waitingToSend))
     {
         /*Codes_SRS_TRANSPORTMULTITHTTP_17_060: [If the list is empty then IoTHubTransportHttp_DoWork shall proceed to the following action.] */
+        deviceData->isLingering = false;
+        resetPendingSize(deviceData);
     }
     else
     {
@@ -1218,7 +1715,11 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
         if (handleData->doBatchedTransfers)
         {
             /*Codes_SRS_TRANSPORTMULTITHTTP_17_054: [Request HTTP headers shall have the value of "Content-Type" created or updated to "application/vnd.microsoft.iothub.json" by a call to HTTPHeaders_ReplaceHeaderNameValuePair.] */
-            if (HTTPHeaders_ReplaceHeaderNameValuePair(deviceData->eventHTTPrequestHeaders, CONTENT_TYPE, APPLICATION_VND_MICROSOFT_IOTHUB_JSON) != HTTP_HEADERS_OK)
+            if (!isBatchDue(handleData, deviceData))
+            {
+                /*lingering for more events*/
+            }
+            else if (HTTPHeaders_ReplaceHeaderNameValuePair(deviceData->eventHTTPrequestHeaders, CONTENT_TYPE, APPLICATION_VND_MICROSOFT_IOTHUB_JSON) != HTTP_HEADERS_OK)
             {
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_055: [If updating Content-Type fails for any reason, then _DoWork shall advance to the next action.] */
                 LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair\r\n");
@@ -1227,7 +1728,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
             {
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_059: [It shall inspect the "waitingToSend" DLIST passed in config structure.] */
                 STRING_HANDLE payload;
-                switch (makePayload(deviceData, &payload))
+                switch (makePayload(deviceData, handleData->batchTargetSize, &payload))
                 {
                 case MAKE_PAYLOAD_OK:
                 {
@@ -1252,6 +1753,10 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                         {
                             unsigned int statusCode;
                             HTTPAPIEX_RESULT r;
+                            uint64_t startTime;
+                            uint64_t endTime;
+                            bool hasStartTime = (tickcounter_get_current_ms(handleData->tickCounter, &startTime) == 0);
+                            HTTP_HEADERS_HANDLE responseHeaders = HTTPHeaders_Alloc(); /*only read for throttling, so the request goes ahead without it*/
                             if ((r = HTTPAPIEX_SAS_ExecuteRequest(
 								deviceData->sasObject,
                                 handleData->httpApiExHandle,
@@ -1260,7 +1765,7 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
 								deviceData->eventHTTPrequestHeaders,
                                 temp,
                                 &statusCode,
-                                NULL,
+                                responseHeaders,
                                 NULL
                                 )) != HTTPAPIEX_OK)
                             {
@@ -1268,9 +1773,15 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                 //items go back to waitingToSend
                                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
                                 reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                                updateBatchPolicy(handleData, 0, false, false);
                             }
                             else
                             {
+                                updateBatchPolicy(handleData,
+                                    (hasStartTime && (tickcounter_get_current_ms(handleData->tickCounter, &endTime) == 0)) ? (endTime - startTime) : handleData->batchLatency,
+                                    (statusCode < 300),
+                                    !DList_IsListEmpty(deviceData->waitingToSend));
+
                                 if (statusCode < 300)
                                 {
                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_BATCHSTATE_SUCESS. The batched items shall be removed from waitingToSend.] */
@@ -1282,8 +1793,13 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
                                     LogError("unexpected HTTP status code (%u)\r\n", statusCode);
                                     reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                                    reportThrottling(iotHubClientHandle, statusCode, responseHeaders);
                                 }
                             }
+                            if (responseHeaders != NULL)
+                            {
+                                HTTPHeaders_Free(responseHeaders);
+                            }
                         }
                         BUFFER_delete(temp);
                     }
@@ -1315,199 +1831,14 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
         }
         else
         {
-            const unsigned char* messageContent=NULL;
-            size_t messageSize=0;
-            size_t originalMessageSize=0;
-            IOTHUB_MESSAGE_LIST* message = containingRecord(deviceData->waitingToSend->Flink, IOTHUB_MESSAGE_LIST, entry);
-            IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message->messageHandle);
-
-            /*Codes_SRS_TRANSPORTMULTITHTTP_17_073: [The message size is computed from the length of the payload + 384.]*/
-            if (!(
-                (((contentType == IOTHUBMESSAGE_BYTEARRAY) && 
-                    (IoTHubMessage_GetByteArray(message->messageHandle, &messageContent, &originalMessageSize)==IOTHUB_MESSAGE_OK)) ? (messageSize= originalMessageSize + MAXIMUM_PAYLOAD_OVERHEAD, 1): 0)
-                
-                ||
-
-                ((contentType == IOTHUBMESSAGE_STRING) && (
-                    messageContent = (const unsigned char*)IoTHubMessage_GetString(message->messageHandle), 
-                    (messageSize = MAXIMUM_PAYLOAD_OVERHEAD + (originalMessageSize = ((messageContent == NULL)?0:strlen((const char*)messageContent)))), 
-                    messageContent!=NULL)
-                    )
-                ))
+            /*the single events are drained one request after the other over the kept alive connection of httpApiExHandle, stopping at the first one that has to be retried*/
+            unsigned int i;
+            resetPendingSize(deviceData);
+            for (i = 0; (i < handleData->maxEventsPerDoWork) && !DList_IsListEmpty(deviceData->waitingToSend); i++)
             {
-                LogError("unable to get the message content\r\n");
-                /*go on...*/
-            }
-            else
-            {
-                /*Codes_SRS_TRANSPORTMULTITHTTP_17_075: [If the oldest message in waitingToSend causes the message to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_BATCHSTATE_FAILED.]*/
-                /*Codes_SRS_TRANSPORTMULTITHTTP_17_072: [The message size shall be limited to 255KB -1 bytes.] */
-                if (messageSize > MAXIMUM_MESSAGE_SIZE)
-                {
-                    PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                    DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                    IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_BATCHSTATE_FAILED); /*takes care of emptying the list too*/
-                }
-                else
+                if (!DoSingleEvent(handleData, deviceData, iotHubClientHandle))
                 {
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_071: [If option SetBatching is false then _Dowork shall send individual event message as specced below.] */
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_076: [A clone of the event HTTP request headers shall be created.]*/
-                    HTTP_HEADERS_HANDLE clonedEventHTTPrequestHeaders = HTTPHeaders_Clone(deviceData->eventHTTPrequestHeaders);
-                    if (clonedEventHTTPrequestHeaders == NULL)
-                    {
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
-                        LogError("HTTPHeaders_Clone failed\r\n");
-                    }
-                    else
-                    {
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_077: [The cloned HTTP headers shall have the HTTP header "Content-Type" set to "application/octet-stream".] */
-                        if (HTTPHeaders_ReplaceHeaderNameValuePair(clonedEventHTTPrequestHeaders, CONTENT_TYPE, APPLICATION_OCTET_STREAM) != HTTP_HEADERS_OK)
-                        {
-                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
-                            LogError("HTTPHeaders_ReplaceHeaderNameValuePair failed\r\n");
-                        }
-                        else
-                        {
-                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_078: [Every message property "property":"value" shall be added to the HTTP headers as an individual header "iothub-app-property":"value".] */
-                            MAP_HANDLE map = IoTHubMessage_Properties(message->messageHandle);
-                            const char*const* keys;
-                            const char*const* values;
-                            size_t count;
-                            if (Map_GetInternals(map, &keys, &values, &count) != MAP_OK)
-                            {
-                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_078: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
-                                LogError("unable to Map_GetInternals\r\n");
-                            }
-                            else
-                            {
-                                size_t i;
-                                bool goOn = true;
-                                const char* msgId;
-                                const char* corrId;
-                                
-                                for (i = 0; (i < count) && goOn; i++)
-                                {
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_074: [Every property name shall add  to the message size the length of the property name + the length of the property value + 16 bytes.] */
-                                    messageSize += (strlen(values[i]) + strlen(keys[i]) + MAXIMUM_PROPERTY_OVERHEAD);
-                                    if (messageSize > MAXIMUM_MESSAGE_SIZE)
-                                    {
-                                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_072: [The message size shall be limited to 255KB -1 bytes.] */
-                                        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                                        DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                                        IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_BATCHSTATE_FAILED); /*takes care of emptying the list too*/
-                                        goOn = false;
-                                    }
-                                    else
-                                    {
-                                        STRING_HANDLE temp = STRING_construct(IOTHUB_APP_PREFIX);
-                                        if (temp == NULL)
-                                        {
-                                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
-                                            LogError("unable to STRING_construct\r\n");
-                                            goOn = false;
-                                        }
-                                        else
-                                        {
-                                            if (STRING_concat(temp, keys[i]) != 0)
-                                            {
-                                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
-                                                LogError("unable to STRING_concat\r\n");
-                                                goOn = false;
-                                            }
-                                            else
-                                            {
-                                                if (HTTPHeaders_ReplaceHeaderNameValuePair(clonedEventHTTPrequestHeaders, STRING_c_str(temp), values[i]) != HTTP_HEADERS_OK)
-                                                {
-                                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
-                                                    LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair\r\n");
-                                                    goOn = false;
-                                                }
-                                            }
-                                            STRING_delete(temp);
-                                        }
-                                    }
-                                }
-
-                                // Add the Message Id and the Correlation Id
-                                msgId = IoTHubMessage_GetMessageId(message->messageHandle);
-                                if (goOn && msgId != NULL)
-                                {
-                                    if (HTTPHeaders_ReplaceHeaderNameValuePair(clonedEventHTTPrequestHeaders, IOTHUB_MESSAGE_ID, msgId) != HTTP_HEADERS_OK)
-                                    {
-                                        LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair\r\n");
-                                        goOn = false;
-                                    }
-                                }
-
-                                corrId = IoTHubMessage_GetCorrelationId(message->messageHandle);
-                                if (goOn && corrId != NULL)
-                                {
-                                    if (HTTPHeaders_ReplaceHeaderNameValuePair(clonedEventHTTPrequestHeaders, IOTHUB_CORRELATION_ID, corrId) != HTTP_HEADERS_OK)
-                                    {
-                                        LogError("unable to HTTPHeaders_ReplaceHeaderNameValuePair\r\n");
-                                        goOn = false;
-                                    }
-                                }
-
-                                if (!goOn)
-                                {
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_079: [If any HTTP header operation fails, _DoWork shall advance to the next action.] */
-                                }
-                                else
-                                {
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_080: [IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters] */
-                                    BUFFER_HANDLE toBeSend = BUFFER_new();
-                                    if (toBeSend == NULL)
-                                    {
-                                        LogError("unable to BUFFER_new\r\n");
-                                    }
-                                    else
-                                    {
-                                        if (BUFFER_build(toBeSend, messageContent, originalMessageSize) != 0)
-                                        {
-                                            LogError("unable to BUFFER_build\r\n");
-                                        }
-                                        else
-                                        {
-                                            unsigned int statusCode;
-                                            HTTPAPIEX_RESULT r;
-                                            if ((r = HTTPAPIEX_SAS_ExecuteRequest(
-												deviceData->sasObject,
-                                                handleData->httpApiExHandle,
-                                                HTTPAPI_REQUEST_POST,
-                                                STRING_c_str(deviceData->eventHTTPrelativePath),
-                                                clonedEventHTTPrequestHeaders,
-                                                toBeSend,
-                                                &statusCode,
-                                                NULL,
-                                                NULL
-                                                )) != HTTPAPIEX_OK)
-                                            {
-                                                LogError("unable to HTTPAPIEX_ExecuteRequest\r\n");
-                                            }
-                                            else
-                                            {
-                                                if (statusCode < 300)
-                                                {
-                                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_082: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list the item send, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_BATCHSTATE_SUCCESS. The item shall be removed from waitingToSend.] */
-                                                    PDLIST_ENTRY justSent = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                                                    DList_InsertTailList(&(deviceData->eventConfirmations), justSent);
-                                                    IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_BATCHSTATE_SUCCESS); /*takes care of emptying the list too*/
-                                                }
-                                                else
-                                                {
-                                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_081: [If HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
-                                                    LogError("unexpected HTTP status code (%u)\r\n", statusCode);
-                                                }
-                                            }
-                                        }
-                                        BUFFER_delete(toBeSend);
-                                    }
-                                }
-                            }
-                        }
-                        HTTPHeaders_Free(clonedEventHTTPrequestHeaders);
-                    }
+                    break;
                 }
             }
         }
@@ -1979,6 +2310,39 @@ IOTHUB_CLIENT_RESULT IoTHubTransportHttp_SetOption(TRANSPORT_LL_HANDLE handle, c
             handleData->getMinimumPollingTime = *(unsigned int*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp("BatchLingerTime", option) == 0)
+        {
+            handleData->maxBatchLingerTime = *(unsigned int*)value;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (strcmp("BatchTargetSize", option) == 0)
+        {
+            size_t targetSize = *(unsigned int*)value;
+            if ((targetSize < MINIMUM_BATCHTARGETSIZE) || (targetSize > MAXIMUM_MESSAGE_SIZE))
+            {
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("BatchTargetSize has to be between %lu and %lu\r\n", (unsigned long)MINIMUM_BATCHTARGETSIZE, (unsigned long)MAXIMUM_MESSAGE_SIZE);
+            }
+            else
+            {
+                handleData->maxBatchTargetSize = targetSize;
+                handleData->batchTargetSize = targetSize;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp("MaxEventsPerDoWork", option) == 0)
+        {
+            if (*(unsigned int*)value == 0)
+            {
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("MaxEventsPerDoWork has to be at least 1\r\n");
+            }
+            else
+            {
+                handleData->maxEventsPerDoWork = *(unsigned int*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         else
         {
 			/*Codes_SRS_TRANSPORTMULTITHTTP_17_126: [ "TrustedCerts"] */
@@ -23,6 +23,7 @@
 #include "platform.h"
 
 #include "iothub_client_version.h"
+#include "trace_probes.h"
 
 #include <stdarg.h>
 #include <stdio.h>
@@ -37,6 +38,7 @@
 #define SAS_TOKEN_DEFAULT_LEN       10
 #define RESEND_TIMEOUT_VALUE_MIN    1*60
 #define MAX_SEND_RECOUNT_LIMIT      2
+#define STANDBY_RETRY_INTERVAL_SEC  30
 
 TICK_COUNTER_HANDLE g_msgTickCounter;
 
@@ -65,10 +67,21 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
     bool destroyCalled;
     DLIST_ENTRY waitingForAck;
     PDLIST_ENTRY waitingToSend;
+    // Publishes of the event at the head of waitingToSend that failed in a row on the current connection
+    size_t publishFailureCount;
     IOTHUB_CLIENT_LL_HANDLE llClientHandle;
     CONTROL_PACKET_TYPE currPacketState;
     XIO_HANDLE xioTransport;
     int keepAliveValue;
+    // Warm standby: a second client whose io is opened (resolved, connected and TLS handshaken) in the background
+    // while the primary is up. The hub only allows one session per device so CONNECT is sent on it at promotion.
+    MQTT_CLIENT_HANDLE standbyClient;
+    XIO_HANDLE standbyXio;
+    bool standbyOpened;
+    uint64_t standbyOpenTime;
+    // Set while the io of a failed standby is closing, it is only opened again once the close has completed
+    bool standbyClosing;
+    bool replayWaitingForAck;
 } MQTTTRANSPORT_HANDLE_DATA, *PMQTTTRANSPORT_HANDLE_DATA;
 
 typedef struct MQTT_MESSAGE_DETAILS_LIST_TAG
@@ -102,10 +115,100 @@ static void sendMsgComplete(IOTHUB_MESSAGE_LIST* iothubMsgList, PMQTTTRANSPORT_H
     IoTHubClient_LL_SendComplete(transportState->llClientHandle, &messageCompleted, batchResult);
 }
 
-static int publishMqttMessage(PMQTTTRANSPORT_HANDLE_DATA transportState, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry, const unsigned char* payload, size_t len)
+/*the length of the MQTT payload of the message, 0 when its body cannot be read*/
+static size_t RetrieveMessagePayloadLength(IOTHUB_MESSAGE_HANDLE messageHandle)
+{
+    size_t result = 0;
+
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(messageHandle);
+    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        const IOTHUB_MESSAGE_SEGMENT* segments;
+        size_t segmentCount;
+        if (IoTHubMessage_GetSegments(messageHandle, &segments, &segmentCount) != IOTHUB_MESSAGE_OK)
+        {
+            LogError("Failure result from IoTHubMessage_GetSegments\r\n");
+        }
+        else
+        {
+            size_t i;
+            for (i = 0; i < segmentCount; i++)
+            {
+                result += segments[i].size;
+            }
+        }
+    }
+    else if (contentType == IOTHUBMESSAGE_STRING)
+    {
+        const char* text = IoTHubMessage_GetString(messageHandle);
+        if (text == NULL)
+        {
+            LogError("Failure result from IoTHubMessage_GetString\r\n");
+        }
+        else
+        {
+            result = strlen(text);
+        }
+    }
+    return result;
+}
+
+/*the message body as the parts of the MQTT payload, one per segment for messages made by IoTHubMessage_CreateFromSegments so
+that they are gathered straight into the payload. Returns singlePart, an array to free when there are several parts, or NULL*/
+static APP_PAYLOAD* RetrieveMessagePayload(IOTHUB_MESSAGE_HANDLE messageHandle, APP_PAYLOAD* singlePart, size_t* partCount)
+{
+    APP_PAYLOAD* result;
+    const IOTHUB_MESSAGE_SEGMENT* segments;
+
+    if (IoTHubMessage_GetContentType(messageHandle) == IOTHUBMESSAGE_STRING)
+    {
+        const char* text = IoTHubMessage_GetString(messageHandle);
+        if (text == NULL)
+        {
+            LogError("Failure result from IoTHubMessage_GetString\r\n");
+            result = NULL;
+        }
+        else
+        {
+            singlePart->message = (uint8_t*)text;
+            singlePart->length = strlen(text);
+            *partCount = 1;
+            result = singlePart;
+        }
+    }
+    else if (IoTHubMessage_GetSegments(messageHandle, &segments, partCount) != IOTHUB_MESSAGE_OK)
+    {
+        LogError("Failure result from IoTHubMessage_GetSegments\r\n");
+        result = NULL;
+    }
+    else if ((result = (*partCount <= 1) ? singlePart : (APP_PAYLOAD*)malloc(*partCount * sizeof(APP_PAYLOAD))) == NULL)
+    {
+        LogError("Allocation Error: Failure allocating the payload parts.\r\n");
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < *partCount; i++)
+        {
+            result[i].message = (uint8_t*)segments[i].data;
+            result[i].length = segments[i].size;
+        }
+    }
+    return result;
+}
+
+static int publishMqttMessage(PMQTTTRANSPORT_HANDLE_DATA transportState, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry)
 {
     int result;
-    MQTT_MESSAGE_HANDLE mqttMsg = mqttmessage_create(transportState->packetId++, STRING_c_str(transportState->mqttEventTopic), DELIVER_AT_LEAST_ONCE, payload, len);
+    APP_PAYLOAD singlePart;
+    size_t partCount;
+    APP_PAYLOAD* parts = RetrieveMessagePayload(mqttMsgEntry->iotHubMessageEntry->messageHandle, &singlePart, &partCount);
+    MQTT_MESSAGE_HANDLE mqttMsg = (parts == NULL) ? NULL : mqttmessage_createFromParts(transportState->packetId++, STRING_c_str(transportState->mqttEventTopic), DELIVER_AT_LEAST_ONCE, parts, partCount);
+    if (parts != &singlePart)
+    {
+        free(parts);
+    }
+
     if (mqttMsg == NULL)
     {
         result = __LINE__;
@@ -149,10 +252,50 @@ static void MqttRecvCallback(MQTT_MESSAGE_HANDLE msgHandle, void* callbackCtx)
     }
 }
 
+static void OnStandbyIoClosed(void* context)
+{
+    ((PMQTTTRANSPORT_HANDLE_DATA)context)->standbyClosing = false;
+}
+
+static void CloseStandbyIo(PMQTTTRANSPORT_HANDLE_DATA transportData)
+{
+    // DoWork drives the close, the callback may also come from within xio_close
+    transportData->standbyOpened = false;
+    transportData->standbyClosing = true;
+    if (xio_close(transportData->standbyXio, OnStandbyIoClosed, transportData) != 0)
+    {
+        transportData->standbyClosing = false;
+    }
+}
+
+static void PromoteStandby(PMQTTTRANSPORT_HANDLE_DATA transportData)
+{
+    // The failed client and io become the standby, the io is closed and reopened from DoWork once that completes
+    MQTT_CLIENT_HANDLE failedClient = transportData->mqttClient;
+    XIO_HANDLE failedXio = transportData->xioTransport;
+    transportData->mqttClient = transportData->standbyClient;
+    transportData->xioTransport = transportData->standbyXio;
+    transportData->standbyClient = failedClient;
+    transportData->standbyXio = failedXio;
+    CloseStandbyIo(transportData);
+
+    // The next DoWork only has to send CONNECT, whatever was waiting for a PUBACK is published again once it is accepted
+    transportData->currPacketState = CONNECT_TYPE;
+    transportData->replayWaitingForAck = !DList_IsListEmpty(&transportData->waitingForAck);
+}
+
 static void MqttOpCompleteCallback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT_EVENT_RESULT actionResult, const void* msgInfo, void* callbackCtx)
 {
-    (void)handle;
-    if (callbackCtx != NULL)
+    if (callbackCtx != NULL && handle != NULL && handle == ((PMQTTTRANSPORT_HANDLE_DATA)callbackCtx)->standbyClient)
+    {
+        PMQTTTRANSPORT_HANDLE_DATA transportData = (PMQTTTRANSPORT_HANDLE_DATA)callbackCtx;
+        // The standby never sends CONNECT, so the only thing it can report is the loss of its io
+        if (actionResult == MQTT_CLIENT_ON_ERROR)
+        {
+            CloseStandbyIo(transportData);
+        }
+    }
+    else if (callbackCtx != NULL)
     {
         PMQTTTRANSPORT_HANDLE_DATA transportData = (PMQTTTRANSPORT_HANDLE_DATA)callbackCtx;
 
@@ -173,6 +316,7 @@ static void MqttOpCompleteCallback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT_EVENT_
 
                         if (puback->packetId == mqttMsgEntry->msgPacketId)
                         {
+                            TRACE_PROBE2(send_ack, transportData, puback->packetId);
                             (void)DList_RemoveEntryList(currentListEntry); //First remove the item from Waiting for Ack List.
                             sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transportData, IOTHUB_BATCHSTATE_SUCCESS);
                             free(mqttMsgEntry);
@@ -190,13 +334,22 @@ static void MqttOpCompleteCallback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT_EVENT_
                     if (connack->returnCode == CONNECTION_ACCEPTED)
                     {
                         // The connect packet has been acked
+                        TRACE_PROBE3(connection_state, transportData, CONNACK_TYPE, transportData->currPacketState);
                         transportData->currPacketState = CONNACK_TYPE;
+                        // Only publishes that fail on one live connection count against the event
+                        transportData->publishFailureCount = 0;
                     }
                     else
                     {
                         LogError("Connection not accepted, return code: %d.\r\n", connack->returnCode);
+                        if ((connack->returnCode == CONN_REFUSED_SERVER_UNAVAIL) && (transportData->llClientHandle != NULL))
+                        {
+                            // The hub refuses connections while it is over its quota
+                            IoTHubClient_LL_ReportThrottle(transportData->llClientHandle, 0);
+                        }
                         (void)mqtt_client_disconnect(transportData->mqttClient);
                         transportData->connected = false;
+                        TRACE_PROBE3(connection_state, transportData, PACKET_TYPE_ERROR, transportData->currPacketState);
                         transportData->currPacketState = PACKET_TYPE_ERROR;
                     }
                 }
@@ -233,15 +386,41 @@ static void MqttOpCompleteCallback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT_EVENT_
             {
                 // Close the client so we can reconnect again
                 transportData->connected = false;
+                TRACE_PROBE3(connection_state, transportData, DISCONNECT_TYPE, transportData->currPacketState);
                 transportData->currPacketState = DISCONNECT_TYPE;
                 break;
             }
             case MQTT_CLIENT_ON_ERROR:
             {
-                xio_close(transportData->xioTransport, NULL, NULL);
+                bool promoteStandby = transportData->standbyOpened && !transportData->destroyCalled;
+                // IoT Hub throttles MQTT devices by dropping the connection, so losing it with events in flight slows the client down.
+                // A warm standby takes over instead and publishes what was in flight again as soon as it is accepted.
+                if (!promoteStandby && !DList_IsListEmpty(&transportData->waitingForAck) && (transportData->llClientHandle != NULL) && !transportData->destroyCalled)
+                {
+                    IoTHubClient_LL_ReportThrottle(transportData->llClientHandle, 0);
+                    // What was in flight goes back to the client, newest first so it keeps its order, and is paced like
+                    // everything else instead of being published again as soon as the connection is back
+                    while (!DList_IsListEmpty(&transportData->waitingForAck))
+                    {
+                        PDLIST_ENTRY newestEntry = transportData->waitingForAck.Blink;
+                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(newestEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
+                        (void)DList_RemoveEntryList(newestEntry);
+                        IoTHubClient_LL_RetryEvent(transportData->llClientHandle, mqttMsgEntry->iotHubMessageEntry);
+                        free(mqttMsgEntry);
+                    }
+                }
+                if (!promoteStandby)
+                {
+                    xio_close(transportData->xioTransport, NULL, NULL);
+                }
                 transportData->connected = false;
                 transportData->subscribed = false;
+                TRACE_PROBE3(connection_state, transportData, PACKET_TYPE_ERROR, transportData->currPacketState);
                 transportData->currPacketState = PACKET_TYPE_ERROR;
+                if (promoteStandby)
+                {
+                    PromoteStandby(transportData);
+                }
             }
         }
     }
@@ -291,42 +470,6 @@ static int SubscribeToMqttProtocol(PMQTTTRANSPORT_HANDLE_DATA transportState)
     return result;
 }
 
-static const unsigned char* RetrieveMessagePayload(IOTHUB_MESSAGE_HANDLE messageHandle, size_t* length)
-{
-    const unsigned char* result;
-
-    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(messageHandle);
-    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
-    {
-        if (IoTHubMessage_GetByteArray(messageHandle, &result, length) != IOTHUB_MESSAGE_OK)
-        {
-            LogError("Failure result from IoTHubMessage_GetByteArray\r\n");
-            result = NULL;
-            *length = 0;
-        }
-    }
-    else if (contentType == IOTHUBMESSAGE_STRING)
-    {
-        result = (const unsigned char*)IoTHubMessage_GetString(messageHandle);
-        if (result == NULL)
-        {
-            LogError("Failure result from IoTHubMessage_GetString\r\n");
-            result = NULL;
-            *length = 0;
-        }
-        else
-        {
-            *length = strlen((const char*)result);
-        }
-    }
-    else
-    {
-        result = NULL;
-        *length = 0;
-    }
-    return result;
-}
-
 static STRING_HANDLE ConstructSasToken(const char* iothubName, const char* iotHubSuffix, const char* deviceId)
 {
     STRING_HANDLE result;
@@ -386,25 +529,30 @@ static STRING_HANDLE ConstructMessageTopic(const char* deviceId)
     return result;
 }
 
+static XIO_HANDLE CreateTransportProvider(PMQTTTRANSPORT_HANDLE_DATA transportState)
+{
+    // construct address
+    const char* hostAddress = STRING_c_str(transportState->hostAddress);
+    const char* hostName = strstr(hostAddress, "//");
+    if (hostName == NULL)
+    {
+        hostName = hostAddress;
+    }
+    else
+    {
+        // Increment beyond the double backslash
+        hostName += 2;
+    }
+    return getIoTransportProvider(hostName, transportState->portNum);
+}
+
 static int GetTransportProviderIfNecessary(PMQTTTRANSPORT_HANDLE_DATA transportState)
 {
     int result;
 
     if (transportState->xioTransport == NULL)
     {
-        // construct address
-        const char* hostAddress = STRING_c_str(transportState->hostAddress);
-        const char* hostName = strstr(hostAddress, "//");
-        if (hostName == NULL)
-        {
-            hostName = hostAddress;
-        }
-        else
-        {
-            // Increment beyond the double backslash
-            hostName += 2;
-        }
-        transportState->xioTransport = getIoTransportProvider(hostName, transportState->portNum);
+        transportState->xioTransport = CreateTransportProvider(transportState);
         if (transportState->xioTransport == NULL)
         {
             LogError("Unable to create the lower level TLS layer.\r\n");
@@ -465,6 +613,104 @@ static int SendMqttConnectMsg(PMQTTTRANSPORT_HANDLE_DATA transportState)
     return result;
 }
 
+static int CreateStandby(PMQTTTRANSPORT_HANDLE_DATA transportState)
+{
+    int result;
+    if (transportState->standbyClient != NULL)
+    {
+        result = 0;
+    }
+    else if ((transportState->standbyXio = CreateTransportProvider(transportState)) == NULL)
+    {
+        LogError("Unable to create the standby TLS layer.\r\n");
+        result = __LINE__;
+    }
+    else if ((transportState->standbyClient = mqtt_client_init(MqttRecvCallback, MqttOpCompleteCallback, transportState, defaultPrintLogFunction)) == NULL)
+    {
+        LogError("Unable to create the standby mqtt client.\r\n");
+        xio_destroy(transportState->standbyXio);
+        transportState->standbyXio = NULL;
+        result = __LINE__;
+    }
+    else
+    {
+        transportState->standbyOpened = false;
+        transportState->standbyOpenTime = 0;
+        transportState->standbyClosing = false;
+        result = 0;
+    }
+    return result;
+}
+
+static void DestroyStandby(PMQTTTRANSPORT_HANDLE_DATA transportState)
+{
+    if (transportState->standbyClient != NULL)
+    {
+        mqtt_client_deinit(transportState->standbyClient);
+        xio_destroy(transportState->standbyXio);
+        transportState->standbyClient = NULL;
+        transportState->standbyXio = NULL;
+        transportState->standbyOpened = false;
+        transportState->standbyClosing = false;
+    }
+}
+
+static void OpenStandbyIfNecessary(PMQTTTRANSPORT_HANDLE_DATA transportState)
+{
+    if (transportState->standbyClient != NULL && !transportState->standbyOpened && !transportState->standbyClosing)
+    {
+        // The endpoint may drop a socket that never sends CONNECT, so a lost standby is only reopened every so often
+        uint64_t current_ms;
+        (void)tickcounter_get_current_ms(g_msgTickCounter, &current_ms);
+        if (transportState->standbyOpenTime == 0 || ((current_ms - transportState->standbyOpenTime) / 1000) >= STANDBY_RETRY_INTERVAL_SEC)
+        {
+            transportState->standbyOpenTime = current_ms;
+            if (mqtt_client_open_io(transportState->standbyClient, transportState->standbyXio) != 0)
+            {
+                LogError("failure opening the standby connection to %s:%d.\r\n", STRING_c_str(transportState->hostAddress), transportState->portNum);
+            }
+            else
+            {
+                transportState->standbyOpened = true;
+            }
+        }
+    }
+}
+
+static void ReplayWaitingForAck(PMQTTTRANSPORT_HANDLE_DATA transportState)
+{
+    PDLIST_ENTRY currentListEntry = transportState->waitingForAck.Flink;
+    while (currentListEntry != &transportState->waitingForAck)
+    {
+        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentListEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
+        DLIST_ENTRY nextListEntry;
+        nextListEntry.Flink = currentListEntry->Flink;
+
+        size_t messageLength = RetrieveMessagePayloadLength(mqttMsgEntry->iotHubMessageEntry->messageHandle);
+        if (messageLength == 0)
+        {
+            LogError("Failure from creating Message IoTHubMessage_GetData\r\n");
+        }
+        else
+        {
+            // A failover is not the message's fault, it does not count against its retries
+            size_t retryCount = mqttMsgEntry->retryCount;
+            mqttMsgEntry->msgPacketId = transportState->packetId;
+            if (publishMqttMessage(transportState, mqttMsgEntry) != 0)
+            {
+                (void)DList_RemoveEntryList(currentListEntry);
+                sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transportState, IOTHUB_BATCHSTATE_FAILED);
+                free(mqttMsgEntry);
+            }
+            else
+            {
+                mqttMsgEntry->retryCount = retryCount;
+            }
+        }
+        currentListEntry = nextListEntry.Flink;
+    }
+}
+
 static int InitializeConnection(PMQTTTRANSPORT_HANDLE_DATA transportState)
 {
     int result = 0;
@@ -603,8 +849,15 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                 state->xioTransport = NULL;
                 state->portNum = DEFAULT_PORT_NUMBER;
                 state->waitingToSend = waitingToSend;
+                state->publishFailureCount = 0;
                 state->currPacketState = CONNECT_TYPE;
                 state->keepAliveValue = DEFAULT_MQTT_KEEPALIVE;
+                state->standbyClient = NULL;
+                state->standbyXio = NULL;
+                state->standbyOpened = false;
+                state->standbyOpenTime = 0;
+                state->standbyClosing = false;
+                state->replayWaitingForAck = false;
             }
         }
     }
@@ -691,6 +944,7 @@ void IoTHubTransportMqtt_Destroy(TRANSPORT_LL_HANDLE handle)
         transportState->destroyCalled = true;
 
         DisconnectFromClient(transportState);
+        DestroyStandby(transportState);
 
         //Empty the Waiting for Ack Messages.
         while (!DList_IsListEmpty(&transportState->waitingForAck))
@@ -771,6 +1025,8 @@ extern void IoTHubTransportMqtt_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
         if (InitializeConnection(transportState) != 0)
         {
             // Don't want to flood the logs with failures here
+            // A promoted standby whose io was lost in the meantime fails CONNECT until its io reports the error
+            mqtt_client_dowork(transportState->mqttClient);
         }
         else
         {
@@ -785,6 +1041,13 @@ extern void IoTHubTransportMqtt_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
             }
             else if (transportState->currPacketState == PUBLISH_TYPE)
             {
+                if (transportState->replayWaitingForAck)
+                {
+                    transportState->replayWaitingForAck = false;
+                    ReplayWaitingForAck(transportState);
+                }
+                OpenStandbyIfNecessary(transportState);
+
                 PDLIST_ENTRY currentListEntry = transportState->waitingForAck.Flink;
                 while (currentListEntry != &transportState->waitingForAck)
                 {
@@ -806,15 +1069,14 @@ extern void IoTHubTransportMqtt_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
                         }
                         else
                         {
-                            size_t messageLength;
-                            const unsigned char* messagePayload = RetrieveMessagePayload(mqttMsgEntry->iotHubMessageEntry->messageHandle, &messageLength);
-                            if (messageLength == 0 || messagePayload == NULL)
+                            size_t messageLength = RetrieveMessagePayloadLength(mqttMsgEntry->iotHubMessageEntry->messageHandle);
+                            if (messageLength == 0)
                             {
                                 LogError("Failure from creating Message IoTHubMessage_GetData\r\n");
                             }
                             else
                             {
-                                if (publishMqttMessage(transportState, mqttMsgEntry, messagePayload, messageLength) != 0)
+                                if (publishMqttMessage(transportState, mqttMsgEntry) != 0)
                                 {
                                     (void)DList_RemoveEntryList(currentListEntry);
                                     sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transportState, IOTHUB_BATCHSTATE_FAILED);
@@ -835,9 +1097,8 @@ extern void IoTHubTransportMqtt_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
                     savedFromCurrentListEntry.Flink = currentListEntry->Flink;
 
                     /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_027: [IoTHubTransportMqtt_DoWork shall inspect the waitingToSend DLIST passed in config structure.] */
-                    size_t messageLength;
-                    const unsigned char* messagePayload = RetrieveMessagePayload(iothubMsgList->messageHandle, &messageLength);
-                    if (messageLength == 0 || messagePayload == NULL)
+                    size_t messageLength = RetrieveMessagePayloadLength(iothubMsgList->messageHandle);
+                    if (messageLength == 0)
                     {
                         LogError("Failure result from IoTHubMessage_GetData\r\n");
                     }
@@ -855,14 +1116,27 @@ extern void IoTHubTransportMqtt_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
                             mqttMsgEntry->msgPacketId = transportState->packetId;
                             mqttMsgEntry->iotHubMessageEntry = iothubMsgList;
 
-                            if (publishMqttMessage(transportState, mqttMsgEntry, messagePayload, messageLength) != 0)
+                            if (publishMqttMessage(transportState, mqttMsgEntry) != 0)
                             {
-                                (void)(DList_RemoveEntryList(currentListEntry));
-                                sendMsgComplete(iothubMsgList, transportState, IOTHUB_BATCHSTATE_FAILED);
                                 free(mqttMsgEntry);
+                                if (++transportState->publishFailureCount < MAX_SEND_RECOUNT_LIMIT)
+                                {
+                                    // Most likely the hub has just dropped the connection, the event stays queued for the
+                                    // next connection instead of failing and nothing else is tried now
+                                    break;
+                                }
+                                else
+                                {
+                                    // The event itself is likely the problem, it must not hold back the ones queued after it
+                                    transportState->publishFailureCount = 0;
+                                    (void)(DList_RemoveEntryList(currentListEntry));
+                                    sendMsgComplete(iothubMsgList, transportState, IOTHUB_BATCHSTATE_FAILED);
+                                }
                             }
                             else
                             {
+                                transportState->publishFailureCount = 0;
+                                TRACE_PROBE2(event_dequeue, transportState, iothubMsgList);
                                 (void)(DList_RemoveEntryList(currentListEntry));
                                 DList_InsertTailList(&(transportState->waitingForAck), &(mqttMsgEntry->entry));
                             }
@@ -873,6 +1147,14 @@ extern void IoTHubTransportMqtt_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIENT
             }
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_030: [IoTHubTransportMqtt_DoWork shall call mqtt_client_dowork everytime it is called if it is connected.] */
             mqtt_client_dowork(transportState->mqttClient);
+            if (transportState->standbyOpened)
+            {
+                mqtt_client_dowork(transportState->standbyClient);
+            }
+            else if (transportState->standbyClosing)
+            {
+                xio_dowork(transportState->standbyXio);
+            }
         }
     }
 }
@@ -926,8 +1208,28 @@ IOTHUB_CLIENT_RESULT IoTHubTransportMqtt_SetOption(TRANSPORT_LL_HANDLE handle, c
         {
             bool* traceVal = (bool*)value;
             mqtt_client_set_trace(transportState->mqttClient, *traceVal, *traceVal);
+            mqtt_client_set_trace(transportState->standbyClient, *traceVal, *traceVal);
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp("warmStandby", option) == 0)
+        {
+            // bool_ptr, keeps a second connection open to fail over to. Set it before any option that is passed down
+            // to the io (TrustedCerts, ...) so both connections get them.
+            bool* standbyVal = (bool*)value;
+            if (!*standbyVal)
+            {
+                DestroyStandby(transportState);
+                result = IOTHUB_CLIENT_OK;
+            }
+            else if (CreateStandby(transportState) != 0)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         else if (strcmp("keepalive", option) == 0)
         {
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_036: [If the option parameter is set to "keepalive" then the value shall be a int_ptr and the value will determine the mqtt keepalive time that is set for pings.] */
@@ -949,7 +1251,8 @@ IOTHUB_CLIENT_RESULT IoTHubTransportMqtt_SetOption(TRANSPORT_LL_HANDLE handle, c
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_032: [IoTHubTransportMqtt_SetOption shall pass down the option to xio_setoption if the option parameter is not a known option string for the MQTT transport.] */
             if (GetTransportProviderIfNecessary(transportState) == 0)
             {
-                if (xio_setoption(transportState->xioTransport, option, value) == 0)
+                if (xio_setoption(transportState->xioTransport, option, value) == 0 &&
+                    (transportState->standbyXio == NULL || xio_setoption(transportState->standbyXio, option, value) == 0))
                 {
                     result = IOTHUB_CLIENT_OK;
                 }
@@ -175,185 +175,218 @@ static void link_frame_received(void* context, AMQP_VALUE performative, uint32_t
 {
 	LINK_INSTANCE* link_instance = (LINK_INSTANCE*)context;
 	AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(performative);
+	uint64_t performative_ulong;
 
-	if (is_attach_type_by_descriptor(descriptor))
+	if (amqpvalue_get_ulong(descriptor, &performative_ulong) != 0)
 	{
-		ATTACH_HANDLE attach_handle;
-		if (amqpvalue_get_attach(performative, &attach_handle) == 0)
-		{
-			if ((link_instance->role == role_receiver) &&
-				(attach_get_initial_delivery_count(attach_handle, &link_instance->delivery_count) != 0))
-			{
-				/* error */
-				set_link_state(link_instance, LINK_STATE_DETACHED);
-			}
-			else
-			{
-				if (link_instance->link_state == LINK_STATE_HALF_ATTACHED)
-				{
-					if (link_instance->role == role_receiver)
-					{
-						link_instance->link_credit = DEFAULT_LINK_CREDIT;
-						send_flow(link_instance);
-					}
-					else
-					{
-						link_instance->link_credit = 0;
-					}
-
-					set_link_state(link_instance, LINK_STATE_ATTACHED);
-				}
-			}
-
-			attach_destroy(attach_handle);
-		}
+		/* error */
 	}
-	else if (is_flow_type_by_descriptor(descriptor))
+	else
 	{
-		FLOW_HANDLE flow_handle;
-		if (amqpvalue_get_flow(performative, &flow_handle) == 0)
+		switch (performative_ulong)
 		{
-			if (link_instance->role == role_sender)
-			{
-				delivery_number rcv_delivery_count;
-				uint32_t rcv_link_credit;
+		default:
+			break;
 
-				if ((flow_get_link_credit(flow_handle, &rcv_link_credit) != 0) ||
-					(flow_get_delivery_count(flow_handle, &rcv_delivery_count) != 0))
+		case AMQP_ATTACH:
+		{
+			ATTACH_HANDLE attach_handle;
+			if (amqpvalue_get_attach(performative, &attach_handle) == 0)
+			{
+				if ((link_instance->role == role_receiver) &&
+					(attach_get_initial_delivery_count(attach_handle, &link_instance->delivery_count) != 0))
 				{
 					/* error */
 					set_link_state(link_instance, LINK_STATE_DETACHED);
 				}
 				else
 				{
-					link_instance->link_credit = rcv_delivery_count + rcv_link_credit - link_instance->delivery_count;
-					if (link_instance->link_credit > 0)
+					if (link_instance->link_state == LINK_STATE_HALF_ATTACHED)
 					{
-						link_instance->on_link_flow_on(link_instance->callback_context);
+						if (link_instance->role == role_receiver)
+						{
+							link_instance->link_credit = DEFAULT_LINK_CREDIT;
+							send_flow(link_instance);
+						}
+						else
+						{
+							link_instance->link_credit = 0;
+						}
+
+						set_link_state(link_instance, LINK_STATE_ATTACHED);
 					}
 				}
+
+				attach_destroy(attach_handle);
 			}
+
+			break;
 		}
 
-		flow_destroy(flow_handle);
-	}
-	else if (is_transfer_type_by_descriptor(descriptor))
-	{
-		if (link_instance->on_transfer_received != NULL)
+		case AMQP_FLOW:
 		{
-			TRANSFER_HANDLE transfer_handle;
-			if (amqpvalue_get_transfer(performative, &transfer_handle) == 0)
+			FLOW_HANDLE flow_handle;
+			if (amqpvalue_get_flow(performative, &flow_handle) == 0)
 			{
-				AMQP_VALUE delivery_state;
-				delivery_number received_delivery_id;
-
-				link_instance->link_credit--;
-				link_instance->delivery_count++;
-				if (link_instance->link_credit == 0)
+				if (link_instance->role == role_sender)
 				{
-					link_instance->link_credit = DEFAULT_LINK_CREDIT;
-					send_flow(link_instance);
-				}
+					delivery_number rcv_delivery_count;
+					uint32_t rcv_link_credit;
 
-				if (transfer_get_delivery_id(transfer_handle, &received_delivery_id) != 0)
-				{
-					/* error */
+					if ((flow_get_link_credit(flow_handle, &rcv_link_credit) != 0) ||
+						(flow_get_delivery_count(flow_handle, &rcv_delivery_count) != 0))
+					{
+						/* error */
+						set_link_state(link_instance, LINK_STATE_DETACHED);
+					}
+					else
+					{
+						link_instance->link_credit = rcv_delivery_count + rcv_link_credit - link_instance->delivery_count;
+						if (link_instance->link_credit > 0)
+						{
+							link_instance->on_link_flow_on(link_instance->callback_context);
+						}
+					}
 				}
-				else
+			}
+
+			flow_destroy(flow_handle);
+
+			break;
+		}
+
+		case AMQP_TRANSFER:
+		{
+			if (link_instance->on_transfer_received != NULL)
+			{
+				TRANSFER_HANDLE transfer_handle;
+				if (amqpvalue_get_transfer(performative, &transfer_handle) == 0)
 				{
-					delivery_state = link_instance->on_transfer_received(link_instance->callback_context, transfer_handle, payload_size, payload_bytes);
+					AMQP_VALUE delivery_state;
+					delivery_number received_delivery_id;
 
-					if (send_disposition(link_instance, received_delivery_id, delivery_state) != 0)
+					link_instance->link_credit--;
+					link_instance->delivery_count++;
+					if (link_instance->link_credit == 0)
 					{
-						/* error */
+						link_instance->link_credit = DEFAULT_LINK_CREDIT;
+						send_flow(link_instance);
 					}
 
-					if (delivery_state != NULL)
+					if (transfer_get_delivery_id(transfer_handle, &received_delivery_id) != 0)
 					{
-						amqpvalue_destroy(delivery_state);
+						/* error */
 					}
-				}
+					else
+					{
+						delivery_state = link_instance->on_transfer_received(link_instance->callback_context, transfer_handle, payload_size, payload_bytes);
+
+						if (send_disposition(link_instance, received_delivery_id, delivery_state) != 0)
+						{
+							/* error */
+						}
 
-				transfer_destroy(transfer_handle);
+						if (delivery_state != NULL)
+						{
+							amqpvalue_destroy(delivery_state);
+						}
+					}
+
+					transfer_destroy(transfer_handle);
+				}
 			}
+
+			break;
 		}
-	}
-	else if (is_disposition_type_by_descriptor(descriptor))
-	{
-		DISPOSITION_HANDLE disposition;
-		if (amqpvalue_get_disposition(performative, &disposition) != 0)
-		{
-			/* error */
-		}
-		else
-		{
-			delivery_number first;
-			delivery_number last;
 
-			if (disposition_get_first(disposition, &first) != 0)
+		case AMQP_DISPOSITION:
+		{
+			DISPOSITION_HANDLE disposition;
+			if (amqpvalue_get_disposition(performative, &disposition) != 0)
 			{
 				/* error */
 			}
 			else
 			{
-                bool settled;
+				delivery_number first;
+				delivery_number last;
 
-				if (disposition_get_last(disposition, &last) != 0)
+				if (disposition_get_first(disposition, &first) != 0)
 				{
-					last = first;
+					/* error */
 				}
+				else
+				{
+	                bool settled;
 
-                if (disposition_get_settled(disposition, &settled) != 0)
-                {
-                    /* Error */
-                    settled = false;
-                }
-
-                if (settled)
-                {
-                    LIST_ITEM_HANDLE pending_delivery = list_get_head_item(link_instance->pending_deliveries);
-                    while (pending_delivery != NULL)
-                    {
-                        LIST_ITEM_HANDLE next_pending_delivery = list_get_next_item(pending_delivery);
-                        DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)list_item_get_value(pending_delivery);
-                        if (delivery_instance == NULL)
-                        {
-                            /* error */
-                            break;
-                        }
-                        else
-                        {
-                            if ((delivery_instance->delivery_id >= first) && (delivery_instance->delivery_id <= last))
-                            {
-                                delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id);
-                                amqpalloc_free(delivery_instance);
-                                if (list_remove(link_instance->pending_deliveries, pending_delivery) != 0)
-                                {
-                                    /* error */
-                                    break;
-                                }
-                                else
-                                {
-                                    pending_delivery = next_pending_delivery;
-                                }
-                            }
-                            else
-                            {
-                                pending_delivery = next_pending_delivery;
-                            }
-                        }
-                    }
-                }
+					if (disposition_get_last(disposition, &last) != 0)
+					{
+						last = first;
+					}
+
+	                if (disposition_get_settled(disposition, &settled) != 0)
+	                {
+	                    /* Error */
+	                    settled = false;
+	                }
+
+	                if (settled)
+	                {
+	                    AMQP_VALUE delivery_state;
+	                    LIST_ITEM_HANDLE pending_delivery = list_get_head_item(link_instance->pending_deliveries);
+	                    if (disposition_get_state(disposition, &delivery_state) != 0)
+	                    {
+	                        delivery_state = NULL;
+	                    }
+	                    while (pending_delivery != NULL)
+	                    {
+	                        LIST_ITEM_HANDLE next_pending_delivery = list_get_next_item(pending_delivery);
+	                        DELIVERY_INSTANCE* delivery_instance = (DELIVERY_INSTANCE*)list_item_get_value(pending_delivery);
+	                        if (delivery_instance == NULL)
+	                        {
+	                            /* error */
+	                            break;
+	                        }
+	                        else
+	                        {
+	                            if ((delivery_instance->delivery_id >= first) && (delivery_instance->delivery_id <= last))
+	                            {
+	                                delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, delivery_state);
+	                                amqpalloc_free(delivery_instance);
+	                                if (list_remove(link_instance->pending_deliveries, pending_delivery) != 0)
+	                                {
+	                                    /* error */
+	                                    break;
+	                                }
+	                                else
+	                                {
+	                                    pending_delivery = next_pending_delivery;
+	                                }
+	                            }
+	                            else
+	                            {
+	                                pending_delivery = next_pending_delivery;
+	                            }
+	                        }
+	                    }
+	                }
+				}
+
+				disposition_destroy(disposition);
 			}
 
-			disposition_destroy(disposition);
+			break;
 		}
-	}
-	else if (is_detach_type_by_descriptor(descriptor))
-	{
-		if (send_detach_frame(link_instance, NULL) != 0)
+
+		case AMQP_DETACH:
 		{
-			/* error */
+			if (send_detach_frame(link_instance, NULL) != 0)
+			{
+				/* error */
+			}
+
+			break;
+		}
 		}
 	}
 }
@@ -470,7 +503,7 @@ static void on_send_complete(void* context, IO_SEND_RESULT send_result)
 	LINK_INSTANCE* link_instance = (LINK_INSTANCE*)delivery_instance->link;
 	if (link_instance->snd_settle_mode == sender_settle_mode_settled)
 	{
-		delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id);
+		delivery_instance->on_delivery_settled(delivery_instance->callback_context, delivery_instance->delivery_id, NULL);
 		amqpalloc_free(delivery_instance);
 		(void)list_remove(link_instance->pending_deliveries, delivery_instance_list_item);
 	}
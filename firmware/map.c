@@ -19,6 +19,7 @@ typedef struct MAP_HANDLE_DATA_TAG
     char** values;
     size_t count;
     MAP_FILTER_CALLBACK mapFilterCallback;
+    bool isReadOnly; /*set by Map_CreateReadOnly: the map and its content belong to the caller*/
 }MAP_HANDLE_DATA;
 
 #define LOG_MAP_ERROR LogError("result = %s\r\n", ENUM_TO_STRING(MAP_RESULT, result));
@@ -35,6 +36,34 @@ MAP_HANDLE Map_Create(MAP_FILTER_CALLBACK mapFilterFunc)
         result->values = NULL;
         result->count = 0;
         result->mapFilterCallback = mapFilterFunc;
+        result->isReadOnly = false;
+    }
+    return (MAP_HANDLE)result;
+}
+
+size_t Map_GetReadOnlyStorageSize(void)
+{
+    return sizeof(MAP_HANDLE_DATA);
+}
+
+MAP_HANDLE Map_CreateReadOnly(void* storage, const char* const* keys, const char* const* values, size_t count)
+{
+    MAP_HANDLE_DATA* result;
+    if ((storage == NULL) ||
+        ((count != 0) && ((keys == NULL) || (values == NULL))))
+    {
+        LogError("invalid arg to Map_CreateReadOnly\r\n");
+        result = NULL;
+    }
+    else
+    {
+        result = (MAP_HANDLE_DATA*)storage;
+        /*the vectors are never written through when isReadOnly is set*/
+        result->keys = (char**)keys;
+        result->values = (char**)values;
+        result->count = count;
+        result->mapFilterCallback = NULL;
+        result->isReadOnly = true;
     }
     return (MAP_HANDLE)result;
 }
@@ -46,16 +75,20 @@ void Map_Destroy(MAP_HANDLE handle)
     {
         /*Codes_SRS_MAP_02_004: [Map_Destroy shall release all resources associated with the map.] */
         MAP_HANDLE_DATA* handleData = (MAP_HANDLE_DATA*)handle;
-        size_t i;
-      
-        for (i = 0; i < handleData->count; i++)
+
+        /*a read only map is owned by whoever called Map_CreateReadOnly*/
+        if (!handleData->isReadOnly)
         {
-            free(handleData->keys[i]);
-            free(handleData->values[i]);
+            size_t i;
+            for (i = 0; i < handleData->count; i++)
+            {
+                free(handleData->keys[i]);
+                free(handleData->values[i]);
+            }
+            free(handleData->keys);
+            free(handleData->values);
+            free(handleData);
         }
-        free(handleData->keys);
-        free(handleData->values);
-        free(handleData);
     }
 }
 
@@ -120,6 +153,8 @@ MAP_HANDLE Map_Clone(MAP_HANDLE handle)
         }
         else
         {
+            /*the clone of a read only map is a regular map*/
+            result->isReadOnly = false;
             if (handleData->count == 0)  
             {
                 result->count = 0;
@@ -342,6 +377,11 @@ MAP_RESULT Map_Add(MAP_HANDLE handle, const char* key, const char* value)
         result = MAP_INVALIDARG;
         LOG_MAP_ERROR; 
     }
+    else if (((MAP_HANDLE_DATA*)handle)->isReadOnly)
+    {
+        result = MAP_ERROR;
+        LogError("map is read only\r\n");
+    }
     else
     {
         MAP_HANDLE_DATA* handleData = (MAP_HANDLE_DATA*)handle;
@@ -392,6 +432,11 @@ MAP_RESULT Map_AddOrUpdate(MAP_HANDLE handle, const char* key, const char* value
         result = MAP_INVALIDARG;
         LOG_MAP_ERROR;
     }
+    else if (((MAP_HANDLE_DATA*)handle)->isReadOnly)
+    {
+        result = MAP_ERROR;
+        LogError("map is read only\r\n");
+    }
     else
     {
         MAP_HANDLE_DATA* handleData = (MAP_HANDLE_DATA*)handle;
@@ -455,6 +500,11 @@ MAP_RESULT Map_Delete(MAP_HANDLE handle, const char* key)
         result = MAP_INVALIDARG;
         LOG_MAP_ERROR;
     }
+    else if (((MAP_HANDLE_DATA*)handle)->isReadOnly)
+    {
+        result = MAP_ERROR;
+        LogError("map is read only\r\n");
+    }
     else
     {
         MAP_HANDLE_DATA* handleData = (MAP_HANDLE_DATA*)handle;
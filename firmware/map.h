@@ -55,6 +55,27 @@ typedef int (*MAP_FILTER_CALLBACK)(const char* mapProperty, const char* mapValue
  */
 extern MAP_HANDLE Map_Create(MAP_FILTER_CALLBACK mapFilterFunc);
 
+/**
+ * @brief   Returns how many bytes ::Map_CreateReadOnly needs for @c storage.
+ */
+extern size_t Map_GetReadOnlyStorageSize(void);
+
+/**
+ * @brief   Creates a map over key/value vectors owned by the caller, without
+ *          allocating. The map cannot be modified, ::Map_Destroy does not
+ *          release anything and ::Map_Clone returns a regular map.
+ *
+ * @param   storage The memory for the map itself, at least
+ *                  ::Map_GetReadOnlyStorageSize bytes, pointer aligned.
+ * @param   keys    The keys, which shall be distinct.
+ * @param   values  The values, @c values[i] belongs to @c keys[i].
+ * @param   count   The number of entries in @p keys and @p values.
+ *
+ * @return  A @c MAP_HANDLE pointing into @p storage or @c NULL in case an
+ *          error occurs. Everything passed in shall outlive the handle.
+ */
+extern MAP_HANDLE Map_CreateReadOnly(void* storage, const char* const* keys, const char* const* values, size_t count);
+
 /**
  * @brief   Release all resources associated with the map.
  *
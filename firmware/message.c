@@ -711,12 +711,30 @@ int message_get_footer(MESSAGE_HANDLE message, annotations* footer)
 
 int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA binary_data)
 {
-	int result;
+	return message_add_body_amqp_data_parts(message, &binary_data, 1);
+}
 
+int message_add_body_amqp_data_parts(MESSAGE_HANDLE message, const BINARY_DATA* parts, size_t part_count)
+{
+	int result;
 	MESSAGE_INSTANCE* message_instance = (MESSAGE_INSTANCE*)message;
+	size_t length = 0;
+	size_t i;
+
+	for (i = 0; (parts != NULL) && (i < part_count); i++)
+	{
+		if ((parts[i].bytes == NULL) && (parts[i].length > 0))
+		{
+			break;
+		}
+
+		length += parts[i].length;
+	}
+
 	if ((message == NULL) ||
-		(binary_data.bytes == NULL) ||
-		(binary_data.length == 0))
+		(parts == NULL) ||
+		(i < part_count) ||
+		(length == 0))
 	{
 		result = __LINE__;
 	}
@@ -731,15 +749,24 @@ int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA binary_data)
 		{
 			message_instance->body_amqp_data_items = new_body_amqp_data_items;
 
-			message_instance->body_amqp_data_items[message_instance->body_amqp_data_count].body_data_section_bytes = (unsigned char*)amqpalloc_malloc(binary_data.length);
+			message_instance->body_amqp_data_items[message_instance->body_amqp_data_count].body_data_section_bytes = (unsigned char*)amqpalloc_malloc(length);
 			if (message_instance->body_amqp_data_items[message_instance->body_amqp_data_count].body_data_section_bytes == NULL)
 			{
 				result = __LINE__;
 			}
 			else
 			{
-				message_instance->body_amqp_data_items[message_instance->body_amqp_data_count].body_data_section_length = binary_data.length;
-				(void)memcpy(message_instance->body_amqp_data_items[message_instance->body_amqp_data_count].body_data_section_bytes, binary_data.bytes, binary_data.length);
+				/* the parts are gathered into one data section */
+				unsigned char* section_bytes = message_instance->body_amqp_data_items[message_instance->body_amqp_data_count].body_data_section_bytes;
+				message_instance->body_amqp_data_items[message_instance->body_amqp_data_count].body_data_section_length = length;
+				for (i = 0; i < part_count; i++)
+				{
+					if (parts[i].length > 0)
+					{
+						(void)memcpy(section_bytes, parts[i].bytes, parts[i].length);
+						section_bytes += parts[i].length;
+					}
+				}
 
 				if (message_instance->body_amqp_value != NULL)
 				{
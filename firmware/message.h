@@ -45,6 +45,8 @@ extern "C" {
 	extern int message_set_footer(MESSAGE_HANDLE message, annotations footer);
 	extern int message_get_footer(MESSAGE_HANDLE message, annotations* footer);
 	extern int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA binary_data);
+	/* adds one data section holding the parts one after the other */
+	extern int message_add_body_amqp_data_parts(MESSAGE_HANDLE message, const BINARY_DATA* parts, size_t part_count);
 	extern int message_get_body_amqp_data(MESSAGE_HANDLE message, size_t index, BINARY_DATA* binary_data);
 	extern int message_get_body_amqp_data_count(MESSAGE_HANDLE message, size_t* count);
 	extern int message_set_body_amqp_value(MESSAGE_HANDLE message, AMQP_VALUE body_amqp_value);
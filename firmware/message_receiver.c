@@ -170,7 +170,7 @@ static AMQP_VALUE on_transfer_received(void* context, TRANSFER_HANDLE transfer,
 		else
 		{
 			message_receiver_instance->decoded_message;
-			AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create(decode_message_value_callback, message_receiver_instance);
+			AMQPVALUE_DECODER_HANDLE amqpvalue_decoder = amqpvalue_decoder_create_in_place(decode_message_value_callback, message_receiver_instance);
 			if (amqpvalue_decoder == NULL)
 			{
 				set_message_receiver_state(message_receiver_instance, MESSAGE_RECEIVER_STATE_ERROR);
@@ -92,14 +92,43 @@ static void remove_pending_message(MESSAGE_SENDER_INSTANCE* message_sender_insta
 	}
 }
 
-static void on_delivery_settled(void* context, delivery_number delivery_no)
+/* IoT Hub rejects transfers with amqp:resource-limit-exceeded while the device or the hub is over its quota */
+static bool is_throttled(AMQP_VALUE delivery_state)
+{
+	bool result = false;
+	AMQP_VALUE descriptor;
+	REJECTED_HANDLE rejected;
+
+	if ((delivery_state != NULL) &&
+		((descriptor = amqpvalue_get_inplace_descriptor(delivery_state)) != NULL) &&
+		is_rejected_type_by_descriptor(descriptor) &&
+		(amqpvalue_get_rejected(delivery_state, &rejected) == 0))
+	{
+		ERROR_HANDLE error;
+		if (rejected_get_error(rejected, &error) == 0)
+		{
+			const char* condition;
+			if ((error_get_condition(error, &condition) == 0) &&
+				(strcmp(condition, "amqp:resource-limit-exceeded") == 0))
+			{
+				result = true;
+			}
+			error_destroy(error);
+		}
+		rejected_destroy(rejected);
+	}
+
+	return result;
+}
+
+static void on_delivery_settled(void* context, delivery_number delivery_no, AMQP_VALUE delivery_state)
 {
 	MESSAGE_WITH_CALLBACK* message_with_callback = (MESSAGE_WITH_CALLBACK*)context;
 	MESSAGE_SENDER_INSTANCE* message_sender_instance = (MESSAGE_SENDER_INSTANCE*)message_with_callback->message_sender;
 
 	if (message_with_callback->on_message_send_complete != NULL)
 	{
-		message_with_callback->on_message_send_complete(message_with_callback->context, MESSAGE_SEND_OK);
+		message_with_callback->on_message_send_complete(message_with_callback->context, is_throttled(delivery_state) ? MESSAGE_SEND_THROTTLED : MESSAGE_SEND_OK);
 	}
 
 	remove_pending_message(message_sender_instance, message_with_callback);
@@ -680,3 +709,24 @@ int messagesender_send(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE mess
 
 	return result;
 }
+
+int messagesender_get_pending_message_count(MESSAGE_SENDER_HANDLE message_sender, size_t* message_count)
+{
+	int result;
+
+	if ((message_sender == NULL) ||
+		(message_count == NULL))
+	{
+		result = __LINE__;
+	}
+	else
+	{
+		MESSAGE_SENDER_INSTANCE* message_sender_instance = (MESSAGE_SENDER_INSTANCE*)message_sender;
+
+		/* messages stay in the pending list until their delivery is settled */
+		*message_count = message_sender_instance->message_count;
+		result = 0;
+	}
+
+	return result;
+}
@@ -15,7 +15,9 @@ extern "C" {
 	typedef enum MESSAGE_SEND_RESULT_TAG
 	{
 		MESSAGE_SEND_OK,
-		MESSAGE_SEND_ERROR
+		MESSAGE_SEND_ERROR,
+		/* rejected with amqp:resource-limit-exceeded, the message can be sent again once the peer's quota allows it */
+		MESSAGE_SEND_THROTTLED
 	} MESSAGE_SEND_RESULT;
 
 	typedef enum MESSAGE_SENDER_STATE_TAG
@@ -36,6 +38,7 @@ extern "C" {
 	extern int messagesender_open(MESSAGE_SENDER_HANDLE message_sender);
 	extern int messagesender_close(MESSAGE_SENDER_HANDLE message_sender);
 	extern int messagesender_send(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context);
+	extern int messagesender_get_pending_message_count(MESSAGE_SENDER_HANDLE message_sender, size_t* message_count);
 
 #ifdef __cplusplus
 }
@@ -36,6 +36,9 @@ typedef struct MQTT_CLIENT_TAG
     MQTT_CLIENT_OPTIONS mqttOptions;
     bool clientConnected;
     bool socketConnected;
+    bool ioOpened;
+    bool connectRequested;
+    bool sendFailed;
     bool logTrace;
     bool rawBytesTrace;
 } MQTT_CLIENT;
@@ -101,6 +104,7 @@ static void sendComplete(void* context, IO_SEND_RESULT send_result)
             (void)xio_close(mqttData->xioHandle, NULL, mqttData->ctx);
             mqttData->socketConnected = false;
             mqttData->clientConnected = false;
+            mqttData->ioOpened = false;
         }
     }
 }
@@ -171,12 +175,44 @@ static int sendPacketItem(MQTT_CLIENT* clientData, const int8_t* data, size_t le
         if (result != 0)
         {
             LOG(clientData->logFunc, LOG_LINE, "%d: Failure sending control packet data", result);
+            // The io may only report its error once the bytes already received are read, dowork reports it sooner
+            clientData->sendFailed = true;
             result = __LINE__;
         }
     }
     return result;
 }
 
+static int sendConnectPacket(MQTT_CLIENT* mqttData)
+{
+    int result;
+    mqttData->packetState = CONNECT_TYPE;
+    // Send the Connect packet
+    BUFFER_HANDLE connPacket = mqtt_codec_connect(&mqttData->mqttOptions);
+    if (connPacket == NULL)
+    {
+        /*Codes_SRS_MQTT_CLIENT_07_007: [If any failure is encountered then mqtt_client_connect shall return a non-zero value.]*/
+        LOG(mqttData->logFunc, LOG_LINE, "Error: mqtt_codec_connect failed");
+        result = __LINE__;
+    }
+    else
+    {
+        /*Codes_SRS_MQTT_CLIENT_07_009: [On success mqtt_client_connect shall send the MQTT CONNECT to the endpoint.]*/
+        if (sendPacketItem(mqttData, BUFFER_u_char(connPacket), BUFFER_length(connPacket)) != 0)
+        {
+            /*Codes_SRS_MQTT_CLIENT_07_007: [If any failure is encountered then mqtt_client_connect shall return a non-zero value.]*/
+            LOG(mqttData->logFunc, LOG_LINE, "Error: mqtt_codec_connect failed");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+        BUFFER_delete(connPacket);
+    }
+    return result;
+}
+
 static void onOpenComplete(void* context, IO_OPEN_RESULT open_result)
 {
     MQTT_CLIENT* mqttData = (MQTT_CLIENT*)context;
@@ -184,28 +220,16 @@ static void onOpenComplete(void* context, IO_OPEN_RESULT open_result)
     {
         if (open_result == IO_OPEN_OK && !mqttData->socketConnected)
         {
-            mqttData->packetState = CONNECT_TYPE;
             mqttData->socketConnected = true;
-            // Send the Connect packet
-            BUFFER_HANDLE connPacket = mqtt_codec_connect(&mqttData->mqttOptions);
-            if (connPacket == NULL)
-            {
-                /*Codes_SRS_MQTT_CLIENT_07_007: [If any failure is encountered then mqtt_client_connect shall return a non-zero value.]*/
-                LOG(mqttData->logFunc, LOG_LINE, "Error: mqtt_codec_connect failed");
-            }
-            else
+            // An io opened through mqtt_client_open_io waits for mqtt_client_connect before sending CONNECT
+            if (mqttData->connectRequested)
             {
-                /*Codes_SRS_MQTT_CLIENT_07_009: [On success mqtt_client_connect shall send the MQTT CONNECT to the endpoint.]*/
-                if (sendPacketItem(mqttData, BUFFER_u_char(connPacket), BUFFER_length(connPacket)) != 0)
-                {
-                    /*Codes_SRS_MQTT_CLIENT_07_007: [If any failure is encountered then mqtt_client_connect shall return a non-zero value.]*/
-                    LOG(mqttData->logFunc, LOG_LINE, "Error: mqtt_codec_connect failed");
-                }
-                BUFFER_delete(connPacket);
+                (void)sendConnectPacket(mqttData);
             }
         }
         else if (open_result == IO_OPEN_ERROR)
         {
+            mqttData->ioOpened = false;
             (void)mqttData->fnOperationCallback(mqttData, MQTT_CLIENT_ON_ERROR, NULL, mqttData->ctx);
         }
     }
@@ -218,6 +242,7 @@ static void onBytesReceived(void* context, const unsigned char* buffer, size_t s
     {
         if (mqtt_codec_bytesReceived(mqttData->codec_handle, buffer, size) != 0)
         {
+            mqttData->ioOpened = false;
             if (mqttData->fnOperationCallback)
             {
                 mqttData->fnOperationCallback(mqttData, MQTT_CLIENT_ON_ERROR, NULL, mqttData->ctx);
@@ -231,6 +256,7 @@ static void onIoError(void* context)
     MQTT_CLIENT* mqttData = (MQTT_CLIENT*)context;
     if (mqttData != NULL && mqttData->fnOperationCallback)
     {
+        mqttData->ioOpened = false;
         /*Codes_SRS_MQTT_CLIENT_07_032: [If the actionResult parameter is of type MQTT_CLIENT_ON_DISCONNECT or MQTT_CLIENT_ON_ERROR the the msgInfo value shall be NULL.]*/
         mqttData->fnOperationCallback(mqttData, MQTT_CLIENT_ON_ERROR, NULL, mqttData->ctx);
         mqttData->socketConnected = false;
@@ -492,6 +518,9 @@ MQTT_CLIENT_HANDLE mqtt_client_init(ON_MQTT_MESSAGE_RECV_CALLBACK msgRecv, ON_MQ
             result->mqttOptions.password = NULL;
             result->socketConnected = false;
             result->clientConnected = false;
+            result->ioOpened = false;
+            result->connectRequested = false;
+            result->sendFailed = false;
             result->logTrace = false;
             result->rawBytesTrace = false;
             if (result->packetTickCntr == NULL)
@@ -555,15 +584,30 @@ int mqtt_client_connect(MQTT_CLIENT_HANDLE handle, XIO_HANDLE xioHandle, MQTT_CL
         }
         else
         {
+            bool ioAlreadyOpened = (mqttData->ioOpened && mqttData->xioHandle == xioHandle);
             mqttData->xioHandle = xioHandle;
             mqttData->packetState = UNKNOWN_TYPE;
             mqttData->qosValue = mqttOptions->qualityOfServiceValue;
             mqttData->keepAliveInterval = mqttOptions->keepAliveInterval;
+            mqttData->connectRequested = true;
+            mqttData->sendFailed = false;
             if (cloneMqttOptions(mqttData, mqttOptions) != 0)
             {
                 LOG(mqttData->logFunc, LOG_LINE, "Error: Clone Mqtt Options failed");
                 result = __LINE__;
             }
+            else if (ioAlreadyOpened)
+            {
+                // The io was opened ahead of time, send CONNECT now or as soon as the open completes
+                if (mqttData->socketConnected && sendConnectPacket(mqttData) != 0)
+                {
+                    result = __LINE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
             /*Codes_SRS_MQTT_CLIENT_07_008: [mqtt_client_connect shall open the XIO_HANDLE by calling into the xio_open interface.]*/
             else if (xio_open(xioHandle, onOpenComplete, mqttData, onBytesReceived, mqttData, onIoError, mqttData) != 0)
             {
@@ -580,6 +624,36 @@ int mqtt_client_connect(MQTT_CLIENT_HANDLE handle, XIO_HANDLE xioHandle, MQTT_CL
     return result;
 }
 
+int mqtt_client_open_io(MQTT_CLIENT_HANDLE handle, XIO_HANDLE xioHandle)
+{
+    int result;
+    if (handle == NULL || xioHandle == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        MQTT_CLIENT* mqttData = (MQTT_CLIENT*)handle;
+        mqttData->xioHandle = xioHandle;
+        mqttData->packetState = UNKNOWN_TYPE;
+        mqttData->socketConnected = false;
+        mqttData->clientConnected = false;
+        mqttData->connectRequested = false;
+        mqttData->sendFailed = false;
+        if (xio_open(xioHandle, onOpenComplete, mqttData, onBytesReceived, mqttData, onIoError, mqttData) != 0)
+        {
+            LOG(mqttData->logFunc, LOG_LINE, "Error: io_open failed");
+            result = __LINE__;
+        }
+        else
+        {
+            mqttData->ioOpened = true;
+            result = 0;
+        }
+    }
+    return result;
+}
+
 int mqtt_client_publish(MQTT_CLIENT_HANDLE handle, MQTT_MESSAGE_HANDLE msgHandle)
 {
     int result;
@@ -759,6 +833,16 @@ void mqtt_client_dowork(MQTT_CLIENT_HANDLE handle)
         /*Codes_SRS_MQTT_CLIENT_07_024: [mqtt_client_dowork shall call the xio_dowork function to complete operations.]*/
         xio_dowork(mqttData->xioHandle);
 
+        // A failed send means the connection is gone, unless the io has reported it already or it is being disconnected
+        if (mqttData->sendFailed)
+        {
+            mqttData->sendFailed = false;
+            if (mqttData->socketConnected && mqttData->packetState != DISCONNECT_TYPE)
+            {
+                onIoError(mqttData);
+            }
+        }
+
         /*Codes_SRS_MQTT_CLIENT_07_025: [mqtt_client_dowork shall retrieve the the last packet send value and ...]*/
         if (mqttData->socketConnected && mqttData->clientConnected && mqttData->keepAliveInterval > 0)
         {
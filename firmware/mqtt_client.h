@@ -40,6 +40,8 @@ extern MQTT_CLIENT_HANDLE mqtt_client_init(ON_MQTT_MESSAGE_RECV_CALLBACK msgRecv
 extern void mqtt_client_deinit(MQTT_CLIENT_HANDLE handle);
 
 extern int mqtt_client_connect(MQTT_CLIENT_HANDLE handle, XIO_HANDLE xioHandle, MQTT_CLIENT_OPTIONS* mqttOptions);
+/* Opens the io without sending CONNECT, a later mqtt_client_connect on the same io only has to send the CONNECT packet */
+extern int mqtt_client_open_io(MQTT_CLIENT_HANDLE handle, XIO_HANDLE xioHandle);
 extern int mqtt_client_disconnect(MQTT_CLIENT_HANDLE handle);
 
 extern int mqtt_client_subscribe(MQTT_CLIENT_HANDLE handle, uint16_t packetId, SUBSCRIBE_PAYLOAD* subscribeList, size_t count);
@@ -8,6 +8,7 @@
 #include "macro_utils.h"
 #include "xlogging.h"
 #include "mqtt_codec.h"
+#include "trace_probes.h"
 
 #define PAYLOAD_OFFSET                      5
 #define PACKET_TYPE_BYTE(p)                 ((uint8_t)(((uint8_t)(p)) & 0xf0))
@@ -294,6 +295,7 @@ static BUFFER_HANDLE constructPublishReply(CONTROL_PACKET_TYPE type, int flags,
                 *iterator = 0x2;
                 iterator++;
                 byteutil_writeInt(&iterator, packetId);
+                TRACE_PROBE2(mqtt_encode, type, 4);
             }
         }
     }
@@ -345,6 +347,7 @@ static int constructFixedHeader(BUFFER_HANDLE ctrlPacket, CONTROL_PACKET_TYPE pa
 
             result = BUFFER_prepend(ctrlPacket, fixedHeader);
             BUFFER_delete(fixedHeader);
+            TRACE_PROBE2(mqtt_encode, packetType, BUFFER_length(ctrlPacket));
         }
     }
     return result;
@@ -506,6 +509,7 @@ static void completePacketData(MQTTCODEC_INSTANCE* codecData)
 {
     if (codecData)
     {
+        TRACE_PROBE2(mqtt_decode, codecData->currPacket, codecData->headerFlags);
         if (codecData->packetComplete != NULL)
         {
             codecData->packetComplete(codecData->callContext, codecData->currPacket, codecData->headerFlags, codecData->headerData);
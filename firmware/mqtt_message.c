@@ -16,9 +16,24 @@ typedef struct MQTT_MESSAGE_TAG
 } MQTT_MESSAGE;
 
 MQTT_MESSAGE_HANDLE mqttmessage_create(uint16_t packetId, const char* topicName, QOS_VALUE qosValue, const uint8_t* appMsg, size_t appMsgLength)
+{
+    APP_PAYLOAD part;
+    part.message = (uint8_t*)appMsg;
+    part.length = appMsgLength;
+    return mqttmessage_createFromParts(packetId, topicName, qosValue, &part, 1);
+}
+
+MQTT_MESSAGE_HANDLE mqttmessage_createFromParts(uint16_t packetId, const char* topicName, QOS_VALUE qosValue, const APP_PAYLOAD* parts, size_t partCount)
 {
     /* Codes_SRS_MQTTMESSAGE_07_001:[If the parameters topicName is NULL is zero then mqttmessage_create shall return NULL.] */
     MQTT_MESSAGE* result;
+    size_t appMsgLength = 0;
+    size_t i;
+    for (i = 0; i < partCount; i++)
+    {
+        appMsgLength += parts[i].length;
+    }
+
     if (topicName == NULL)
     {
         result = NULL;
@@ -56,7 +71,16 @@ MQTT_MESSAGE_HANDLE mqttmessage_create(uint16_t packetId, const char* topicName,
                     }
                     else
                     {
-                        memcpy(result->appPayload.message, appMsg, appMsgLength);
+                        /*the parts are gathered into the one payload the codec encodes*/
+                        uint8_t* iterator = result->appPayload.message;
+                        for (i = 0; i < partCount; i++)
+                        {
+                            if (parts[i].length > 0)
+                            {
+                                memcpy(iterator, parts[i].message, parts[i].length);
+                                iterator += parts[i].length;
+                            }
+                        }
                     }
                 }
                 else
@@ -21,6 +21,8 @@ typedef struct SOCKETIO_CONFIG_TAG
     void* accepted_socket;
 } SOCKETIO_CONFIG;
 
+/* option "socket_detach" (value: int*) hands the connected socket to the caller, who then does all reads and writes
+   on it. The socket io keeps ownership and still closes the socket on close. Backends without a real socket fail it. */
 extern CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters, LOGGER_LOG logger_log);
 extern void socketio_destroy(CONCRETE_IO_HANDLE socket_io);
 extern int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context);
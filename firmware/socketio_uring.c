@@ -0,0 +1,1314 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* io_uring is Linux only */
+#if defined(__linux__)
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "socketio.h"
+#include "socketio_uring.h"
+#include "dns_resolver.h"
+#include "lock.h"
+#include "crt_abstractions.h"
+#include "iot_logging.h"
+
+/* submission queue size, the completion queue is twice as large */
+#ifndef SOCKETIO_URING_ENTRIES
+#define SOCKETIO_URING_ENTRIES 1024
+#endif
+
+/* receive buffers shared by all connections, the count must be a power of 2 */
+#ifndef SOCKETIO_URING_RECEIVE_BUFFER_COUNT
+#define SOCKETIO_URING_RECEIVE_BUFFER_COUNT 1024
+#endif
+
+#ifndef SOCKETIO_URING_RECEIVE_BUFFER_SIZE
+#define SOCKETIO_URING_RECEIVE_BUFFER_SIZE 4096
+#endif
+
+#define SOCKETIO_URING_BUFFER_GROUP 0
+
+typedef enum IO_STATE_TAG
+{
+    IO_STATE_NOT_OPEN,
+    IO_STATE_OPENING,
+    IO_STATE_OPEN,
+    IO_STATE_CLOSING,
+    IO_STATE_ERROR
+} IO_STATE;
+
+typedef enum URING_OP_TYPE_TAG
+{
+    URING_OP_CONNECT,
+    URING_OP_RECEIVE,
+    URING_OP_SEND,
+    URING_OP_CANCEL
+} URING_OP_TYPE;
+
+/* every submission carries a pointer to one of these as its user_data */
+typedef struct URING_OP_TAG
+{
+    URING_OP_TYPE type;
+    struct SOCKET_IO_INSTANCE_TAG* socket_io_instance;
+} URING_OP;
+
+typedef struct PENDING_SEND_TAG
+{
+    URING_OP op;
+    unsigned char* bytes;
+    size_t size;
+    size_t sent;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    struct PENDING_SEND_TAG* next;
+} PENDING_SEND;
+
+/* a completion reaped on one thread for an instance that another thread drives */
+typedef struct PARKED_COMPLETION_TAG
+{
+    URING_OP* op;
+    int res;
+    unsigned int flags;
+    struct PARKED_COMPLETION_TAG* next;
+} PARKED_COMPLETION;
+
+typedef struct SOCKET_IO_INSTANCE_TAG
+{
+    int socket;
+    char* hostname;
+    int port;
+    /* set while the name is looked up by the shared resolver, before the connect is queued */
+    DNS_RESOLVER_HANDLE dns_resolver;
+    struct SOCKET_IO_INSTANCE_TAG* next_resolving;
+    struct sockaddr_storage address;
+    socklen_t address_length;
+    ON_BYTES_RECEIVED on_bytes_received;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    ON_IO_CLOSE_COMPLETE on_io_close_complete;
+    ON_IO_ERROR on_io_error;
+    void* on_bytes_received_context;
+    void* on_io_open_complete_context;
+    void* on_io_close_complete_context;
+    void* on_io_error_context;
+    LOGGER_LOG logger_log;
+    IO_STATE io_state;
+    URING_OP connect_op;
+    URING_OP receive_op;
+    URING_OP cancel_op;
+    /* sends go out one at a time per connection so that partial writes cannot reorder the stream */
+    PENDING_SEND* pending_sends_head;
+    PENDING_SEND* pending_sends_tail;
+    bool send_in_flight;
+    /* the instance cannot be freed while the kernel still holds submissions that point to it */
+    size_t outstanding_ops;
+    bool destroy_pending;
+    /* the socket was handed over with the socket_detach option, this instance no longer reads or writes it */
+    bool detached;
+    /* the thread that last called socketio_uring_dowork for this instance, its callbacks are only made there */
+    bool driven;
+    pthread_t driving_thread;
+    PARKED_COMPLETION* parked_head;
+    PARKED_COMPLETION* parked_tail;
+    struct SOCKET_IO_INSTANCE_TAG* next_parked;
+} SOCKET_IO_INSTANCE;
+
+typedef struct URING_TAG
+{
+    int fd;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned int* sq_head;
+    unsigned int* sq_tail;
+    unsigned int* sq_mask;
+    unsigned int* sq_entries;
+    unsigned int* sq_flags;
+    unsigned int* sq_array;
+    unsigned int sq_local_tail;
+    unsigned int to_submit;
+    unsigned int* cq_head;
+    unsigned int* cq_tail;
+    unsigned int* cq_mask;
+    struct io_uring_cqe* cqes;
+    struct io_uring_buf_ring* buffer_ring;
+    unsigned char* buffers;
+    unsigned short buffer_tail;
+    size_t instance_count;
+    SOCKET_IO_INSTANCE* resolving;
+    /* instances with completions waiting for the thread that drives them */
+    SOCKET_IO_INSTANCE* parked;
+    LOCK_HANDLE lock;
+} URING;
+
+static URING* uring = NULL;
+
+/* set while this thread holds the ring lock, so that calls made from a callback do not take it again */
+static __thread bool ring_locked_here = false;
+
+static const IO_INTERFACE_DESCRIPTION socketio_uring_interface_description =
+{
+    socketio_uring_create,
+    socketio_uring_destroy,
+    socketio_uring_open,
+    socketio_uring_close,
+    socketio_uring_send,
+    socketio_uring_dowork,
+    socketio_uring_setoption
+};
+
+/* returns true when the lock was taken by this call and has to be released by unlock_ring */
+static bool lock_ring(void)
+{
+    bool result;
+
+    if (ring_locked_here)
+    {
+        result = false;
+    }
+    else
+    {
+        if (Lock(uring->lock) != LOCK_OK)
+        {
+            LogError("Failed to get the Lock.\r\n");
+        }
+        ring_locked_here = true;
+        result = true;
+    }
+
+    return result;
+}
+
+static void unlock_ring(bool locked)
+{
+    if (locked)
+    {
+        ring_locked_here = false;
+        (void)Unlock(uring->lock);
+    }
+}
+
+static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->on_io_error == NULL)
+    {
+        LogError("NULL on_io_error.\r\n");
+    }
+    else
+    {
+        socket_io_instance->on_io_error(socket_io_instance->on_io_error_context);
+    }
+}
+
+static void indicate_open_complete(SOCKET_IO_INSTANCE* socket_io_instance, IO_OPEN_RESULT open_result)
+{
+    if (socket_io_instance->on_io_open_complete == NULL)
+    {
+        LogError("NULL on_io_open_complete.\r\n");
+    }
+    else
+    {
+        socket_io_instance->on_io_open_complete(socket_io_instance->on_io_open_complete_context, open_result);
+    }
+}
+
+static void uring_submit(void)
+{
+    __atomic_store_n(uring->sq_tail, uring->sq_local_tail, __ATOMIC_RELEASE);
+
+    if ((uring->to_submit > 0) ||
+        ((__atomic_load_n(uring->sq_flags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) != 0))
+    {
+        /* one system call submits everything queued since the last pass, for all connections */
+        int submitted = (int)syscall(__NR_io_uring_enter, uring->fd, uring->to_submit, 0, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (submitted < 0)
+        {
+            if ((errno != EAGAIN) && (errno != EBUSY) && (errno != EINTR))
+            {
+                LogError("io_uring_enter failed, errno=%d.\r\n", errno);
+            }
+        }
+        else
+        {
+            uring->to_submit -= (unsigned int)submitted;
+        }
+    }
+}
+
+static struct io_uring_sqe* uring_get_sqe(URING_OP* op, int fd)
+{
+    struct io_uring_sqe* result;
+
+    if (uring->sq_local_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= *uring->sq_entries)
+    {
+        uring_submit();
+    }
+
+    if (uring->sq_local_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= *uring->sq_entries)
+    {
+        LogError("io_uring submission queue is full.\r\n");
+        result = NULL;
+    }
+    else
+    {
+        unsigned int index = uring->sq_local_tail & *uring->sq_mask;
+
+        result = &uring->sqes[index];
+        (void)memset(result, 0, sizeof(*result));
+        result->fd = fd;
+        result->user_data = (uint64_t)(uintptr_t)op;
+        uring->sq_array[index] = index;
+        uring->sq_local_tail++;
+        uring->to_submit++;
+        op->socket_io_instance->outstanding_ops++;
+    }
+
+    return result;
+}
+
+static void recycle_receive_buffer(unsigned short buffer_id)
+{
+    struct io_uring_buf* buffer = &uring->buffer_ring->bufs[uring->buffer_tail & (SOCKETIO_URING_RECEIVE_BUFFER_COUNT - 1)];
+
+    buffer->addr = (uint64_t)(uintptr_t)(uring->buffers + ((size_t)buffer_id * SOCKETIO_URING_RECEIVE_BUFFER_SIZE));
+    buffer->len = SOCKETIO_URING_RECEIVE_BUFFER_SIZE;
+    buffer->bid = buffer_id;
+    uring->buffer_tail++;
+    __atomic_store_n(&uring->buffer_ring->tail, uring->buffer_tail, __ATOMIC_RELEASE);
+}
+
+static int queue_connect(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    struct io_uring_sqe* sqe = uring_get_sqe(&socket_io_instance->connect_op, socket_io_instance->socket);
+
+    if (sqe == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_CONNECT;
+        sqe->addr = (uint64_t)(uintptr_t)&socket_io_instance->address;
+        sqe->off = socket_io_instance->address_length;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int queue_receive(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    struct io_uring_sqe* sqe = uring_get_sqe(&socket_io_instance->receive_op, socket_io_instance->socket);
+
+    if (sqe == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        /* one multishot receive stays armed for the lifetime of the connection, the kernel picks the buffer */
+        sqe->opcode = IORING_OP_RECV;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = SOCKETIO_URING_BUFFER_GROUP;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int queue_send(PENDING_SEND* pending_send)
+{
+    int result;
+    SOCKET_IO_INSTANCE* socket_io_instance = pending_send->op.socket_io_instance;
+    struct io_uring_sqe* sqe = uring_get_sqe(&pending_send->op, socket_io_instance->socket);
+
+    if (sqe == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->addr = (uint64_t)(uintptr_t)(pending_send->bytes + pending_send->sent);
+        sqe->len = (uint32_t)(pending_send->size - pending_send->sent);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int queue_cancel(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    struct io_uring_sqe* sqe = uring_get_sqe(&socket_io_instance->cancel_op, socket_io_instance->socket);
+
+    if (sqe == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int queue_cancel_receive(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    struct io_uring_sqe* sqe = uring_get_sqe(&socket_io_instance->cancel_op, -1);
+
+    if (sqe == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = (uint64_t)(uintptr_t)&socket_io_instance->receive_op;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void start_next_send(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if ((!socket_io_instance->send_in_flight) &&
+        (socket_io_instance->pending_sends_head != NULL))
+    {
+        if (queue_send(socket_io_instance->pending_sends_head) != 0)
+        {
+            LogError("Failure queueing send.\r\n");
+            socket_io_instance->io_state = IO_STATE_ERROR;
+            indicate_error(socket_io_instance);
+        }
+        else
+        {
+            socket_io_instance->send_in_flight = true;
+        }
+    }
+}
+
+static void complete_pending_send(SOCKET_IO_INSTANCE* socket_io_instance, IO_SEND_RESULT send_result)
+{
+    PENDING_SEND* pending_send = socket_io_instance->pending_sends_head;
+
+    socket_io_instance->pending_sends_head = pending_send->next;
+    if (socket_io_instance->pending_sends_head == NULL)
+    {
+        socket_io_instance->pending_sends_tail = NULL;
+    }
+
+    if (pending_send->on_send_complete != NULL)
+    {
+        pending_send->on_send_complete(pending_send->callback_context, send_result);
+    }
+
+    free(pending_send);
+}
+
+static void free_instance(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    free(socket_io_instance->hostname);
+    free(socket_io_instance);
+    uring->instance_count--;
+}
+
+static void finish_close(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->socket != -1)
+    {
+        (void)close(socket_io_instance->socket);
+        socket_io_instance->socket = -1;
+    }
+
+    socket_io_instance->send_in_flight = false;
+    while (socket_io_instance->pending_sends_head != NULL)
+    {
+        complete_pending_send(socket_io_instance, IO_SEND_CANCELLED);
+    }
+
+    socket_io_instance->io_state = IO_STATE_NOT_OPEN;
+    if ((!socket_io_instance->destroy_pending) &&
+        (socket_io_instance->on_io_close_complete != NULL))
+    {
+        socket_io_instance->on_io_close_complete(socket_io_instance->on_io_close_complete_context);
+    }
+}
+
+/* called last for every completion that ends a submission, the instance may be gone afterwards */
+static void release_op(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    socket_io_instance->outstanding_ops--;
+    if (socket_io_instance->outstanding_ops == 0)
+    {
+        if (socket_io_instance->io_state == IO_STATE_CLOSING)
+        {
+            finish_close(socket_io_instance);
+        }
+
+        if (socket_io_instance->destroy_pending)
+        {
+            free_instance(socket_io_instance);
+        }
+    }
+}
+
+static void on_connect_complete(SOCKET_IO_INSTANCE* socket_io_instance, int res)
+{
+    if (socket_io_instance->io_state == IO_STATE_OPENING)
+    {
+        if (res < 0)
+        {
+            LogError("Failure connecting to %s:%d, errno=%d.\r\n", socket_io_instance->hostname, socket_io_instance->port, -res);
+            (void)close(socket_io_instance->socket);
+            socket_io_instance->socket = -1;
+            socket_io_instance->io_state = IO_STATE_NOT_OPEN;
+            indicate_open_complete(socket_io_instance, IO_OPEN_ERROR);
+        }
+        else if (queue_receive(socket_io_instance) != 0)
+        {
+            LogError("Failure arming receive.\r\n");
+            socket_io_instance->io_state = IO_STATE_ERROR;
+            indicate_open_complete(socket_io_instance, IO_OPEN_ERROR);
+        }
+        else
+        {
+            socket_io_instance->io_state = IO_STATE_OPEN;
+            indicate_open_complete(socket_io_instance, IO_OPEN_OK);
+        }
+    }
+
+    release_op(socket_io_instance);
+}
+
+static void on_receive_complete(SOCKET_IO_INSTANCE* socket_io_instance, int res, unsigned int flags)
+{
+    if ((flags & IORING_CQE_F_BUFFER) != 0)
+    {
+        unsigned short buffer_id = (unsigned short)(flags >> IORING_CQE_BUFFER_SHIFT);
+
+        /* a detached socket belongs to its new owner, whatever the multishot receive still completes is not ours */
+        if ((res > 0) &&
+            (socket_io_instance->io_state == IO_STATE_OPEN) &&
+            (!socket_io_instance->detached))
+        {
+            /* bytes are handed out straight from the shared buffer ring, no copy */
+            socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, uring->buffers + ((size_t)buffer_id * SOCKETIO_URING_RECEIVE_BUFFER_SIZE), (size_t)res);
+        }
+
+        recycle_receive_buffer(buffer_id);
+    }
+
+    if ((flags & IORING_CQE_F_MORE) == 0)
+    {
+        /* the multishot receive ended, rearm it unless the connection is gone or was handed over */
+        if ((socket_io_instance->io_state == IO_STATE_OPEN) &&
+            (!socket_io_instance->detached))
+        {
+            if ((res > 0) || (res == -ENOBUFS))
+            {
+                if (queue_receive(socket_io_instance) != 0)
+                {
+                    LogError("Failure rearming receive.\r\n");
+                    socket_io_instance->io_state = IO_STATE_ERROR;
+                    indicate_error(socket_io_instance);
+                }
+            }
+            else
+            {
+                LogError("Receive ended, res=%d.\r\n", res);
+                socket_io_instance->io_state = IO_STATE_ERROR;
+                indicate_error(socket_io_instance);
+            }
+        }
+
+        release_op(socket_io_instance);
+    }
+}
+
+static void on_send_complete(PENDING_SEND* pending_send, int res)
+{
+    SOCKET_IO_INSTANCE* socket_io_instance = pending_send->op.socket_io_instance;
+
+    if ((res > 0) && (pending_send->sent + (size_t)res < pending_send->size) &&
+        (socket_io_instance->io_state == IO_STATE_OPEN))
+    {
+        pending_send->sent += (size_t)res;
+        if (queue_send(pending_send) != 0)
+        {
+            LogError("Failure queueing the rest of a send.\r\n");
+            socket_io_instance->send_in_flight = false;
+            complete_pending_send(socket_io_instance, IO_SEND_ERROR);
+            socket_io_instance->io_state = IO_STATE_ERROR;
+            indicate_error(socket_io_instance);
+        }
+    }
+    else if (socket_io_instance->io_state == IO_STATE_CLOSING)
+    {
+        /* finish_close cancels it together with the queued ones */
+    }
+    else
+    {
+        socket_io_instance->send_in_flight = false;
+        if (res >= 0)
+        {
+            complete_pending_send(socket_io_instance, IO_SEND_OK);
+            if (socket_io_instance->io_state == IO_STATE_OPEN)
+            {
+                start_next_send(socket_io_instance);
+            }
+        }
+        else
+        {
+            LogError("Send failed, errno=%d.\r\n", -res);
+            complete_pending_send(socket_io_instance, IO_SEND_ERROR);
+            if (socket_io_instance->io_state == IO_STATE_OPEN)
+            {
+                socket_io_instance->io_state = IO_STATE_ERROR;
+                indicate_error(socket_io_instance);
+            }
+        }
+    }
+
+    release_op(socket_io_instance);
+}
+
+static void stop_resolving(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    SOCKET_IO_INSTANCE** current = &uring->resolving;
+
+    while (*current != socket_io_instance)
+    {
+        current = &(*current)->next_resolving;
+    }
+    *current = socket_io_instance->next_resolving;
+
+    dns_resolver_destroy(socket_io_instance->dns_resolver);
+    socket_io_instance->dns_resolver = NULL;
+    socket_io_instance->next_resolving = NULL;
+}
+
+static int start_connect(SOCKET_IO_INSTANCE* socket_io_instance, const struct addrinfo* address_info)
+{
+    int result;
+
+    (void)memcpy(&socket_io_instance->address, address_info->ai_addr, address_info->ai_addrlen);
+    socket_io_instance->address_length = address_info->ai_addrlen;
+
+    socket_io_instance->socket = socket(address_info->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socket_io_instance->socket == -1)
+    {
+        result = __LINE__;
+        LogError("Failure creating the socket, errno=%d.\r\n", errno);
+    }
+    else if (queue_connect(socket_io_instance) != 0)
+    {
+        result = __LINE__;
+        LogError("Failure queueing connect.\r\n");
+        (void)close(socket_io_instance->socket);
+        socket_io_instance->socket = -1;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* connects the instances whose lookups finished since the last pass */
+static void check_resolving(void)
+{
+    SOCKET_IO_INSTANCE* socket_io_instance = uring->resolving;
+
+    while (socket_io_instance != NULL)
+    {
+        SOCKET_IO_INSTANCE* next_resolving = socket_io_instance->next_resolving;
+
+        if (dns_resolver_is_lookup_complete(socket_io_instance->dns_resolver))
+        {
+            const struct addrinfo* address_info = dns_resolver_get_addrinfo(socket_io_instance->dns_resolver);
+            int connect_result = (address_info == NULL) ? __LINE__ : start_connect(socket_io_instance, address_info);
+
+            stop_resolving(socket_io_instance);
+            if (connect_result != 0)
+            {
+                LogError("Failure connecting to %s.\r\n", socket_io_instance->hostname);
+                socket_io_instance->io_state = IO_STATE_NOT_OPEN;
+                indicate_open_complete(socket_io_instance, IO_OPEN_ERROR);
+            }
+        }
+
+        socket_io_instance = next_resolving;
+    }
+}
+
+static void dispatch_completion(URING_OP* op, int res, unsigned int flags)
+{
+    switch (op->type)
+    {
+    default:
+    case URING_OP_CANCEL:
+        release_op(op->socket_io_instance);
+        break;
+
+    case URING_OP_CONNECT:
+        on_connect_complete(op->socket_io_instance, res);
+        break;
+
+    case URING_OP_RECEIVE:
+        on_receive_complete(op->socket_io_instance, res, flags);
+        break;
+
+    case URING_OP_SEND:
+        on_send_complete((PENDING_SEND*)op, res);
+        break;
+    }
+}
+
+/* once destroy was called there is nobody left to call back, any thread may finish the instance */
+static bool is_driven_elsewhere(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    return (socket_io_instance->driven) &&
+        (!socket_io_instance->destroy_pending) &&
+        (!pthread_equal(socket_io_instance->driving_thread, pthread_self()));
+}
+
+/* hands out the completions parked for the instance in the order they were reaped, the last one may free it */
+static void dispatch_parked(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->parked_head != NULL)
+    {
+        SOCKET_IO_INSTANCE** current = &uring->parked;
+        PARKED_COMPLETION* parked = socket_io_instance->parked_head;
+
+        while (*current != socket_io_instance)
+        {
+            current = &(*current)->next_parked;
+        }
+        *current = socket_io_instance->next_parked;
+        socket_io_instance->next_parked = NULL;
+        socket_io_instance->parked_head = NULL;
+        socket_io_instance->parked_tail = NULL;
+
+        while (parked != NULL)
+        {
+            PARKED_COMPLETION* next = parked->next;
+            dispatch_completion(parked->op, parked->res, parked->flags);
+            free(parked);
+            parked = next;
+        }
+    }
+}
+
+static void park_completion(URING_OP* op, int res, unsigned int flags)
+{
+    SOCKET_IO_INSTANCE* socket_io_instance = op->socket_io_instance;
+    PARKED_COMPLETION* parked = (PARKED_COMPLETION*)malloc(sizeof(PARKED_COMPLETION));
+
+    if (parked == NULL)
+    {
+        LogError("Failure parking a completion, it is handed out on this thread.\r\n");
+        dispatch_parked(socket_io_instance);
+        dispatch_completion(op, res, flags);
+    }
+    else
+    {
+        parked->op = op;
+        parked->res = res;
+        parked->flags = flags;
+        parked->next = NULL;
+
+        if (socket_io_instance->parked_tail == NULL)
+        {
+            socket_io_instance->parked_head = parked;
+            socket_io_instance->next_parked = uring->parked;
+            uring->parked = socket_io_instance;
+        }
+        else
+        {
+            socket_io_instance->parked_tail->next = parked;
+        }
+        socket_io_instance->parked_tail = parked;
+    }
+}
+
+/* hands out what other threads parked for the instances this thread drives */
+static void dispatch_parked_for_this_thread(void)
+{
+    SOCKET_IO_INSTANCE* socket_io_instance = uring->parked;
+
+    while (socket_io_instance != NULL)
+    {
+        SOCKET_IO_INSTANCE* next_parked = socket_io_instance->next_parked;
+
+        if (!is_driven_elsewhere(socket_io_instance))
+        {
+            dispatch_parked(socket_io_instance);
+        }
+
+        socket_io_instance = next_parked;
+    }
+}
+
+int socketio_uring_init(void)
+{
+    int result;
+
+    if (uring != NULL)
+    {
+        result = __LINE__;
+        LogError("socketio_uring is already initialized.\r\n");
+    }
+    else if (dns_resolver_init() != 0)
+    {
+        result = __LINE__;
+        LogError("Failure initializing the DNS resolver.\r\n");
+    }
+    else if ((uring = (URING*)malloc(sizeof(URING))) == NULL)
+    {
+        result = __LINE__;
+        LogError("Failure allocating the uring.\r\n");
+        dns_resolver_deinit();
+    }
+    else
+    {
+        struct io_uring_params params;
+
+        (void)memset(uring, 0, sizeof(URING));
+        (void)memset(&params, 0, sizeof(params));
+        uring->sq_ring = MAP_FAILED;
+        uring->cq_ring = MAP_FAILED;
+        uring->sqes = MAP_FAILED;
+
+        uring->fd = (int)syscall(__NR_io_uring_setup, SOCKETIO_URING_ENTRIES, &params);
+        if ((uring->lock = Lock_Init()) == NULL)
+        {
+            result = __LINE__;
+            LogError("Failed creating the ring lock.\r\n");
+        }
+        else if (uring->fd < 0)
+        {
+            result = __LINE__;
+            LogError("io_uring_setup failed, errno=%d.\r\n", errno);
+        }
+        else
+        {
+            uring->sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+            uring->cq_ring_size = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+            uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+            if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+            {
+                if (uring->cq_ring_size > uring->sq_ring_size)
+                {
+                    uring->sq_ring_size = uring->cq_ring_size;
+                }
+                uring->cq_ring_size = uring->sq_ring_size;
+            }
+
+            uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+            if ((uring->sq_ring != MAP_FAILED) && ((params.features & IORING_FEAT_SINGLE_MMAP) != 0))
+            {
+                uring->cq_ring = uring->sq_ring;
+            }
+            else if (uring->sq_ring != MAP_FAILED)
+            {
+                uring->cq_ring = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+            }
+            uring->sqes = (struct io_uring_sqe*)mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+
+            if ((uring->sq_ring == MAP_FAILED) ||
+                (uring->cq_ring == MAP_FAILED) ||
+                (uring->sqes == MAP_FAILED))
+            {
+                result = __LINE__;
+                LogError("Failure mapping the io_uring rings, errno=%d.\r\n", errno);
+            }
+            else
+            {
+                struct io_uring_buf_reg buffer_registration;
+                unsigned char* sq_ring = (unsigned char*)uring->sq_ring;
+                unsigned char* cq_ring = (unsigned char*)uring->cq_ring;
+
+                uring->sq_head = (unsigned int*)(sq_ring + params.sq_off.head);
+                uring->sq_tail = (unsigned int*)(sq_ring + params.sq_off.tail);
+                uring->sq_mask = (unsigned int*)(sq_ring + params.sq_off.ring_mask);
+                uring->sq_entries = (unsigned int*)(sq_ring + params.sq_off.ring_entries);
+                uring->sq_flags = (unsigned int*)(sq_ring + params.sq_off.flags);
+                uring->sq_array = (unsigned int*)(sq_ring + params.sq_off.array);
+                uring->sq_local_tail = *uring->sq_tail;
+                uring->cq_head = (unsigned int*)(cq_ring + params.cq_off.head);
+                uring->cq_tail = (unsigned int*)(cq_ring + params.cq_off.tail);
+                uring->cq_mask = (unsigned int*)(cq_ring + params.cq_off.ring_mask);
+                uring->cqes = (struct io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+
+                /* the buffer ring is shared with the kernel and has to be page aligned */
+                if (posix_memalign((void**)&uring->buffer_ring, (size_t)sysconf(_SC_PAGESIZE), SOCKETIO_URING_RECEIVE_BUFFER_COUNT * sizeof(struct io_uring_buf)) != 0)
+                {
+                    uring->buffer_ring = NULL;
+                    result = __LINE__;
+                    LogError("Failure allocating the receive buffer ring.\r\n");
+                }
+                else if ((uring->buffers = (unsigned char*)malloc((size_t)SOCKETIO_URING_RECEIVE_BUFFER_COUNT * SOCKETIO_URING_RECEIVE_BUFFER_SIZE)) == NULL)
+                {
+                    result = __LINE__;
+                    LogError("Failure allocating the receive buffers.\r\n");
+                }
+                else
+                {
+                    (void)memset(uring->buffer_ring, 0, SOCKETIO_URING_RECEIVE_BUFFER_COUNT * sizeof(struct io_uring_buf));
+                    (void)memset(&buffer_registration, 0, sizeof(buffer_registration));
+                    buffer_registration.ring_addr = (uint64_t)(uintptr_t)uring->buffer_ring;
+                    buffer_registration.ring_entries = SOCKETIO_URING_RECEIVE_BUFFER_COUNT;
+                    buffer_registration.bgid = SOCKETIO_URING_BUFFER_GROUP;
+
+                    if (syscall(__NR_io_uring_register, uring->fd, IORING_REGISTER_PBUF_RING, &buffer_registration, 1) != 0)
+                    {
+                        result = __LINE__;
+                        LogError("Failure registering the receive buffer ring, errno=%d.\r\n", errno);
+                    }
+                    else
+                    {
+                        unsigned short i;
+
+                        for (i = 0; i < SOCKETIO_URING_RECEIVE_BUFFER_COUNT; i++)
+                        {
+                            recycle_receive_buffer(i);
+                        }
+
+                        result = 0;
+                    }
+                }
+            }
+        }
+
+        if (result != 0)
+        {
+            socketio_uring_deinit();
+        }
+    }
+
+    return result;
+}
+
+void socketio_uring_deinit(void)
+{
+    if (uring != NULL)
+    {
+        if (uring->instance_count > 0)
+        {
+            LogError("socketio_uring deinitialized with %u instances still alive.\r\n", (unsigned int)uring->instance_count);
+        }
+
+        if (uring->sqes != MAP_FAILED)
+        {
+            (void)munmap(uring->sqes, uring->sqes_size);
+        }
+        if ((uring->cq_ring != MAP_FAILED) && (uring->cq_ring != uring->sq_ring))
+        {
+            (void)munmap(uring->cq_ring, uring->cq_ring_size);
+        }
+        if (uring->sq_ring != MAP_FAILED)
+        {
+            (void)munmap(uring->sq_ring, uring->sq_ring_size);
+        }
+        if (uring->fd >= 0)
+        {
+            /* closing the ring also drops the buffer ring registration */
+            (void)close(uring->fd);
+        }
+
+        if (uring->lock != NULL)
+        {
+            (void)Lock_Deinit(uring->lock);
+        }
+
+        free(uring->buffers);
+        free(uring->buffer_ring);
+        free(uring);
+        uring = NULL;
+        dns_resolver_deinit();
+    }
+}
+
+void socketio_uring_dowork_all(void)
+{
+    /* a callback that drives the ring again would only find what is being reaped already */
+    if ((uring != NULL) && (!ring_locked_here))
+    {
+        unsigned int head;
+        bool locked = lock_ring();
+
+        check_resolving();
+        uring_submit();
+        dispatch_parked_for_this_thread();
+
+        /* the completion queue lives in shared memory, reaping it needs no system call */
+        while ((head = *uring->cq_head) != __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE))
+        {
+            struct io_uring_cqe cqe = uring->cqes[head & *uring->cq_mask];
+            URING_OP* op = (URING_OP*)(uintptr_t)cqe.user_data;
+
+            __atomic_store_n(uring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+            /* callbacks are only made on the thread that drives the instance, whatever client lock it holds */
+            if (is_driven_elsewhere(op->socket_io_instance))
+            {
+                park_completion(op, cqe.res, cqe.flags);
+            }
+            else
+            {
+                dispatch_parked(op->socket_io_instance);
+                dispatch_completion(op, cqe.res, cqe.flags);
+            }
+        }
+
+        /* submit what the callbacks queued without waiting for the next pass */
+        uring_submit();
+        unlock_ring(locked);
+    }
+}
+
+CONCRETE_IO_HANDLE socketio_uring_create(void* io_create_parameters, LOGGER_LOG logger_log)
+{
+    SOCKETIO_CONFIG* socket_io_config = (SOCKETIO_CONFIG*)io_create_parameters;
+    SOCKET_IO_INSTANCE* result;
+
+    if ((socket_io_config == NULL) || (socket_io_config->hostname == NULL))
+    {
+        result = NULL;
+        LogError("Invalid argument: socket_io_config is NULL or has no hostname.\r\n");
+    }
+    else if (uring == NULL)
+    {
+        result = NULL;
+        LogError("socketio_uring_init was not called.\r\n");
+    }
+    else
+    {
+        result = (SOCKET_IO_INSTANCE*)malloc(sizeof(SOCKET_IO_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Failure allocating the socket io instance.\r\n");
+        }
+        else
+        {
+            (void)memset(result, 0, sizeof(SOCKET_IO_INSTANCE));
+            if (mallocAndStrcpy_s(&result->hostname, socket_io_config->hostname) != 0)
+            {
+                LogError("Failure copying the hostname.\r\n");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->socket = -1;
+                result->port = socket_io_config->port;
+                result->logger_log = logger_log;
+                result->io_state = IO_STATE_NOT_OPEN;
+                result->connect_op.type = URING_OP_CONNECT;
+                result->connect_op.socket_io_instance = result;
+                result->receive_op.type = URING_OP_RECEIVE;
+                result->receive_op.socket_io_instance = result;
+                result->cancel_op.type = URING_OP_CANCEL;
+                result->cancel_op.socket_io_instance = result;
+
+                bool locked = lock_ring();
+                uring->instance_count++;
+                unlock_ring(locked);
+            }
+        }
+    }
+
+    return result;
+}
+
+void socketio_uring_destroy(CONCRETE_IO_HANDLE socket_io)
+{
+    if (socket_io != NULL)
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        bool locked = lock_ring();
+
+        socket_io_instance->destroy_pending = true;
+        if ((socket_io_instance->io_state != IO_STATE_NOT_OPEN) &&
+            (socket_io_instance->io_state != IO_STATE_CLOSING))
+        {
+            (void)socketio_uring_close(socket_io, NULL, NULL);
+        }
+
+        /* otherwise the last completion frees it, which may be one parked for the thread that drove it */
+        if (socket_io_instance->outstanding_ops == 0)
+        {
+            free_instance(socket_io_instance);
+        }
+        else
+        {
+            dispatch_parked(socket_io_instance);
+        }
+
+        unlock_ring(locked);
+    }
+}
+
+int socketio_uring_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if ((socket_io == NULL) || (on_bytes_received == NULL))
+    {
+        result = __LINE__;
+        LogError("Invalid argument: socket_io or on_bytes_received is NULL.\r\n");
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        bool locked = lock_ring();
+
+        if (socket_io_instance->io_state != IO_STATE_NOT_OPEN)
+        {
+            result = __LINE__;
+            LogError("Invalid io_state. Expected state is IO_STATE_NOT_OPEN.\r\n");
+        }
+        else if ((socket_io_instance->dns_resolver = dns_resolver_create(socket_io_instance->hostname, socket_io_instance->port)) == NULL)
+        {
+            result = __LINE__;
+            LogError("Failure starting the lookup of %s.\r\n", socket_io_instance->hostname);
+        }
+        else
+        {
+            socket_io_instance->on_bytes_received = on_bytes_received;
+            socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+            socket_io_instance->on_io_open_complete = on_io_open_complete;
+            socket_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+            socket_io_instance->on_io_error = on_io_error;
+            socket_io_instance->on_io_error_context = on_io_error_context;
+
+            /* the connect is queued by socketio_uring_dowork_all once the name is resolved, usually from the cache */
+            socket_io_instance->next_resolving = uring->resolving;
+            uring->resolving = socket_io_instance;
+            socket_io_instance->io_state = IO_STATE_OPENING;
+            result = 0;
+        }
+
+        unlock_ring(locked);
+    }
+
+    return result;
+}
+
+int socketio_uring_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+
+    if (socket_io == NULL)
+    {
+        result = __LINE__;
+        LogError("NULL socket_io.\r\n");
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        bool locked = lock_ring();
+
+        if ((socket_io_instance->io_state == IO_STATE_NOT_OPEN) ||
+            (socket_io_instance->io_state == IO_STATE_CLOSING))
+        {
+            result = __LINE__;
+            LogError("Invalid io_state. The socket io is not open.\r\n");
+        }
+        else
+        {
+            socket_io_instance->io_state = IO_STATE_CLOSING;
+            socket_io_instance->on_io_close_complete = on_io_close_complete;
+            socket_io_instance->on_io_close_complete_context = callback_context;
+
+            if (socket_io_instance->dns_resolver != NULL)
+            {
+                stop_resolving(socket_io_instance);
+            }
+
+            if (socket_io_instance->outstanding_ops == 0)
+            {
+                finish_close(socket_io_instance);
+            }
+            else if (queue_cancel(socket_io_instance) != 0)
+            {
+                /* the pending operations still fail once the socket is shut down */
+                (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
+            }
+
+            result = 0;
+        }
+
+        unlock_ring(locked);
+    }
+
+    return result;
+}
+
+int socketio_uring_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        result = __LINE__;
+        LogError("Invalid argument: socket_io or buffer is NULL, or size is 0.\r\n");
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        bool locked = lock_ring();
+
+        if ((socket_io_instance->io_state != IO_STATE_OPEN) ||
+            (socket_io_instance->detached))
+        {
+            result = __LINE__;
+            LogError("Invalid io_state. Expected state is IO_STATE_OPEN.\r\n");
+        }
+        else
+        {
+            /* the bytes are kept with the send until its completion, one allocation for both */
+            PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + size);
+            if (pending_send == NULL)
+            {
+                result = __LINE__;
+                LogError("Failure allocating the pending send.\r\n");
+            }
+            else
+            {
+                pending_send->op.type = URING_OP_SEND;
+                pending_send->op.socket_io_instance = socket_io_instance;
+                pending_send->bytes = (unsigned char*)(pending_send + 1);
+                pending_send->size = size;
+                pending_send->sent = 0;
+                pending_send->on_send_complete = on_send_complete;
+                pending_send->callback_context = callback_context;
+                pending_send->next = NULL;
+                (void)memcpy(pending_send->bytes, buffer, size);
+
+                if (socket_io_instance->pending_sends_tail == NULL)
+                {
+                    socket_io_instance->pending_sends_head = pending_send;
+                }
+                else
+                {
+                    socket_io_instance->pending_sends_tail->next = pending_send;
+                }
+                socket_io_instance->pending_sends_tail = pending_send;
+
+                /* queued only, the submission goes out with everybody else's in socketio_uring_dowork_all */
+                start_next_send(socket_io_instance);
+                result = 0;
+            }
+        }
+
+        unlock_ring(locked);
+    }
+
+    return result;
+}
+
+void socketio_uring_dowork(CONCRETE_IO_HANDLE socket_io)
+{
+    if (socket_io == NULL)
+    {
+        LogError("NULL socket_io.\r\n");
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        bool locked = lock_ring();
+
+        socket_io_instance->driven = true;
+        socket_io_instance->driving_thread = pthread_self();
+        unlock_ring(locked);
+
+        /* every connection shares the ring, so any instance drives all of them */
+        socketio_uring_dowork_all();
+    }
+}
+
+int socketio_uring_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (optionName == NULL) ||
+        (value == NULL))
+    {
+        result = __LINE__;
+        LogError("Invalid argument: socket_io, optionName or value is NULL.\r\n");
+    }
+    else if (strcmp(optionName, "socket_detach") == 0)
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        bool locked = lock_ring();
+
+        if ((socket_io_instance->io_state != IO_STATE_OPEN) ||
+            (socket_io_instance->detached) ||
+            (socket_io_instance->pending_sends_head != NULL))
+        {
+            result = __LINE__;
+            LogError("The socket can only be detached from an open socket io with no pending sends.\r\n");
+        }
+        else if (queue_cancel_receive(socket_io_instance) != 0)
+        {
+            result = __LINE__;
+            LogError("Failure cancelling the receive.\r\n");
+        }
+        else
+        {
+            /* submit the cancel now so the armed receive cannot take bytes meant for the new owner */
+            uring_submit();
+            socket_io_instance->detached = true;
+            *(int*)value = socket_io_instance->socket;
+            result = 0;
+        }
+
+        unlock_ring(locked);
+    }
+    else
+    {
+        result = __LINE__;
+        LogError("Unknown option %s.\r\n", optionName);
+    }
+
+    return result;
+}
+
+const IO_INTERFACE_DESCRIPTION* socketio_uring_get_interface_description(void)
+{
+    return &socketio_uring_interface_description;
+}
+
+#endif /* defined(__linux__) */
@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SOCKETIO_URING_H
+#define SOCKETIO_URING_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "xio.h"
+#include "xlogging.h"
+
+/* Linux io_uring socketio. All instances share one ring: sends are queued and submitted together, receives use
+   multishot recv into a ring of provided buffers and completions for every connection are reaped in one pass.
+   socketio_uring_create takes a SOCKETIO_CONFIG (socketio.h).
+
+   Threading: socketio_uring_init and socketio_uring_deinit must not run concurrently with anything else. Every
+   other call may be made from any thread, the ring is guarded by one lock. The callbacks of an instance that is
+   driven through socketio_uring_dowork are only made on the thread that last called it for that instance, so a
+   client worker thread never runs the callbacks of another client. The completions it reaps for other instances
+   are kept until their own thread drives the ring. Callbacks of instances only driven through
+   socketio_uring_dowork_all are made on whichever thread calls it. Callbacks run with the ring lock held and may
+   call back into socketio_uring. */
+
+extern int socketio_uring_init(void);
+extern void socketio_uring_deinit(void);
+extern void socketio_uring_dowork_all(void);
+
+extern CONCRETE_IO_HANDLE socketio_uring_create(void* io_create_parameters, LOGGER_LOG logger_log);
+extern void socketio_uring_destroy(CONCRETE_IO_HANDLE socket_io);
+extern int socketio_uring_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context);
+extern int socketio_uring_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context);
+extern int socketio_uring_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context);
+extern void socketio_uring_dowork(CONCRETE_IO_HANDLE socket_io);
+extern int socketio_uring_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value);
+
+extern const IO_INTERFACE_DESCRIPTION* socketio_uring_get_interface_description(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SOCKETIO_URING_H */
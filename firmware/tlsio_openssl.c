@@ -11,11 +11,19 @@
 #include <crypto.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
 #include "tlsio.h"
 #include "tlsio_openssl.h"
 #include "socketio.h"
 #include "xlogging.h"
 
+/* OpenSSL 1.1 and later can have custom BIOs, which lets OpenSSL read straight out of the buffers the underlying IO
+   delivers and write straight into xio_send instead of copying through a memory BIO pair */
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+#define USE_XIO_BIO
+#endif
+
 typedef enum TLSIO_STATE_TAG
 {
     TLSIO_STATE_NOT_OPEN,
@@ -43,8 +51,45 @@ typedef struct TLS_IO_INSTANCE_TAG
     BIO* in_bio;
     BIO* out_bio;
     TLSIO_STATE tlsio_state;
+    /* xio BIO mode: in_bio and out_bio are NULL and OpenSSL reads and writes through the underlying IO */
+    bool use_xio_bio;
+    const unsigned char* received_bytes;
+    size_t received_size;
+    unsigned char* leftover_bytes;
+    size_t leftover_size;
+    struct TLS_SEND_CONTEXT_TAG* send_context;
+    bool ktls_requested;
+    /* socket taken over from the underlying IO in kTLS mode, -1 when the memory BIOs are used */
+    int socket;
+    /* kTLS mode: sends the socket could not take yet, in order */
+    struct PENDING_SEND_TAG* pending_sends_head;
+    struct PENDING_SEND_TAG* pending_sends_tail;
 } TLS_IO_INSTANCE;
 
+/* one tlsio send can turn into several records, the caller is told when the last of them is sent */
+typedef struct TLS_SEND_CONTEXT_TAG
+{
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    size_t pending_sends;
+    bool is_written;
+    IO_SEND_RESULT send_result;
+} TLS_SEND_CONTEXT;
+
+/* kTLS mode: a send that is finished from tlsio_openssl_dowork once the socket has room for it */
+typedef struct PENDING_SEND_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    struct PENDING_SEND_TAG* next;
+} PENDING_SEND;
+
+#ifdef USE_XIO_BIO
+static BIO_METHOD* xio_bio_method = NULL;
+#endif
+
 static const IO_INTERFACE_DESCRIPTION tlsio_openssl_interface_description =
 {
     tlsio_openssl_create,
@@ -85,7 +130,8 @@ static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLE
 {
     int result;
 
-    int pending = BIO_ctrl_pending(tls_io_instance->out_bio);
+    /* without an out BIO the records already went out through the xio BIO */
+    int pending = (tls_io_instance->out_bio == NULL) ? 0 : BIO_ctrl_pending(tls_io_instance->out_bio);
     if (pending <= 0)
     {
         result = 0;
@@ -169,6 +215,369 @@ static int send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
     return result;
 }
 
+static void complete_send_context(TLS_SEND_CONTEXT* send_context)
+{
+    if (send_context->on_send_complete != NULL)
+    {
+        send_context->on_send_complete(send_context->callback_context, send_context->send_result);
+    }
+
+    free(send_context);
+}
+
+static void on_record_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    TLS_SEND_CONTEXT* send_context = (TLS_SEND_CONTEXT*)context;
+
+    if (send_result != IO_SEND_OK)
+    {
+        send_context->send_result = send_result;
+    }
+
+    send_context->pending_sends--;
+    if ((send_context->pending_sends == 0) &&
+        (send_context->is_written))
+    {
+        complete_send_context(send_context);
+    }
+}
+
+#ifdef USE_XIO_BIO
+static int xio_bio_write(BIO* bio, const char* buffer, int size)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)BIO_get_data(bio);
+    TLS_SEND_CONTEXT* send_context = tls_io_instance->send_context;
+    int result;
+
+    BIO_clear_retry_flags(bio);
+
+    /* counted before the send, the underlying IO may complete it right away */
+    if (send_context != NULL)
+    {
+        send_context->pending_sends++;
+    }
+
+    if (xio_send(tls_io_instance->underlying_io, buffer, size, (send_context == NULL) ? NULL : on_record_send_complete, send_context) != 0)
+    {
+        if (send_context != NULL)
+        {
+            send_context->pending_sends--;
+        }
+
+        result = -1;
+        LogError("Error in xio_send.\r\n");
+    }
+    else
+    {
+        result = size;
+    }
+
+    return result;
+}
+
+static int xio_bio_read(BIO* bio, char* buffer, int size)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)BIO_get_data(bio);
+    int result;
+
+    BIO_clear_retry_flags(bio);
+
+    if (tls_io_instance->leftover_size > 0)
+    {
+        result = (tls_io_instance->leftover_size < (size_t)size) ? (int)tls_io_instance->leftover_size : size;
+        (void)memcpy(buffer, tls_io_instance->leftover_bytes, result);
+        tls_io_instance->leftover_size -= result;
+        (void)memmove(tls_io_instance->leftover_bytes, tls_io_instance->leftover_bytes + result, tls_io_instance->leftover_size);
+    }
+    else if (tls_io_instance->received_size > 0)
+    {
+        /* the only copy on the way in, straight into the OpenSSL record buffer */
+        result = (tls_io_instance->received_size < (size_t)size) ? (int)tls_io_instance->received_size : size;
+        (void)memcpy(buffer, tls_io_instance->received_bytes, result);
+        tls_io_instance->received_bytes += result;
+        tls_io_instance->received_size -= result;
+    }
+    else
+    {
+        BIO_set_retry_read(bio);
+        result = -1;
+    }
+
+    return result;
+}
+
+static long xio_bio_ctrl(BIO* bio, int cmd, long num, void* ptr)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)BIO_get_data(bio);
+    long result;
+
+    (void)num;
+    (void)ptr;
+
+    switch (cmd)
+    {
+    case BIO_CTRL_FLUSH:
+        result = 1;
+        break;
+
+    case BIO_CTRL_PENDING:
+        result = (long)(tls_io_instance->leftover_size + tls_io_instance->received_size);
+        break;
+
+    default:
+        result = 0;
+        break;
+    }
+
+    return result;
+}
+
+static int xio_bio_create(BIO* bio)
+{
+    BIO_set_init(bio, 1);
+    return 1;
+}
+
+static int xio_bio_destroy(BIO* bio)
+{
+    /* the data is the owning TLS_IO_INSTANCE */
+    BIO_set_data(bio, NULL);
+    return 1;
+}
+#endif
+
+/* bytes OpenSSL has not asked for yet outlive the underlying IO buffer, so they are kept */
+static int keep_leftover_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if (tls_io_instance->received_size == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        unsigned char* leftover_bytes = (unsigned char*)realloc(tls_io_instance->leftover_bytes, tls_io_instance->leftover_size + tls_io_instance->received_size);
+        if (leftover_bytes == NULL)
+        {
+            result = __LINE__;
+            LogError("Failed allocating leftover bytes.\r\n");
+        }
+        else
+        {
+            (void)memcpy(leftover_bytes + tls_io_instance->leftover_size, tls_io_instance->received_bytes, tls_io_instance->received_size);
+            tls_io_instance->leftover_bytes = leftover_bytes;
+            tls_io_instance->leftover_size += tls_io_instance->received_size;
+            result = 0;
+        }
+    }
+
+    tls_io_instance->received_bytes = NULL;
+    tls_io_instance->received_size = 0;
+
+    return result;
+}
+
+/* kTLS mode: OpenSSL only hands record encryption to the kernel when it talks to the socket itself, so the
+   socket is detached from the underlying IO and wrapped in a socket BIO before the handshake starts */
+static int use_socket_bio(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+    int socket;
+
+    if (xio_setoption(tls_io_instance->underlying_io, "socket_detach", &socket) != 0)
+    {
+        result = __LINE__;
+        LogInfo("kTLS requested, but the underlying IO has no socket to hand over. Using memory BIOs.\r\n");
+    }
+    else
+    {
+        int flags = fcntl(socket, F_GETFL, 0);
+        BIO* socket_bio;
+
+        if ((flags == -1) ||
+            (fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1))
+        {
+            result = __LINE__;
+            LogError("Failure making the socket non-blocking.\r\n");
+        }
+        else if ((socket_bio = BIO_new_socket(socket, BIO_NOCLOSE)) == NULL)
+        {
+            result = __LINE__;
+            LogError("Failed BIO_new_socket.\r\n");
+        }
+        else
+        {
+#ifdef SSL_OP_ENABLE_KTLS
+            (void)SSL_set_options(tls_io_instance->ssl, SSL_OP_ENABLE_KTLS);
+#endif
+            /* a write the socket refused is retried out of the pending send's copy of the bytes */
+            (void)SSL_set_mode(tls_io_instance->ssl, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+            /* SSL_set_bio frees the memory BIOs */
+            SSL_set_bio(tls_io_instance->ssl, socket_bio, socket_bio);
+            tls_io_instance->in_bio = NULL;
+            tls_io_instance->out_bio = NULL;
+            tls_io_instance->use_xio_bio = false;
+            tls_io_instance->socket = socket;
+            result = 0;
+        }
+
+        if (result != 0)
+        {
+            /* the socket is already detached, there is no going back to the memory BIOs */
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+static int do_socket_handshake(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+    int ret = SSL_do_handshake(tls_io_instance->ssl);
+
+    if (ret == 1)
+    {
+        LogInfo("TLS handshake done, kernel TLS send: %s, receive: %s.\r\n",
+            BIO_get_ktls_send(SSL_get_wbio(tls_io_instance->ssl)) ? "on" : "off",
+            BIO_get_ktls_recv(SSL_get_rbio(tls_io_instance->ssl)) ? "on" : "off");
+        tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
+        indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+        result = 0;
+    }
+    else
+    {
+        int ssl_error = SSL_get_error(tls_io_instance->ssl, ret);
+        if ((ssl_error == SSL_ERROR_WANT_READ) ||
+            (ssl_error == SSL_ERROR_WANT_WRITE))
+        {
+            result = 0;
+        }
+        else
+        {
+            result = __LINE__;
+            LogError("SSL_do_handshake failed, error %d.\r\n", ssl_error);
+        }
+    }
+
+    return result;
+}
+
+static int read_socket_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+    unsigned char buffer[1024];
+    int rcv_bytes;
+
+    while ((rcv_bytes = SSL_read(tls_io_instance->ssl, buffer, sizeof(buffer))) > 0)
+    {
+        if (tls_io_instance->on_bytes_received == NULL)
+        {
+            LogError("NULL on_bytes_received.\r\n");
+        }
+        else
+        {
+            tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
+        }
+    }
+
+    switch (SSL_get_error(tls_io_instance->ssl, rcv_bytes))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        result = 0;
+        break;
+
+    default:
+        result = __LINE__;
+        LogError("SSL_read failed or the connection was closed.\r\n");
+        break;
+    }
+
+    return result;
+}
+
+/* the kernel encrypts (or OpenSSL does on the socket when kTLS is not available). *is_written is false when the
+   socket buffer is full, the same bytes have to be written again later */
+static int write_socket_bytes(TLS_IO_INSTANCE* tls_io_instance, const void* buffer, size_t size, bool* is_written)
+{
+    int result;
+    int res = SSL_write(tls_io_instance->ssl, buffer, (int)size);
+
+    if (res == (int)size)
+    {
+        *is_written = true;
+        result = 0;
+    }
+    else
+    {
+        int ssl_error = SSL_get_error(tls_io_instance->ssl, res);
+
+        *is_written = false;
+        if ((ssl_error == SSL_ERROR_WANT_WRITE) ||
+            (ssl_error == SSL_ERROR_WANT_READ))
+        {
+            result = 0;
+        }
+        else
+        {
+            result = __LINE__;
+            LogError("SSL_write error.\r\n");
+        }
+    }
+
+    return result;
+}
+
+static void complete_pending_send(TLS_IO_INSTANCE* tls_io_instance, IO_SEND_RESULT send_result)
+{
+    PENDING_SEND* pending_send = tls_io_instance->pending_sends_head;
+
+    tls_io_instance->pending_sends_head = pending_send->next;
+    if (tls_io_instance->pending_sends_head == NULL)
+    {
+        tls_io_instance->pending_sends_tail = NULL;
+    }
+
+    if (pending_send->on_send_complete != NULL)
+    {
+        pending_send->on_send_complete(pending_send->callback_context, send_result);
+    }
+
+    free(pending_send);
+}
+
+static void cancel_pending_sends(TLS_IO_INSTANCE* tls_io_instance, IO_SEND_RESULT send_result)
+{
+    while (tls_io_instance->pending_sends_head != NULL)
+    {
+        complete_pending_send(tls_io_instance, send_result);
+    }
+}
+
+/* writes the queued sends until the socket is full again */
+static int write_pending_sends(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result = 0;
+    bool is_written = true;
+
+    while ((result == 0) &&
+        is_written &&
+        (tls_io_instance->pending_sends_head != NULL))
+    {
+        PENDING_SEND* pending_send = tls_io_instance->pending_sends_head;
+
+        result = write_socket_bytes(tls_io_instance, pending_send->bytes, pending_send->size, &is_written);
+        if ((result == 0) && is_written)
+        {
+            complete_pending_send(tls_io_instance, IO_SEND_OK);
+        }
+    }
+
+    return result;
+}
+
 static void on_underlying_io_close_complete(void* context)
 {
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
@@ -219,9 +628,24 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
             }
             else
             {
+                int socket_bio_result = (tls_io_instance->ktls_requested) ? use_socket_bio(tls_io_instance) : __LINE__;
+
                 tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
 
-                if (send_handshake_bytes(tls_io_instance) != 0)
+                if (socket_bio_result == 0)
+                {
+                    /* the handshake goes on straight over the socket from tlsio_openssl_dowork */
+                    if (do_socket_handshake(tls_io_instance) != 0)
+                    {
+                        if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
+                        {
+                            indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+                            LogError("Error in xio_close.\r\n");
+                        }
+                    }
+                }
+                else if ((socket_bio_result < 0) ||
+                    (send_handshake_bytes(tls_io_instance) != 0))
                 {
                     if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
                     {
@@ -288,8 +712,20 @@ static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
 static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    int written;
+
+    if (tls_io_instance->use_xio_bio)
+    {
+        /* OpenSSL pulls the bytes through the xio BIO while they are processed below */
+        tls_io_instance->received_bytes = buffer;
+        tls_io_instance->received_size = size;
+        written = (int)size;
+    }
+    else
+    {
+        written = BIO_write(tls_io_instance->in_bio, buffer, size);
+    }
 
-    int written = BIO_write(tls_io_instance->in_bio, buffer, size);
     if (written != size)
     {
         tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
@@ -323,6 +759,13 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             }
             break;
         }
+
+        if ((tls_io_instance->use_xio_bio) &&
+            (keep_leftover_bytes(tls_io_instance) != 0))
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+        }
     }
 }
 
@@ -333,11 +776,37 @@ int tlsio_openssl_init(void)
     ERR_load_BIO_strings();
     OpenSSL_add_all_algorithms();
 
+#ifdef USE_XIO_BIO
+    xio_bio_method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "xio");
+    if ((xio_bio_method == NULL) ||
+        (BIO_meth_set_write(xio_bio_method, xio_bio_write) != 1) ||
+        (BIO_meth_set_read(xio_bio_method, xio_bio_read) != 1) ||
+        (BIO_meth_set_ctrl(xio_bio_method, xio_bio_ctrl) != 1) ||
+        (BIO_meth_set_create(xio_bio_method, xio_bio_create) != 1) ||
+        (BIO_meth_set_destroy(xio_bio_method, xio_bio_destroy) != 1))
+    {
+        /* not fatal, every instance falls back to the memory BIO pair */
+        LogError("Failed creating the xio BIO method.\r\n");
+        if (xio_bio_method != NULL)
+        {
+            BIO_meth_free(xio_bio_method);
+            xio_bio_method = NULL;
+        }
+    }
+#endif
+
     return 0;
 }
 
 void tlsio_openssl_deinit(void)
 {
+#ifdef USE_XIO_BIO
+    if (xio_bio_method != NULL)
+    {
+        BIO_meth_free(xio_bio_method);
+        xio_bio_method = NULL;
+    }
+#endif
 }
 
 CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters, LOGGER_LOG logger_log)
@@ -379,8 +848,30 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters, LOGGER_LOG l
 
             result->logger_log = logger_log;
             result->tlsio_state = TLSIO_STATE_NOT_OPEN;
-
+            result->use_xio_bio = false;
+            result->received_bytes = NULL;
+            result->received_size = 0;
+            result->leftover_bytes = NULL;
+            result->leftover_size = 0;
+            result->send_context = NULL;
+            result->ktls_requested = false;
+            result->socket = -1;
+            result->pending_sends_head = NULL;
+            result->pending_sends_tail = NULL;
+
+#ifdef SSL_OP_ENABLE_KTLS
+            /* still pinned to TLS 1.0, but on a version flexible method so that the kTLS option can lift the pin */
+            result->ssl_context = SSL_CTX_new(TLS_client_method());
+            if ((result->ssl_context != NULL) &&
+                ((SSL_CTX_set_min_proto_version(result->ssl_context, TLS1_VERSION) != 1) ||
+                (SSL_CTX_set_max_proto_version(result->ssl_context, TLS1_VERSION) != 1)))
+            {
+                SSL_CTX_free(result->ssl_context);
+                result->ssl_context = NULL;
+            }
+#else
             result->ssl_context = SSL_CTX_new(TLSv1_method());
+#endif
             if (result->ssl_context == NULL)
             {
                 free(result);
@@ -459,6 +950,28 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters, LOGGER_LOG l
                                 {
                                     SSL_set_bio(result->ssl, result->in_bio, result->out_bio);
                                     SSL_set_connect_state(result->ssl);
+
+#ifdef USE_XIO_BIO
+                                    /* the underlying IO is a plain socketio, so OpenSSL can go through it directly;
+                                       layered underlying IOs and a missing BIO method keep the memory BIO pair */
+                                    if (xio_bio_method != NULL)
+                                    {
+                                        BIO* xio_bio = BIO_new(xio_bio_method);
+                                        if (xio_bio == NULL)
+                                        {
+                                            LogInfo("Failed creating the xio BIO, using memory BIOs.\r\n");
+                                        }
+                                        else
+                                        {
+                                            /* SSL_set_bio frees the memory BIOs */
+                                            BIO_set_data(xio_bio, result);
+                                            SSL_set_bio(result->ssl, xio_bio, xio_bio);
+                                            result->in_bio = NULL;
+                                            result->out_bio = NULL;
+                                            result->use_xio_bio = true;
+                                        }
+                                    }
+#endif
                                 }
                             }
                         }
@@ -480,8 +993,10 @@ void tlsio_openssl_destroy(CONCRETE_IO_HANDLE tls_io)
     else
     {
         TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+        cancel_pending_sends(tls_io_instance, IO_SEND_CANCELLED);
         SSL_free(tls_io_instance->ssl);
         SSL_CTX_free(tls_io_instance->ssl_context);
+        free(tls_io_instance->leftover_bytes);
 
         xio_destroy(tls_io_instance->underlying_io);
         free(tls_io);
@@ -559,6 +1074,14 @@ int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_cl
             tls_io_instance->on_io_close_complete = on_io_close_complete;
             tls_io_instance->on_io_close_complete_context = callback_context;
 
+            if (tls_io_instance->socket != -1)
+            {
+                /* best effort close_notify, the underlying IO closes the socket */
+                cancel_pending_sends(tls_io_instance, IO_SEND_CANCELLED);
+                (void)SSL_shutdown(tls_io_instance->ssl);
+                tls_io_instance->socket = -1;
+            }
+
             if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
             {
                 result = __LINE__;
@@ -592,10 +1115,104 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
             result = __LINE__;
             LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPEN.\r\n");
         }
+        else if (tls_io_instance->socket != -1)
+        {
+            bool is_written = false;
+
+            /* nothing overtakes the sends that are already queued */
+            if ((tls_io_instance->pending_sends_head == NULL) &&
+                (write_socket_bytes(tls_io_instance, buffer, size, &is_written) != 0))
+            {
+                result = __LINE__;
+                LogError("Error in write_socket_bytes.\r\n");
+            }
+            else if (is_written)
+            {
+                if (on_send_complete != NULL)
+                {
+                    on_send_complete(callback_context, IO_SEND_OK);
+                }
+
+                result = 0;
+            }
+            else
+            {
+                /* the socket is full, tlsio_openssl_dowork finishes the send instead of the caller waiting for room */
+                PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + size);
+                if (pending_send == NULL)
+                {
+                    result = __LINE__;
+                    LogError("Failure allocating the pending send.\r\n");
+                }
+                else
+                {
+                    pending_send->bytes = (unsigned char*)(pending_send + 1);
+                    pending_send->size = size;
+                    pending_send->on_send_complete = on_send_complete;
+                    pending_send->callback_context = callback_context;
+                    pending_send->next = NULL;
+                    (void)memcpy(pending_send->bytes, buffer, size);
+
+                    if (tls_io_instance->pending_sends_tail == NULL)
+                    {
+                        tls_io_instance->pending_sends_head = pending_send;
+                    }
+                    else
+                    {
+                        tls_io_instance->pending_sends_tail->next = pending_send;
+                    }
+                    tls_io_instance->pending_sends_tail = pending_send;
+
+                    result = 0;
+                }
+            }
+        }
+        else if (tls_io_instance->use_xio_bio)
+        {
+            TLS_SEND_CONTEXT* send_context = (TLS_SEND_CONTEXT*)malloc(sizeof(TLS_SEND_CONTEXT));
+            if (send_context == NULL)
+            {
+                result = __LINE__;
+                LogError("Failed allocating the send context.\r\n");
+            }
+            else
+            {
+                int res;
+
+                send_context->on_send_complete = on_send_complete;
+                send_context->callback_context = callback_context;
+                send_context->pending_sends = 0;
+                send_context->is_written = false;
+                send_context->send_result = IO_SEND_OK;
+
+                /* the records go straight to xio_send from the xio BIO */
+                tls_io_instance->send_context = send_context;
+                res = SSL_write(tls_io_instance->ssl, buffer, size);
+                tls_io_instance->send_context = NULL;
+
+                if (res != (int)size)
+                {
+                    /* the failure is reported here, not through the callback */
+                    send_context->on_send_complete = NULL;
+                    result = __LINE__;
+                    LogError("SSL_write error.\r\n");
+                }
+                else
+                {
+                    result = 0;
+                }
+
+                send_context->is_written = true;
+                if (send_context->pending_sends == 0)
+                {
+                    complete_send_context(send_context);
+                }
+            }
+        }
         else
         {
             int res = SSL_write(tls_io_instance->ssl, buffer, size);
-            if (res != size)
+            if (res != (int)size)
             {
                 result = __LINE__;
                 LogError("SSL_write error.\r\n");
@@ -632,6 +1249,32 @@ void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
             (tls_io_instance->tlsio_state != TLSIO_STATE_ERROR))
         {
             xio_dowork(tls_io_instance->underlying_io);
+
+            if (tls_io_instance->socket == -1)
+            {
+                /* memory BIO mode, everything is driven by the underlying IO callbacks */
+            }
+            else if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+            {
+                if (do_socket_handshake(tls_io_instance) != 0)
+                {
+                    if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
+                    {
+                        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+                        LogError("Error in xio_close.\r\n");
+                    }
+                }
+            }
+            else if (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN)
+            {
+                if ((write_pending_sends(tls_io_instance) != 0) ||
+                    (read_socket_bytes(tls_io_instance) != 0))
+                {
+                    cancel_pending_sends(tls_io_instance, IO_SEND_ERROR);
+                    tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                    indicate_error(tls_io_instance);
+                }
+            }
         }
     }
 }
@@ -689,6 +1332,41 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
                 }
             }
         }
+        else if (strcmp("ktls", optionName) == 0)
+        {
+#ifdef SSL_OP_ENABLE_KTLS
+            if ((value == NULL) ||
+                (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN))
+            {
+                result = __LINE__;
+                LogError("kTLS can only be set before open.\r\n");
+            }
+            else if ((*(const bool*)value) &&
+                ((SSL_set_min_proto_version(tls_io_instance->ssl, TLS1_2_VERSION) != 1) ||
+                (SSL_set_max_proto_version(tls_io_instance->ssl, 0) != 1)))
+            {
+                /* the kernel only offloads TLS 1.2 and 1.3 records */
+                result = __LINE__;
+                LogError("Failure allowing TLS 1.2 and later for kTLS.\r\n");
+            }
+            else if ((!*(const bool*)value) &&
+                ((SSL_set_min_proto_version(tls_io_instance->ssl, SSL_CTX_get_min_proto_version(tls_io_instance->ssl_context)) != 1) ||
+                (SSL_set_max_proto_version(tls_io_instance->ssl, SSL_CTX_get_max_proto_version(tls_io_instance->ssl_context)) != 1)))
+            {
+                /* turning kTLS off again goes back to the versions the context pins */
+                result = __LINE__;
+                LogError("Failure restoring the TLS versions of the context.\r\n");
+            }
+            else
+            {
+                tls_io_instance->ktls_requested = *(const bool*)value;
+                result = 0;
+            }
+#else
+            result = __LINE__;
+            LogError("kTLS needs OpenSSL 3.0 or later.\r\n");
+#endif
+        }
         else
         {
             result = xio_setoption(tls_io_instance->underlying_io, optionName, value);
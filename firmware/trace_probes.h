@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef TRACE_PROBES_H
+#define TRACE_PROBES_H
+
+/* USDT (sys/sdt.h) static tracepoints under the "azure_iot" provider, enabled by building with USE_USDT_PROBES on Linux.
+   An enabled probe is a single nop until a tracer attaches, e.g.
+       bpftrace -e 'usdt:./app:azure_iot:event_enqueue { @t[arg1] = nsecs; }
+                    usdt:./app:azure_iot:event_complete /@t[arg1]/ { @us = hist((nsecs - @t[arg1]) / 1000); delete(@t[arg1]); }'
+   Without USE_USDT_PROBES the macros expand to nothing and their arguments are not evaluated.
+
+   event_enqueue(ll_handle, message)        IoTHubClient_LL_SendEventAsync queued the message
+   event_dequeue(transport, message)        a transport took the message off waitingToSend
+   event_complete(ll_handle, message, ok)   the confirmation is handed back to the application
+   xio_send(xio, size)                      bytes handed to an IO
+   frame_encode(type, size)                 AMQP frame encoded (frame_codec.c)
+   frame_decode(type, body_size)            AMQP frame decoded
+   mqtt_encode(packet_type, size)           MQTT control packet encoded (mqtt_codec.c)
+   mqtt_decode(packet_type, flags)          MQTT control packet decoded
+   send_ack(transport, id)                  PUBACK (packet id) or AMQP disposition (message) received
+   connection_state(transport, new, old)    transport connection state change, in the transport's own state values */
+
+#if defined(USE_USDT_PROBES) && defined(__linux__)
+
+#include <sys/sdt.h>
+
+#define TRACE_PROBE1(name, a1)              DTRACE_PROBE1(azure_iot, name, a1)
+#define TRACE_PROBE2(name, a1, a2)          DTRACE_PROBE2(azure_iot, name, a1, a2)
+#define TRACE_PROBE3(name, a1, a2, a3)      DTRACE_PROBE3(azure_iot, name, a1, a2, a3)
+
+#else
+
+#define TRACE_PROBE1(name, a1)
+#define TRACE_PROBE2(name, a1, a2)
+#define TRACE_PROBE3(name, a1, a2, a3)
+
+#endif
+
+#endif /* TRACE_PROBES_H */
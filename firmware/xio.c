@@ -6,15 +6,41 @@
 #include <crtdbg.h>
 #endif
 #include <stddef.h>
+#include <string.h>
 #include "gballoc.h"
+#include "iot_logging.h"
 #include "xio.h"
+#include "xio_capture.h"
+#include "trace_probes.h"
 
 typedef struct XIO_INSTANCE_TAG
 {
     const IO_INTERFACE_DESCRIPTION* io_interface_description;
     XIO_HANDLE concrete_xio_handle;
+    /* only used while capturing, the concrete IO then calls on_bytes_received_captured */
+    XIO_CAPTURE_HANDLE capture;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
 } XIO_INSTANCE;
 
+static void on_bytes_received_captured(void* context, const unsigned char* buffer, size_t size)
+{
+    XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)context;
+
+    if ((xio_instance->capture != NULL) &&
+        (xio_capture_write(xio_instance->capture, XIO_CAPTURE_RECEIVED, buffer, size) != 0))
+    {
+        LogError("Failure capturing received bytes, capture stopped.\r\n");
+        xio_capture_destroy(xio_instance->capture);
+        xio_instance->capture = NULL;
+    }
+
+    if (xio_instance->on_bytes_received != NULL)
+    {
+        xio_instance->on_bytes_received(xio_instance->on_bytes_received_context, buffer, size);
+    }
+}
+
 XIO_HANDLE xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description, const void* xio_create_parameters, LOGGER_LOG logger_log)
 {
     XIO_INSTANCE* xio_instance;
@@ -40,6 +66,9 @@ XIO_HANDLE xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description,
         {
             /* Codes_SRS_XIO_01_001: [xio_create shall return on success a non-NULL handle to a new IO interface.] */
             xio_instance->io_interface_description = io_interface_description;
+            xio_instance->capture = NULL;
+            xio_instance->on_bytes_received = NULL;
+            xio_instance->on_bytes_received_context = NULL;
 
             /* Codes_SRS_XIO_01_002: [In order to instantiate the concrete IO implementation the function concrete_io_create from the io_interface_description shall be called, passing the xio_create_parameters and logger_log arguments.] */
             xio_instance->concrete_xio_handle = xio_instance->io_interface_description->concrete_io_create((void*)xio_create_parameters, logger_log);
@@ -64,6 +93,7 @@ void xio_destroy(XIO_HANDLE xio)
 
         /* Codes_SRS_XIO_01_006: [xio_destroy shall also call the concrete_io_destroy function that is member of the io_interface_description argument passed to xio_create, while passing as argument to concrete_io_destroy the result of the underlying concrete_io_create handle that was called as part of the xio_create call.] */
         xio_instance->io_interface_description->concrete_io_destroy(xio_instance->concrete_xio_handle);
+        xio_capture_destroy(xio_instance->capture);
 
         /* Codes_SRS_XIO_01_005: [xio_destroy shall free all resources associated with the IO handle.] */
         free(xio_instance);
@@ -83,6 +113,15 @@ int xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_i
     {
         XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
 
+        if (xio_instance->capture != NULL)
+        {
+            (void)xio_capture_write(xio_instance->capture, XIO_CAPTURE_OPEN, NULL, 0);
+            xio_instance->on_bytes_received = on_bytes_received;
+            xio_instance->on_bytes_received_context = on_bytes_received_context;
+            on_bytes_received = on_bytes_received_captured;
+            on_bytes_received_context = xio_instance;
+        }
+
         /* Codes_SRS_XIO_01_019: [xio_open shall call the specific concrete_xio_open function specified in xio_create, passing callback function and context arguments for three events: open completed, bytes received, and IO error.] */
         if (xio_instance->io_interface_description->concrete_io_open(xio_instance->concrete_xio_handle, on_io_open_complete, on_io_open_complete_context, on_bytes_received, on_bytes_received_context, on_io_error, on_io_error_context) != 0)
         {
@@ -142,6 +181,12 @@ int xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE o
     {
         XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
 
+        TRACE_PROBE2(xio_send, xio, size);
+        if (xio_instance->capture != NULL)
+        {
+            (void)xio_capture_write(xio_instance->capture, XIO_CAPTURE_SENT, buffer, size);
+        }
+
         /* Codes_SRS_XIO_01_008: [xio_send shall pass the sequence of bytes pointed to by buffer to the concrete IO implementation specified in xio_create, by calling the concrete_io_send function while passing down the buffer and size arguments to it.] */
         /* Codes_SRS_XIO_01_009: [On success, xio_send shall return 0.] */
         /* Codes_SRS_XIO_01_015: [If the underlying concrete_io_send fails, xio_send shall return a non-zero value.] */
@@ -173,6 +218,23 @@ int xio_setoption(XIO_HANDLE xio, const char* optionName, const void* value)
     {
         result = __LINE__;
     }
+    else if (strcmp(optionName, XIO_CAPTURE_OPTION) == 0)
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        /* a new capture replaces the current one, NULL only stops it */
+        xio_capture_destroy(xio_instance->capture);
+        xio_instance->capture = NULL;
+        if ((value != NULL) &&
+            ((xio_instance->capture = xio_capture_create((const char*)value)) == NULL))
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
     else
     {
         XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
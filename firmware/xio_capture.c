@@ -0,0 +1,318 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "gballoc.h"
+#include "iot_logging.h"
+#include "tickcounter.h"
+#include "xio_capture.h"
+
+/* captures are files, the device has no file system to write them to */
+#if defined(__unix__) || defined(__APPLE__) || defined(_WIN32)
+
+#define XIO_CAPTURE_MAGIC_SIZE          8
+#define XIO_CAPTURE_RECORD_HEADER_SIZE  9
+
+typedef struct XIO_CAPTURE_INSTANCE_TAG
+{
+    FILE* file;
+    TICK_COUNTER_HANDLE tick_counter;
+    uint64_t start_ms;
+} XIO_CAPTURE_INSTANCE;
+
+static void put_uint32(unsigned char* bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value & 0xFF);
+    bytes[1] = (unsigned char)((value >> 8) & 0xFF);
+    bytes[2] = (unsigned char)((value >> 16) & 0xFF);
+    bytes[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+static uint32_t get_uint32(const unsigned char* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+XIO_CAPTURE_HANDLE xio_capture_create(const char* file_name)
+{
+    XIO_CAPTURE_INSTANCE* result;
+
+    if (file_name == NULL)
+    {
+        LogError("Invalid argument (file_name = NULL).\r\n");
+        result = NULL;
+    }
+    else if ((result = (XIO_CAPTURE_INSTANCE*)malloc(sizeof(XIO_CAPTURE_INSTANCE))) == NULL)
+    {
+        LogError("Failure allocating the capture instance.\r\n");
+    }
+    else if ((result->tick_counter = tickcounter_create()) == NULL)
+    {
+        LogError("Failure creating the capture tick counter.\r\n");
+        free(result);
+        result = NULL;
+    }
+    else if (tickcounter_get_current_ms(result->tick_counter, &result->start_ms) != 0)
+    {
+        LogError("Failure reading the capture tick counter.\r\n");
+        tickcounter_destroy(result->tick_counter);
+        free(result);
+        result = NULL;
+    }
+    else if ((result->file = fopen(file_name, "wb")) == NULL)
+    {
+        LogError("Failure opening capture file %s.\r\n", file_name);
+        tickcounter_destroy(result->tick_counter);
+        free(result);
+        result = NULL;
+    }
+    else if (fwrite(XIO_CAPTURE_MAGIC, 1, XIO_CAPTURE_MAGIC_SIZE, result->file) != XIO_CAPTURE_MAGIC_SIZE)
+    {
+        LogError("Failure writing capture file %s.\r\n", file_name);
+        (void)fclose(result->file);
+        tickcounter_destroy(result->tick_counter);
+        free(result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+void xio_capture_destroy(XIO_CAPTURE_HANDLE xio_capture)
+{
+    if (xio_capture != NULL)
+    {
+        (void)fclose(xio_capture->file);
+        tickcounter_destroy(xio_capture->tick_counter);
+        free(xio_capture);
+    }
+}
+
+int xio_capture_write(XIO_CAPTURE_HANDLE xio_capture, XIO_CAPTURE_RECORD_TYPE type, const void* buffer, size_t size)
+{
+    int result;
+    uint64_t now_ms;
+
+    if ((xio_capture == NULL) ||
+        ((buffer == NULL) && (size > 0)))
+    {
+        LogError("Invalid argument (xio_capture = %p, buffer = %p).\r\n", xio_capture, buffer);
+        result = __LINE__;
+    }
+    else if (tickcounter_get_current_ms(xio_capture->tick_counter, &now_ms) != 0)
+    {
+        LogError("Failure reading the capture tick counter.\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        unsigned char header[XIO_CAPTURE_RECORD_HEADER_SIZE];
+        header[0] = (unsigned char)type;
+        put_uint32(header + 1, (uint32_t)(now_ms - xio_capture->start_ms));
+        put_uint32(header + 5, (uint32_t)size);
+
+        if ((fwrite(header, 1, sizeof(header), xio_capture->file) != sizeof(header)) ||
+            ((size > 0) && (fwrite(buffer, 1, size, xio_capture->file) != size)))
+        {
+            LogError("Failure writing a capture record.\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int read_file(const char* file_name, unsigned char** contents, size_t* size)
+{
+    int result;
+    FILE* file = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        LogError("Failure opening capture file %s.\r\n", file_name);
+        result = __LINE__;
+    }
+    else
+    {
+        long length;
+
+        if ((fseek(file, 0, SEEK_END) != 0) ||
+            ((length = ftell(file)) < 0) ||
+            (fseek(file, 0, SEEK_SET) != 0))
+        {
+            LogError("Failure sizing capture file %s.\r\n", file_name);
+            result = __LINE__;
+        }
+        else if ((*contents = (unsigned char*)malloc((length == 0) ? 1 : (size_t)length)) == NULL)
+        {
+            LogError("Failure allocating %ld bytes for capture file %s.\r\n", length, file_name);
+            result = __LINE__;
+        }
+        else if (fread(*contents, 1, (size_t)length, file) != (size_t)length)
+        {
+            LogError("Failure reading capture file %s.\r\n", file_name);
+            free(*contents);
+            result = __LINE__;
+        }
+        else
+        {
+            *size = (size_t)length;
+            result = 0;
+        }
+
+        (void)fclose(file);
+    }
+
+    return result;
+}
+
+/* walks the records once to validate them, fills records when it is not NULL */
+static int parse_records(const unsigned char* contents, size_t size, XIO_CAPTURE_RECORD* records, size_t* record_count)
+{
+    int result = 0;
+    size_t position = XIO_CAPTURE_MAGIC_SIZE;
+    size_t count = 0;
+
+    while (position < size)
+    {
+        size_t record_size;
+
+        if (size - position < XIO_CAPTURE_RECORD_HEADER_SIZE)
+        {
+            result = __LINE__;
+            break;
+        }
+
+        record_size = get_uint32(contents + position + 5);
+        if ((contents[position] > XIO_CAPTURE_OPEN) ||
+            (size - position - XIO_CAPTURE_RECORD_HEADER_SIZE < record_size))
+        {
+            result = __LINE__;
+            break;
+        }
+
+        if (records != NULL)
+        {
+            records[count].type = (XIO_CAPTURE_RECORD_TYPE)contents[position];
+            records[count].time_ms = get_uint32(contents + position + 1);
+            records[count].size = record_size;
+            records[count].bytes = contents + position + XIO_CAPTURE_RECORD_HEADER_SIZE;
+        }
+
+        count++;
+        position += XIO_CAPTURE_RECORD_HEADER_SIZE + record_size;
+    }
+
+    *record_count = count;
+    return result;
+}
+
+int xio_capture_load(const char* file_name, XIO_CAPTURE_RECORD** records, size_t* record_count)
+{
+    int result;
+    unsigned char* contents;
+    size_t size;
+
+    if ((file_name == NULL) || (records == NULL) || (record_count == NULL))
+    {
+        LogError("Invalid argument (file_name = %p, records = %p, record_count = %p).\r\n", file_name, records, record_count);
+        result = __LINE__;
+    }
+    else if (read_file(file_name, &contents, &size) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        size_t count;
+
+        if ((size < XIO_CAPTURE_MAGIC_SIZE) ||
+            (memcmp(contents, XIO_CAPTURE_MAGIC, XIO_CAPTURE_MAGIC_SIZE) != 0))
+        {
+            LogError("%s is not a capture file.\r\n", file_name);
+            result = __LINE__;
+        }
+        else if (parse_records(contents, size, NULL, &count) != 0)
+        {
+            LogError("Capture file %s is truncated or corrupt after %lu records.\r\n", file_name, (unsigned long)count);
+            result = __LINE__;
+        }
+        else
+        {
+            /* the records are followed by a copy of the file, which their bytes point into */
+            XIO_CAPTURE_RECORD* block = (XIO_CAPTURE_RECORD*)malloc(count * sizeof(XIO_CAPTURE_RECORD) + size);
+            if (block == NULL)
+            {
+                LogError("Failure allocating the capture records.\r\n");
+                result = __LINE__;
+            }
+            else
+            {
+                unsigned char* copy = (unsigned char*)(block + count);
+                (void)memcpy(copy, contents, size);
+                (void)parse_records(copy, size, block, &count);
+                *records = block;
+                *record_count = count;
+                result = 0;
+            }
+        }
+
+        free(contents);
+    }
+
+    return result;
+}
+
+void xio_capture_free_records(XIO_CAPTURE_RECORD* records)
+{
+    free(records);
+}
+
+#else
+
+XIO_CAPTURE_HANDLE xio_capture_create(const char* file_name)
+{
+    (void)file_name;
+    LogError("Traffic capture needs a file system.\r\n");
+    return NULL;
+}
+
+void xio_capture_destroy(XIO_CAPTURE_HANDLE xio_capture)
+{
+    (void)xio_capture;
+}
+
+int xio_capture_write(XIO_CAPTURE_HANDLE xio_capture, XIO_CAPTURE_RECORD_TYPE type, const void* buffer, size_t size)
+{
+    (void)xio_capture;
+    (void)type;
+    (void)buffer;
+    (void)size;
+    return __LINE__;
+}
+
+int xio_capture_load(const char* file_name, XIO_CAPTURE_RECORD** records, size_t* record_count)
+{
+    (void)file_name;
+    (void)records;
+    (void)record_count;
+    LogError("Traffic capture needs a file system.\r\n");
+    return __LINE__;
+}
+
+void xio_capture_free_records(XIO_CAPTURE_RECORD* records)
+{
+    free(records);
+}
+
+#endif /* defined(__unix__) || defined(__APPLE__) || defined(_WIN32) */
@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef XIO_CAPTURE_H
+#define XIO_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+/* Traffic capture for any XIO_HANDLE: xio_setoption(xio, XIO_CAPTURE_OPTION, file_name) records every later open and
+   the bytes sent and received through that IO, NULL stops the capture. Set it on the TLS IO (the transports pass
+   unknown options down to it) to capture the plain protocol streams. Receive callbacks are only wrapped by xio_open,
+   so received bytes are captured from the next open on. Captures are only written and loaded on hosts with a file
+   system, on the device xio_capture_create and xio_capture_load fail.
+
+   File format, integers little endian: the 8 byte XIO_CAPTURE_MAGIC, then records of
+       uint8 type (XIO_CAPTURE_RECORD_TYPE), uint32 milliseconds since the capture started, uint32 size, size bytes
+   An XIO_CAPTURE_OPEN record has no bytes and starts a new connection, so decoders have to start over after it. */
+
+#define XIO_CAPTURE_OPTION  "xio_capture"
+#define XIO_CAPTURE_MAGIC   "XIOCAP01"
+
+typedef enum XIO_CAPTURE_RECORD_TYPE_TAG
+{
+    XIO_CAPTURE_RECEIVED,
+    XIO_CAPTURE_SENT,
+    XIO_CAPTURE_OPEN
+} XIO_CAPTURE_RECORD_TYPE;
+
+typedef struct XIO_CAPTURE_RECORD_TAG
+{
+    XIO_CAPTURE_RECORD_TYPE type;
+    uint32_t time_ms;
+    size_t size;
+    const unsigned char* bytes;
+} XIO_CAPTURE_RECORD;
+
+typedef struct XIO_CAPTURE_INSTANCE_TAG* XIO_CAPTURE_HANDLE;
+
+extern XIO_CAPTURE_HANDLE xio_capture_create(const char* file_name);
+extern void xio_capture_destroy(XIO_CAPTURE_HANDLE xio_capture);
+extern int xio_capture_write(XIO_CAPTURE_HANDLE xio_capture, XIO_CAPTURE_RECORD_TYPE type, const void* buffer, size_t size);
+
+/* reads a whole capture, the records and their bytes are one allocation released with xio_capture_free_records */
+extern int xio_capture_load(const char* file_name, XIO_CAPTURE_RECORD** records, size_t* record_count);
+extern void xio_capture_free_records(XIO_CAPTURE_RECORD* records);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* XIO_CAPTURE_H */
@@ -0,0 +1,748 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "gballoc.h"
+#include "crt_abstractions.h"
+#include "iot_logging.h"
+#include "xio.h"
+#include "frame_codec.h"
+#include "sasl_frame_codec.h"
+#include "amqp_definitions.h"
+#include "amqpvalue.h"
+#include "connection.h"
+#include "session.h"
+#include "link.h"
+#include "message.h"
+#include "messaging.h"
+#include "message_receiver.h"
+#include "message_sender.h"
+#include "amqp_hub_sim.h"
+
+/* the CBS node, two links per connection, and up to 4 event senders and a receiver (iothubtransportamqp.c) */
+#define AMQP_HUB_SIM_MAX_LINKS      8
+#define AMQP_HUB_SIM_CBS_ADDRESS    "$cbs"
+
+typedef enum HUB_IO_STATE_TAG
+{
+    HUB_IO_SASL_HEADER,
+    HUB_IO_SASL_FRAMES,
+    HUB_IO_AMQP_HEADER,
+    HUB_IO_OPEN,
+    HUB_IO_ERROR
+} HUB_IO_STATE;
+
+typedef struct HUB_LINK_TAG
+{
+    struct AMQP_HUB_SIM_INSTANCE_TAG* amqp_hub;
+    LINK_HANDLE link;
+    /* the hub receives on the links the device sends on and the other way round */
+    MESSAGE_RECEIVER_HANDLE message_receiver;
+    MESSAGE_SENDER_HANDLE message_sender;
+    bool is_cbs;
+} HUB_LINK;
+
+typedef struct AMQP_HUB_SIM_INSTANCE_TAG
+{
+    LOOPBACKIO_CONNECTION_HANDLE connection;
+    ON_AMQP_HUB_SIM_EVENT on_event;
+    void* on_event_context;
+    HUB_IO_STATE io_state;
+    size_t header_bytes_received;
+    FRAME_CODEC_HANDLE frame_codec;
+    SASL_FRAME_CODEC_HANDLE sasl_frame_codec;
+    /* the io under amqp_connection, it carries the frames once the SASL handshake is done */
+    XIO_HANDLE io;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    CONNECTION_HANDLE amqp_connection;
+    SESSION_HANDLE session;
+    HUB_LINK links[AMQP_HUB_SIM_MAX_LINKS];
+    size_t link_count;
+    HUB_LINK* cbs_link;
+    HUB_LINK* device_bound_link;
+    char* device_bound_address;
+} AMQP_HUB_SIM_INSTANCE;
+
+static const unsigned char sasl_header[] = { 'A', 'M', 'Q', 'P', 3, 1, 0, 0 };
+static const unsigned char amqp_header[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+
+static void deliver(AMQP_HUB_SIM_INSTANCE* amqp_hub, const unsigned char* bytes, size_t size)
+{
+    if ((amqp_hub->connection != NULL) && (loopbackio_deliver(amqp_hub->connection, bytes, size) != 0))
+    {
+        LogError("Failure delivering to the device.\r\n");
+    }
+}
+
+/* the concrete io under amqp_connection: sends go to the device, receives come from amqp_hub_sim_bytes_received */
+
+static CONCRETE_IO_HANDLE hubio_create(void* io_create_parameters, LOGGER_LOG logger_log)
+{
+    (void)logger_log;
+    return io_create_parameters;
+}
+
+static void hubio_destroy(CONCRETE_IO_HANDLE hub_io)
+{
+    /* the io state lives in the hub instance */
+    (void)hub_io;
+}
+
+static int hubio_open(CONCRETE_IO_HANDLE hub_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    AMQP_HUB_SIM_INSTANCE* amqp_hub = (AMQP_HUB_SIM_INSTANCE*)hub_io;
+
+    (void)on_io_error;
+    (void)on_io_error_context;
+
+    /* the open completes with the AMQP header exchange, connection_listen only expects the open frame after it */
+    amqp_hub->on_io_open_complete = on_io_open_complete;
+    amqp_hub->on_io_open_complete_context = on_io_open_complete_context;
+    amqp_hub->on_bytes_received = on_bytes_received;
+    amqp_hub->on_bytes_received_context = on_bytes_received_context;
+
+    return 0;
+}
+
+static int hubio_close(CONCRETE_IO_HANDLE hub_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)hub_io;
+
+    if (on_io_close_complete != NULL)
+    {
+        on_io_close_complete(callback_context);
+    }
+
+    return 0;
+}
+
+static int hubio_send(CONCRETE_IO_HANDLE hub_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    AMQP_HUB_SIM_INSTANCE* amqp_hub = (AMQP_HUB_SIM_INSTANCE*)hub_io;
+    int result;
+
+    if (amqp_hub->connection == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        deliver(amqp_hub, (const unsigned char*)buffer, size);
+        if (on_send_complete != NULL)
+        {
+            on_send_complete(callback_context, IO_SEND_OK);
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+static void hubio_dowork(CONCRETE_IO_HANDLE hub_io)
+{
+    (void)hub_io;
+}
+
+static int hubio_setoption(CONCRETE_IO_HANDLE hub_io, const char* optionName, const void* value)
+{
+    (void)hub_io;
+    (void)optionName;
+    (void)value;
+    return __LINE__;
+}
+
+static const IO_INTERFACE_DESCRIPTION hubio_interface_description =
+{
+    hubio_create,
+    hubio_destroy,
+    hubio_open,
+    hubio_close,
+    hubio_send,
+    hubio_dowork,
+    hubio_setoption
+};
+
+static void on_sasl_bytes_encoded(void* context, const unsigned char* bytes, size_t length, bool encode_complete)
+{
+    (void)encode_complete;
+    deliver((AMQP_HUB_SIM_INSTANCE*)context, bytes, length);
+}
+
+/* amqpvalue only encodes packed arrays of numbers, so the sasl-mechanisms body with its array of symbols is spelled
+   out: the descriptor 0x40, a list of one field, an array of one sym8 */
+static const unsigned char sasl_mechanisms_frame_body[] =
+{
+    0x00, 0x53, 0x40,
+    0xC0, 0x0D, 0x01,
+    0xE0, 0x0A, 0x01, 0xA3, 0x07, 'M', 'S', 'S', 'B', 'C', 'B', 'S'
+};
+
+static int send_sasl_mechanisms(AMQP_HUB_SIM_INSTANCE* amqp_hub)
+{
+    PAYLOAD payload;
+    payload.bytes = sasl_mechanisms_frame_body;
+    payload.length = sizeof(sasl_mechanisms_frame_body);
+
+    return frame_codec_encode_frame(amqp_hub->frame_codec, FRAME_TYPE_SASL, &payload, 1, NULL, 0, on_sasl_bytes_encoded, amqp_hub);
+}
+
+/* the device already traces every frame both ways */
+static void hub_log(unsigned int options, char* format, ...)
+{
+    (void)options;
+    (void)format;
+}
+
+static int send_sasl_outcome(AMQP_HUB_SIM_INSTANCE* amqp_hub)
+{
+    int result;
+    SASL_OUTCOME_HANDLE sasl_outcome = sasl_outcome_create(sasl_code_ok);
+
+    if (sasl_outcome == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        AMQP_VALUE sasl_outcome_value = amqpvalue_create_sasl_outcome(sasl_outcome);
+        if (sasl_outcome_value == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            result = sasl_frame_codec_encode_frame(amqp_hub->sasl_frame_codec, sasl_outcome_value, on_sasl_bytes_encoded, amqp_hub);
+            amqpvalue_destroy(sasl_outcome_value);
+        }
+        sasl_outcome_destroy(sasl_outcome);
+    }
+
+    return result;
+}
+
+static void on_sasl_frame_received(void* context, AMQP_VALUE sasl_frame_value)
+{
+    AMQP_HUB_SIM_INSTANCE* amqp_hub = (AMQP_HUB_SIM_INSTANCE*)context;
+    AMQP_VALUE descriptor = amqpvalue_get_inplace_descriptor(sasl_frame_value);
+
+    /* any credentials will do, the outcome follows the init right away */
+    if ((descriptor != NULL) && is_sasl_init_type_by_descriptor(descriptor))
+    {
+        if (send_sasl_outcome(amqp_hub) != 0)
+        {
+            LogError("Failure sending the SASL outcome.\r\n");
+            amqp_hub->io_state = HUB_IO_ERROR;
+        }
+        else
+        {
+            amqp_hub->io_state = HUB_IO_AMQP_HEADER;
+            amqp_hub->header_bytes_received = 0;
+        }
+    }
+}
+
+static void on_sasl_error(void* context)
+{
+    AMQP_HUB_SIM_INSTANCE* amqp_hub = (AMQP_HUB_SIM_INSTANCE*)context;
+    LogError("Failure decoding a SASL frame from the device.\r\n");
+    amqp_hub->io_state = HUB_IO_ERROR;
+}
+
+static const char* get_address(AMQP_VALUE address_value)
+{
+    const char* result;
+
+    if ((address_value == NULL) || (amqpvalue_get_string(address_value, &result) != 0))
+    {
+        result = NULL;
+    }
+
+    return result;
+}
+
+/* the address of the node on the hub's side of a link: the target of a link the device sends on, else the source */
+static bool is_cbs_node(role device_role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    bool result = false;
+    AMQP_VALUE address_value;
+
+    if (device_role == role_sender)
+    {
+        TARGET_HANDLE target_handle;
+        if ((target != NULL) && (amqpvalue_get_target(target, &target_handle) == 0))
+        {
+            const char* address = (target_get_address(target_handle, &address_value) == 0) ? get_address(address_value) : NULL;
+            result = (address != NULL) && (strcmp(address, AMQP_HUB_SIM_CBS_ADDRESS) == 0);
+            target_destroy(target_handle);
+        }
+    }
+    else
+    {
+        SOURCE_HANDLE source_handle;
+        if ((source != NULL) && (amqpvalue_get_source(source, &source_handle) == 0))
+        {
+            const char* address = (source_get_address(source_handle, &address_value) == 0) ? get_address(address_value) : NULL;
+            result = (address != NULL) && (strcmp(address, AMQP_HUB_SIM_CBS_ADDRESS) == 0);
+            source_destroy(source_handle);
+        }
+    }
+
+    return result;
+}
+
+static int save_device_bound_address(AMQP_HUB_SIM_INSTANCE* amqp_hub, AMQP_VALUE source)
+{
+    int result = __LINE__;
+    SOURCE_HANDLE source_handle;
+    AMQP_VALUE address_value;
+
+    if ((source != NULL) && (amqpvalue_get_source(source, &source_handle) == 0))
+    {
+        const char* address = (source_get_address(source_handle, &address_value) == 0) ? get_address(address_value) : NULL;
+        if (address != NULL)
+        {
+            free(amqp_hub->device_bound_address);
+            amqp_hub->device_bound_address = NULL;
+            result = mallocAndStrcpy_s(&amqp_hub->device_bound_address, address);
+        }
+        source_destroy(source_handle);
+    }
+
+    return result;
+}
+
+static MESSAGE_HANDLE create_cbs_response(MESSAGE_HANDLE request)
+{
+    MESSAGE_HANDLE result = NULL;
+    PROPERTIES_HANDLE request_properties;
+    AMQP_VALUE message_id;
+
+    if ((message_get_properties(request, &request_properties) != 0) || (request_properties == NULL))
+    {
+        LogError("CBS request without properties.\r\n");
+    }
+    else
+    {
+        if (properties_get_message_id(request_properties, &message_id) != 0)
+        {
+            LogError("CBS request without a message id.\r\n");
+        }
+        else
+        {
+            PROPERTIES_HANDLE response_properties = properties_create();
+            AMQP_VALUE application_properties = amqpvalue_create_map();
+            AMQP_VALUE status_code_key = amqpvalue_create_string("status-code");
+            AMQP_VALUE status_code = amqpvalue_create_int(200);
+            AMQP_VALUE body = amqpvalue_create_null();
+
+            if ((response_properties == NULL) || (application_properties == NULL) ||
+                (status_code_key == NULL) || (status_code == NULL) || (body == NULL) ||
+                (properties_set_correlation_id(response_properties, message_id) != 0) ||
+                (amqpvalue_set_map_value(application_properties, status_code_key, status_code) != 0) ||
+                ((result = message_create()) == NULL) ||
+                (message_set_properties(result, response_properties) != 0) ||
+                (message_set_application_properties(result, application_properties) != 0) ||
+                (message_set_body_amqp_value(result, body) != 0))
+            {
+                LogError("Failure building the CBS response.\r\n");
+                if (result != NULL)
+                {
+                    message_destroy(result);
+                    result = NULL;
+                }
+            }
+
+            if (body != NULL)
+            {
+                amqpvalue_destroy(body);
+            }
+            if (status_code != NULL)
+            {
+                amqpvalue_destroy(status_code);
+            }
+            if (status_code_key != NULL)
+            {
+                amqpvalue_destroy(status_code_key);
+            }
+            if (application_properties != NULL)
+            {
+                amqpvalue_destroy(application_properties);
+            }
+            if (response_properties != NULL)
+            {
+                properties_destroy(response_properties);
+            }
+        }
+
+        properties_destroy(request_properties);
+    }
+
+    return result;
+}
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    HUB_LINK* hub_link = (HUB_LINK*)context;
+    AMQP_HUB_SIM_INSTANCE* amqp_hub = hub_link->amqp_hub;
+    AMQP_VALUE result;
+
+    if (hub_link->is_cbs)
+    {
+        /* a put-token, its response goes out on the CBS link the device receives on */
+        MESSAGE_HANDLE response = create_cbs_response(message);
+        if ((response != NULL) && (amqp_hub->cbs_link != NULL) &&
+            (messagesender_send(amqp_hub->cbs_link->message_sender, response, NULL, NULL) != 0))
+        {
+            LogError("Failure sending the CBS response.\r\n");
+        }
+        if (response != NULL)
+        {
+            message_destroy(response);
+        }
+        result = messaging_delivery_accepted();
+    }
+    else if ((amqp_hub->on_event == NULL) || amqp_hub->on_event(amqp_hub->on_event_context))
+    {
+        result = messaging_delivery_accepted();
+    }
+    else
+    {
+        result = messaging_delivery_rejected("amqp:resource-limit-exceeded", "The hub's message quota is exhausted");
+    }
+
+    return result;
+}
+
+static bool on_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    AMQP_HUB_SIM_INSTANCE* amqp_hub = (AMQP_HUB_SIM_INSTANCE*)context;
+    bool result;
+
+    if (amqp_hub->link_count == AMQP_HUB_SIM_MAX_LINKS)
+    {
+        LogError("Too many links on one connection.\r\n");
+        result = false;
+    }
+    else
+    {
+        HUB_LINK* hub_link = &amqp_hub->links[amqp_hub->link_count];
+        hub_link->amqp_hub = amqp_hub;
+        hub_link->message_receiver = NULL;
+        hub_link->message_sender = NULL;
+        hub_link->is_cbs = is_cbs_node(role, source, target);
+
+        if ((hub_link->link = link_create_from_endpoint(amqp_hub->session, new_link_endpoint, name, role, source, target)) == NULL)
+        {
+            LogError("Failure creating the hub's end of link %s.\r\n", name);
+            result = false;
+        }
+        else if (role == role_sender)
+        {
+            if (((hub_link->message_receiver = messagereceiver_create(hub_link->link, NULL, NULL)) == NULL) ||
+                (messagereceiver_open(hub_link->message_receiver, on_message_received, hub_link) != 0))
+            {
+                LogError("Failure receiving on link %s.\r\n", name);
+                result = false;
+            }
+            else
+            {
+                result = true;
+            }
+        }
+        else
+        {
+            if (((hub_link->message_sender = messagesender_create(hub_link->link, NULL, NULL, NULL)) == NULL) ||
+                (messagesender_open(hub_link->message_sender) != 0))
+            {
+                LogError("Failure sending on link %s.\r\n", name);
+                result = false;
+            }
+            else if (hub_link->is_cbs)
+            {
+                amqp_hub->cbs_link = hub_link;
+                result = true;
+            }
+            else if (save_device_bound_address(amqp_hub, source) != 0)
+            {
+                LogError("Failure saving the address of link %s.\r\n", name);
+                result = false;
+            }
+            else
+            {
+                amqp_hub->device_bound_link = hub_link;
+                result = true;
+            }
+        }
+
+        if (result)
+        {
+            amqp_hub->link_count++;
+        }
+        else
+        {
+            if (hub_link->message_receiver != NULL)
+            {
+                messagereceiver_destroy(hub_link->message_receiver);
+            }
+            if (hub_link->message_sender != NULL)
+            {
+                messagesender_destroy(hub_link->message_sender);
+            }
+            if (hub_link->link != NULL)
+            {
+                link_destroy(hub_link->link);
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool on_new_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    AMQP_HUB_SIM_INSTANCE* amqp_hub = (AMQP_HUB_SIM_INSTANCE*)context;
+    bool result;
+
+    /* the transport begins a single session */
+    if (amqp_hub->session != NULL)
+    {
+        result = false;
+    }
+    else if ((amqp_hub->session = session_create_from_endpoint(amqp_hub->amqp_connection, new_endpoint, on_link_attached, amqp_hub)) == NULL)
+    {
+        LogError("Failure creating the hub's end of the session.\r\n");
+        result = false;
+    }
+    /* session_create_from_endpoint leaves the desired incoming window unset, so the hub sets the one the device does */
+    else if ((session_set_incoming_window(amqp_hub->session, UINT32_MAX) != 0) ||
+        (session_begin(amqp_hub->session) != 0))
+    {
+        LogError("Failure beginning the hub's end of the session.\r\n");
+        session_destroy(amqp_hub->session);
+        amqp_hub->session = NULL;
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+
+    return result;
+}
+
+AMQP_HUB_SIM_HANDLE amqp_hub_sim_create(LOOPBACKIO_CONNECTION_HANDLE connection, ON_AMQP_HUB_SIM_EVENT on_event, void* on_event_context)
+{
+    AMQP_HUB_SIM_INSTANCE* result;
+
+    if (connection == NULL)
+    {
+        LogError("Invalid argument to amqp_hub_sim_create.\r\n");
+        result = NULL;
+    }
+    else if ((result = (AMQP_HUB_SIM_INSTANCE*)malloc(sizeof(AMQP_HUB_SIM_INSTANCE))) == NULL)
+    {
+        LogError("Failure allocating the hub's end of an AMQP connection.\r\n");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(AMQP_HUB_SIM_INSTANCE));
+        result->connection = connection;
+        result->on_event = on_event;
+        result->on_event_context = on_event_context;
+        result->io_state = HUB_IO_SASL_HEADER;
+
+        if (((result->frame_codec = frame_codec_create(on_sasl_error, result, NULL)) == NULL) ||
+            ((result->sasl_frame_codec = sasl_frame_codec_create(result->frame_codec, on_sasl_frame_received, on_sasl_error, result)) == NULL) ||
+            ((result->io = xio_create(&hubio_interface_description, result, NULL)) == NULL) ||
+            ((result->amqp_connection = connection_create2(result->io, NULL, "fleetsim-hub", on_new_endpoint, result, NULL, NULL, NULL, NULL, hub_log)) == NULL) ||
+            (connection_listen(result->amqp_connection) != 0))
+        {
+            LogError("Failure creating the hub's end of an AMQP connection.\r\n");
+            result->connection = NULL;
+            amqp_hub_sim_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void amqp_hub_sim_destroy(AMQP_HUB_SIM_HANDLE amqp_hub)
+{
+    if (amqp_hub != NULL)
+    {
+        size_t i;
+
+        /* the detach, end and close frames the teardown encodes go nowhere */
+        amqp_hub->connection = NULL;
+
+        for (i = 0; i < amqp_hub->link_count; i++)
+        {
+            /* closing detaches a link that is still attached, any other link reports its detach from link_destroy,
+               so the sender and the receiver are closed before the link goes and freed after it */
+            if (amqp_hub->links[i].message_sender != NULL)
+            {
+                (void)messagesender_close(amqp_hub->links[i].message_sender);
+            }
+            if (amqp_hub->links[i].message_receiver != NULL)
+            {
+                (void)messagereceiver_close(amqp_hub->links[i].message_receiver);
+            }
+            link_destroy(amqp_hub->links[i].link);
+            if (amqp_hub->links[i].message_sender != NULL)
+            {
+                messagesender_destroy(amqp_hub->links[i].message_sender);
+            }
+            if (amqp_hub->links[i].message_receiver != NULL)
+            {
+                messagereceiver_destroy(amqp_hub->links[i].message_receiver);
+            }
+        }
+        if (amqp_hub->session != NULL)
+        {
+            session_destroy(amqp_hub->session);
+        }
+        if (amqp_hub->amqp_connection != NULL)
+        {
+            connection_destroy(amqp_hub->amqp_connection);
+        }
+        if (amqp_hub->io != NULL)
+        {
+            xio_destroy(amqp_hub->io);
+        }
+        if (amqp_hub->sasl_frame_codec != NULL)
+        {
+            sasl_frame_codec_destroy(amqp_hub->sasl_frame_codec);
+        }
+        if (amqp_hub->frame_codec != NULL)
+        {
+            frame_codec_destroy(amqp_hub->frame_codec);
+        }
+        free(amqp_hub->device_bound_address);
+        free(amqp_hub);
+    }
+}
+
+void amqp_hub_sim_bytes_received(AMQP_HUB_SIM_HANDLE amqp_hub, const unsigned char* buffer, size_t size)
+{
+    size_t i = 0;
+
+    /* the SASL and AMQP headers and the SASL frames are handled here, the rest goes to the connection */
+    while ((i < size) && (amqp_hub->io_state != HUB_IO_OPEN) && (amqp_hub->io_state != HUB_IO_ERROR))
+    {
+        unsigned char b = buffer[i++];
+
+        switch (amqp_hub->io_state)
+        {
+            default:
+                break;
+
+            case HUB_IO_SASL_HEADER:
+            case HUB_IO_AMQP_HEADER:
+            {
+                const unsigned char* header = (amqp_hub->io_state == HUB_IO_SASL_HEADER) ? sasl_header : amqp_header;
+                if (b != header[amqp_hub->header_bytes_received])
+                {
+                    LogError("Unexpected protocol header from the device.\r\n");
+                    amqp_hub->io_state = HUB_IO_ERROR;
+                }
+                else if (++amqp_hub->header_bytes_received == sizeof(sasl_header))
+                {
+                    deliver(amqp_hub, header, sizeof(sasl_header));
+                    if (amqp_hub->io_state == HUB_IO_AMQP_HEADER)
+                    {
+                        amqp_hub->io_state = HUB_IO_OPEN;
+                        if (amqp_hub->on_io_open_complete != NULL)
+                        {
+                            amqp_hub->on_io_open_complete(amqp_hub->on_io_open_complete_context, IO_OPEN_OK);
+                        }
+                    }
+                    else if (send_sasl_mechanisms(amqp_hub) != 0)
+                    {
+                        LogError("Failure sending the SASL mechanisms.\r\n");
+                        amqp_hub->io_state = HUB_IO_ERROR;
+                    }
+                    else
+                    {
+                        amqp_hub->io_state = HUB_IO_SASL_FRAMES;
+                    }
+                }
+                break;
+            }
+
+            case HUB_IO_SASL_FRAMES:
+                if (frame_codec_receive_bytes(amqp_hub->frame_codec, &b, 1) != 0)
+                {
+                    amqp_hub->io_state = HUB_IO_ERROR;
+                }
+                break;
+        }
+    }
+
+    if ((i < size) && (amqp_hub->io_state == HUB_IO_OPEN) && (amqp_hub->on_bytes_received != NULL))
+    {
+        amqp_hub->on_bytes_received(amqp_hub->on_bytes_received_context, buffer + i, size - i);
+    }
+}
+
+void amqp_hub_sim_dowork(AMQP_HUB_SIM_HANDLE amqp_hub)
+{
+    if (amqp_hub != NULL)
+    {
+        connection_dowork(amqp_hub->amqp_connection);
+    }
+}
+
+const char* amqp_hub_sim_get_device_bound_address(AMQP_HUB_SIM_HANDLE amqp_hub)
+{
+    return (amqp_hub == NULL) ? NULL : amqp_hub->device_bound_address;
+}
+
+int amqp_hub_sim_send_to_device(AMQP_HUB_SIM_HANDLE amqp_hub, const unsigned char* body, size_t size)
+{
+    int result;
+
+    if ((amqp_hub == NULL) || (amqp_hub->device_bound_link == NULL))
+    {
+        LogError("No link to send the message to the device on.\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        MESSAGE_HANDLE message = message_create();
+        if (message == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            BINARY_DATA binary_data;
+            binary_data.bytes = body;
+            binary_data.length = size;
+
+            if ((message_add_body_amqp_data(message, binary_data) != 0) ||
+                (messagesender_send(amqp_hub->device_bound_link->message_sender, message, NULL, NULL) != 0))
+            {
+                LogError("Failure sending a message to the device.\r\n");
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+            message_destroy(message);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef AMQP_HUB_SIM_H
+#define AMQP_HUB_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+#include "loopbackio.h"
+
+/* The stand-in hub's side of one AMQP connection (fleet_sim.h), built from uAMQP's listening connection, sessions
+   and links. It answers the SASL handshake with MSSBCBS and an ok outcome without looking at the credentials,
+   accepts every link the device attaches, replies 200 to every CBS put-token and accepts the events, unless
+   ON_AMQP_HUB_SIM_EVENT rejects them with amqp:resource-limit-exceeded the way IoT Hub throttles. */
+
+typedef struct AMQP_HUB_SIM_INSTANCE_TAG* AMQP_HUB_SIM_HANDLE;
+
+/* an event arrived, returns false to reject it as throttled */
+typedef bool(*ON_AMQP_HUB_SIM_EVENT)(void* context);
+
+extern AMQP_HUB_SIM_HANDLE amqp_hub_sim_create(LOOPBACKIO_CONNECTION_HANDLE connection, ON_AMQP_HUB_SIM_EVENT on_event, void* on_event_context);
+/* nothing is sent on the connection from here on, so it may already be closed by either side */
+extern void amqp_hub_sim_destroy(AMQP_HUB_SIM_HANDLE amqp_hub);
+/* bytes the device sent, from ON_LOOPBACK_BYTES_RECEIVED */
+extern void amqp_hub_sim_bytes_received(AMQP_HUB_SIM_HANDLE amqp_hub, const unsigned char* buffer, size_t size);
+extern void amqp_hub_sim_dowork(AMQP_HUB_SIM_HANDLE amqp_hub);
+/* the source address of the link the device receives cloud to device messages on, NULL until it is attached */
+extern const char* amqp_hub_sim_get_device_bound_address(AMQP_HUB_SIM_HANDLE amqp_hub);
+/* sends a cloud to device message with a data body on that link */
+extern int amqp_hub_sim_send_to_device(AMQP_HUB_SIM_HANDLE amqp_hub, const unsigned char* body, size_t size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* AMQP_HUB_SIM_H */
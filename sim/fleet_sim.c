@@ -0,0 +1,1012 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gballoc.h"
+#include "doublylinkedlist.h"
+#include "iot_logging.h"
+#include "iothub_client_ll.h"
+#include "iothubtransportmqtt.h"
+#include "iothubtransporthttp.h"
+#include "iothubtransportamqp.h"
+#include "loopbackio.h"
+#include "httpapi_sim.h"
+#include "amqp_hub_sim.h"
+#include "virtualclock.h"
+#include "fleet_sim.h"
+
+/* 2016-01-01T00:00:00Z, a fixed start keeps the SAS tokens and so the whole run reproducible */
+#define FLEET_SIM_START_TIME        1451606400
+/* latencies below 64 ms get a bucket each, above that every power of 2 up to 2^32 ms is split into 32 buckets */
+#define FLEET_SIM_LATENCY_EXACT_BITS    6
+#define FLEET_SIM_LATENCY_SUB_BITS      5
+#define FLEET_SIM_LATENCY_BUCKETS       ((1 << FLEET_SIM_LATENCY_EXACT_BITS) + ((32 - FLEET_SIM_LATENCY_EXACT_BITS) << FLEET_SIM_LATENCY_SUB_BITS))
+#define FLEET_SIM_DEVICE_ID_LEN     32
+#define FLEET_SIM_DEVICE_ID_PREFIX  "simdevice"
+/* base64 of 32 zero bytes, the stand-in hub does not check signatures */
+#define FLEET_SIM_DEVICE_KEY        "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA="
+
+#define MQTT_CONNECT        0x10
+#define MQTT_PUBLISH        0x30
+#define MQTT_SUBSCRIBE      0x80
+#define MQTT_UNSUBSCRIBE    0xA0
+#define MQTT_PINGREQ        0xC0
+#define MQTT_DISCONNECT     0xE0
+
+typedef struct SIM_MESSAGE_TAG
+{
+    struct FLEET_SIM_TAG* sim;
+    uint64_t enqueue_ms;
+} SIM_MESSAGE;
+
+typedef struct SIM_DEVICE_TAG
+{
+    IOTHUB_CLIENT_LL_HANDLE client;
+    size_t messages_sent;
+    uint64_t next_send_ms;
+    /* an HTTP request blocks the device until then */
+    uint64_t busy_until_ms;
+    /* cloud to device messages the hub sent the device */
+    size_t messages_to_device_sent;
+    uint64_t next_to_device_ms;
+} SIM_DEVICE;
+
+/* the hub's side of one connection */
+typedef struct SIM_CONNECTION_TAG
+{
+    struct FLEET_SIM_TAG* sim;
+    LOOPBACKIO_CONNECTION_HANDLE connection;
+    unsigned char* received;
+    size_t received_size;
+    size_t received_capacity;
+    /* the uAMQP listening side, NULL over MQTT */
+    AMQP_HUB_SIM_HANDLE amqp_hub;
+    /* the device listening for cloud to device messages on this connection, SIZE_MAX before it does */
+    size_t device_index;
+    uint16_t next_packet_id;
+    DLIST_ENTRY entry;
+} SIM_CONNECTION;
+
+typedef struct FLEET_SIM_TAG
+{
+    const FLEET_SIM_CONFIG* config;
+    FLEET_SIM_REPORT* report;
+    DLIST_ENTRY connections;
+    SIM_DEVICE* devices;
+    const unsigned char* payload;
+    size_t* latency_histogram;
+    /* hub quota bucket, an event costs 1000 tokens and every virtual millisecond adds hub_messages_per_second */
+    uint64_t quota_tokens;
+    uint64_t quota_refill_ms;
+    /* what the hub allocated, it is not charged to the devices */
+    size_t hub_allocation_count;
+    size_t hub_allocated_bytes;
+    size_t hub_entered_count;
+    size_t hub_entered_bytes;
+    size_t hub_depth;
+    /* ETag of the last cloud to device message sent over HTTP */
+    char etag[24];
+} FLEET_SIM;
+
+/* everything from hub_enter to hub_leave is the stand-in hub's work */
+static void hub_enter(FLEET_SIM* sim)
+{
+    if (sim->hub_depth++ == 0)
+    {
+        sim->hub_entered_count = gballoc_getAllocationCount();
+        sim->hub_entered_bytes = gballoc_getAllocatedBytes();
+    }
+}
+
+static void hub_leave(FLEET_SIM* sim)
+{
+    if (--sim->hub_depth == 0)
+    {
+        sim->hub_allocation_count += gballoc_getAllocationCount() - sim->hub_entered_count;
+        sim->hub_allocated_bytes += gballoc_getAllocatedBytes() - sim->hub_entered_bytes;
+    }
+}
+
+/* the index in the device id within text, SIZE_MAX when there is none */
+static size_t parse_device_index(const char* text, size_t length)
+{
+    size_t result = SIZE_MAX;
+    size_t prefix_length = sizeof(FLEET_SIM_DEVICE_ID_PREFIX) - 1;
+    size_t i;
+
+    for (i = 0; i + prefix_length < length; i++)
+    {
+        if (memcmp(text + i, FLEET_SIM_DEVICE_ID_PREFIX, prefix_length) == 0)
+        {
+            size_t j = i + prefix_length;
+            result = 0;
+            while ((j < length) && (text[j] >= '0') && (text[j] <= '9'))
+            {
+                result = result * 10 + (size_t)(text[j++] - '0');
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+/* the hub sends a device its next cloud to device message once send_interval_ms has passed since the last one */
+static SIM_DEVICE* get_device_to_send_to(FLEET_SIM* sim, size_t device_index)
+{
+    SIM_DEVICE* result;
+
+    if ((device_index >= sim->config->device_count) ||
+        (sim->devices[device_index].messages_to_device_sent >= sim->config->messages_to_device) ||
+        (sim->devices[device_index].next_to_device_ms > virtualclock_get_ms()))
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = &sim->devices[device_index];
+        result->messages_to_device_sent++;
+        result->next_to_device_ms = virtualclock_get_ms() + sim->config->send_interval_ms;
+    }
+
+    return result;
+}
+
+static bool take_quota(FLEET_SIM* sim, size_t events)
+{
+    bool result;
+
+    if (sim->config->hub_messages_per_second == 0)
+    {
+        result = true;
+    }
+    else
+    {
+        uint64_t now = virtualclock_get_ms();
+        uint64_t max_tokens = (uint64_t)sim->config->hub_messages_per_second * 1000;
+
+        sim->quota_tokens += (now - sim->quota_refill_ms) * sim->config->hub_messages_per_second;
+        if (sim->quota_tokens > max_tokens)
+        {
+            sim->quota_tokens = max_tokens;
+        }
+        sim->quota_refill_ms = now;
+
+        if (sim->quota_tokens >= 1000 * (uint64_t)events)
+        {
+            sim->quota_tokens -= 1000 * (uint64_t)events;
+            result = true;
+        }
+        else
+        {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+/* over AMQP the hub rejects the events over the quota instead of dropping the connection */
+static bool on_amqp_event(void* context)
+{
+    SIM_CONNECTION* sim_connection = (SIM_CONNECTION*)context;
+    bool result;
+
+    sim_connection->sim->report->publishes++;
+    if (!take_quota(sim_connection->sim, 1))
+    {
+        sim_connection->sim->report->throttled_disconnects++;
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+
+    return result;
+}
+
+static void* on_hub_connect(void* endpoint_context, LOOPBACKIO_CONNECTION_HANDLE connection)
+{
+    FLEET_SIM* sim = (FLEET_SIM*)endpoint_context;
+    SIM_CONNECTION* sim_connection;
+
+    hub_enter(sim);
+    if ((sim_connection = (SIM_CONNECTION*)malloc(sizeof(SIM_CONNECTION))) != NULL)
+    {
+        sim_connection->sim = sim;
+        sim_connection->connection = connection;
+        sim_connection->received = NULL;
+        sim_connection->received_size = 0;
+        sim_connection->received_capacity = 0;
+        sim_connection->amqp_hub = NULL;
+        sim_connection->device_index = SIZE_MAX;
+        sim_connection->next_packet_id = 1;
+
+        if ((sim->config->protocol == FLEET_SIM_AMQP) &&
+            ((sim_connection->amqp_hub = amqp_hub_sim_create(connection, on_amqp_event, sim_connection)) == NULL))
+        {
+            free(sim_connection);
+            sim_connection = NULL;
+        }
+        else
+        {
+            DList_InsertTailList(&sim->connections, &sim_connection->entry);
+        }
+    }
+    hub_leave(sim);
+
+    return sim_connection;
+}
+
+static void free_connection(SIM_CONNECTION* sim_connection)
+{
+    (void)DList_RemoveEntryList(&sim_connection->entry);
+    amqp_hub_sim_destroy(sim_connection->amqp_hub);
+    free(sim_connection->received);
+    free(sim_connection);
+}
+
+static void on_hub_disconnect(void* connection_context)
+{
+    FLEET_SIM* sim = ((SIM_CONNECTION*)connection_context)->sim;
+
+    hub_enter(sim);
+    free_connection((SIM_CONNECTION*)connection_context);
+    hub_leave(sim);
+}
+
+static void reply(SIM_CONNECTION* sim_connection, const unsigned char* packet, size_t size)
+{
+    if (loopbackio_deliver(sim_connection->connection, packet, size) != 0)
+    {
+        LogError("Failure delivering a reply.\r\n");
+    }
+}
+
+/* returns false when the hub drops the connection */
+static bool handle_packet(SIM_CONNECTION* sim_connection, unsigned char header, const unsigned char* body, size_t body_size)
+{
+    bool result = true;
+
+    switch (header & 0xF0)
+    {
+        case MQTT_CONNECT:
+        {
+            unsigned char connack[] = { 0x20, 0x02, 0x00, 0x00 };
+            sim_connection->sim->report->connects++;
+            reply(sim_connection, connack, sizeof(connack));
+            break;
+        }
+        case MQTT_PUBLISH:
+        {
+            size_t topic_size = (body_size < 2) ? 0 : ((size_t)body[0] << 8) + body[1];
+            sim_connection->sim->report->publishes++;
+            if (!take_quota(sim_connection->sim, 1))
+            {
+                sim_connection->sim->report->throttled_disconnects++;
+                result = false;
+            }
+            /* QoS 1 and 2 carry a packet id after the topic, both are acknowledged with a PUBACK here */
+            else if (((header & 0x06) != 0) && (body_size >= topic_size + 4))
+            {
+                unsigned char puback[] = { 0x40, 0x02, body[2 + topic_size], body[3 + topic_size] };
+                reply(sim_connection, puback, sizeof(puback));
+            }
+            break;
+        }
+        case MQTT_SUBSCRIBE:
+        {
+            if (body_size >= 2)
+            {
+                unsigned char suback[] = { 0x90, 0x03, body[0], body[1], 0x01 };
+                /* the topic filter is devices/{device id}/messages/devicebound/# */
+                sim_connection->device_index = parse_device_index((const char*)body + 2, body_size - 2);
+                reply(sim_connection, suback, sizeof(suback));
+            }
+            break;
+        }
+        case MQTT_UNSUBSCRIBE:
+        {
+            if (body_size >= 2)
+            {
+                unsigned char unsuback[] = { 0xB0, 0x02, body[0], body[1] };
+                reply(sim_connection, unsuback, sizeof(unsuback));
+            }
+            break;
+        }
+        case MQTT_PINGREQ:
+        {
+            unsigned char pingresp[] = { 0xD0, 0x00 };
+            reply(sim_connection, pingresp, sizeof(pingresp));
+            break;
+        }
+        default:
+            break;
+    }
+
+    return result;
+}
+
+static int append_received(SIM_CONNECTION* sim_connection, const unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if (sim_connection->received_size + size > sim_connection->received_capacity)
+    {
+        size_t new_capacity = (sim_connection->received_size + size) * 2;
+        unsigned char* new_received = (unsigned char*)realloc(sim_connection->received, new_capacity);
+        if (new_received == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            sim_connection->received = new_received;
+            sim_connection->received_capacity = new_capacity;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        (void)memcpy(sim_connection->received + sim_connection->received_size, buffer, size);
+        sim_connection->received_size += size;
+    }
+
+    return result;
+}
+
+static void on_mqtt_bytes_received(SIM_CONNECTION* sim_connection, const unsigned char* buffer, size_t size)
+{
+    if (append_received(sim_connection, buffer, size) != 0)
+    {
+        LogError("Failure growing the receive buffer.\r\n");
+        loopbackio_disconnect(sim_connection->connection);
+        free_connection(sim_connection);
+    }
+    else
+    {
+        size_t consumed = 0;
+        bool keep_connection = true;
+
+        /* split the stream into control packets: fixed header byte, 1 to 4 bytes of remaining length, body */
+        while (sim_connection->received_size - consumed >= 2)
+        {
+            const unsigned char* packet = sim_connection->received + consumed;
+            size_t available = sim_connection->received_size - consumed;
+            size_t remaining_length = 0;
+            size_t multiplier = 1;
+            size_t header_size = 1;
+            bool complete_length = false;
+
+            while ((header_size < available) && (header_size <= 4))
+            {
+                unsigned char encoded = packet[header_size++];
+                remaining_length += (encoded & 0x7F) * multiplier;
+                multiplier *= 128;
+                if ((encoded & 0x80) == 0)
+                {
+                    complete_length = true;
+                    break;
+                }
+            }
+
+            if (!complete_length || (available - header_size < remaining_length))
+            {
+                break;
+            }
+
+            keep_connection = handle_packet(sim_connection, packet[0], packet + header_size, remaining_length);
+            consumed += header_size + remaining_length;
+            if (!keep_connection)
+            {
+                break;
+            }
+        }
+
+        if (!keep_connection)
+        {
+            loopbackio_disconnect(sim_connection->connection);
+            free_connection(sim_connection);
+        }
+        else if (consumed > 0)
+        {
+            (void)memmove(sim_connection->received, sim_connection->received + consumed, sim_connection->received_size - consumed);
+            sim_connection->received_size -= consumed;
+        }
+    }
+}
+
+static void on_hub_bytes_received(void* connection_context, const unsigned char* buffer, size_t size)
+{
+    SIM_CONNECTION* sim_connection = (SIM_CONNECTION*)connection_context;
+    FLEET_SIM* sim = sim_connection->sim;
+
+    hub_enter(sim);
+    if (sim_connection->amqp_hub != NULL)
+    {
+        amqp_hub_sim_bytes_received(sim_connection->amqp_hub, buffer, size);
+    }
+    else
+    {
+        /* may free the connection */
+        on_mqtt_bytes_received(sim_connection, buffer, size);
+    }
+    hub_leave(sim);
+}
+
+/* a QoS 1 PUBLISH on the device's devicebound topic */
+static void publish_to_device(SIM_CONNECTION* sim_connection)
+{
+    char topic[sizeof("devices//messages/devicebound/") + FLEET_SIM_DEVICE_ID_LEN];
+    size_t topic_size = (size_t)snprintf(topic, sizeof(topic), "devices/" FLEET_SIM_DEVICE_ID_PREFIX "%06lu/messages/devicebound/", (unsigned long)sim_connection->device_index);
+    size_t remaining_length = 2 + topic_size + 2 + sim_connection->sim->config->message_size;
+    unsigned char* packet = (unsigned char*)malloc(5 + remaining_length);
+
+    if (packet == NULL)
+    {
+        LogError("Failure allocating a PUBLISH packet.\r\n");
+    }
+    else
+    {
+        size_t size = 0;
+        size_t length = remaining_length;
+
+        packet[size++] = MQTT_PUBLISH | 0x02;
+        do
+        {
+            unsigned char encoded = (unsigned char)(length % 128);
+            length /= 128;
+            packet[size++] = (length > 0) ? (encoded | 0x80) : encoded;
+        } while (length > 0);
+        packet[size++] = (unsigned char)(topic_size >> 8);
+        packet[size++] = (unsigned char)(topic_size & 0xFF);
+        (void)memcpy(packet + size, topic, topic_size);
+        size += topic_size;
+        packet[size++] = (unsigned char)(sim_connection->next_packet_id >> 8);
+        packet[size++] = (unsigned char)(sim_connection->next_packet_id & 0xFF);
+        (void)memcpy(packet + size, sim_connection->sim->payload, sim_connection->sim->config->message_size);
+        size += sim_connection->sim->config->message_size;
+
+        /* packet id 0 is not allowed */
+        sim_connection->next_packet_id = (sim_connection->next_packet_id == UINT16_MAX) ? 1 : sim_connection->next_packet_id + 1;
+        reply(sim_connection, packet, size);
+        free(packet);
+    }
+}
+
+/* the hub's own round: uAMQP's timers and the cloud to device messages that are due */
+static void run_hub(FLEET_SIM* sim)
+{
+    PDLIST_ENTRY entry;
+
+    hub_enter(sim);
+    for (entry = sim->connections.Flink; entry != &sim->connections; entry = entry->Flink)
+    {
+        SIM_CONNECTION* sim_connection = containingRecord(entry, SIM_CONNECTION, entry);
+
+        if ((sim_connection->amqp_hub != NULL) && (sim_connection->device_index == SIZE_MAX))
+        {
+            const char* address = amqp_hub_sim_get_device_bound_address(sim_connection->amqp_hub);
+            if (address != NULL)
+            {
+                sim_connection->device_index = parse_device_index(address, strlen(address));
+            }
+        }
+
+        if (get_device_to_send_to(sim, sim_connection->device_index) != NULL)
+        {
+            if (sim_connection->amqp_hub == NULL)
+            {
+                publish_to_device(sim_connection);
+            }
+            else if (amqp_hub_sim_send_to_device(sim_connection->amqp_hub, sim->payload, sim->config->message_size) != 0)
+            {
+                LogError("Failure sending a message to device %lu.\r\n", (unsigned long)sim_connection->device_index);
+            }
+        }
+
+        amqp_hub_sim_dowork(sim_connection->amqp_hub);
+    }
+    hub_leave(sim);
+}
+
+/* the number of events in an HTTP request body, a batch is a JSON array of {"body":...} objects */
+static size_t count_posted_events(const unsigned char* content, size_t content_length)
+{
+    static const char body_key[] = "{\"body\":";
+    size_t result;
+
+    if ((content_length == 0) || (content[0] != '['))
+    {
+        result = 1;
+    }
+    else
+    {
+        size_t i;
+        result = 0;
+        for (i = 0; i + sizeof(body_key) - 1 <= content_length; i++)
+        {
+            if (memcmp(content + i, body_key, sizeof(body_key) - 1) == 0)
+            {
+                result++;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void on_hub_request(void* context, HTTPAPI_REQUEST_TYPE request_type, const char* relative_path, const unsigned char* content, size_t content_length, HTTPAPI_SIM_RESPONSE* response)
+{
+    FLEET_SIM* sim = (FLEET_SIM*)context;
+
+    hub_enter(sim);
+    if ((request_type == HTTPAPI_REQUEST_POST) && (strstr(relative_path, "/messages/events") != NULL))
+    {
+        size_t events = count_posted_events(content, content_length);
+        sim->report->event_requests++;
+        sim->report->publishes += events;
+        if (!take_quota(sim, events))
+        {
+            sim->report->throttled_disconnects++;
+            response->status_code = 429;
+        }
+        else
+        {
+            response->status_code = 204;
+        }
+    }
+    else if ((request_type == HTTPAPI_REQUEST_GET) && (strstr(relative_path, "/messages/devicebound") != NULL))
+    {
+        SIM_DEVICE* device = get_device_to_send_to(sim, parse_device_index(relative_path, strlen(relative_path)));
+        if (device == NULL)
+        {
+            response->status_code = 204;
+        }
+        else
+        {
+            (void)snprintf(sim->etag, sizeof(sim->etag), "\"%lu\"", (unsigned long)device->messages_to_device_sent);
+            response->status_code = 200;
+            response->etag = sim->etag;
+            response->content = sim->payload;
+            response->content_length = sim->config->message_size;
+        }
+    }
+    else
+    {
+        /* completes and abandons of cloud to device messages */
+        response->status_code = 204;
+    }
+    hub_leave(sim);
+}
+
+static void drop_connections(FLEET_SIM* sim)
+{
+    hub_enter(sim);
+    while (!DList_IsListEmpty(&sim->connections))
+    {
+        SIM_CONNECTION* sim_connection = containingRecord(sim->connections.Flink, SIM_CONNECTION, entry);
+        loopbackio_disconnect(sim_connection->connection);
+        free_connection(sim_connection);
+    }
+    hub_leave(sim);
+}
+
+static size_t latency_bucket(uint64_t latency_ms)
+{
+    size_t result;
+
+    if (latency_ms < (1 << FLEET_SIM_LATENCY_EXACT_BITS))
+    {
+        result = (size_t)latency_ms;
+    }
+    else
+    {
+        unsigned int exponent = FLEET_SIM_LATENCY_EXACT_BITS;
+
+        if (latency_ms > UINT32_MAX)
+        {
+            latency_ms = UINT32_MAX;
+        }
+        while ((latency_ms >> (exponent + 1)) != 0)
+        {
+            exponent++;
+        }
+
+        /* the bits just below the leading one pick the bucket within its power of 2 */
+        result = (1 << FLEET_SIM_LATENCY_EXACT_BITS) +
+            ((size_t)(exponent - FLEET_SIM_LATENCY_EXACT_BITS) << FLEET_SIM_LATENCY_SUB_BITS) +
+            (size_t)((latency_ms >> (exponent - FLEET_SIM_LATENCY_SUB_BITS)) & ((1 << FLEET_SIM_LATENCY_SUB_BITS) - 1));
+    }
+
+    return result;
+}
+
+/* the largest latency that falls into the bucket */
+static uint64_t latency_bucket_limit(size_t bucket)
+{
+    uint64_t result;
+
+    if (bucket < (1 << FLEET_SIM_LATENCY_EXACT_BITS))
+    {
+        result = bucket;
+    }
+    else
+    {
+        size_t offset = bucket - (1 << FLEET_SIM_LATENCY_EXACT_BITS);
+        unsigned int shift = (unsigned int)(offset >> FLEET_SIM_LATENCY_SUB_BITS) + FLEET_SIM_LATENCY_EXACT_BITS - FLEET_SIM_LATENCY_SUB_BITS;
+        uint64_t sub_bucket = (1 << FLEET_SIM_LATENCY_SUB_BITS) + (offset & ((1 << FLEET_SIM_LATENCY_SUB_BITS) - 1));
+
+        result = ((sub_bucket + 1) << shift) - 1;
+    }
+
+    return result;
+}
+
+static void on_event_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    SIM_MESSAGE* sim_message = (SIM_MESSAGE*)userContextCallback;
+    FLEET_SIM* sim = sim_message->sim;
+
+    if (result == IOTHUB_CLIENT_CONFIRMATION_OK)
+    {
+        uint64_t latency_ms = virtualclock_get_ms() - sim_message->enqueue_ms;
+        sim->latency_histogram[latency_bucket(latency_ms)] += 1;
+        if (latency_ms > sim->report->latency_max_ms)
+        {
+            sim->report->latency_max_ms = (unsigned int)latency_ms;
+        }
+        sim->report->messages_confirmed++;
+    }
+    else
+    {
+        sim->report->messages_failed++;
+    }
+}
+
+static IOTHUBMESSAGE_DISPOSITION_RESULT on_message_to_device(IOTHUB_MESSAGE_HANDLE message, void* userContextCallback)
+{
+    (void)message;
+    ((FLEET_SIM*)userContextCallback)->report->messages_received++;
+    return IOTHUBMESSAGE_ACCEPTED;
+}
+
+static unsigned int latency_percentile(const FLEET_SIM* sim, size_t percent)
+{
+    size_t target = (sim->report->messages_confirmed * percent + 99) / 100;
+    size_t seen = 0;
+    size_t i;
+
+    for (i = 0; i < FLEET_SIM_LATENCY_BUCKETS; i++)
+    {
+        seen += sim->latency_histogram[i];
+        if ((seen >= target) && (seen > 0))
+        {
+            break;
+        }
+    }
+
+    /* a bucket is reported by its upper end, never above the largest latency seen */
+    return ((i < FLEET_SIM_LATENCY_BUCKETS) && (latency_bucket_limit(i) < sim->report->latency_max_ms)) ?
+        (unsigned int)latency_bucket_limit(i) :
+        sim->report->latency_max_ms;
+}
+
+static size_t memory_used_since(size_t baseline, size_t now)
+{
+    /* gballoc reports SIZE_MAX when it is compiled out */
+    return ((now == SIZE_MAX) || (now < baseline)) ? 0 : now - baseline;
+}
+
+static void log_call_site(void* context, const char* text)
+{
+    (void)context;
+    LogInfo("%s", text);
+}
+
+static int check_allocation_budget(const FLEET_SIM* sim, size_t baseline_count, size_t baseline_bytes, size_t baseline_messages)
+{
+    int result;
+    const FLEET_SIM_CONFIG* config = sim->config;
+    FLEET_SIM_REPORT* report = sim->report;
+    size_t count = gballoc_getAllocationCount();
+    size_t bytes = gballoc_getAllocatedBytes();
+    size_t messages = report->messages_confirmed + report->messages_received - baseline_messages;
+
+    if ((count == SIZE_MAX) || (baseline_count == SIZE_MAX) || (messages == 0))
+    {
+        if ((config->max_allocations_per_message != 0) || (config->max_allocated_bytes_per_message != 0))
+        {
+            LogError("The allocation budget cannot be checked: %s.\r\n", (count == SIZE_MAX) ? "built without GB_DEBUG_ALLOC" : "no message in the steady state");
+            result = __LINE__;
+        }
+        else
+        {
+            /* nothing measured, so nothing to hold against the budget */
+            result = 0;
+        }
+    }
+    else
+    {
+        report->allocations_per_message = (double)(count - baseline_count - sim->hub_allocation_count) / messages;
+        report->allocated_bytes_per_message = (double)(bytes - baseline_bytes - sim->hub_allocated_bytes) / messages;
+
+        if (((config->max_allocations_per_message != 0) && (report->allocations_per_message > config->max_allocations_per_message)) ||
+            ((config->max_allocated_bytes_per_message != 0) && (report->allocated_bytes_per_message > config->max_allocated_bytes_per_message)))
+        {
+            LogError("Allocation budget exceeded: %.1f allocations (budget %lu) and %.1f bytes (budget %lu) per message.\r\n",
+                report->allocations_per_message, (unsigned long)config->max_allocations_per_message,
+                report->allocated_bytes_per_message, (unsigned long)config->max_allocated_bytes_per_message);
+            (void)gballoc_dumpCallSites(GBALLOC_DUMP_TABLE, log_call_site, NULL);
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void send_message(FLEET_SIM* sim, SIM_DEVICE* device, SIM_MESSAGE* sim_message, const unsigned char* payload)
+{
+    IOTHUB_MESSAGE_HANDLE message = IoTHubMessage_CreateFromByteArray(payload, sim->config->message_size);
+    if (message == NULL)
+    {
+        sim->report->messages_failed++;
+    }
+    else
+    {
+        sim_message->sim = sim;
+        sim_message->enqueue_ms = virtualclock_get_ms();
+        if (IoTHubClient_LL_SendEventAsync(device->client, message, on_event_confirmation, sim_message) != IOTHUB_CLIENT_OK)
+        {
+            sim->report->messages_failed++;
+        }
+        else
+        {
+            sim->report->messages_sent++;
+        }
+        IoTHubMessage_Destroy(message);
+    }
+}
+
+int fleet_sim_run(const FLEET_SIM_CONFIG* config, FLEET_SIM_REPORT* report)
+{
+    int result;
+
+    if ((config == NULL) || (report == NULL) ||
+        (config->device_count == 0) || (config->step_ms == 0) || (config->message_size == 0))
+    {
+        LogError("Invalid argument to fleet_sim_run.\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        FLEET_SIM sim;
+        size_t total_messages = config->device_count * config->messages_per_device;
+        SIM_DEVICE* devices = (SIM_DEVICE*)calloc(config->device_count, sizeof(SIM_DEVICE));
+        SIM_MESSAGE* messages = (SIM_MESSAGE*)malloc((total_messages == 0 ? 1 : total_messages) * sizeof(SIM_MESSAGE));
+        unsigned char* payload = (unsigned char*)malloc(config->message_size);
+
+        (void)memset(report, 0, sizeof(FLEET_SIM_REPORT));
+        sim.config = config;
+        sim.report = report;
+        sim.latency_histogram = (size_t*)calloc(FLEET_SIM_LATENCY_BUCKETS, sizeof(size_t));
+        sim.devices = devices;
+        sim.payload = payload;
+        sim.quota_tokens = (uint64_t)config->hub_messages_per_second * 1000;
+        sim.quota_refill_ms = 0;
+        sim.hub_allocation_count = 0;
+        sim.hub_allocated_bytes = 0;
+        sim.hub_depth = 0;
+        DList_InitializeListHead(&sim.connections);
+
+        if ((devices == NULL) || (messages == NULL) || (payload == NULL) || (sim.latency_histogram == NULL))
+        {
+            LogError("Failure allocating the simulation state.\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            LOOPBACKIO_ENDPOINT endpoint;
+            HTTPAPI_SIM_ENDPOINT http_endpoint;
+            size_t baseline_memory = gballoc_getCurrentMemoryUsed();
+            clock_t cpu_start;
+            size_t i;
+
+            (void)memset(payload, 'x', config->message_size);
+            virtualclock_reset(FLEET_SIM_START_TIME);
+            endpoint.on_connect = on_hub_connect;
+            endpoint.on_bytes_received = on_hub_bytes_received;
+            endpoint.on_disconnect = on_hub_disconnect;
+            endpoint.context = &sim;
+            endpoint.latency_ms = config->latency_ms;
+            loopbackio_set_endpoint(&endpoint);
+            http_endpoint.on_request = on_hub_request;
+            http_endpoint.context = &sim;
+            http_endpoint.latency_ms = config->latency_ms;
+            httpapi_sim_set_endpoint(&http_endpoint);
+
+            cpu_start = clock();
+            result = 0;
+            for (i = 0; i < config->device_count; i++)
+            {
+                char device_id[FLEET_SIM_DEVICE_ID_LEN];
+                IOTHUB_CLIENT_CONFIG client_config;
+                (void)snprintf(device_id, sizeof(device_id), FLEET_SIM_DEVICE_ID_PREFIX "%06lu", (unsigned long)i);
+                client_config.protocol = (config->protocol == FLEET_SIM_HTTP) ? HTTP_Protocol :
+                    (config->protocol == FLEET_SIM_AMQP) ? AMQP_Protocol : MQTT_Protocol;
+                client_config.deviceId = device_id;
+                client_config.deviceKey = FLEET_SIM_DEVICE_KEY;
+                client_config.iotHubName = "fleetsim";
+                client_config.iotHubSuffix = "azure-devices.net";
+                client_config.protocolGatewayHostName = NULL;
+
+                if ((devices[i].client = IoTHubClient_LL_Create(&client_config)) == NULL)
+                {
+                    LogError("Failure creating simulated device %lu.\r\n", (unsigned long)i);
+                    result = __LINE__;
+                    break;
+                }
+                report->devices_created++;
+                if (config->disable_throttle_pacing)
+                {
+                    bool throttle_pacing = false;
+                    if (IoTHubClient_LL_SetOption(devices[i].client, "throttlePacing", &throttle_pacing) != IOTHUB_CLIENT_OK)
+                    {
+                        LogError("Failure turning throttle pacing off on simulated device %lu.\r\n", (unsigned long)i);
+                        result = __LINE__;
+                        break;
+                    }
+                }
+                if ((config->protocol == FLEET_SIM_HTTP) && config->http_batching)
+                {
+                    bool batching = true;
+                    if (IoTHubClient_LL_SetOption(devices[i].client, "Batching", &batching) != IOTHUB_CLIENT_OK)
+                    {
+                        LogError("Failure turning batching on on simulated device %lu.\r\n", (unsigned long)i);
+                        result = __LINE__;
+                        break;
+                    }
+                }
+                if (config->warm_standby)
+                {
+                    bool warm_standby = true;
+                    if (IoTHubClient_LL_SetOption(devices[i].client, "warmStandby", &warm_standby) != IOTHUB_CLIENT_OK)
+                    {
+                        LogError("Failure turning the warm standby on on simulated device %lu.\r\n", (unsigned long)i);
+                        result = __LINE__;
+                        break;
+                    }
+                }
+                if (config->messages_to_device != 0)
+                {
+                    if (IoTHubClient_LL_SetMessageCallback(devices[i].client, on_message_to_device, &sim) != IOTHUB_CLIENT_OK)
+                    {
+                        LogError("Failure listening for messages on simulated device %lu.\r\n", (unsigned long)i);
+                        result = __LINE__;
+                        break;
+                    }
+                    if (config->protocol == FLEET_SIM_HTTP)
+                    {
+                        /* a GET once a virtual second instead of every 25 minutes */
+                        unsigned int minimum_polling_time = 0;
+                        if (IoTHubClient_LL_SetOption(devices[i].client, "MinimumPollingTime", &minimum_polling_time) != IOTHUB_CLIENT_OK)
+                        {
+                            LogError("Failure setting the polling time on simulated device %lu.\r\n", (unsigned long)i);
+                            result = __LINE__;
+                            break;
+                        }
+                    }
+                }
+                /* spread the first messages over one interval instead of sending them all in the same round */
+                devices[i].next_send_ms = ((uint64_t)config->send_interval_ms * i) / config->device_count;
+                devices[i].next_to_device_ms = devices[i].next_send_ms;
+            }
+
+            if (result == 0)
+            {
+                bool dropped = false;
+                bool steady = false;
+                size_t baseline_count = SIZE_MAX;
+                size_t baseline_bytes = 0;
+                size_t baseline_messages = 0;
+
+                while ((virtualclock_get_ms() < config->max_duration_ms) &&
+                    ((report->messages_confirmed + report->messages_failed < total_messages) ||
+                    (report->messages_received < config->device_count * config->messages_to_device)))
+                {
+                    uint64_t now = virtualclock_get_ms();
+
+                    if (!steady && (now >= config->send_interval_ms))
+                    {
+                        /* the call site profile covers the steady state only */
+                        gballoc_resetCallSites();
+                        baseline_count = gballoc_getAllocationCount();
+                        baseline_bytes = gballoc_getAllocatedBytes();
+                        baseline_messages = report->messages_confirmed + report->messages_received;
+                        sim.hub_allocation_count = 0;
+                        sim.hub_allocated_bytes = 0;
+                        steady = true;
+                    }
+
+                    for (i = 0; i < config->device_count; i++)
+                    {
+                        SIM_DEVICE* device = &devices[i];
+                        if ((device->messages_sent < config->messages_per_device) && (device->next_send_ms <= now))
+                        {
+                            send_message(&sim, device, &messages[i * config->messages_per_device + device->messages_sent], payload);
+                            device->messages_sent++;
+                            device->next_send_ms = now + config->send_interval_ms;
+                        }
+                        /* the application keeps queueing while DoWork waits for an HTTP response, as it does next to the
+                           IoTHubClient worker thread */
+                        if (device->busy_until_ms <= now)
+                        {
+                            IoTHubClient_LL_DoWork(device->client);
+                            device->busy_until_ms = now + virtualclock_get_offset_ms();
+                            virtualclock_set_offset_ms(0);
+                        }
+                    }
+
+                    run_hub(&sim);
+
+                    if (!dropped && (config->drop_connections_at_ms != 0) && (now >= config->drop_connections_at_ms))
+                    {
+                        drop_connections(&sim);
+                        dropped = true;
+                    }
+
+                    virtualclock_advance_ms(config->step_ms);
+                }
+
+                result = check_allocation_budget(&sim, baseline_count, baseline_bytes, baseline_messages);
+            }
+
+            report->peak_memory_bytes = memory_used_since(baseline_memory, gballoc_getMaximumMemoryUsed());
+            report->memory_per_device_bytes = (report->devices_created == 0) ? 0 : memory_used_since(baseline_memory, gballoc_getCurrentMemoryUsed()) / report->devices_created;
+
+            for (i = 0; i < report->devices_created; i++)
+            {
+                IoTHubClient_LL_Destroy(devices[i].client);
+            }
+
+            report->cpu_seconds = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+            report->virtual_ms = virtualclock_get_ms();
+            report->messages_per_virtual_second = (report->virtual_ms == 0) ? 0 : report->messages_confirmed * 1000.0 / report->virtual_ms;
+            report->messages_per_cpu_second = (report->cpu_seconds <= 0) ? 0 : report->messages_confirmed / report->cpu_seconds;
+            report->events_per_request = (report->event_requests == 0) ? 0 : (double)report->publishes / report->event_requests;
+            report->latency_p50_ms = latency_percentile(&sim, 50);
+            report->latency_p90_ms = latency_percentile(&sim, 90);
+            report->latency_p99_ms = latency_percentile(&sim, 99);
+
+            drop_connections(&sim);
+            loopbackio_set_endpoint(NULL);
+            httpapi_sim_set_endpoint(NULL);
+        }
+
+        free(sim.latency_histogram);
+        free(payload);
+        free(messages);
+        free(devices);
+    }
+
+    return result;
+}
@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef FLEET_SIM_H
+#define FLEET_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+/* Fleet simulation: device_count IoTHubClient_LL instances over MQTT, all connected through loopbackio to an
+   in process stand-in for the hub that acknowledges CONNECT, SUBSCRIBE, PUBLISH and PINGREQ. Time is virtual
+   (virtualclock.h), every round runs DoWork on all devices and then advances the clock by step_ms, so hours of
+   keep alives, SAS token renewals and reconnects take only the CPU the SDK itself needs.
+
+   Over HTTP the devices post to the stand-in hub through httpapi_sim.c instead, which answers every request with a
+   204 and blocks the device for latency_ms. event_requests against publishes is then how well the transport batches,
+   and the latency percentiles what the batching costs. Over AMQP the stand-in hub is uAMQP's own listening side
+   (amqp_hub_sim.h), which completes the SASL handshake and the CBS put-token and accepts the events.
+
+   With messages_to_device the hub also sends every device cloud to device messages, one per send_interval_ms once
+   the device listens for them: a QoS 1 PUBLISH on its devicebound topic, a transfer on its receiver link, or the
+   response to its next GET over HTTP, which polls once a virtual second then. The devices accept them all.
+
+   These sources live in sim/, outside the firmware/ directory Particle builds, because platform_sim.c and
+   virtualclock.c define the platform adapter, tickcounter and agenttime functions, and httpapi_sim.c the HTTPAPI.
+   Build for the host with the sim/ sources in place of those implementations, lock_sim.c for gballoc's lock, the
+   transports and -I firmware; fleet_sim_budgets.c has the full command. Memory figures need GB_DEBUG_ALLOC and
+   GB_MEASURE_MEMORY_FOR_THIS on the SDK sources, they are 0 otherwise. gballoc looks up every free in a list of
+   all live blocks, so take memory per device from a fleet of about a thousand and CPU and throughput figures for
+   large fleets from a build without gballoc.
+
+   Allocation budgets: the steady state starts once the first send interval is over, every device has connected and
+   sent once by then. With GB_DEBUG_ALLOC the run counts the allocations made from there on per message confirmed
+   or received and fails when they exceed a budget, logging the steady state call sites first, or when a budget is
+   set and nothing could be measured. What the stand-in hub allocates, uAMQP's listening side included, is left out.
+   fleet_sim_budgets.c holds the budgets of every transport. Build the SDK sources with
+   GB_PROFILE_CALL_SITES and call gballoc_setSampleInterval(1) to have every allocation attributed to its file and
+   line, so the table shows which layer owns it.
+
+   Throttling: with hub_messages_per_second the stand-in hub keeps a hub wide quota the way IoT Hub does and drops the
+   connection of a device that publishes over it, without a PUBACK (over HTTP it answers 429, over AMQP it rejects the
+   transfer with amqp:resource-limit-exceeded). messages_per_virtual_second is then the goodput,
+   publishes against messages_confirmed shows what the retries cost, and disable_throttle_pacing gives the baseline of
+   clients that reconnect and publish again at once. */
+
+typedef enum FLEET_SIM_PROTOCOL_TAG
+{
+    FLEET_SIM_MQTT,
+    FLEET_SIM_HTTP,
+    FLEET_SIM_AMQP
+} FLEET_SIM_PROTOCOL;
+
+typedef struct FLEET_SIM_CONFIG_TAG
+{
+    FLEET_SIM_PROTOCOL protocol;
+    size_t device_count;
+    size_t messages_per_device;
+    /* cloud to device messages the hub sends each device, 0 for none */
+    size_t messages_to_device;
+    size_t message_size;
+    /* virtual time between two messages of a device, the devices' first messages are spread over one interval */
+    unsigned int send_interval_ms;
+    /* virtual time per round */
+    unsigned int step_ms;
+    /* round trip between a device and the stand-in hub */
+    unsigned int latency_ms;
+    /* when not 0 the hub drops every connection once at this virtual time, to replay a reconnect storm */
+    unsigned int drop_connections_at_ms;
+    /* the run stops here even if messages are still outstanding */
+    unsigned int max_duration_ms;
+    /* steady state budgets per message confirmed or received, 0 for none */
+    size_t max_allocations_per_message;
+    size_t max_allocated_bytes_per_message;
+    /* PUBLISH packets the hub accepts per virtual second with bursts of up to one second of quota, 0 for no quota */
+    unsigned int hub_messages_per_second;
+    /* sets the "throttlePacing" option of every device to false */
+    bool disable_throttle_pacing;
+    /* sets the "warmStandby" option of every device, so dropped connections fail over to a second one */
+    bool warm_standby;
+    /* sets the "Batching" option of every device over HTTP */
+    bool http_batching;
+} FLEET_SIM_CONFIG;
+
+typedef struct FLEET_SIM_REPORT_TAG
+{
+    size_t devices_created;
+    size_t messages_sent;
+    size_t messages_confirmed;
+    size_t messages_failed;
+    /* cloud to device messages that reached the devices' message callbacks */
+    size_t messages_received;
+    /* CONNECT packets seen by the hub, device_count when nothing reconnected */
+    size_t connects;
+    /* PUBLISH packets, events posted over HTTP or AMQP transfers seen by the hub, retries included, and the connections
+       it dropped (the HTTP requests it answered with a 429, the transfers it rejected) for going over the quota */
+    size_t publishes;
+    size_t throttled_disconnects;
+    /* HTTP requests that posted events, and the events they carried on average */
+    size_t event_requests;
+    double events_per_request;
+    uint64_t virtual_ms;
+    double cpu_seconds;
+    double messages_per_virtual_second;
+    double messages_per_cpu_second;
+    size_t peak_memory_bytes;
+    size_t memory_per_device_bytes;
+    /* enqueue to confirmation, in virtual milliseconds (resolution step_ms). The percentiles come from a histogram
+       that is exact up to 63 ms, above that they are rounded up by less than 1/32 (about 3%) of the value, at any run
+       length */
+    unsigned int latency_p50_ms;
+    unsigned int latency_p90_ms;
+    unsigned int latency_p99_ms;
+    unsigned int latency_max_ms;
+    /* steady state, 0 without GB_DEBUG_ALLOC or when no message was confirmed or received in the steady state */
+    double allocations_per_message;
+    double allocated_bytes_per_message;
+} FLEET_SIM_REPORT;
+
+extern int fleet_sim_run(const FLEET_SIM_CONFIG* config, FLEET_SIM_REPORT* report);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FLEET_SIM_H */
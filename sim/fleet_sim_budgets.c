@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Allocation budgets of every transport (fleet_sim.h): a small fleet sends and receives in the steady state over
+   MQTT, AMQP and HTTP, and the program exits with 1 when any transport allocates more per message than its budget
+   below, after logging the call sites that did. Lower a budget when a change saves allocations, so the next
+   regression fails, and raise it only together with the change that needs it.
+
+   Build and run on the host from the repository root (OpenSSL for the hashes is not needed, hmacsha256.c is
+   self-contained):
+
+   gcc -std=gnu99 -O1 -DGB_DEBUG_ALLOC -DGB_MEASURE_MEMORY_FOR_THIS -DGB_PROFILE_CALL_SITES -Ifirmware -Isim \
+       sim/[a-z]*.c $(ls firmware/[a-z]*.c | grep -v -e platform -e tickcounter -e agenttime -e httpapi_ -e tlsio_ \
+       -e socketio -e socket_listener -e wsio -e _websockets -e dns_resolver -e lock -e 'iothubtransport\.c') \
+       -o fleet_sim_budgets
+   ./fleet_sim_budgets */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "gballoc.h"
+#include "fleet_sim.h"
+
+#if !defined(GB_DEBUG_ALLOC)
+#error "the budgets are measured with gballoc, build with GB_DEBUG_ALLOC and GB_MEASURE_MEMORY_FOR_THIS"
+#endif
+
+typedef struct TRANSPORT_BUDGET_TAG
+{
+    const char* name;
+    FLEET_SIM_PROTOCOL protocol;
+    size_t max_allocations_per_message;
+    size_t max_allocated_bytes_per_message;
+} TRANSPORT_BUDGET;
+
+static const TRANSPORT_BUDGET transport_budgets[] =
+{
+    { "MQTT", FLEET_SIM_MQTT, 18, 1800 },
+    { "AMQP", FLEET_SIM_AMQP, 200, 7900 },
+    { "HTTP", FLEET_SIM_HTTP, 84, 4100 }
+};
+
+int main(void)
+{
+    int result = 0;
+    size_t i;
+
+    if (gballoc_init() != 0)
+    {
+        (void)printf("gballoc_init failed\r\n");
+        result = 1;
+    }
+    else
+    {
+        /* attribute every allocation, so a failing budget names the lines that went over it */
+        gballoc_setSampleInterval(1);
+
+        for (i = 0; i < sizeof(transport_budgets) / sizeof(transport_budgets[0]); i++)
+        {
+            FLEET_SIM_CONFIG config = { 0 };
+            FLEET_SIM_REPORT report;
+            int run_result;
+
+            config.protocol = transport_budgets[i].protocol;
+            config.device_count = 10;
+            config.messages_per_device = 20;
+            config.messages_to_device = 20;
+            config.message_size = 256;
+            config.send_interval_ms = 1000;
+            config.step_ms = 10;
+            config.latency_ms = 20;
+            config.max_duration_ms = 60 * 1000;
+            config.max_allocations_per_message = transport_budgets[i].max_allocations_per_message;
+            config.max_allocated_bytes_per_message = transport_budgets[i].max_allocated_bytes_per_message;
+
+            run_result = fleet_sim_run(&config, &report);
+            (void)printf("%s: %lu sent, %lu received, %.1f allocations (budget %lu) and %.1f bytes (budget %lu) per message: %s\r\n",
+                transport_budgets[i].name,
+                (unsigned long)report.messages_confirmed, (unsigned long)report.messages_received,
+                report.allocations_per_message, (unsigned long)config.max_allocations_per_message,
+                report.allocated_bytes_per_message, (unsigned long)config.max_allocated_bytes_per_message,
+                (run_result == 0) ? "ok" : "FAILED");
+
+            if ((run_result != 0) ||
+                (report.messages_confirmed != config.device_count * config.messages_per_device) ||
+                (report.messages_received != config.device_count * config.messages_to_device))
+            {
+                result = 1;
+            }
+        }
+
+        gballoc_deinit();
+    }
+
+    return result;
+}
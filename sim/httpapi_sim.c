@@ -0,0 +1,159 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdbool.h>
+#include "gballoc.h"
+#include "httpapi.h"
+#include "httpapi_sim.h"
+#include "virtualclock.h"
+#include "iot_logging.h"
+
+typedef struct HTTP_HANDLE_DATA_TAG
+{
+    int unused;
+} HTTP_HANDLE_DATA;
+
+static HTTPAPI_SIM_ENDPOINT httpapi_endpoint = { NULL, NULL, 0 };
+
+void httpapi_sim_set_endpoint(const HTTPAPI_SIM_ENDPOINT* endpoint)
+{
+    if (endpoint == NULL)
+    {
+        httpapi_endpoint.on_request = NULL;
+        httpapi_endpoint.context = NULL;
+        httpapi_endpoint.latency_ms = 0;
+    }
+    else
+    {
+        httpapi_endpoint = *endpoint;
+    }
+}
+
+HTTPAPI_RESULT HTTPAPI_Init(void)
+{
+    return HTTPAPI_OK;
+}
+
+void HTTPAPI_Deinit(void)
+{
+}
+
+HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
+{
+    HTTP_HANDLE_DATA* result;
+
+    if (hostName == NULL)
+    {
+        LogError("Invalid argument to HTTPAPI_CreateConnection.\r\n");
+        result = NULL;
+    }
+    else if ((result = (HTTP_HANDLE_DATA*)malloc(sizeof(HTTP_HANDLE_DATA))) == NULL)
+    {
+        LogError("Failure allocating the simulated connection.\r\n");
+    }
+    else
+    {
+        result->unused = 0;
+    }
+
+    return result;
+}
+
+void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
+{
+    free(handle);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+    size_t contentLength, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+
+    (void)httpHeadersHandle;
+
+    if ((handle == NULL) || (relativePath == NULL) || (statusCode == NULL) || ((content == NULL) && (contentLength != 0)))
+    {
+        LogError("Invalid argument to HTTPAPI_ExecuteRequest.\r\n");
+        result = HTTPAPI_INVALID_ARG;
+    }
+    else if (httpapi_endpoint.on_request == NULL)
+    {
+        LogError("No simulated endpoint to send the request to.\r\n");
+        result = HTTPAPI_OPEN_REQUEST_FAILED;
+    }
+    else
+    {
+        HTTPAPI_SIM_RESPONSE response;
+        response.status_code = 500;
+        response.etag = NULL;
+        response.content = NULL;
+        response.content_length = 0;
+
+        httpapi_endpoint.on_request(httpapi_endpoint.context, requestType, relativePath, content, contentLength, &response);
+
+        if ((responseContent != NULL) && (BUFFER_build(responseContent, response.content, response.content_length) != 0))
+        {
+            LogError("Failure copying the response content.\r\n");
+            result = HTTPAPI_ALLOC_FAILED;
+        }
+        else if ((responseHeadersHandle != NULL) && (response.etag != NULL) &&
+            (HTTPHeaders_AddHeaderNameValuePair(responseHeadersHandle, "ETag", response.etag) != HTTP_HEADERS_OK))
+        {
+            LogError("Failure copying the response headers.\r\n");
+            result = HTTPAPI_HTTP_HEADERS_FAILED;
+        }
+        else
+        {
+            *statusCode = response.status_code;
+            /* the device is blocked for the round trip, the others are not */
+            virtualclock_set_offset_ms(virtualclock_get_offset_ms() + httpapi_endpoint.latency_ms);
+            result = HTTPAPI_OK;
+        }
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
+{
+    HTTPAPI_RESULT result;
+
+    (void)value;
+
+    if ((handle == NULL) || (optionName == NULL))
+    {
+        result = HTTPAPI_INVALID_ARG;
+    }
+    else
+    {
+        /* there are no certificates or timeouts to set on an in process endpoint, and HTTPAPI_CloneOption saves NULL */
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, const void** savedValue)
+{
+    HTTPAPI_RESULT result;
+
+    if ((optionName == NULL) || (value == NULL) || (savedValue == NULL))
+    {
+        result = HTTPAPI_INVALID_ARG;
+    }
+    else
+    {
+        /* HTTPAPI_SetOption keeps nothing, so the saved value never has to outlive the caller's */
+        *savedValue = NULL;
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
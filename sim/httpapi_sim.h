@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef HTTPAPI_SIM_H
+#define HTTPAPI_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "httpapi.h"
+
+/* In process HTTPAPI (httpapi.h) for simulations: every request goes to the one endpoint set with
+   httpapi_sim_set_endpoint instead of a server. The request blocks the device that makes it for latency_ms, which
+   httpapi_sim adds to the virtual clock's offset (virtualclock.h), so the caller only sees its own time move and
+   runs the device again once the global clock has caught up with it. The only response header is the ETag. */
+
+typedef struct HTTPAPI_SIM_RESPONSE_TAG
+{
+    unsigned int status_code;
+    /* NULL for no ETag header */
+    const char* etag;
+    const unsigned char* content;
+    size_t content_length;
+} HTTPAPI_SIM_RESPONSE;
+
+/* fills in the response, etag and content are copied before the endpoint sees the next request */
+typedef void(*ON_HTTPAPI_SIM_REQUEST)(void* context, HTTPAPI_REQUEST_TYPE request_type, const char* relative_path, const unsigned char* content, size_t content_length, HTTPAPI_SIM_RESPONSE* response);
+
+typedef struct HTTPAPI_SIM_ENDPOINT_TAG
+{
+    ON_HTTPAPI_SIM_REQUEST on_request;
+    void* context;
+    /* round trip of a request */
+    unsigned int latency_ms;
+} HTTPAPI_SIM_ENDPOINT;
+
+extern void httpapi_sim_set_endpoint(const HTTPAPI_SIM_ENDPOINT* endpoint);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HTTPAPI_SIM_H */
@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "lock.h"
+
+/* lock for simulation builds (fleet_sim.h): the devices, the stand-in hub and the virtual clock all run on the
+   calling thread, so there is nothing to exclude and gballoc only needs a handle that is not NULL */
+
+static int sim_lock;
+
+LOCK_HANDLE Lock_Init(void)
+{
+    return &sim_lock;
+}
+
+LOCK_RESULT Lock(LOCK_HANDLE handle)
+{
+    return (handle == NULL) ? LOCK_ERROR : LOCK_OK;
+}
+
+LOCK_RESULT Unlock(LOCK_HANDLE handle)
+{
+    return (handle == NULL) ? LOCK_ERROR : LOCK_OK;
+}
+
+LOCK_RESULT Lock_Deinit(LOCK_HANDLE handle)
+{
+    return (handle == NULL) ? LOCK_ERROR : LOCK_OK;
+}
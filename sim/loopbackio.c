@@ -0,0 +1,396 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "gballoc.h"
+#include "loopbackio.h"
+#include "tickcounter.h"
+#include "iot_logging.h"
+
+typedef enum IO_STATE_TAG
+{
+    IO_STATE_NOT_OPEN,
+    IO_STATE_OPENING,
+    IO_STATE_OPEN,
+    IO_STATE_ERROR
+} IO_STATE;
+
+typedef struct DELIVERY_TAG
+{
+    struct DELIVERY_TAG* next;
+    uint64_t due_ms;
+    size_t size;
+    unsigned char bytes[1];
+} DELIVERY;
+
+typedef struct LOOPBACKIO_INSTANCE_TAG
+{
+    ON_BYTES_RECEIVED on_bytes_received;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    ON_IO_ERROR on_io_error;
+    void* on_bytes_received_context;
+    void* on_io_open_complete_context;
+    void* on_io_error_context;
+    LOGGER_LOG logger_log;
+    TICK_COUNTER_HANDLE tick_counter;
+    IO_STATE io_state;
+    uint64_t open_due_ms;
+    void* connection_context;
+    bool endpoint_connected;
+    bool endpoint_closed;
+    DELIVERY* deliveries_head;
+    DELIVERY* deliveries_tail;
+} LOOPBACKIO_INSTANCE;
+
+static LOOPBACKIO_ENDPOINT loopback_endpoint = { NULL, NULL, NULL, NULL, 0 };
+
+static const IO_INTERFACE_DESCRIPTION loopbackio_interface_description =
+{
+    loopbackio_create,
+    loopbackio_destroy,
+    loopbackio_open,
+    loopbackio_close,
+    loopbackio_send,
+    loopbackio_dowork,
+    loopbackio_setoption
+};
+
+static uint64_t get_current_ms(LOOPBACKIO_INSTANCE* loopback_io_instance)
+{
+    uint64_t current_ms;
+    if (tickcounter_get_current_ms(loopback_io_instance->tick_counter, &current_ms) != 0)
+    {
+        current_ms = 0;
+    }
+    return current_ms;
+}
+
+static void free_deliveries(LOOPBACKIO_INSTANCE* loopback_io_instance)
+{
+    while (loopback_io_instance->deliveries_head != NULL)
+    {
+        DELIVERY* delivery = loopback_io_instance->deliveries_head;
+        loopback_io_instance->deliveries_head = delivery->next;
+        free(delivery);
+    }
+    loopback_io_instance->deliveries_tail = NULL;
+}
+
+static void indicate_error(LOOPBACKIO_INSTANCE* loopback_io_instance)
+{
+    loopback_io_instance->io_state = IO_STATE_ERROR;
+    if (loopback_io_instance->on_io_error != NULL)
+    {
+        loopback_io_instance->on_io_error(loopback_io_instance->on_io_error_context);
+    }
+}
+
+static void indicate_open_complete(LOOPBACKIO_INSTANCE* loopback_io_instance, IO_OPEN_RESULT open_result)
+{
+    if (loopback_io_instance->on_io_open_complete != NULL)
+    {
+        loopback_io_instance->on_io_open_complete(loopback_io_instance->on_io_open_complete_context, open_result);
+    }
+}
+
+static void disconnect_endpoint(LOOPBACKIO_INSTANCE* loopback_io_instance)
+{
+    if (loopback_io_instance->endpoint_connected)
+    {
+        loopback_io_instance->endpoint_connected = false;
+        if (!loopback_io_instance->endpoint_closed && loopback_endpoint.on_disconnect != NULL)
+        {
+            loopback_endpoint.on_disconnect(loopback_io_instance->connection_context);
+        }
+    }
+    loopback_io_instance->connection_context = NULL;
+    free_deliveries(loopback_io_instance);
+}
+
+void loopbackio_set_endpoint(const LOOPBACKIO_ENDPOINT* endpoint)
+{
+    if (endpoint == NULL)
+    {
+        (void)memset(&loopback_endpoint, 0, sizeof(loopback_endpoint));
+    }
+    else
+    {
+        loopback_endpoint = *endpoint;
+    }
+}
+
+int loopbackio_deliver(LOOPBACKIO_CONNECTION_HANDLE connection, const unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if ((connection == NULL) ||
+        ((buffer == NULL) && (size > 0)))
+    {
+        result = __LINE__;
+    }
+    else if (!connection->endpoint_connected || connection->endpoint_closed)
+    {
+        result = __LINE__;
+    }
+    else if (size == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        DELIVERY* delivery = (DELIVERY*)malloc(sizeof(DELIVERY) + size - 1);
+        if (delivery == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            delivery->next = NULL;
+            delivery->due_ms = get_current_ms(connection) + loopback_endpoint.latency_ms;
+            delivery->size = size;
+            (void)memcpy(delivery->bytes, buffer, size);
+            if (connection->deliveries_tail == NULL)
+            {
+                connection->deliveries_head = delivery;
+            }
+            else
+            {
+                connection->deliveries_tail->next = delivery;
+            }
+            connection->deliveries_tail = delivery;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+void loopbackio_disconnect(LOOPBACKIO_CONNECTION_HANDLE connection)
+{
+    if (connection != NULL)
+    {
+        connection->endpoint_closed = true;
+    }
+}
+
+CONCRETE_IO_HANDLE loopbackio_create(void* io_create_parameters, LOGGER_LOG logger_log)
+{
+    LOOPBACKIO_INSTANCE* result;
+    (void)io_create_parameters;
+
+    result = (LOOPBACKIO_INSTANCE*)malloc(sizeof(LOOPBACKIO_INSTANCE));
+    if (result == NULL)
+    {
+        LogError("Failure allocating the loopback io instance.\r\n");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(LOOPBACKIO_INSTANCE));
+        result->tick_counter = tickcounter_create();
+        if (result->tick_counter == NULL)
+        {
+            LogError("Failure creating the tick counter.\r\n");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->logger_log = logger_log;
+            result->io_state = IO_STATE_NOT_OPEN;
+        }
+    }
+
+    return result;
+}
+
+void loopbackio_destroy(CONCRETE_IO_HANDLE loopback_io)
+{
+    if (loopback_io != NULL)
+    {
+        LOOPBACKIO_INSTANCE* loopback_io_instance = (LOOPBACKIO_INSTANCE*)loopback_io;
+        disconnect_endpoint(loopback_io_instance);
+        tickcounter_destroy(loopback_io_instance->tick_counter);
+        free(loopback_io_instance);
+    }
+}
+
+int loopbackio_open(CONCRETE_IO_HANDLE loopback_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    LOOPBACKIO_INSTANCE* loopback_io_instance = (LOOPBACKIO_INSTANCE*)loopback_io;
+
+    if (loopback_io_instance == NULL)
+    {
+        result = __LINE__;
+    }
+    else if (loopback_io_instance->io_state != IO_STATE_NOT_OPEN)
+    {
+        result = __LINE__;
+    }
+    else if (loopback_endpoint.on_connect == NULL)
+    {
+        LogError("No loopback endpoint is set.\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        loopback_io_instance->on_bytes_received = on_bytes_received;
+        loopback_io_instance->on_bytes_received_context = on_bytes_received_context;
+        loopback_io_instance->on_io_open_complete = on_io_open_complete;
+        loopback_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+        loopback_io_instance->on_io_error = on_io_error;
+        loopback_io_instance->on_io_error_context = on_io_error_context;
+        loopback_io_instance->endpoint_closed = false;
+        loopback_io_instance->open_due_ms = get_current_ms(loopback_io_instance) + 2 * (uint64_t)loopback_endpoint.latency_ms;
+        loopback_io_instance->io_state = IO_STATE_OPENING;
+        result = 0;
+    }
+
+    return result;
+}
+
+int loopbackio_close(CONCRETE_IO_HANDLE loopback_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+    LOOPBACKIO_INSTANCE* loopback_io_instance = (LOOPBACKIO_INSTANCE*)loopback_io;
+
+    if (loopback_io_instance == NULL)
+    {
+        result = __LINE__;
+    }
+    else if (loopback_io_instance->io_state == IO_STATE_NOT_OPEN)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        if (loopback_io_instance->io_state == IO_STATE_OPENING)
+        {
+            indicate_open_complete(loopback_io_instance, IO_OPEN_CANCELLED);
+        }
+
+        disconnect_endpoint(loopback_io_instance);
+        loopback_io_instance->io_state = IO_STATE_NOT_OPEN;
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+int loopbackio_send(CONCRETE_IO_HANDLE loopback_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    LOOPBACKIO_INSTANCE* loopback_io_instance = (LOOPBACKIO_INSTANCE*)loopback_io;
+
+    if ((loopback_io_instance == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        result = __LINE__;
+    }
+    else if ((loopback_io_instance->io_state != IO_STATE_OPEN) || loopback_io_instance->endpoint_closed)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        if (loopback_endpoint.on_bytes_received != NULL)
+        {
+            loopback_endpoint.on_bytes_received(loopback_io_instance->connection_context, (const unsigned char*)buffer, size);
+        }
+        if (on_send_complete != NULL)
+        {
+            on_send_complete(callback_context, IO_SEND_OK);
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+void loopbackio_dowork(CONCRETE_IO_HANDLE loopback_io)
+{
+    LOOPBACKIO_INSTANCE* loopback_io_instance = (LOOPBACKIO_INSTANCE*)loopback_io;
+
+    if (loopback_io_instance != NULL)
+    {
+        uint64_t current_ms = get_current_ms(loopback_io_instance);
+
+        if ((loopback_io_instance->io_state == IO_STATE_OPENING) &&
+            (current_ms >= loopback_io_instance->open_due_ms))
+        {
+            loopback_io_instance->connection_context = loopback_endpoint.on_connect(loopback_endpoint.context, loopback_io_instance);
+            if (loopback_io_instance->connection_context == NULL)
+            {
+                loopback_io_instance->io_state = IO_STATE_NOT_OPEN;
+                indicate_open_complete(loopback_io_instance, IO_OPEN_ERROR);
+            }
+            else
+            {
+                loopback_io_instance->endpoint_connected = true;
+                loopback_io_instance->io_state = IO_STATE_OPEN;
+                indicate_open_complete(loopback_io_instance, IO_OPEN_OK);
+            }
+        }
+
+        /* the callback may close the io, so the state is checked again for every delivery */
+        while ((loopback_io_instance->io_state == IO_STATE_OPEN) &&
+            (loopback_io_instance->deliveries_head != NULL) &&
+            (loopback_io_instance->deliveries_head->due_ms <= current_ms))
+        {
+            DELIVERY* delivery = loopback_io_instance->deliveries_head;
+            loopback_io_instance->deliveries_head = delivery->next;
+            if (loopback_io_instance->deliveries_head == NULL)
+            {
+                loopback_io_instance->deliveries_tail = NULL;
+            }
+
+            if (loopback_io_instance->on_bytes_received != NULL)
+            {
+                loopback_io_instance->on_bytes_received(loopback_io_instance->on_bytes_received_context, delivery->bytes, delivery->size);
+            }
+            free(delivery);
+        }
+
+        if ((loopback_io_instance->io_state == IO_STATE_OPEN) &&
+            loopback_io_instance->endpoint_closed &&
+            (loopback_io_instance->deliveries_head == NULL))
+        {
+            indicate_error(loopback_io_instance);
+        }
+    }
+}
+
+int loopbackio_setoption(CONCRETE_IO_HANDLE loopback_io, const char* optionName, const void* value)
+{
+    int result;
+    (void)value;
+
+    if ((loopback_io == NULL) || (optionName == NULL))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        /* accept and ignore what would go to a TLS io (TrustedCerts, ...) */
+        result = 0;
+    }
+
+    return result;
+}
+
+const IO_INTERFACE_DESCRIPTION* loopbackio_get_interface_description(void)
+{
+    return &loopbackio_interface_description;
+}
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef LOOPBACKIO_H
+#define LOOPBACKIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "xio.h"
+#include "xlogging.h"
+
+/* In process IO: every instance connects to the one endpoint set with loopbackio_set_endpoint instead of a socket.
+   Bytes sent by the client reach the endpoint synchronously, bytes delivered by the endpoint reach the client from
+   dowork once latency_ms has elapsed on the tickcounter, so a virtual clock drives the delays as well.
+   loopbackio_create takes a TLSIO_CONFIG (tlsio.h), the hostname and port are not used. */
+
+typedef struct LOOPBACKIO_INSTANCE_TAG* LOOPBACKIO_CONNECTION_HANDLE;
+
+/* returns the endpoint's context for the new connection, NULL refuses it */
+typedef void*(*ON_LOOPBACK_CONNECT)(void* endpoint_context, LOOPBACKIO_CONNECTION_HANDLE connection);
+typedef void(*ON_LOOPBACK_BYTES_RECEIVED)(void* connection_context, const unsigned char* buffer, size_t size);
+/* the client closed the connection, the handle must not be used anymore */
+typedef void(*ON_LOOPBACK_DISCONNECT)(void* connection_context);
+
+typedef struct LOOPBACKIO_ENDPOINT_TAG
+{
+    ON_LOOPBACK_CONNECT on_connect;
+    ON_LOOPBACK_BYTES_RECEIVED on_bytes_received;
+    ON_LOOPBACK_DISCONNECT on_disconnect;
+    void* context;
+    /* delay of every delivery to the client, so the round trip of a request (sends are immediate),
+       opening a connection takes two round trips as a TCP and TLS handshake would */
+    unsigned int latency_ms;
+} LOOPBACKIO_ENDPOINT;
+
+extern void loopbackio_set_endpoint(const LOOPBACKIO_ENDPOINT* endpoint);
+/* queues bytes for the client, may be called from ON_LOOPBACK_BYTES_RECEIVED */
+extern int loopbackio_deliver(LOOPBACKIO_CONNECTION_HANDLE connection, const unsigned char* buffer, size_t size);
+/* endpoint side close: the client sees an IO error after the bytes already delivered, no ON_LOOPBACK_DISCONNECT follows */
+extern void loopbackio_disconnect(LOOPBACKIO_CONNECTION_HANDLE connection);
+
+extern CONCRETE_IO_HANDLE loopbackio_create(void* io_create_parameters, LOGGER_LOG logger_log);
+extern void loopbackio_destroy(CONCRETE_IO_HANDLE loopback_io);
+extern int loopbackio_open(CONCRETE_IO_HANDLE loopback_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context);
+extern int loopbackio_close(CONCRETE_IO_HANDLE loopback_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context);
+extern int loopbackio_send(CONCRETE_IO_HANDLE loopback_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context);
+extern void loopbackio_dowork(CONCRETE_IO_HANDLE loopback_io);
+extern int loopbackio_setoption(CONCRETE_IO_HANDLE loopback_io, const char* optionName, const void* value);
+
+extern const IO_INTERFACE_DESCRIPTION* loopbackio_get_interface_description(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOOPBACKIO_H */
@@ -0,0 +1,21 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "platform.h"
+#include "loopbackio.h"
+
+/* platform adapter for simulation builds (fleet_sim.h): every transport's TLS io is a loopbackio */
+
+int platform_init(void)
+{
+    return 0;
+}
+
+void platform_deinit(void)
+{
+}
+
+const IO_INTERFACE_DESCRIPTION* platform_get_default_tlsio(void)
+{
+    return loopbackio_get_interface_description();
+}
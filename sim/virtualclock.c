@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#ifdef _CRTDBG_MAP_ALLOC
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <time.h>
+#include "virtualclock.h"
+#include "tickcounter.h"
+#include "agenttime.h"
+
+/* the tick counters carry no state of their own, they all read the one virtual clock */
+typedef struct TICK_COUNTER_INSTANCE_TAG
+{
+    int unused;
+} TICK_COUNTER_INSTANCE;
+
+static TICK_COUNTER_INSTANCE virtual_tick_counter;
+static uint64_t virtual_ms = 0;
+static uint64_t offset_ms = 0;
+static time_t virtual_start_time = 0;
+
+void virtualclock_reset(time_t start_time)
+{
+    virtual_ms = 0;
+    offset_ms = 0;
+    virtual_start_time = start_time;
+}
+
+void virtualclock_advance_ms(uint64_t ms)
+{
+    virtual_ms += ms;
+}
+
+uint64_t virtualclock_get_ms(void)
+{
+    return virtual_ms + offset_ms;
+}
+
+void virtualclock_set_offset_ms(uint64_t ms)
+{
+    offset_ms = ms;
+}
+
+uint64_t virtualclock_get_offset_ms(void)
+{
+    return offset_ms;
+}
+
+TICK_COUNTER_HANDLE tickcounter_create(void)
+{
+    return &virtual_tick_counter;
+}
+
+void tickcounter_destroy(TICK_COUNTER_HANDLE tick_counter)
+{
+    (void)tick_counter;
+}
+
+int tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, uint64_t* current_ms)
+{
+    int result;
+
+    if ((tick_counter == NULL) || (current_ms == NULL))
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        *current_ms = virtual_ms + offset_ms;
+        result = 0;
+    }
+
+    return result;
+}
+
+time_t get_time(time_t* currentTime)
+{
+    time_t result = virtual_start_time + (time_t)((virtual_ms + offset_ms) / 1000);
+    if (currentTime != NULL)
+    {
+        *currentTime = result;
+    }
+    return result;
+}
+
+struct tm* get_gmtime(time_t* currentTime)
+{
+    return gmtime(currentTime);
+}
+
+char* get_ctime(time_t* timeToGet)
+{
+    return ctime(timeToGet);
+}
+
+double get_difftime(time_t stopTime, time_t startTime)
+{
+    return difftime(stopTime, startTime);
+}
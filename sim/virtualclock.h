@@ -0,0 +1,33 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef VIRTUALCLOCK_H
+#define VIRTUALCLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstdint>
+#include <ctime>
+#else
+#include <stdint.h>
+#include <time.h>
+#endif /* __cplusplus */
+
+/* Controllable clock for simulations. virtualclock.c implements tickcounter.h and agenttime.h on top of it and is
+   linked instead of the platform's implementations, so every timeout, keep alive and SAS token expiry in the
+   SDK follows the virtual time and only moves when virtualclock_advance_ms is called. */
+
+/* restarts the millisecond counter at 0, get_time reports start_time plus the elapsed virtual seconds */
+extern void virtualclock_reset(time_t start_time);
+extern void virtualclock_advance_ms(uint64_t ms);
+extern uint64_t virtualclock_get_ms(void);
+/* a blocking call such as an HTTP request moves only the time of the device that makes it: the offset is added to
+   what the clock reports until it is set back to 0 */
+extern void virtualclock_set_offset_ms(uint64_t ms);
+extern uint64_t virtualclock_get_offset_ms(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* VIRTUALCLOCK_H */